@@ -4,6 +4,7 @@
 
 static Mix_Chunk* meow_sound = nullptr;
 static int meow_channel = -1;
+static bool silent = false;
 
 bool audio_init() {
     // Open the audio device at standard CD quality
@@ -27,7 +28,7 @@ void audio_quit() {
 }
 
 void audio_play_meow() {
-    if (meow_sound) {
+    if (meow_sound && !silent) {
         // Play on the first available channel
         meow_channel = Mix_PlayChannel(-1, meow_sound, 0);
     }
@@ -49,7 +50,7 @@ Mix_Chunk* audio_load_sound(const std::string& path) {
 }
 
 void audio_play_chunk(Mix_Chunk* chunk, int volume) {
-    if (!chunk) return;
+    if (!chunk || silent) return;
     int channel = Mix_PlayChannel(-1, chunk, 0);
     if (channel != -1) {
         Mix_Volume(channel, (volume * MIX_MAX_VOLUME) / 100);
@@ -57,4 +58,18 @@ void audio_play_chunk(Mix_Chunk* chunk, int volume) {
 }
 bool audio_is_playing() {
     return Mix_Playing(-1) > 0;
-}
\ No newline at end of file
+}
+
+void audio_set_silent(bool on) {
+    silent = on;
+    if (on) Mix_HaltChannel(-1);
+}
+
+unsigned int audio_chunk_ms(const Mix_Chunk* chunk) {
+    int freq = 0, channels = 0;
+    Uint16 format = 0;
+    if (!chunk || !Mix_QuerySpec(&freq, &format, &channels) || freq <= 0 || channels <= 0) return 0;
+    Uint32 frame_bytes = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+    if (frame_bytes == 0) return 0;
+    return (unsigned int)((Uint64)(chunk->alen / frame_bytes) * 1000 / freq);
+}
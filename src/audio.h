@@ -11,6 +11,10 @@ void audio_play_meow();
 void audio_stop_all();
 void audio_set_volume(int percent); // 0 to 100
 bool audio_is_playing();
+// While silent nothing starts on the mixer (offline export runs faster than real time)
+void audio_set_silent(bool on);
+// Playing time of a chunk at the opened mixer format; 0 if unknown
+unsigned int audio_chunk_ms(const Mix_Chunk* chunk);
 
 Mix_Chunk* audio_load_sound(const std::string& path);
 void audio_play_chunk(Mix_Chunk* chunk, int volume);
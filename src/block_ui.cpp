@@ -1,6 +1,9 @@
 #include "block_ui.h"
 #include "renderer.h"
+#include "geometry.h"
 #include "SDL_ttf.h"
+#include "text.h"
+#include "render_queue.h"
 #include <algorithm>
 #include <cstdio>
 #include <cstring>
@@ -11,9 +14,8 @@ static void draw_reporter_shape(SDL_Renderer *r, const SDL_Rect &br, Color col,
 
 static int text_w(TTF_Font *f, const char *txt)
 {
-    int w = 0, h = 0;
-    if (TTF_SizeUTF8(f, txt, &w, &h) != 0)
-        return 0;
+    int w = 0;
+    text_size(f, txt, &w, nullptr);
     return w;
 }
 
@@ -35,33 +37,18 @@ static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt,
         return;
 
     SDL_Color sc{(Uint8)c.r, (Uint8)c.g, (Uint8)c.b, 255};
-    SDL_Surface *surf = TTF_RenderUTF8_Blended(f, txt, sc);
-    if (!surf)
-        return;
-
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, surf);
-    if (!t)
-    {
-        SDL_FreeSurface(surf);
-        return;
-    }
-
-    SDL_Rect dst{x, y, surf->w, surf->h};
-    SDL_RenderCopy(r, t, nullptr, &dst);
-
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(surf);
+    text_draw(r, f, txt, x, y, sc);
 }
 
 /* ---------- caret ---------- */
 
 static void draw_caret(SDL_Renderer *r, int cx, int cy, Color c)
 {
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 200);
-    SDL_RenderDrawLine(r, cx - 4, cy - 2, cx, cy + 2);
-    SDL_RenderDrawLine(r, cx, cy + 2, cx + 4, cy - 2);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    rq_set_blend(r, SDL_BLENDMODE_BLEND);
+    rq_set_color(r, c.r, c.g, c.b, 200);
+    rq_draw_line(r, cx - 4, cy - 2, cx, cy + 2);
+    rq_draw_line(r, cx, cy + 2, cx + 4, cy - 2);
+    rq_set_blend(r, SDL_BLENDMODE_NONE);
 }
 
 /* ---------- base stack shape ---------- */
@@ -90,10 +77,10 @@ static void draw_input_capsule(SDL_Renderer *r, const SDL_Rect &rc,
 {
     renderer_fill_rounded_rect(r, &rc, rc.h / 2, 255, 255, 255);
 
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(r, 0, 0, 0, selected ? 80 : 45);
-    SDL_RenderDrawRect(r, &rc);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    rq_set_blend(r, SDL_BLENDMODE_BLEND);
+    rq_set_color(r, 0, 0, 0, selected ? 80 : 45);
+    rq_draw_rect(r, &rc);
+    rq_set_blend(r, SDL_BLENDMODE_NONE);
 }
 
 // Draw text clipped to the capsule bounds (prevents overflow)
@@ -101,8 +88,7 @@ static void draw_text_clipped(SDL_Renderer *r, TTF_Font *font, const char *text,
                               int tx, int ty, Color col, const SDL_Rect &clip)
 {
     SDL_Rect old_clip;
-    SDL_RenderGetClipRect(r, &old_clip);
-    bool clip_active = SDL_RenderIsClipEnabled(r);
+    bool clip_active = rq_get_clip(r, &old_clip);
 
     SDL_Rect new_clip = clip;
     // Intersect so we don't break out of the palette's master clip!
@@ -110,61 +96,24 @@ static void draw_text_clipped(SDL_Renderer *r, TTF_Font *font, const char *text,
         SDL_IntersectRect(&new_clip, &old_clip, &new_clip);
     }
     
-    SDL_RenderSetClipRect(r, &new_clip);
+    rq_set_clip(r, &new_clip);
     draw_text(r, font, text, tx, ty, col);
 
     // Safely restore the previous clip state
     if (clip_active) {
-        SDL_RenderSetClipRect(r, &old_clip);
+        rq_set_clip(r, &old_clip);
     } else {
-        SDL_RenderSetClipRect(r, nullptr);
+        rq_set_clip(r, nullptr);
     }
 }
 
 static void draw_dropdown_capsule(SDL_Renderer *r, const SDL_Rect &rc, Color base)
 {
     renderer_fill_rounded_rect(r, &rc, rc.h / 2, base.r, base.g, base.b);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(r, 0, 0, 0, 35);
-    SDL_RenderDrawRect(r, &rc);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
-}
-
-static void draw_stack_shape(SDL_Renderer *r, const SDL_Rect &br,
-                             Color col, Color panel_bg,
-                             bool ghost)
-{
-    MotionBlockMetrics m = motion_block_metrics();
-
-    float gk = ghost ? 0.75f : 1.0f;
-
-    Color border = shade(col, 0.80f * gk);
-    Color fill = shade(col, 1.00f * gk);
-
-    renderer_fill_rounded_rect(r, &br, m.radius, border.r, border.g, border.b);
-
-    SDL_Rect inner{br.x + 1, br.y + 1, br.w - 2, br.h - 2};
-    renderer_fill_rounded_rect(r, &inner, std::max(0, m.radius - 1), fill.r, fill.g, fill.b);
-
-    SDL_Rect topCut{
-        br.x + m.notch_x,
-        br.y,
-        m.notch_w,
-        m.notch_h};
-    renderer_fill_rounded_rect(r, &topCut, m.notch_h / 2, panel_bg.r, panel_bg.g, panel_bg.b);
-
-    SDL_Rect botCut{
-        br.x + m.notch_x,
-        br.y + br.h - m.notch_h,
-        m.notch_w,
-        m.notch_h};
-    renderer_fill_rounded_rect(r, &botCut, m.notch_h / 2, panel_bg.r, panel_bg.g, panel_bg.b);
-
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(r, 0, 0, 0, ghost ? 18 : 22);
-    SDL_Rect sh{topCut.x, topCut.y + 1, topCut.w, 2};
-    SDL_RenderFillRect(r, &sh);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    rq_set_blend(r, SDL_BLENDMODE_BLEND);
+    rq_set_color(r, 0, 0, 0, 35);
+    rq_draw_rect(r, &rc);
+    rq_set_blend(r, SDL_BLENDMODE_NONE);
 }
 
 static void draw_stack_shape_custom(SDL_Renderer *r, const SDL_Rect &br,
@@ -179,36 +128,20 @@ static void draw_stack_shape_custom(SDL_Renderer *r, const SDL_Rect &br,
     Color border = shade(col, 0.80f * gk);
     Color fill = shade(col, 1.00f * gk);
 
-    renderer_fill_rounded_rect(r, &br, m.radius, border.r, border.g, border.b);
-
-    SDL_Rect inner{br.x + 1, br.y + 1, br.w - 2, br.h - 2};
-    renderer_fill_rounded_rect(r, &inner, std::max(0, m.radius - 1), fill.r, fill.g, fill.b);
-
-    if (top_notch)
-    {
-        SDL_Rect topCut{
-            br.x + m.notch_x,
-            br.y,
-            m.notch_w,
-            m.notch_h};
-        renderer_fill_rounded_rect(r, &topCut, m.notch_h / 2, panel_bg.r, panel_bg.g, panel_bg.b);
-
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-        SDL_SetRenderDrawColor(r, 0, 0, 0, ghost ? 18 : 22);
-        SDL_Rect sh{topCut.x, topCut.y + 1, topCut.w, 2};
-        SDL_RenderFillRect(r, &sh);
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
-    }
+    BlockOutline o = {m.radius, m.notch_x, m.notch_w, m.notch_h, top_notch, bottom_notch};
+    SDL_Color slots[SLOT_COUNT] = {
+        {(Uint8)border.r, (Uint8)border.g, (Uint8)border.b, 255},
+        {(Uint8)fill.r, (Uint8)fill.g, (Uint8)fill.b, 255},
+        {(Uint8)panel_bg.r, (Uint8)panel_bg.g, (Uint8)panel_bg.b, 255},
+        {0, 0, 0, (Uint8)(ghost ? 18 : 22)}};
+    geometry_fill_block(r, br, o, slots);
+}
 
-    if (bottom_notch)
-    {
-        SDL_Rect botCut{
-            br.x + m.notch_x,
-            br.y + br.h - m.notch_h,
-            m.notch_w,
-            m.notch_h};
-        renderer_fill_rounded_rect(r, &botCut, m.notch_h / 2, panel_bg.r, panel_bg.g, panel_bg.b);
-    }
+static void draw_stack_shape(SDL_Renderer *r, const SDL_Rect &br,
+                             Color col, Color panel_bg,
+                             bool ghost)
+{
+    draw_stack_shape_custom(r, br, col, panel_bg, ghost, true, true);
 }
 
 /* ---------------- Motion ---------------- */
@@ -1288,50 +1221,9 @@ static void draw_boolean_shape(SDL_Renderer *r, const SDL_Rect &br, Color col, b
     float gk = ghost ? 0.75f : 1.0f;
     Color border = shade(col, 0.80f * gk);
     Color fill = shade(col, 1.00f * gk);
-    int point_w = br.h / 2;
-    SDL_Rect center{br.x + point_w, br.y, br.w - 2 * point_w, br.h};
-    SDL_Rect center_b{center.x - 1, center.y, center.w + 2, center.h};
-    SDL_SetRenderDrawColor(r, border.r, border.g, border.b, 255);
-    SDL_RenderFillRect(r, &center_b);
-    SDL_Rect center_f{center.x, center.y + 1, center.w, center.h - 2};
-    SDL_SetRenderDrawColor(r, fill.r, fill.g, fill.b, 255);
-    SDL_RenderFillRect(r, &center_f);
-    int mid_y = br.y + br.h / 2;
-    int left_x = br.x;
-    int right_of_left = br.x + point_w;
-    for (int row = 0; row < br.h; row++)
-    {
-        int y_pos = br.y + row;
-        int dist = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        float ratio = (float)dist / (float)(br.h / 2);
-        int x_start = right_of_left - (int)(ratio * point_w);
-        SDL_SetRenderDrawColor(r, border.r, border.g, border.b, 255);
-        SDL_RenderDrawLine(r, x_start, y_pos, right_of_left, y_pos);
-        if (row > 0 && row < br.h - 1)
-        {
-            SDL_SetRenderDrawColor(r, fill.r, fill.g, fill.b, 255);
-            SDL_RenderDrawLine(r, x_start + 1, y_pos, right_of_left, y_pos);
-        }
-    }
-    int left_of_right = br.x + br.w - point_w;
-    int right_x = br.x + br.w;
-    for (int row = 0; row < br.h; row++)
-    {
-        int y_pos = br.y + row;
-        int dist = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        float ratio = (float)dist / (float)(br.h / 2);
-        int x_end = left_of_right + (int)(ratio * point_w);
-        SDL_SetRenderDrawColor(r, border.r, border.g, border.b, 255);
-        SDL_RenderDrawLine(r, left_of_right, y_pos, x_end, y_pos);
-        if (row > 0 && row < br.h - 1)
-        {
-            SDL_SetRenderDrawColor(r, fill.r, fill.g, fill.b, 255);
-            SDL_RenderDrawLine(r, left_of_right, y_pos, x_end - 1, y_pos);
-        }
-    }
-    (void)mid_y;
-    (void)left_x;
-    (void)right_x;
+    geometry_fill_hexagon(r, br, {(Uint8)border.r, (Uint8)border.g, (Uint8)border.b, 255});
+    SDL_Rect inner{br.x + 1, br.y + 1, br.w - 2, br.h - 2};
+    geometry_fill_hexagon(r, inner, {(Uint8)fill.r, (Uint8)fill.g, (Uint8)fill.b, 255});
 }
 
 int sensing_block_width(SensingBlockType type)
@@ -1520,50 +1412,9 @@ static void draw_boolean_shape(SDL_Renderer *r, const SDL_Rect &br, Color col, C
     float gk = ghost ? 0.75f : 1.0f;
     Color border = shade(col, 0.80f * gk);
     Color fill = shade(col, 1.00f * gk);
-    int arrow = br.h / 2;
-
-    SDL_Rect mid_b = {br.x + arrow, br.y, br.w - 2 * arrow, br.h};
-    SDL_SetRenderDrawColor(r, border.r, border.g, border.b, 255);
-    SDL_RenderFillRect(r, &mid_b);
-
-    int cx_l = br.x + arrow;
-    int cy_m = br.y + br.h / 2;
-    for (int row = 0; row < br.h; ++row)
-    {
-        int y = br.y + row;
-        int half = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        int x0 = cx_l - half;
-        SDL_RenderDrawLine(r, x0, y, cx_l, y);
-    }
-    int cx_r = br.x + br.w - arrow;
-    for (int row = 0; row < br.h; ++row)
-    {
-        int y = br.y + row;
-        int half = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        int x1 = cx_r + half;
-        SDL_RenderDrawLine(r, cx_r, y, x1, y);
-    }
-
-    SDL_Rect mid_f = {br.x + arrow + 1, br.y + 1, br.w - 2 * arrow - 2, br.h - 2};
-    SDL_SetRenderDrawColor(r, fill.r, fill.g, fill.b, 255);
-    SDL_RenderFillRect(r, &mid_f);
-
-    for (int row = 1; row < br.h - 1; ++row)
-    {
-        int y = br.y + row;
-        int half = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        int x0 = cx_l - half + 1;
-        SDL_SetRenderDrawColor(r, fill.r, fill.g, fill.b, 255);
-        SDL_RenderDrawLine(r, x0, y, cx_l, y);
-    }
-    for (int row = 1; row < br.h - 1; ++row)
-    {
-        int y = br.y + row;
-        int half = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        int x1 = cx_r + half - 1;
-        SDL_SetRenderDrawColor(r, fill.r, fill.g, fill.b, 255);
-        SDL_RenderDrawLine(r, cx_r, y, x1, y);
-    }
+    geometry_fill_hexagon(r, br, {(Uint8)border.r, (Uint8)border.g, (Uint8)border.b, 255});
+    SDL_Rect inner{br.x + 1, br.y + 1, br.w - 2, br.h - 2};
+    geometry_fill_hexagon(r, inner, {(Uint8)fill.r, (Uint8)fill.g, (Uint8)fill.b, 255});
 }
 
 int sensing_boolean_block_width(SensingBlockType type)
@@ -1627,10 +1478,10 @@ void sensing_boolean_block_draw(SDL_Renderer *r, TTF_Font *font,
     {
         SDL_Rect cap = input_capsule_rect(cur_x, cap_y, 32, cap_h);
         renderer_fill_rounded_rect(r, &cap, cap.h / 2, col_r, col_g, col_b);
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-        SDL_SetRenderDrawColor(r, 0, 0, 0, 50);
-        SDL_RenderDrawRect(r, &cap);
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+        rq_set_blend(r, SDL_BLENDMODE_BLEND);
+        rq_set_color(r, 0, 0, 0, 50);
+        rq_draw_rect(r, &cap);
+        rq_set_blend(r, SDL_BLENDMODE_NONE);
         cur_x += 38;
     };
 
@@ -1856,34 +1707,13 @@ static void draw_c_shape_native(SDL_Renderer *r, int x, int y, int w, int top_h,
     int spine_w = 16;
     MotionBlockMetrics m = motion_block_metrics();
 
-    SDL_Rect top = {x, y, w, top_h};
-    renderer_fill_rounded_rect(r, &top, 4, border.r, border.g, border.b);
-    SDL_Rect topF = {x + 1, y + 1, w - 2, top_h - 2};
-    renderer_fill_rounded_rect(r, &topF, 4, fill.r, fill.g, fill.b);
-
-    SDL_Rect spine = {x, y + top_h - 4, spine_w, inner_h + 8};
-    SDL_SetRenderDrawColor(r, fill.r, fill.g, fill.b, 255);
-    SDL_RenderFillRect(r, &spine);
-    SDL_SetRenderDrawColor(r, border.r, border.g, border.b, 255);
-    SDL_RenderDrawLine(r, x, spine.y, x, spine.y + spine.h);
-
-    SDL_Rect bot = {x, y + top_h + inner_h, w, bottom_h};
-    renderer_fill_rounded_rect(r, &bot, 4, border.r, border.g, border.b);
-    SDL_Rect botF = {x + 1, y + top_h + inner_h + 1, w - 2, bottom_h - 2};
-    renderer_fill_rounded_rect(r, &botF, 4, fill.r, fill.g, fill.b);
-
-    if (has_top_notch)
-    {
-        SDL_Rect tc = {x + m.notch_x, y, m.notch_w, m.notch_h};
-        renderer_fill_rounded_rect(r, &tc, m.notch_h / 2, bg.r, bg.g, bg.b);
-    }
-    if (has_bottom_notch)
-    {
-        SDL_Rect bc = {x + m.notch_x, bot.y + bot.h - m.notch_h, m.notch_w, m.notch_h};
-        renderer_fill_rounded_rect(r, &bc, m.notch_h / 2, bg.r, bg.g, bg.b);
-    }
-    SDL_Rect ic = {x + spine_w + m.notch_x, y + top_h - m.notch_h, m.notch_w, m.notch_h};
-    renderer_fill_rounded_rect(r, &ic, m.notch_h / 2, fill.r, fill.g, fill.b);
+    BlockOutline o = {4, m.notch_x, m.notch_w, m.notch_h, has_top_notch, has_bottom_notch};
+    SDL_Color slots[SLOT_COUNT] = {
+        {(Uint8)border.r, (Uint8)border.g, (Uint8)border.b, 255},
+        {(Uint8)fill.r, (Uint8)fill.g, (Uint8)fill.b, 255},
+        {(Uint8)bg.r, (Uint8)bg.g, (Uint8)bg.b, 255},
+        {0, 0, 0, 0}};
+    geometry_fill_c_block(r, x, y, w, top_h, inner_h, bottom_h, spine_w, o, slots);
 }
 
 int control_block_width(ControlBlockType type)
@@ -1931,28 +1761,11 @@ static void draw_hex_slot(SDL_Renderer *r, int cx, int cy, Color base_col, bool
     Color hole_col = shade(base_col, 0.70f);
     int arrow = br.h / 2;
     SDL_Rect mid = {br.x + arrow, br.y, br.w - 2 * arrow, br.h};
-    SDL_SetRenderDrawColor(r, hole_col.r, hole_col.g, hole_col.b, 255);
-    SDL_RenderFillRect(r, &mid);
-    int cx_l = br.x + arrow;
-    for (int row = 0; row < br.h; ++row)
-    {
-        int y = br.y + row;
-        int half = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        int x0 = cx_l - half;
-        SDL_RenderDrawLine(r, x0, y, cx_l, y);
-    }
-    int cx_r = br.x + br.w - arrow;
-    for (int row = 0; row < br.h; ++row)
-    {
-        int y = br.y + row;
-        int half = (row <= br.h / 2) ? row : (br.h - 1 - row);
-        int x1 = cx_r + half;
-        SDL_RenderDrawLine(r, cx_r, y, x1, y);
-    }
-    SDL_SetRenderDrawColor(r, 0, 0, 0, 40);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-    SDL_RenderDrawLine(r, mid.x - 5, mid.y, mid.x + mid.w + 5, mid.y);
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    geometry_fill_hexagon(r, br, {(Uint8)hole_col.r, (Uint8)hole_col.g, (Uint8)hole_col.b, 255});
+    rq_set_color(r, 0, 0, 0, 40);
+    rq_set_blend(r, SDL_BLENDMODE_BLEND);
+    rq_draw_line(r, mid.x - 5, mid.y, mid.x + mid.w + 5, mid.y);
+    rq_set_blend(r, SDL_BLENDMODE_NONE);
 }
 
 void control_block_draw(SDL_Renderer *r, TTF_Font *font, ControlBlockType type, int x, int y, int inner1_h, int inner2_h, int a, bool has_condition, bool ghost, Color panel_bg, int selected_field, const char *override_field0_text)
@@ -2939,10 +2752,10 @@ void pen_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
             c = {sc.r, sc.g, sc.b};
         }
         renderer_fill_rounded_rect(r, &cap, cap.h / 2, c.r, c.g, c.b);
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-        SDL_SetRenderDrawColor(r, 0, 0, 0, 50);
-        SDL_RenderDrawRect(r, &cap);
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+        rq_set_blend(r, SDL_BLENDMODE_BLEND);
+        rq_set_color(r, 0, 0, 0, 50);
+        rq_draw_rect(r, &cap);
+        rq_set_blend(r, SDL_BLENDMODE_NONE);
         cur_x += 46;
     };
 
@@ -3102,19 +2915,7 @@ SDL_Rect myblocks_define_block_rect(const AppState &state, const std::string &fu
 }
 
 static void draw_hex_capsule(SDL_Renderer *r, SDL_Rect rect, Color c) {
-    // ---> FIXED: Replaced c.a with 255 <---
-    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255); 
-    int h2 = rect.h / 2;
-    SDL_Rect mid = {rect.x + h2, rect.y, rect.w - rect.h, rect.h};
-    SDL_RenderFillRect(r, &mid);
-    for (int y = 0; y < h2; y++) {
-        // Left point
-        SDL_RenderDrawLine(r, rect.x + h2 - y, rect.y + y, rect.x + h2, rect.y + y);
-        SDL_RenderDrawLine(r, rect.x + h2 - y, rect.y + rect.h - 1 - y, rect.x + h2, rect.y + rect.h - 1 - y);
-        // Right point
-        SDL_RenderDrawLine(r, rect.x + rect.w - h2, rect.y + y, rect.x + rect.w - h2 + y, rect.y + y);
-        SDL_RenderDrawLine(r, rect.x + rect.w - h2, rect.y + rect.h - 1 - y, rect.x + rect.w - h2 + y, rect.y + rect.h - 1 - y);
-    }
+    geometry_fill_hexagon(r, rect, {(Uint8)c.r, (Uint8)c.g, (Uint8)c.b, 255});
 }
 void myblocks_define_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const std::string &func_name, int x, int y, bool ghost) {
     SDL_Rect br = myblocks_define_block_rect(state, func_name, x, y);
@@ -3129,27 +2930,11 @@ void myblocks_define_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState
     SDL_Color wc = {255, 255, 255, (Uint8)(ghost ? 128 : 255)};
     
     if (font) {
-        SDL_Surface *sf = TTF_RenderUTF8_Blended(font, "define", wc);
-        if (sf) {
-            SDL_Texture *tx = SDL_CreateTextureFromSurface(r, sf);
-            SDL_Rect dr = {cur_x, text_y, sf->w, sf->h};
-            SDL_RenderCopy(r, tx, NULL, &dr);
-            cur_x += sf->w + 8;
-            SDL_DestroyTexture(tx);
-            SDL_FreeSurface(sf);
-        }
+        cur_x += text_draw(r, font, "define", cur_x, text_y, wc) + 8;
     } else cur_x += 48;
 
     if (font) {
-        SDL_Surface *sf = TTF_RenderUTF8_Blended(font, func_name.c_str(), wc);
-        if (sf) {
-            SDL_Texture *tx = SDL_CreateTextureFromSurface(r, sf);
-            SDL_Rect dr = {cur_x, text_y, sf->w, sf->h};
-            SDL_RenderCopy(r, tx, NULL, &dr);
-            cur_x += sf->w + 12;
-            SDL_DestroyTexture(tx);
-            SDL_FreeSurface(sf);
-        }
+        cur_x += text_draw(r, font, func_name.c_str(), cur_x, text_y, wc) + 12;
     } else cur_x += func_name.length() * 8 + 12;
 
     const CustomFunctionDef *def = myblocks_find_def(state, func_name);
@@ -3166,14 +2951,9 @@ void myblocks_define_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState
 
             if (font) {
                 SDL_Color lc = {255, 255, 255, 255};
-                SDL_Surface *sf = TTF_RenderUTF8_Blended(font, p.name.c_str(), lc);
-                if (sf) {
-                    SDL_Texture *tx = SDL_CreateTextureFromSurface(r, sf);
-                    SDL_Rect dr = {param_pill.x + (param_pill.w - sf->w) / 2, param_pill.y + (param_pill.h - sf->h) / 2, sf->w, sf->h};
-                    SDL_RenderCopy(r, tx, NULL, &dr);
-                    SDL_DestroyTexture(tx);
-                    SDL_FreeSurface(sf);
-                }
+                int lw = 0, lh = 0;
+                text_size(font, p.name.c_str(), &lw, &lh);
+                text_draw(r, font, p.name.c_str(), param_pill.x + (param_pill.w - lw) / 2, param_pill.y + (param_pill.h - lh) / 2, lc);
             }
             cur_x += param_pw + 6;
         }
@@ -3241,14 +3021,7 @@ void myblocks_call_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState &s
 
     if (font && !func_name.empty()) {
         int label_w = text_w(font, func_name.c_str());
-        SDL_Surface *sf = TTF_RenderUTF8_Blended(font, func_name.c_str(), wc);
-        if (sf) {
-            SDL_Texture *tx = SDL_CreateTextureFromSurface(r, sf);
-            SDL_Rect dr = {cur_x, text_y, sf->w, sf->h};
-            SDL_RenderCopy(r, tx, NULL, &dr);
-            SDL_DestroyTexture(tx);
-            SDL_FreeSurface(sf);
-        }
+        text_draw(r, font, func_name.c_str(), cur_x, text_y, wc);
         cur_x += label_w + 8;
     }
 
@@ -3258,15 +3031,7 @@ void myblocks_call_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState &s
             const auto &p = def->params[pi];
             std::string lbl = p.name + ":";
             if (font) {
-                SDL_Surface *lsf = TTF_RenderUTF8_Blended(font, lbl.c_str(), wc);
-                if (lsf) {
-                    SDL_Texture *ltx = SDL_CreateTextureFromSurface(r, lsf);
-                    SDL_Rect ldr = {cur_x, text_y, lsf->w, lsf->h};
-                    SDL_RenderCopy(r, ltx, NULL, &ldr);
-                    SDL_DestroyTexture(ltx);
-                    cur_x += lsf->w + 4;
-                    SDL_FreeSurface(lsf);
-                }
+                cur_x += text_draw(r, font, lbl.c_str(), cur_x, text_y, wc) + 4;
             }
             int param_tw = font ? text_w(font, p.name.c_str()) : (int)p.name.size() * 8;
             int ew = (pi == 0) ? ew0 : (pi == 1 ? ew1 : ew2);
@@ -3285,10 +3050,10 @@ void myblocks_call_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState &s
             } else if (p.type == CPARAM_NUMBER) {
                 draw_input_capsule(r, cap, focused);
             } else {
-                SDL_SetRenderDrawColor(r, fr, fg, fb, 255);
-                SDL_RenderFillRect(r, &cap);
-                SDL_SetRenderDrawColor(r, 160, 160, 160, 255);
-                SDL_RenderDrawRect(r, &cap);
+                rq_set_color(r, fr, fg, fb, 255);
+                rq_fill_rect(r, &cap);
+                rq_set_color(r, 160, 160, 160, 255);
+                rq_draw_rect(r, &cap);
             }
 
             const char *val = ovs[pi];
@@ -3298,31 +3063,24 @@ void myblocks_call_block_draw(SDL_Renderer *r, TTF_Font *font, const AppState &s
             // ---> ONLY DRAW TEXT IF IT'S NOT A BOOLEAN AND NO BLOCK IS SNAPPED IN <---
             if (font && p.type != CPARAM_BOOLEAN && !has_child) {
                 SDL_Color dc = {40, 40, 40, 255};
-                SDL_Surface *sf = TTF_RenderUTF8_Blended(font, val, dc);
-                if (sf) {
-                    SDL_Texture *tx = SDL_CreateTextureFromSurface(r, sf);
-                    
+                int tw2 = 0, th2 = 0;
+                text_size(font, val, &tw2, &th2);
+                {
                     // Safely combine with the Palette's clip rect
                     SDL_Rect old_clip;
-                    SDL_RenderGetClipRect(r, &old_clip);
-                    bool clip_active = SDL_RenderIsClipEnabled(r);
+                    bool clip_active = rq_get_clip(r, &old_clip);
 
                     SDL_Rect new_clip = cap;
                     if (clip_active) SDL_IntersectRect(&new_clip, &old_clip, &new_clip);
 
-                    SDL_RenderSetClipRect(r, &new_clip);
+                    rq_set_clip(r, &new_clip);
                     
-                    int tw2 = sf->w;
                     int tx2 = (tw2 <= cap.w - 10) ? (cap.x + (cap.w - tw2) / 2) : (cap.x + 6);
-                    SDL_Rect dr = {tx2, cap.y + (cap.h - sf->h) / 2, sf->w, sf->h};
-                    SDL_RenderCopy(r, tx, NULL, &dr);
+                    text_draw(r, font, val, tx2, cap.y + (cap.h - th2) / 2, dc);
                     
                     // Safely restore the Palette's clip rect
-                    if (clip_active) SDL_RenderSetClipRect(r, &old_clip);
-                    else SDL_RenderSetClipRect(r, nullptr);
-                    
-                    SDL_DestroyTexture(tx);
-                    SDL_FreeSurface(sf);
+                    if (clip_active) rq_set_clip(r, &old_clip);
+                    else rq_set_clip(r, nullptr);
                 }
             }
             cur_x += cap_w + 6;
@@ -3383,13 +3141,8 @@ void myblocks_param_block_draw(SDL_Renderer *r, TTF_Font *font, const std::strin
 
     if (font) {
         SDL_Color wc = {255, 255, 255, (Uint8)(ghost ? 128 : 255)};
-        SDL_Surface *sf = TTF_RenderUTF8_Blended(font, param_name.c_str(), wc);
-        if (sf) {
-            SDL_Texture *tx = SDL_CreateTextureFromSurface(r, sf);
-            SDL_Rect dr = {br.x + (br.w - sf->w)/2, br.y + (br.h - sf->h)/2, sf->w, sf->h};
-            SDL_RenderCopy(r, tx, NULL, &dr);
-            SDL_DestroyTexture(tx);
-            SDL_FreeSurface(sf);
-        }
+        int lw = 0, lh = 0;
+        text_size(font, param_name.c_str(), &lw, &lh);
+        text_draw(r, font, param_name.c_str(), br.x + (br.w - lw)/2, br.y + (br.h - lh)/2, wc);
     }
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "canvas.h"
 #include "config.h"
 #include "workspace.h"
+#include "render_queue.h"
+#include <cmath>
 
 static bool point_in_rect(int px, int py, const SDL_Rect &r)
 {
@@ -9,7 +11,7 @@ static bool point_in_rect(int px, int py, const SDL_Rect &r)
 
 static void set_color(SDL_Renderer *r, Color c)
 {
-    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255);
+    rq_set_color(r, c.r, c.g, c.b, 255);
 }
 
 void canvas_layout(CanvasRects &rects)
@@ -28,15 +30,20 @@ void canvas_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
                  const CanvasRects &rects, const Textures &tex)
 {
     set_color(r, COL_CANVAS_BG);
-    SDL_RenderFillRect(r, &rects.panel);
+    rq_fill_rect(r, &rects.panel);
 
     set_color(r, COL_CANVAS_GRID);
-    int spacing = 30;
-    for (int x = rects.panel.x; x < rects.panel.x + rects.panel.w; x += spacing) {
-        SDL_RenderDrawLine(r, x, rects.panel.y, x, rects.panel.y + rects.panel.h);
+    // The grid is anchored in workspace coordinates so it moves with the camera
+    float spacing = 30 * state.ws_zoom;
+    float gx = (rects.panel.x - std::floor(state.ws_cam_x)) * state.ws_zoom;
+    float gy = (rects.panel.y - std::floor(state.ws_cam_y)) * state.ws_zoom;
+    gx -= std::floor((gx - rects.panel.x) / spacing) * spacing;
+    gy -= std::floor((gy - rects.panel.y) / spacing) * spacing;
+    for (float x = gx; x < rects.panel.x + rects.panel.w; x += spacing) {
+        rq_draw_line(r, (int)x, rects.panel.y, (int)x, rects.panel.y + rects.panel.h);
     }
-    for (int y = rects.panel.y; y < rects.panel.y + rects.panel.h; y += spacing) {
-        SDL_RenderDrawLine(r, rects.panel.x, y, rects.panel.x + rects.panel.w, y);
+    for (float y = gy; y < rects.panel.y + rects.panel.h; y += spacing) {
+        rq_draw_line(r, rects.panel.x, (int)y, rects.panel.x + rects.panel.w, (int)y);
     }
 
     workspace_draw(r, font, tex, state, rects.panel, COL_CANVAS_BG);
@@ -2,6 +2,8 @@
 #include "config.h"
 #include "blocks.h"
 #include "renderer.h"
+#include "text.h"
+#include "render_queue.h"
 
 static bool point_in_rect(int px, int py, const SDL_Rect &r)
 {
@@ -10,7 +12,7 @@ static bool point_in_rect(int px, int py, const SDL_Rect &r)
 
 static void set_color(SDL_Renderer *r, Color c)
 {
-    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255);
+    rq_set_color(r, c.r, c.g, c.b, 255);
 }
 
 static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt,
@@ -18,14 +20,7 @@ static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt,
 {
     SDL_Color sc;
     sc.r = c.r; sc.g = c.g; sc.b = c.b; sc.a = 255;
-    SDL_Surface *s = TTF_RenderUTF8_Blended(f, txt, sc);
-    if (!s) return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst;
-    dst.x = x; dst.y = y; dst.w = s->w; dst.h = s->h;
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    text_draw(r, f, txt, x, y, sc);
 }
 
 void categories_layout(CategoriesRects &rects)
@@ -66,11 +61,11 @@ void categories_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
                      const CategoriesRects &rects)
 {
     set_color(r, COL_CAT_BG);
-    SDL_RenderFillRect(r, &rects.panel);
+    rq_fill_rect(r, &rects.panel);
 
     /* right border */
     set_color(r, COL_SEPARATOR);
-    SDL_RenderDrawLine(r, rects.panel.x + rects.panel.w - 1, rects.panel.y,
+    rq_draw_line(r, rects.panel.x + rects.panel.w - 1, rects.panel.y,
                        rects.panel.x + rects.panel.w - 1,
                        rects.panel.y + rects.panel.h);
 
@@ -82,7 +77,7 @@ void categories_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
 
         if (sel) {
             set_color(r, COL_CAT_SELECTED_BG);
-            SDL_RenderFillRect(r, &rects.items[i]);
+            rq_fill_rect(r, &rects.items[i]);
         }
 
         /* dot */
@@ -100,11 +95,11 @@ void categories_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
     }
 
     // Draw Extension Button (Blue Background)
-    SDL_SetRenderDrawColor(r, 76, 151, 255, 255); 
-    SDL_RenderFillRect(r, &rects.ext_btn);
+    rq_set_color(r, 76, 151, 255, 255); 
+    rq_fill_rect(r, &rects.ext_btn);
     
     // ---> FIXED: PERFECTLY CENTERED PLUS SIGN <---
-    SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
+    rq_set_color(r, 255, 255, 255, 255);
     
     int center_x = rects.ext_btn.x + rects.ext_btn.w / 2;
     int center_y = rects.ext_btn.y + rects.ext_btn.h / 2;
@@ -114,8 +109,8 @@ void categories_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
     SDL_Rect plus_v = { center_x - thickness / 2, center_y - length / 2, thickness, length };
     SDL_Rect plus_h = { center_x - length / 2, center_y - thickness / 2, length, thickness };
     
-    SDL_RenderFillRect(r, &plus_v);
-    SDL_RenderFillRect(r, &plus_h);
+    rq_fill_rect(r, &plus_v);
+    rq_fill_rect(r, &plus_h);
 }
 
 bool categories_handle_event(const SDL_Event &e, AppState &state,
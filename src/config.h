@@ -13,6 +13,14 @@ static const int CATEGORY_WIDTH       = 120;
 static const int PALETTE_WIDTH        = 430;
 static const int STAGE_HEIGHT_RATIO   = 40;   /* percent of right column */
 
+/* Stage units: sprites, pen and sensing all work on a 480x360 stage */
+static const int STAGE_WIDTH          = 480;
+static const int STAGE_HEIGHT         = 360;
+
+/* Fixed simulation rate; SIM_HZ in the environment overrides it */
+static const int SIM_HZ_DEFAULT       = 30;
+static const int SIM_MAX_CATCHUP      = 4;    /* steps per frame before the simulation slows down instead */
+
 /* Navbar */
 static const int NAVBAR_LOGO_SIZE = 70;
 static const int NAVBAR_LOGO_WIDTH  = 100;
@@ -0,0 +1,220 @@
+#include "costume_undo.h"
+#include "paint_layer.h"
+#include <cstdlib>
+#include <deque>
+#include <utility>
+
+struct UndoStep
+{
+    bool on_stage;
+    int sprite, costume; // same addressing the editor uses
+
+    std::vector<PaintTileBackup> tiles;
+    bool has_shapes;
+    std::vector<GraphicShape> shapes;
+    bool has_flips;
+    bool flip_h, flip_v;
+
+    size_t bytes;
+};
+
+static std::deque<UndoStep> g_undo;
+static std::vector<UndoStep> g_redo;
+static UndoStep g_open;
+static bool g_open_active = false;
+static bool g_open_had_layer = false;
+static PaintLayer *g_open_layer = nullptr; // layer journaling into g_open.tiles
+static size_t g_history_bytes = 0;
+static size_t g_cap_bytes = 0;
+
+static size_t undo_cap()
+{
+    if (g_cap_bytes == 0)
+    {
+        const char *mb = std::getenv("UNDO_MEMORY_MB");
+        long v = mb ? std::atol(mb) : 0;
+        g_cap_bytes = (size_t)(v > 0 ? v : 64) * 1024 * 1024;
+    }
+    return g_cap_bytes;
+}
+
+static size_t step_bytes(const UndoStep &st)
+{
+    size_t n = sizeof(UndoStep);
+    for (const auto &t : st.tiles)
+        n += sizeof(PaintTileBackup) + t.data.size() * sizeof(Uint32);
+    for (const auto &sh : st.shapes)
+        n += sizeof(GraphicShape) + sh.text.size();
+    return n;
+}
+
+static bool same_shapes(const std::vector<GraphicShape> &a, const std::vector<GraphicShape> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        const GraphicShape &x = a[i], &y = b[i];
+        if (x.type != y.type || x.text != y.text ||
+            x.rect.x != y.rect.x || x.rect.y != y.rect.y || x.rect.w != y.rect.w || x.rect.h != y.rect.h ||
+            x.color.r != y.color.r || x.color.g != y.color.g || x.color.b != y.color.b || x.color.a != y.color.a)
+            return false;
+    }
+    return true;
+}
+
+static GraphicItem *resolve(AppState &state, bool on_stage, int sprite, int costume)
+{
+    if (on_stage)
+        return (sprite >= 0 && sprite < (int)state.backdrops.size()) ? &state.backdrops[sprite] : nullptr;
+    if (sprite < 0 || sprite >= (int)state.sprites.size())
+        return nullptr;
+    Sprite &spr = state.sprites[sprite];
+    return (costume >= 0 && costume < (int)spr.costumes.size()) ? &spr.costumes[costume] : nullptr;
+}
+
+static void drop_redo()
+{
+    for (const auto &st : g_redo)
+        g_history_bytes -= st.bytes;
+    g_redo.clear();
+}
+
+void costume_undo_begin(AppState &state)
+{
+    if (g_open_active)
+        costume_undo_commit(state);
+
+    g_open = UndoStep();
+    g_open.on_stage = state.editing_target_is_stage;
+    g_open.sprite = state.editing_target_is_stage ? state.selected_backdrop : state.selected_sprite;
+    g_open.costume = -1;
+    if (!g_open.on_stage && g_open.sprite >= 0 && g_open.sprite < (int)state.sprites.size())
+        g_open.costume = state.sprites[g_open.sprite].selected_costume;
+
+    GraphicItem *item = resolve(state, g_open.on_stage, g_open.sprite, g_open.costume);
+    if (!item)
+        return;
+
+    g_open.shapes = item->shapes;
+    g_open.flip_h = item->flip_h;
+    g_open.flip_v = item->flip_v;
+    g_open_had_layer = item->paint_layer != nullptr;
+    g_open_layer = item->paint_layer;
+    if (g_open_layer)
+        paint_layer_begin_journal(g_open_layer, &g_open.tiles);
+    g_open_active = true;
+}
+
+void costume_undo_commit(AppState &state)
+{
+    if (!g_open_active)
+        return;
+    g_open_active = false;
+    paint_layer_end_journal(g_open_layer);
+    g_open_layer = nullptr;
+
+    GraphicItem *item = resolve(state, g_open.on_stage, g_open.sprite, g_open.costume);
+    if (!item)
+        return;
+
+    if (item->paint_layer && !g_open_had_layer)
+    {
+        // The layer was created during this step: every tile in it is new
+        for (size_t i = 0; i < item->paint_layer->tiles.size(); i++)
+            if (item->paint_layer->tiles[i])
+                g_open.tiles.push_back({(int)i, false, false, {}});
+    }
+
+    g_open.has_shapes = !same_shapes(g_open.shapes, item->shapes);
+    if (!g_open.has_shapes)
+        g_open.shapes.clear();
+    g_open.has_flips = g_open.flip_h != item->flip_h || g_open.flip_v != item->flip_v;
+
+    if (g_open.tiles.empty() && !g_open.has_shapes && !g_open.has_flips)
+        return;
+
+    drop_redo();
+    g_open.bytes = step_bytes(g_open);
+    g_history_bytes += g_open.bytes;
+    g_undo.push_back(std::move(g_open));
+
+    // Oldest steps go first, but the newest always survives
+    while (g_history_bytes > undo_cap() && g_undo.size() > 1)
+    {
+        g_history_bytes -= g_undo.front().bytes;
+        g_undo.pop_front();
+    }
+}
+
+// Swap the step's stored state with the item's live state, so the same step can go the other way
+static bool apply_step(AppState &state, UndoStep &st)
+{
+    GraphicItem *item = resolve(state, st.on_stage, st.sprite, st.costume);
+    if (!item)
+        return false;
+
+    if (!st.tiles.empty() && item->paint_layer)
+        paint_layer_swap_backups(item->paint_layer, st.tiles);
+    if (st.has_shapes)
+        std::swap(st.shapes, item->shapes);
+    if (st.has_flips)
+    {
+        std::swap(st.flip_h, item->flip_h);
+        std::swap(st.flip_v, item->flip_v);
+    }
+    item->version++;
+
+    g_history_bytes -= st.bytes;
+    st.bytes = step_bytes(st);
+    g_history_bytes += st.bytes;
+    state.active_shape_index = -1;
+    return true;
+}
+
+bool costume_undo(AppState &state)
+{
+    costume_undo_commit(state);
+    if (g_undo.empty())
+        return false;
+    UndoStep st = std::move(g_undo.back());
+    g_undo.pop_back();
+    if (!apply_step(state, st))
+    {
+        g_history_bytes -= st.bytes;
+        return false;
+    }
+    g_redo.push_back(std::move(st));
+    return true;
+}
+
+bool costume_redo(AppState &state)
+{
+    costume_undo_commit(state);
+    if (g_redo.empty())
+        return false;
+    UndoStep st = std::move(g_redo.back());
+    g_redo.pop_back();
+    if (!apply_step(state, st))
+    {
+        g_history_bytes -= st.bytes;
+        return false;
+    }
+    g_undo.push_back(std::move(st));
+    return true;
+}
+
+void costume_undo_clear()
+{
+    // Called before the items go away, so the journaling layer is still alive
+    if (g_open_active)
+    {
+        paint_layer_end_journal(g_open_layer);
+        g_open_layer = nullptr;
+        g_open_active = false;
+        g_open.tiles.clear();
+    }
+    g_undo.clear();
+    g_redo.clear();
+    g_history_bytes = 0;
+}
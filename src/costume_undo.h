@@ -0,0 +1,23 @@
+#ifndef COSTUME_UNDO_H
+#define COSTUME_UNDO_H
+
+#include "types.h"
+
+// ---> COSTUME EDITOR UNDO / REDO <---
+// A step covers one action on the costume/backdrop being edited. It keeps only
+// the paint tiles that action touched (RLE compressed unless that is larger), plus the shape list and
+// flips when those changed. History is capped by UNDO_MEMORY_MB (default 64).
+
+/* Open a step for the item currently shown in the costume editor */
+void costume_undo_begin(AppState &state);
+/* Close the open step; steps that changed nothing are dropped */
+void costume_undo_commit(AppState &state);
+
+bool costume_undo(AppState &state);
+bool costume_redo(AppState &state);
+
+/* Forget all history (project reset, or item indices shifting).
+   Call before the items are destroyed. */
+void costume_undo_clear();
+
+#endif
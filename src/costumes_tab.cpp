@@ -1,7 +1,13 @@
 #include "costumes_tab.h"
 #include "config.h"
 #include "renderer.h"
+#include "paint_layer.h"
+#include "costume_undo.h"
 #include "logger.h" // ---> Logger Integrated!
+#include "text.h"
+#include "render_queue.h"
+#include "perf_overlay.h"
+#include "trace.h"
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -25,27 +31,15 @@ static bool g_is_drawing = false;
 static void draw_text_centered(SDL_Renderer *r, TTF_Font *font, const char *txt, int cx, int cy, Uint8 cr, Uint8 cg, Uint8 cb)
 {
     SDL_Color col = {cr, cg, cb, 255};
-    SDL_Surface *s = TTF_RenderUTF8_Blended(font, txt, col);
-    if (!s)
-        return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst = {cx - s->w / 2, cy - s->h / 2, s->w, s->h};
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    int w = 0, h = 0;
+    text_size(font, txt, &w, &h);
+    text_draw(r, font, txt, cx - w / 2, cy - h / 2, col);
 }
 
 static void draw_text_left(SDL_Renderer *r, TTF_Font *font, const char *txt, int x, int y, Uint8 cr, Uint8 cg, Uint8 cb)
 {
     SDL_Color col = {cr, cg, cb, 255};
-    SDL_Surface *s = TTF_RenderUTF8_Blended(font, txt, col);
-    if (!s)
-        return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst = {x, y, s->w, s->h};
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    text_draw(r, font, txt, x, y, col);
 }
 
 static SDL_Rect get_normalized_rect(SDL_Rect r)
@@ -63,66 +57,109 @@ static SDL_Rect get_normalized_rect(SDL_Rect r)
     return r;
 }
 
-static void fill_circle_local(SDL_Renderer *r, int cx, int cy, int radius, bool erase, SDL_Color color)
+// ---> BRUSH STROKE QUEUE <---
+// Motion events only queue points; costumes_tab_flush_stroke() rasterizes them once per frame
+struct BrushStroke
 {
-    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
-    if (erase)
-    {
-        SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
-    }
-    else
-    {
-        SDL_SetRenderDrawColor(r, color.r, color.g, color.b, 255);
-    }
-    for (int dy = -radius; dy <= radius; ++dy)
-    {
-        int dx = 0;
-        while (dx * dx + dy * dy <= radius * radius)
-            ++dx;
-        --dx;
-        SDL_RenderDrawLine(r, cx - dx, cy + dy, cx + dx, cy + dy);
-    }
+    bool active;
+    bool on_stage;
+    int sprite, costume; // which GraphicItem, resolved again at flush time
+    SDL_Color color;
+    float radius; // hi-res pixels
+    bool erase;
+    std::vector<SDL_FPoint> pending; // raw cursor points, hi-res
+    SDL_FPoint ctrl;                 // last raw point
+    SDL_FPoint tail;                 // where the drawn curve currently ends
+    bool dot_pending;                // first point not yet stamped
+    bool finish;                     // mouse released, close the curve on the next flush
+};
+static BrushStroke g_stroke = {};
+
+static GraphicItem *stroke_target(AppState &state)
+{
+    if (g_stroke.on_stage)
+        return (g_stroke.sprite >= 0 && g_stroke.sprite < (int)state.backdrops.size()) ? &state.backdrops[g_stroke.sprite] : nullptr;
+    if (g_stroke.sprite < 0 || g_stroke.sprite >= (int)state.sprites.size())
+        return nullptr;
+    Sprite &spr = state.sprites[g_stroke.sprite];
+    return (g_stroke.costume >= 0 && g_stroke.costume < (int)spr.costumes.size()) ? &spr.costumes[g_stroke.costume] : nullptr;
 }
 
-static void draw_on_paint_layer(GraphicItem &item, SDL_Renderer *r, int x1, int y1, int x2, int y2, SDL_Color color, int size, bool erase)
+static void stroke_begin(AppState &state, int x, int y, SDL_Color color, int size, bool erase)
 {
-    if (!item.paint_layer)
-    {
-        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
-        item.paint_layer = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, RENDER_W, RENDER_H);
-        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
-
-        SDL_SetTextureBlendMode(item.paint_layer, SDL_BLENDMODE_BLEND);
-        SDL_SetRenderTarget(r, item.paint_layer);
-        SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
-        SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
-        SDL_RenderClear(r);
-    }
-    SDL_SetRenderTarget(r, item.paint_layer);
+    g_stroke.active = true;
+    g_stroke.on_stage = state.editing_target_is_stage;
+    g_stroke.sprite = state.editing_target_is_stage ? state.selected_backdrop : state.selected_sprite;
+    g_stroke.costume = state.editing_target_is_stage ? -1 : state.sprites[state.selected_sprite].selected_costume;
+    g_stroke.color = color;
+    g_stroke.radius = (float)(size * HIRES_MULT);
+    g_stroke.erase = erase;
+    g_stroke.pending.clear();
+    g_stroke.ctrl = g_stroke.tail = {(float)(x * HIRES_MULT), (float)(y * HIRES_MULT)};
+    g_stroke.dot_pending = true;
+    g_stroke.finish = false;
+    costume_undo_begin(state);
+}
 
-    int hx1 = x1 * HIRES_MULT, hy1 = y1 * HIRES_MULT;
-    int hx2 = x2 * HIRES_MULT, hy2 = y2 * HIRES_MULT;
-    int hsize = size * HIRES_MULT;
+static void stroke_add(int x, int y)
+{
+    if (g_stroke.active)
+        g_stroke.pending.push_back({(float)(x * HIRES_MULT), (float)(y * HIRES_MULT)});
+}
 
-    int dx = hx2 - hx1, dy = hy2 - hy1;
-    int steps = std::max(abs(dx), abs(dy));
-    if (steps == 0)
+// Quadratic from a to c bent towards b, flattened into capsules
+static void stroke_curve(PaintLayer *pl, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c)
+{
+    float span = std::fabs(a.x - b.x) + std::fabs(a.y - b.y) + std::fabs(b.x - c.x) + std::fabs(b.y - c.y);
+    int n = std::max(1, std::min(32, (int)(span / 16.0f)));
+    SDL_FPoint prev = a;
+    for (int i = 1; i <= n; i++)
     {
-        fill_circle_local(r, hx1, hy1, hsize, erase, color);
+        float t = i / (float)n, u = 1.0f - t;
+        SDL_FPoint p = {u * u * a.x + 2 * u * t * b.x + t * t * c.x, u * u * a.y + 2 * u * t * b.y + t * t * c.y};
+        paint_layer_fill_capsule(pl, prev.x, prev.y, p.x, p.y, g_stroke.radius, g_stroke.color, g_stroke.erase);
+        prev = p;
     }
-    else
+}
+
+void costumes_tab_flush_stroke(AppState &state)
+{
+    if (!g_stroke.active)
+        return;
+    if (!g_stroke.dot_pending && g_stroke.pending.empty() && !g_stroke.finish)
+        return;
+
+    GraphicItem *item = stroke_target(state);
+    if (item && !item->paint_layer && !g_stroke.erase)
+        item->paint_layer = paint_layer_create(RENDER_W, RENDER_H);
+
+    if (item && item->paint_layer)
     {
-        float x_inc = dx / (float)steps;
-        float y_inc = dy / (float)steps;
-        float cx = hx1, cy = hy1;
-        for (int i = 0; i <= steps; i++)
+        PaintLayer *pl = item->paint_layer;
+        if (g_stroke.dot_pending)
+            paint_layer_fill_capsule(pl, g_stroke.tail.x, g_stroke.tail.y, g_stroke.tail.x, g_stroke.tail.y, g_stroke.radius, g_stroke.color, g_stroke.erase);
+
+        // Midpoint smoothing: each raw point becomes the control of a curve
+        // that runs between the midpoints of its neighbouring segments
+        for (const SDL_FPoint &p : g_stroke.pending)
         {
-            fill_circle_local(r, (int)cx, (int)cy, hsize, erase, color);
-            cx += x_inc;
-            cy += y_inc;
+            SDL_FPoint mid = {(g_stroke.ctrl.x + p.x) * 0.5f, (g_stroke.ctrl.y + p.y) * 0.5f};
+            stroke_curve(pl, g_stroke.tail, g_stroke.ctrl, mid);
+            g_stroke.tail = mid;
+            g_stroke.ctrl = p;
         }
+        if (g_stroke.finish)
+            paint_layer_fill_capsule(pl, g_stroke.tail.x, g_stroke.tail.y, g_stroke.ctrl.x, g_stroke.ctrl.y, g_stroke.radius, g_stroke.color, g_stroke.erase);
+        item->version++;
+    }
+
+    g_stroke.pending.clear();
+    g_stroke.dot_pending = false;
+    if (g_stroke.finish)
+    {
+        g_stroke.active = false;
+        costume_undo_commit(state);
     }
-    SDL_SetRenderTarget(r, NULL);
 }
 
 void get_canvas_bounds(const GraphicItem &item, SDL_Rect canvas_rect, SDL_Rect &dst_out, float &scale_out)
@@ -136,6 +173,13 @@ void get_canvas_bounds(const GraphicItem &item, SDL_Rect canvas_rect, SDL_Rect &
 
 void update_composed_texture(GraphicItem &item, SDL_Renderer *r, TTF_Font *font)
 {
+    // Nothing changed since the last composition
+    bool stale = !item.composed_texture || item.composed_version != item.version;
+    perf_note_compose(stale);
+    if (!stale)
+        return;
+    TRACE_ZONE("compose costume");
+
     if (!item.composed_texture)
     {
         SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
@@ -146,8 +190,8 @@ void update_composed_texture(GraphicItem &item, SDL_Renderer *r, TTF_Font *font)
 
     SDL_SetRenderTarget(r, item.composed_texture);
     SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
-    SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
-    SDL_RenderClear(r);
+    rq_set_color(r, 0, 0, 0, 0);
+    rq_clear(r);
 
     SDL_RendererFlip flip = (SDL_RendererFlip)((item.flip_h ? SDL_FLIP_HORIZONTAL : 0) | (item.flip_v ? SDL_FLIP_VERTICAL : 0));
 
@@ -170,8 +214,8 @@ void update_composed_texture(GraphicItem &item, SDL_Renderer *r, TTF_Font *font)
 
     if (item.paint_layer)
     {
-        SDL_SetTextureBlendMode(item.paint_layer, SDL_BLENDMODE_BLEND);
-        SDL_RenderCopyEx(r, item.paint_layer, NULL, NULL, 0, NULL, flip);
+        paint_layer_upload(item.paint_layer, r);
+        paint_layer_draw(item.paint_layer, r, flip);
     }
 
     SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
@@ -201,8 +245,8 @@ void update_composed_texture(GraphicItem &item, SDL_Renderer *r, TTF_Font *font)
 
         if (sh.type == SHAPE_RECT)
         {
-            SDL_SetRenderDrawColor(r, sh.color.r, sh.color.g, sh.color.b, 255);
-            SDL_RenderFillRect(r, &sr);
+            rq_set_color(r, sh.color.r, sh.color.g, sh.color.b, 255);
+            rq_fill_rect(r, &sr);
         }
         else if (sh.type == SHAPE_CIRCLE)
         {
@@ -220,7 +264,7 @@ void update_composed_texture(GraphicItem &item, SDL_Renderer *r, TTF_Font *font)
                     SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
                     SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
                     SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
-                    SDL_RenderCopy(r, t, NULL, &sr);
+                    rq_copy(r, t, NULL, &sr);
                     SDL_DestroyTexture(t);
                     SDL_FreeSurface(s);
                 }
@@ -228,6 +272,60 @@ void update_composed_texture(GraphicItem &item, SDL_Renderer *r, TTF_Font *font)
         }
     }
     SDL_SetRenderTarget(r, NULL);
+    renderer_build_mips(r, item);
+    static unsigned int composed_serial = 0;
+    item.composed_version = item.version;
+    item.composed_serial = ++composed_serial;
+}
+
+void release_composed_texture(GraphicItem &item)
+{
+    if (item.paint_layer)
+        paint_layer_destroy(item.paint_layer);
+    item.paint_layer = nullptr;
+    if (item.composed_texture)
+        SDL_DestroyTexture(item.composed_texture);
+    if (item.texture == item.composed_texture)
+        item.texture = item.original_texture;
+    item.composed_texture = nullptr;
+    renderer_destroy_mips(item);
+}
+
+// CPU copy of the last composition the fill tool read, so repeated fills on an
+// unchanged costume skip the GPU readback. composed_serial is unique per composition.
+static std::vector<Uint32> g_fill_pixels;
+static unsigned int g_fill_serial = 0;
+
+// Composed pixels of the item in paint-layer space (flips undone), for the fill tool
+static const Uint32 *read_composed_pixels(GraphicItem &item, SDL_Renderer *r, TTF_Font *font)
+{
+    update_composed_texture(item, r, font);
+    if (!item.composed_texture)
+        return nullptr;
+    if (g_fill_serial == item.composed_serial && !g_fill_pixels.empty())
+        return g_fill_pixels.data();
+
+    std::vector<Uint32> &out = g_fill_pixels;
+    out.resize((size_t)RENDER_W * RENDER_H);
+    SDL_SetRenderTarget(r, item.composed_texture);
+    int rc = SDL_RenderReadPixels(r, NULL, SDL_PIXELFORMAT_RGBA8888, out.data(), RENDER_W * 4);
+    SDL_SetRenderTarget(r, NULL);
+    if (rc != 0)
+    {
+        SDL_Log("Fill: could not read costume pixels: %s", SDL_GetError());
+        g_fill_serial = 0;
+        return nullptr;
+    }
+
+    if (item.flip_h)
+        for (int y = 0; y < RENDER_H; y++)
+            std::reverse(out.begin() + (size_t)y * RENDER_W, out.begin() + (size_t)(y + 1) * RENDER_W);
+    if (item.flip_v)
+        for (int y = 0; y < RENDER_H / 2; y++)
+            std::swap_ranges(out.begin() + (size_t)y * RENDER_W, out.begin() + (size_t)(y + 1) * RENDER_W,
+                             out.begin() + (size_t)(RENDER_H - 1 - y) * RENDER_W);
+    g_fill_serial = item.composed_serial;
+    return out.data();
 }
 
 CostumesRects get_costumes_rects(const AppState &state)
@@ -274,11 +372,11 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
     CostumesRects rects = get_costumes_rects(state);
     int area_x = 0, area_y = NAVBAR_HEIGHT + TAB_BAR_HEIGHT, left_w = 120, canvas_x = left_w, canvas_w = (WINDOW_WIDTH - RIGHT_COLUMN_WIDTH) - left_w, toolbar_h = 60;
 
-    SDL_SetRenderDrawColor(r, 245, 245, 245, 255);
+    rq_set_color(r, 245, 245, 245, 255);
     SDL_Rect left_bg = {area_x, area_y, left_w, WINDOW_HEIGHT - area_y};
-    SDL_RenderFillRect(r, &left_bg);
-    SDL_SetRenderDrawColor(r, 220, 220, 220, 255);
-    SDL_RenderDrawLine(r, left_w - 1, area_y, left_w - 1, WINDOW_HEIGHT);
+    rq_fill_rect(r, &left_bg);
+    rq_set_color(r, 220, 220, 220, 255);
+    rq_draw_line(r, left_w - 1, area_y, left_w - 1, WINDOW_HEIGHT);
 
     const std::vector<GraphicItem> *items = nullptr;
     int selected_idx = 0;
@@ -308,26 +406,26 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
                 int cx = del_r.x + del_r.w / 2;
                 int cy = del_r.y + del_r.h / 2;
                 renderer_fill_circle(r, cx, cy, del_r.w / 2, 255, 60, 60);
-                SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
+                rq_set_color(r, 255, 255, 255, 255);
                 int d = 4;
                 for (int w = -1; w <= 1; w++)
                 {
-                    SDL_RenderDrawLine(r, cx - d + w, cy - d, cx + d + w, cy + d);
-                    SDL_RenderDrawLine(r, cx - d + w, cy + d, cx + d + w, cy - d);
+                    rq_draw_line(r, cx - d + w, cy - d, cx + d + w, cy + d);
+                    rq_draw_line(r, cx - d + w, cy + d, cx + d + w, cy - d);
                 }
             }
             else
             {
                 renderer_fill_rounded_rect(r, &box, 4, 255, 255, 255);
-                SDL_SetRenderDrawColor(r, 200, 200, 200, 255);
-                SDL_RenderDrawRect(r, &box);
+                rq_set_color(r, 200, 200, 200, 255);
+                rq_draw_rect(r, &box);
                 draw_text_centered(r, font, (*items)[i].name.c_str(), box.x + box.w / 2, box.y + box.h + 8, 80, 80, 80);
             }
 
-            SDL_Texture *thumb_tex = (*items)[i].composed_texture ? (*items)[i].composed_texture : (*items)[i].texture;
+            SDL_Rect img_r = {box.x + 10, box.y + 10, box.w - 20, box.h - 20};
+            SDL_Texture *thumb_tex = renderer_pick_level((*items)[i], img_r.w, img_r.h);
             if (thumb_tex)
             {
-                SDL_Rect img_r = {box.x + 10, box.y + 10, box.w - 20, box.h - 20};
                 renderer_draw_texture_fit(r, thumb_tex, &img_r);
             }
         }
@@ -340,27 +438,27 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
     int p_w = 24, p_t = 6;
     SDL_Rect p_h = {btn_cx - p_w / 2, btn_cy - p_t / 2, p_w, p_t};
     SDL_Rect p_v = {btn_cx - p_t / 2, btn_cy - p_w / 2, p_t, p_w};
-    SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-    SDL_RenderFillRect(r, &p_h);
-    SDL_RenderFillRect(r, &p_v);
+    rq_set_color(r, 255, 255, 255, 255);
+    rq_fill_rect(r, &p_h);
+    rq_fill_rect(r, &p_v);
 
     SDL_Rect right_bg = {canvas_x, area_y, canvas_w, WINDOW_HEIGHT - area_y};
-    SDL_SetRenderDrawColor(r, 230, 238, 242, 255);
-    SDL_RenderFillRect(r, &right_bg);
+    rq_set_color(r, 230, 238, 242, 255);
+    rq_fill_rect(r, &right_bg);
 
     SDL_Rect toolbar_bg = {canvas_x, area_y, canvas_w, toolbar_h};
-    SDL_SetRenderDrawColor(r, 245, 245, 245, 255);
-    SDL_RenderFillRect(r, &toolbar_bg);
-    SDL_SetRenderDrawColor(r, 220, 220, 220, 255);
-    SDL_RenderDrawLine(r, canvas_x, area_y + toolbar_h - 1, canvas_x + canvas_w, area_y + toolbar_h - 1);
+    rq_set_color(r, 245, 245, 245, 255);
+    rq_fill_rect(r, &toolbar_bg);
+    rq_set_color(r, 220, 220, 220, 255);
+    rq_draw_line(r, canvas_x, area_y + toolbar_h - 1, canvas_x + canvas_w, area_y + toolbar_h - 1);
 
     std::string active_name = items && selected_idx >= 0 && selected_idx < (int)items->size() ? (*items)[selected_idx].name : "Costume 1";
     draw_text_left(r, font, state.editing_target_is_stage ? "Backdrop" : "Costume", canvas_x + 20, area_y + 8, 120, 120, 120);
 
     SDL_Rect name_box = rects.name_box;
     renderer_fill_rounded_rect(r, &name_box, 4, 255, 255, 255);
-    SDL_SetRenderDrawColor(r, 180, 180, 180, 255);
-    SDL_RenderDrawRect(r, &name_box);
+    rq_set_color(r, 180, 180, 180, 255);
+    rq_draw_rect(r, &name_box);
     std::string disp_name = (state.active_input == INPUT_COSTUME_NAME) ? state.input_buffer + "|" : active_name;
     draw_text_left(r, font, disp_name.c_str(), name_box.x + 8, name_box.y + 6, 40, 40, 40);
 
@@ -373,14 +471,14 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
         else
         {
             renderer_fill_rounded_rect(r, &btn, 4, 245, 245, 245);
-            SDL_SetRenderDrawColor(r, 150, 150, 150, 255);
-            SDL_RenderDrawRect(r, &btn);
+            rq_set_color(r, 150, 150, 150, 255);
+            rq_draw_rect(r, &btn);
         }
 
         if (icon)
         {
             SDL_Rect ic = {btn.x + 4, btn.y + 4, 24, 24};
-            SDL_RenderCopy(r, icon, NULL, &ic);
+            rq_copy(r, icon, NULL, &ic);
         }
         else
         {
@@ -401,22 +499,34 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
     SDL_Texture *trash_icon = tex.trash_nonactive ? tex.trash_nonactive : tex.trash_active;
     draw_tool(rects.del_tool, trash_icon, false, "Del");
 
+    if (state.active_tool == TOOL_FILL)
+    {
+        std::string tol = "Tolerance " + std::to_string(state.fill_tolerance) + "  [ / ]";
+        draw_text_left(r, font, tol.c_str(), rects.del_tool.x + 52, rects.del_tool.y + 8, 87, 94, 117);
+    }
+
     SDL_Rect canvas = rects.canvas;
     renderer_fill_rounded_rect(r, &canvas, 8, 255, 255, 255);
-    SDL_RenderSetClipRect(r, &canvas);
+    // Stay inside the frame's dirty clip, if any
+    SDL_Rect old_clip, checker = canvas;
+    bool clip_active = SDL_RenderIsClipEnabled(r);
+    SDL_RenderGetClipRect(r, &old_clip);
+    if (clip_active && !SDL_IntersectRect(&canvas, &old_clip, &checker))
+        checker.w = checker.h = 0;
+    SDL_RenderSetClipRect(r, &checker);
     for (int y = canvas.y; y < canvas.y + canvas.h; y += 15)
     {
         for (int x = canvas.x; x < canvas.x + canvas.w; x += 15)
         {
             bool even = ((x - canvas.x) / 15 + (y - canvas.y) / 15) % 2 == 0;
-            SDL_SetRenderDrawColor(r, even ? 255 : 230, even ? 255 : 230, even ? 255 : 230, 255);
+            rq_set_color(r, even ? 255 : 230, even ? 255 : 230, even ? 255 : 230, 255);
             SDL_Rect sq = {x, y, 15, 15};
-            SDL_RenderFillRect(r, &sq);
+            rq_fill_rect(r, &sq);
         }
     }
-    SDL_RenderSetClipRect(r, NULL);
-    SDL_SetRenderDrawColor(r, 200, 200, 200, 255);
-    SDL_RenderDrawRect(r, &canvas);
+    SDL_RenderSetClipRect(r, clip_active ? &old_clip : NULL);
+    rq_set_color(r, 200, 200, 200, 255);
+    rq_draw_rect(r, &canvas);
 
     if (items && selected_idx >= 0 && selected_idx < (int)items->size())
     {
@@ -427,7 +537,7 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
             SDL_Rect dst;
             float scale;
             get_canvas_bounds(item, canvas, dst, scale);
-            SDL_RenderCopy(r, item.composed_texture, NULL, &dst);
+            rq_copy(r, item.composed_texture, NULL, &dst);
 
             if (state.active_tool == TOOL_POINTER && state.active_shape_index >= 0 && state.active_shape_index < (int)item.shapes.size())
             {
@@ -441,10 +551,10 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
                     act_y = LOGICAL_H - act_y - norm_r.h;
 
                 SDL_Rect sel = {(int)(dst.x + act_x * scale), (int)(dst.y + act_y * scale), (int)(norm_r.w * scale), (int)(norm_r.h * scale)};
-                SDL_SetRenderDrawColor(r, 76, 151, 255, 255);
-                SDL_RenderDrawRect(r, &sel);
+                rq_set_color(r, 76, 151, 255, 255);
+                rq_draw_rect(r, &sel);
                 SDL_Rect hand = {sel.x + sel.w - 4, sel.y + sel.h - 4, 8, 8};
-                SDL_RenderFillRect(r, &hand);
+                rq_fill_rect(r, &hand);
             }
         }
     }
@@ -452,7 +562,6 @@ void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
 
 bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer *renderer, TTF_Font *font)
 {
-    (void)font;
     CostumesRects rects = get_costumes_rects(state);
     auto point_in = [](const SDL_Rect &r, int x, int y)
     { return x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h; };
@@ -470,13 +579,45 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
         selected_idx = state.sprites[state.selected_sprite].selected_costume;
     }
 
+    if (e.type == SDL_KEYDOWN && (e.key.keysym.mod & KMOD_CTRL) && state.active_input == INPUT_NONE && !g_is_drawing && !g_is_dragging)
+    {
+        bool shift = (e.key.keysym.mod & KMOD_SHIFT) != 0;
+        // A stroke released this frame is still queued; finish it so its step is complete
+        costumes_tab_flush_stroke(state);
+        if (e.key.keysym.sym == SDLK_z && !shift)
+        {
+            if (costume_undo(state))
+                LogSimple(LOG_INFO, 0, -1, "EDIT_COSTUME", "Undo."); // ---> LOGGED
+            return true;
+        }
+        if (e.key.keysym.sym == SDLK_y || (e.key.keysym.sym == SDLK_z && shift))
+        {
+            if (costume_redo(state))
+                LogSimple(LOG_INFO, 0, -1, "EDIT_COSTUME", "Redo."); // ---> LOGGED
+            return true;
+        }
+    }
+
+    if (e.type == SDL_KEYDOWN && state.active_tool == TOOL_FILL && state.active_input == INPUT_NONE)
+    {
+        if (e.key.keysym.sym == SDLK_LEFTBRACKET || e.key.keysym.sym == SDLK_RIGHTBRACKET)
+        {
+            int step = e.key.keysym.sym == SDLK_RIGHTBRACKET ? 8 : -8;
+            state.fill_tolerance = std::max(0, std::min(255, state.fill_tolerance + step));
+            return true;
+        }
+    }
+
     if (e.type == SDL_KEYDOWN && state.active_tool == TOOL_POINTER && state.active_input != INPUT_COSTUME_TEXT)
     {
         if (e.key.keysym.sym == SDLK_DELETE || e.key.keysym.sym == SDLK_BACKSPACE)
         {
             if (item && state.active_shape_index >= 0 && state.active_shape_index < (int)item->shapes.size())
             {
+                costume_undo_begin(state);
                 item->shapes.erase(item->shapes.begin() + state.active_shape_index);
+                item->version++;
+                costume_undo_commit(state);
                 state.active_shape_index = -1;
                 LogSimple(LOG_INFO, 0, -1, "EDIT_COSTUME", "Deleted a shape."); // ---> LOGGED
                 return true;
@@ -495,9 +636,7 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
             int real_tx = item->flip_h ? (LOGICAL_W - tx) : tx;
             int real_ty = item->flip_v ? (LOGICAL_H - ty) : ty;
 
-            int brush_rad = std::max(2, (int)(4.0f / scale));
-
-            draw_on_paint_layer(*item, renderer, g_last_mouse_x, g_last_mouse_y, real_tx, real_ty, state.active_color, brush_rad, state.active_tool == TOOL_ERASER);
+            stroke_add(real_tx, real_ty);
             g_last_mouse_x = real_tx;
             g_last_mouse_y = real_ty;
             return true;
@@ -532,6 +671,7 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                     sh.rect.h += item->flip_v ? -dy : dy;
                 }
             }
+            item->version++;
             g_last_mouse_x = real_tx;
             g_last_mouse_y = real_ty;
             return true;
@@ -540,8 +680,11 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
     else if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT)
     {
         if (g_is_drawing) {
+            g_stroke.finish = true;
             LogSimple(LOG_INFO, 0, -1, "DRAW_SHAPE", "Used Brush/Eraser to draw on canvas."); // ---> LOGGED
         }
+        if (g_is_dragging)
+            costume_undo_commit(state); // shape moved, resized or just drawn
         g_is_drawing = false;
         g_is_dragging = false;
         return false;
@@ -554,9 +697,11 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
         {
             if (point_in(rects.thumb_dels[i], mx, my) && selected_idx == (int)i)
             {
+                costume_undo_clear();
                 if (state.editing_target_is_stage && state.backdrops.size() > 1)
                 {
                     delete_asset_from_project(state.backdrops[i].source_path);
+                    release_composed_texture(state.backdrops[i]);
                     state.backdrops.erase(state.backdrops.begin() + i);
                     if (state.selected_backdrop >= (int)state.backdrops.size())
                         state.selected_backdrop = state.backdrops.size() - 1;
@@ -565,9 +710,11 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                 {
                     auto &spr = state.sprites[state.selected_sprite];
                     delete_asset_from_project(spr.costumes[i].source_path);
+                    release_composed_texture(spr.costumes[i]);
                     spr.costumes.erase(spr.costumes.begin() + i);
                     if (spr.selected_costume >= (int)spr.costumes.size())
                         spr.selected_costume = spr.costumes.size() - 1;
+                    spr.texture = spr.costumes[spr.selected_costume].texture; // the old one may be freed
                 }
                 LogSimple(LOG_INFO, 0, -1, "DELETE_COSTUME", "Deleted a Backdrop/Costume"); // ---> LOGGED
                 return true;
@@ -629,24 +776,30 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
 
         if (point_in(rects.flip_h, mx, my) && item)
         {
+            costume_undo_begin(state);
             item->flip_h = !item->flip_h;
+            item->version++;
+            costume_undo_commit(state);
             LogSimple(LOG_INFO, 0, -1, "FLIP_COSTUME", "Flipped horizontally."); // ---> LOGGED
             return true;
         }
         if (point_in(rects.flip_v, mx, my) && item)
         {
+            costume_undo_begin(state);
             item->flip_v = !item->flip_v;
+            item->version++;
+            costume_undo_commit(state);
             LogSimple(LOG_INFO, 0, -1, "FLIP_COSTUME", "Flipped vertically."); // ---> LOGGED
             return true;
         }
         if (point_in(rects.del_tool, mx, my) && item)
         {
+            // Tiles are dropped rather than the whole layer, so this can be undone
+            costume_undo_begin(state);
             item->shapes.clear();
-            if (item->paint_layer)
-            {
-                SDL_DestroyTexture(item->paint_layer);
-                item->paint_layer = nullptr;
-            }
+            paint_layer_clear(item->paint_layer);
+            item->version++;
+            costume_undo_commit(state);
             LogSimple(LOG_INFO, 0, -1, "CLEAR_COSTUME", "Cleared all drawing edits."); // ---> LOGGED
             return true;
         }
@@ -661,6 +814,7 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
             if (state.active_input == INPUT_COSTUME_TEXT)
             {
                 state.active_input = INPUT_NONE;
+                costume_undo_commit(state);
             }
             SDL_Rect dst;
             float scale;
@@ -682,6 +836,7 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                     SDL_Rect hand = {norm_sr.x + norm_sr.w - 10, norm_sr.y + norm_sr.h - 10, 20, 20};
                     if (real_tx >= hand.x && real_tx <= hand.x + hand.w && real_ty >= hand.y && real_ty <= hand.y + hand.h)
                     {
+                        costume_undo_begin(state);
                         state.active_shape_index = i;
                         g_resize_handle = 1;
                         g_is_dragging = true;
@@ -691,6 +846,7 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                     }
                     if (real_tx >= norm_sr.x && real_tx <= norm_sr.x + norm_sr.w && real_ty >= norm_sr.y && real_ty <= norm_sr.y + norm_sr.h)
                     {
+                        costume_undo_begin(state);
                         state.active_shape_index = i;
                         g_resize_handle = 0;
                         g_is_dragging = true;
@@ -705,7 +861,7 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                 g_is_drawing = true;
                 g_last_mouse_x = real_tx;
                 g_last_mouse_y = real_ty;
-                draw_on_paint_layer(*item, renderer, real_tx, real_ty, real_tx, real_ty, state.active_color, brush_rad, state.active_tool == TOOL_ERASER);
+                stroke_begin(state, real_tx, real_ty, state.active_color, brush_rad, state.active_tool == TOOL_ERASER);
                 return true;
             }
             else if (state.active_tool == TOOL_TEXT)
@@ -716,7 +872,9 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                 sh.rect = {real_tx, real_ty, 20, th};
                 sh.color = state.active_color;
                 sh.text = "Text";
+                costume_undo_begin(state); // closed when typing ends, so the text is part of the step
                 item->shapes.push_back(sh);
+                item->version++;
                 state.active_shape_index = item->shapes.size() - 1;
                 state.active_input = INPUT_COSTUME_TEXT;
                 state.input_buffer = "Text";
@@ -729,7 +887,9 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                 sh.type = (state.active_tool == TOOL_RECT) ? SHAPE_RECT : SHAPE_CIRCLE;
                 sh.rect = {real_tx, real_ty, 0, 0};
                 sh.color = state.active_color;
+                costume_undo_begin(state); // closed on mouse up, once the shape has its size
                 item->shapes.push_back(sh);
+                item->version++;
                 state.active_shape_index = item->shapes.size() - 1;
                 g_resize_handle = 1;
                 g_is_dragging = true;
@@ -745,11 +905,32 @@ bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer
                     SDL_Rect norm_sr = get_normalized_rect(item->shapes[i].rect);
                     if (real_tx >= norm_sr.x && real_tx <= norm_sr.x + norm_sr.w && real_ty >= norm_sr.y && real_ty <= norm_sr.y + norm_sr.h)
                     {
+                        costume_undo_begin(state);
                         item->shapes[i].color = state.active_color;
+                        item->version++;
+                        costume_undo_commit(state);
                         LogSimple(LOG_INFO, 0, -1, "DRAW_SHAPE", "Filled shape with color"); // ---> LOGGED
                         return true;
                     }
                 }
+
+                // No shape under the cursor: flood fill the bitmap
+                const Uint32 *pixels = read_composed_pixels(*item, renderer, font);
+                if (!pixels)
+                    return true;
+                if (!item->paint_layer)
+                    item->paint_layer = paint_layer_create(RENDER_W, RENDER_H);
+                costume_undo_begin(state);
+                int hx = std::max(0, std::min(RENDER_W - 1, real_tx * HIRES_MULT));
+                int hy = std::max(0, std::min(RENDER_H - 1, real_ty * HIRES_MULT));
+                SDL_Rect filled = paint_layer_flood_fill(item->paint_layer, pixels, hx, hy, state.active_color, state.fill_tolerance);
+                costume_undo_commit(state);
+                if (filled.w > 0)
+                {
+                    item->version++;
+                    LogSimple(LOG_INFO, 0, -1, "DRAW_SHAPE", "Flood filled " + std::to_string(filled.w) + "x" + std::to_string(filled.h) + " area"); // ---> LOGGED
+                }
+                return true;
             }
         }
     }
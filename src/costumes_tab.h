@@ -23,6 +23,8 @@ struct CostumesRects
 CostumesRects get_costumes_rects(const AppState &state);
 void costumes_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const Textures &tex);
 bool costumes_tab_handle_event(const SDL_Event &e, AppState &state, SDL_Renderer *renderer, TTF_Font *font);
+void costumes_tab_flush_stroke(AppState &state); // rasterize queued brush input, once per frame
 void update_composed_texture(GraphicItem &item, SDL_Renderer *r, TTF_Font *font); // <-- EXPORT COMPOSITOR
+void release_composed_texture(GraphicItem &item); // paint layer, composition and mips; the original may be shared and stays
 
 #endif
\ No newline at end of file
@@ -1,9 +1,15 @@
 #include "filemenu.h"
 #include "config.h"
 #include "renderer.h"
+#include "paint_layer.h"
+#include "costume_undo.h"
+#include "image_import.h"
 #include "SDL_image.h"
 #include "SDL_mixer.h"
 #include "audio.h"
+#include "text.h"
+#include "stage.h"
+#include "render_queue.h"
 #include <string>
 #include <fstream>
 #include <filesystem>
@@ -14,19 +20,12 @@
 static const int RENDER_W = 480 * 4;
 static const int RENDER_H = 360 * 4;
 
-static void set_color(SDL_Renderer *r, Color c) { SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255); }
+static void set_color(SDL_Renderer *r, Color c) { rq_set_color(r, c.r, c.g, c.b, 255); }
 
 static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt, int x, int y, Color c)
 {
     SDL_Color sc = {(Uint8)c.r, (Uint8)c.g, (Uint8)c.b, 255};
-    SDL_Surface *s = TTF_RenderUTF8_Blended(f, txt, sc);
-    if (!s)
-        return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst = {x, y, s->w, s->h};
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    text_draw(r, f, txt, x, y, sc);
 }
 
 // ---> SECURE JSON ESCAPER <---
@@ -47,32 +46,28 @@ static std::string escape_json(const std::string &s)
     return res;
 }
 
-// ---> EXTRACT AND SAVE PAINT STROKES TO PNG <---
-static void save_paint_layer(SDL_Renderer *r, SDL_Texture *paint_layer, const std::string &filepath)
+// ---> SAVE PAINT STROKES (only painted tiles) TO PNG <---
+// Returns the JSON array of tile coords, or "" when nothing was written.
+static std::string save_paint_layer(const PaintLayer *paint_layer, const std::string &filepath)
 {
-    if (!paint_layer)
-        return;
-
-    SDL_Texture *prev_target = SDL_GetRenderTarget(r);
-    SDL_SetRenderTarget(r, paint_layer);
-
-    int w, h;
-    SDL_QueryTexture(paint_layer, NULL, NULL, &w, &h);
-
-    SDL_Surface *surf = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ABGR8888);
-    if (surf)
+    std::vector<int> coords;
+    if (!paint_layer_save(paint_layer, filepath, coords))
+        return "";
+    std::string res = "[";
+    for (size_t i = 0; i < coords.size(); i++)
     {
-        SDL_RenderReadPixels(r, NULL, SDL_PIXELFORMAT_ABGR8888, surf->pixels, surf->pitch);
-        IMG_SavePNG(surf, filepath.c_str());
-        SDL_FreeSurface(surf);
+        res += std::to_string(coords[i]);
+        if (i < coords.size() - 1)
+            res += ",";
     }
-
-    SDL_SetRenderTarget(r, prev_target);
+    return res + "]";
 }
 
 // ---> MEMORY CLEANER <---
 static void cleanup_project(AppState &state)
 {
+    costume_undo_clear();
+    image_import_cancel();
     for (auto &s : state.sprites)
     {
         for (auto &c : s.costumes)
@@ -80,9 +75,10 @@ static void cleanup_project(AppState &state)
             if (c.original_texture)
                 SDL_DestroyTexture(c.original_texture);
             if (c.paint_layer)
-                SDL_DestroyTexture(c.paint_layer);
+                paint_layer_destroy(c.paint_layer);
             if (c.composed_texture)
                 SDL_DestroyTexture(c.composed_texture);
+            renderer_destroy_mips(c);
         }
         for (auto &snd : s.sounds)
         {
@@ -95,10 +91,12 @@ static void cleanup_project(AppState &state)
         if (b.original_texture)
             SDL_DestroyTexture(b.original_texture);
         if (b.paint_layer)
-            SDL_DestroyTexture(b.paint_layer);
+            paint_layer_destroy(b.paint_layer);
         if (b.composed_texture)
             SDL_DestroyTexture(b.composed_texture);
+        renderer_destroy_mips(b);
     }
+    stage_layers_clear(state);
     state.sprites.clear();
     state.backdrops.clear();
     state.drag.active = false;
@@ -232,6 +230,188 @@ static JVal parse_json(const std::string &str, size_t &pos)
     }
 }
 
+// ---> LOAD PAINT STROKES (tile strip, or a full-size PNG from older saves) <---
+static PaintLayer *load_paint_layer(const std::string &filepath, const JVal &tiles)
+{
+    if (tiles.type != JVal::ARR || tiles.a.empty())
+        return paint_layer_load_image(filepath, RENDER_W, RENDER_H);
+    std::vector<int> coords;
+    for (const auto &v : tiles.a)
+        coords.push_back((int)v.n);
+    return paint_layer_load_tiles(filepath, coords, RENDER_W, RENDER_H);
+}
+
+bool filemenu_load_project(SDL_Renderer *r, AppState &state, const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in.is_open())
+    {
+        SDL_Log("Project load failed: cannot open %s", path.c_str());
+        return false;
+    }
+    std::string json_str((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    size_t pos = 0;
+    JVal root = parse_json(json_str, pos);
+
+    if (root.type != JVal::OBJ)
+    {
+        SDL_Log("Project load failed: %s is not a project file", path.c_str());
+        return false;
+    }
+    cleanup_project(state);
+    state.project_name = root.o["project_name"].s;
+    state.next_block_id = root.o["next_block_id"].n;
+
+    // RESTORE ACTIVE BACKDROP
+    state.selected_backdrop = (int)root.o["selected_backdrop"].n;
+
+    if (state.next_block_id <= 0)
+        state.next_block_id = 1;
+
+    state.variables.clear();
+    state.variable_values.clear();
+    state.variable_visible.clear();
+    for (auto &v_val : root.o["variables"].a)
+    {
+        std::string n = v_val.o["name"].s;
+        state.variables.push_back(n);
+        state.variable_values[n] = v_val.o["value"].s;
+        state.variable_visible[n] = v_val.o["visible"].b;
+    }
+
+    for (auto &b_val : root.o["backdrops"].a)
+    {
+        std::string n = b_val.o["name"].s;
+        std::string p = b_val.o["source_path"].s;
+        SDL_Texture *t = p.empty() ? nullptr : image_import_load_texture(r, p);
+        Backdrop b(n, t, p);
+
+        b.flip_h = b_val.o["flip_h"].b;
+        b.flip_v = b_val.o["flip_v"].b;
+        std::string paint_path = b_val.o["paint_path"].s;
+        if (!paint_path.empty() && std::filesystem::exists(paint_path))
+            b.paint_layer = load_paint_layer(paint_path, b_val.o["paint_tiles"]);
+
+        for (auto &sh_val : b_val.o["shapes"].a)
+        {
+            GraphicShape sh;
+            sh.type = (ShapeType)(int)sh_val.o["type"].n;
+            sh.rect = {(int)sh_val.o["x"].n, (int)sh_val.o["y"].n, (int)sh_val.o["w"].n, (int)sh_val.o["h"].n};
+            sh.color = {(Uint8)sh_val.o["r"].n, (Uint8)sh_val.o["g"].n, (Uint8)sh_val.o["b"].n, (Uint8)sh_val.o["a"].n};
+            if (sh.type == SHAPE_TEXT)
+                sh.text = sh_val.o["text"].s;
+            b.shapes.push_back(sh);
+        }
+        b.version++; // loaded paint/shapes/flips need a fresh composition
+        state.backdrops.push_back(b);
+    }
+
+    for (auto &s_val : root.o["sprites"].a)
+    {
+        std::string n = s_val.o["name"].s;
+        Sprite spr(n, nullptr, "");
+        spr.costumes.clear();
+
+        spr.x = s_val.o["x"].n;
+        spr.y = s_val.o["y"].n;
+        spr.direction = s_val.o["direction"].n;
+        spr.size = s_val.o["size"].n;
+        spr.visible = s_val.o["visible"].b;
+
+        // RESTORE ACTIVE COSTUME
+        spr.selected_costume = (int)s_val.o["selected_costume"].n;
+
+        for (auto &c_val : s_val.o["costumes"].a)
+        {
+            std::string cn = c_val.o["name"].s;
+            std::string cp = c_val.o["source_path"].s;
+            SDL_Texture *ct = cp.empty() ? nullptr : image_import_load_texture(r, cp);
+            Costume c(cn, ct, cp);
+
+            c.flip_h = c_val.o["flip_h"].b;
+            c.flip_v = c_val.o["flip_v"].b;
+            std::string paint_path = c_val.o["paint_path"].s;
+            if (!paint_path.empty() && std::filesystem::exists(paint_path))
+                c.paint_layer = load_paint_layer(paint_path, c_val.o["paint_tiles"]);
+
+            for (auto &sh_val : c_val.o["shapes"].a)
+            {
+                GraphicShape sh;
+                sh.type = (ShapeType)(int)sh_val.o["type"].n;
+                sh.rect = {(int)sh_val.o["x"].n, (int)sh_val.o["y"].n, (int)sh_val.o["w"].n, (int)sh_val.o["h"].n};
+                sh.color = {(Uint8)sh_val.o["r"].n, (Uint8)sh_val.o["g"].n, (Uint8)sh_val.o["b"].n, (Uint8)sh_val.o["a"].n};
+                if (sh.type == SHAPE_TEXT)
+                    sh.text = sh_val.o["text"].s;
+                c.shapes.push_back(sh);
+            }
+            c.version++; // loaded paint/shapes/flips need a fresh composition
+            spr.costumes.push_back(c);
+        }
+
+        for (auto &snd_val : s_val.o["sounds"].a)
+        {
+            std::string sn = snd_val.o["name"].s;
+            std::string sp = snd_val.o["source_path"].s;
+            Mix_Chunk *c = sp.empty() ? nullptr : audio_load_sound(sp);
+            SoundData sd(sn, c, sp);
+            sd.volume = snd_val.o["volume"].n;
+            spr.sounds.push_back(sd);
+        }
+
+        for (auto &blk_val : s_val.o["blocks"].a)
+        {
+            BlockInstance blk;
+            blk.id = (int)blk_val.o["id"].n;
+            blk.kind = (BlockKind)(int)blk_val.o["kind"].n;
+            blk.subtype = (int)blk_val.o["subtype"].n;
+            blk.x = (int)blk_val.o["x"].n;
+            blk.y = (int)blk_val.o["y"].n;
+            blk.a = (int)blk_val.o["a"].n;
+            blk.b = (int)blk_val.o["b"].n;
+            blk.c = (int)blk_val.o["c"].n;
+            blk.d = (int)blk_val.o["d"].n;
+            blk.e = (int)blk_val.o["e"].n;
+            blk.f = (int)blk_val.o["f"].n;
+            blk.opt = (int)blk_val.o["opt"].n;
+            blk.text = blk_val.o["text"].s;
+            blk.text2 = blk_val.o["text2"].s;
+            blk.next_id = (int)blk_val.o["next_id"].n;
+            blk.parent_id = (int)blk_val.o["parent_id"].n;
+            blk.child_id = (int)blk_val.o["child_id"].n;
+            blk.child2_id = (int)blk_val.o["child2_id"].n;
+            blk.condition_id = (int)blk_val.o["condition_id"].n;
+            blk.arg0_id = (int)blk_val.o["arg0_id"].n;
+            blk.arg1_id = (int)blk_val.o["arg1_id"].n;
+            blk.arg2_id = (int)blk_val.o["arg2_id"].n;
+            spr.blocks.push_back(blk);
+        }
+
+        for (auto &tl_val : s_val.o["top_level_blocks"].a)
+        {
+            spr.top_level_blocks.push_back((int)tl_val.n);
+        }
+
+        if (!spr.costumes.empty() && spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size())
+            spr.texture = spr.costumes[spr.selected_costume].texture;
+        else if (!spr.costumes.empty())
+            spr.texture = spr.costumes[0].texture;
+
+        state.sprites.push_back(spr);
+    }
+
+    if (state.sprites.empty())
+    {
+        state.sprites.push_back(Sprite("Sprite1", IMG_LoadTexture(r, "assets/sprites/scratch_cat.png"), "assets/sprites/scratch_cat.png"));
+    }
+
+    state.selected_sprite = 0;
+    if (state.selected_backdrop < 0 || state.selected_backdrop >= (int)state.backdrops.size())
+        state.selected_backdrop = 0;
+
+    std::cout << "SUCCESS: Workspace fully loaded from " << path << "\n";
+    return true;
+}
+
 void filemenu_layout(FileMenuRects &rects, int file_btn_x)
 {
     rects.menu = {file_btn_x, NAVBAR_HEIGHT, 220, 10 + 3 * 30};
@@ -249,9 +429,9 @@ void filemenu_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const
     if (!state.file_menu_open)
         return;
     set_color(r, COL_WHITE);
-    SDL_RenderFillRect(r, const_cast<SDL_Rect *>(&rects.menu));
+    rq_fill_rect(r, &rects.menu);
     set_color(r, COL_SEPARATOR);
-    SDL_RenderDrawRect(r, const_cast<SDL_Rect *>(&rects.menu));
+    rq_draw_rect(r, &rects.menu);
 
     const char *labels[3] = {"New", "Load from your computer", "Save to your computer"};
     for (int i = 0; i < 3; ++i)
@@ -259,7 +439,7 @@ void filemenu_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const
         if (state.file_menu_hover == i)
         {
             set_color(r, COL_FILEMENU_HOVER);
-            SDL_RenderFillRect(r, const_cast<SDL_Rect *>(&rects.items[i]));
+            rq_fill_rect(r, &rects.items[i]);
         }
         draw_text(r, font, labels[i], rects.items[i].x + 15, rects.items[i].y + 6, COL_FILEMENU_TEXT);
     }
@@ -312,202 +492,7 @@ bool filemenu_handle_event(const SDL_Event &e, AppState &state, const FileMenuRe
                 result.pop_back();
 
             if (!result.empty())
-            {
-                std::ifstream in(result);
-                if (in.is_open())
-                {
-                    std::string json_str((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-                    size_t pos = 0;
-                    JVal root = parse_json(json_str, pos);
-
-                    if (root.type == JVal::OBJ)
-                    {
-                        cleanup_project(state);
-                        state.project_name = root.o["project_name"].s;
-                        state.next_block_id = root.o["next_block_id"].n;
-
-                        // RESTORE ACTIVE BACKDROP
-                        state.selected_backdrop = (int)root.o["selected_backdrop"].n;
-
-                        if (state.next_block_id <= 0)
-                            state.next_block_id = 1;
-
-                        state.variables.clear();
-                        state.variable_values.clear();
-                        state.variable_visible.clear();
-                        for (auto &v_val : root.o["variables"].a)
-                        {
-                            std::string n = v_val.o["name"].s;
-                            state.variables.push_back(n);
-                            state.variable_values[n] = v_val.o["value"].s;
-                            state.variable_visible[n] = v_val.o["visible"].b;
-                        }
-
-                        for (auto &b_val : root.o["backdrops"].a)
-                        {
-                            std::string n = b_val.o["name"].s;
-                            std::string p = b_val.o["source_path"].s;
-                            SDL_Texture *t = p.empty() ? nullptr : IMG_LoadTexture(r, p.c_str());
-                            Backdrop b(n, t, p);
-
-                            b.flip_h = b_val.o["flip_h"].b;
-                            b.flip_v = b_val.o["flip_v"].b;
-                            std::string paint_path = b_val.o["paint_path"].s;
-                            if (!paint_path.empty() && std::filesystem::exists(paint_path))
-                            {
-                                SDL_Texture *loaded_paint = IMG_LoadTexture(r, paint_path.c_str());
-                                if (loaded_paint)
-                                {
-                                    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
-                                    b.paint_layer = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, RENDER_W, RENDER_H);
-                                    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
-                                    SDL_SetTextureBlendMode(b.paint_layer, SDL_BLENDMODE_BLEND);
-
-                                    SDL_Texture *prev = SDL_GetRenderTarget(r);
-                                    SDL_SetRenderTarget(r, b.paint_layer);
-                                    SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
-                                    SDL_RenderClear(r);
-                                    SDL_RenderCopy(r, loaded_paint, NULL, NULL);
-                                    SDL_SetRenderTarget(r, prev);
-                                    SDL_DestroyTexture(loaded_paint);
-                                }
-                            }
-
-                            for (auto &sh_val : b_val.o["shapes"].a)
-                            {
-                                GraphicShape sh;
-                                sh.type = (ShapeType)(int)sh_val.o["type"].n;
-                                sh.rect = {(int)sh_val.o["x"].n, (int)sh_val.o["y"].n, (int)sh_val.o["w"].n, (int)sh_val.o["h"].n};
-                                sh.color = {(Uint8)sh_val.o["r"].n, (Uint8)sh_val.o["g"].n, (Uint8)sh_val.o["b"].n, (Uint8)sh_val.o["a"].n};
-                                if (sh.type == SHAPE_TEXT)
-                                    sh.text = sh_val.o["text"].s;
-                                b.shapes.push_back(sh);
-                            }
-                            state.backdrops.push_back(b);
-                        }
-
-                        for (auto &s_val : root.o["sprites"].a)
-                        {
-                            std::string n = s_val.o["name"].s;
-                            Sprite spr(n, nullptr, "");
-                            spr.costumes.clear();
-
-                            spr.x = s_val.o["x"].n;
-                            spr.y = s_val.o["y"].n;
-                            spr.direction = s_val.o["direction"].n;
-                            spr.size = s_val.o["size"].n;
-                            spr.visible = s_val.o["visible"].b;
-
-                            // RESTORE ACTIVE COSTUME
-                            spr.selected_costume = (int)s_val.o["selected_costume"].n;
-
-                            for (auto &c_val : s_val.o["costumes"].a)
-                            {
-                                std::string cn = c_val.o["name"].s;
-                                std::string cp = c_val.o["source_path"].s;
-                                SDL_Texture *ct = cp.empty() ? nullptr : IMG_LoadTexture(r, cp.c_str());
-                                Costume c(cn, ct, cp);
-
-                                c.flip_h = c_val.o["flip_h"].b;
-                                c.flip_v = c_val.o["flip_v"].b;
-                                std::string paint_path = c_val.o["paint_path"].s;
-                                if (!paint_path.empty() && std::filesystem::exists(paint_path))
-                                {
-                                    SDL_Texture *loaded_paint = IMG_LoadTexture(r, paint_path.c_str());
-                                    if (loaded_paint)
-                                    {
-                                        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
-                                        c.paint_layer = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, RENDER_W, RENDER_H);
-                                        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
-                                        SDL_SetTextureBlendMode(c.paint_layer, SDL_BLENDMODE_BLEND);
-
-                                        SDL_Texture *prev = SDL_GetRenderTarget(r);
-                                        SDL_SetRenderTarget(r, c.paint_layer);
-                                        SDL_SetRenderDrawColor(r, 0, 0, 0, 0);
-                                        SDL_RenderClear(r);
-                                        SDL_RenderCopy(r, loaded_paint, NULL, NULL);
-                                        SDL_SetRenderTarget(r, prev);
-                                        SDL_DestroyTexture(loaded_paint);
-                                    }
-                                }
-
-                                for (auto &sh_val : c_val.o["shapes"].a)
-                                {
-                                    GraphicShape sh;
-                                    sh.type = (ShapeType)(int)sh_val.o["type"].n;
-                                    sh.rect = {(int)sh_val.o["x"].n, (int)sh_val.o["y"].n, (int)sh_val.o["w"].n, (int)sh_val.o["h"].n};
-                                    sh.color = {(Uint8)sh_val.o["r"].n, (Uint8)sh_val.o["g"].n, (Uint8)sh_val.o["b"].n, (Uint8)sh_val.o["a"].n};
-                                    if (sh.type == SHAPE_TEXT)
-                                        sh.text = sh_val.o["text"].s;
-                                    c.shapes.push_back(sh);
-                                }
-                                spr.costumes.push_back(c);
-                            }
-
-                            for (auto &snd_val : s_val.o["sounds"].a)
-                            {
-                                std::string sn = snd_val.o["name"].s;
-                                std::string sp = snd_val.o["source_path"].s;
-                                Mix_Chunk *c = sp.empty() ? nullptr : audio_load_sound(sp);
-                                SoundData sd(sn, c, sp);
-                                sd.volume = snd_val.o["volume"].n;
-                                spr.sounds.push_back(sd);
-                            }
-
-                            for (auto &blk_val : s_val.o["blocks"].a)
-                            {
-                                BlockInstance blk;
-                                blk.id = (int)blk_val.o["id"].n;
-                                blk.kind = (BlockKind)(int)blk_val.o["kind"].n;
-                                blk.subtype = (int)blk_val.o["subtype"].n;
-                                blk.x = (int)blk_val.o["x"].n;
-                                blk.y = (int)blk_val.o["y"].n;
-                                blk.a = (int)blk_val.o["a"].n;
-                                blk.b = (int)blk_val.o["b"].n;
-                                blk.c = (int)blk_val.o["c"].n;
-                                blk.d = (int)blk_val.o["d"].n;
-                                blk.e = (int)blk_val.o["e"].n;
-                                blk.f = (int)blk_val.o["f"].n;
-                                blk.opt = (int)blk_val.o["opt"].n;
-                                blk.text = blk_val.o["text"].s;
-                                blk.text2 = blk_val.o["text2"].s;
-                                blk.next_id = (int)blk_val.o["next_id"].n;
-                                blk.parent_id = (int)blk_val.o["parent_id"].n;
-                                blk.child_id = (int)blk_val.o["child_id"].n;
-                                blk.child2_id = (int)blk_val.o["child2_id"].n;
-                                blk.condition_id = (int)blk_val.o["condition_id"].n;
-                                blk.arg0_id = (int)blk_val.o["arg0_id"].n;
-                                blk.arg1_id = (int)blk_val.o["arg1_id"].n;
-                                blk.arg2_id = (int)blk_val.o["arg2_id"].n;
-                                spr.blocks.push_back(blk);
-                            }
-
-                            for (auto &tl_val : s_val.o["top_level_blocks"].a)
-                            {
-                                spr.top_level_blocks.push_back((int)tl_val.n);
-                            }
-
-                            if (!spr.costumes.empty() && spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size())
-                                spr.texture = spr.costumes[spr.selected_costume].texture;
-                            else if (!spr.costumes.empty())
-                                spr.texture = spr.costumes[0].texture;
-
-                            state.sprites.push_back(spr);
-                        }
-
-                        if (state.sprites.empty())
-                        {
-                            state.sprites.push_back(Sprite("Sprite1", IMG_LoadTexture(r, "assets/sprites/scratch_cat.png"), "assets/sprites/scratch_cat.png"));
-                        }
-
-                        state.selected_sprite = 0;
-                        if (state.selected_backdrop < 0 || state.selected_backdrop >= (int)state.backdrops.size())
-                            state.selected_backdrop = 0;
-
-                        std::cout << "SUCCESS: Workspace fully loaded from " << result << "\n";
-                    }
-                }
-            }
+                filemenu_load_project(r, state, result);
             state.file_menu_open = false;
             return true;
         }
@@ -546,15 +531,19 @@ bool filemenu_handle_event(const SDL_Event &e, AppState &state, const FileMenuRe
                 auto &b = state.backdrops[i];
 
                 std::string p_path = "";
+                std::string p_tiles = "";
                 if (b.paint_layer)
                 {
                     p_path = dir + "/assets/backdrop_" + std::to_string(i) + "_paint.png";
-                    save_paint_layer(r, b.paint_layer, p_path);
+                    p_tiles = save_paint_layer(b.paint_layer, p_path);
+                    if (p_tiles.empty())
+                        p_path = "";
                 }
 
                 out << "    { \"name\": \"" << escape_json(b.name) << "\", "
                     << "\"source_path\": \"" << escape_json(b.source_path) << "\", "
                     << "\"paint_path\": \"" << escape_json(p_path) << "\", "
+                    << "\"paint_tiles\": " << (p_tiles.empty() ? "[]" : p_tiles) << ", "
                     << "\"flip_h\": " << (b.flip_h ? "true" : "false") << ", "
                     << "\"flip_v\": " << (b.flip_v ? "true" : "false") << ", "
                     << "\"shapes\": [";
@@ -591,15 +580,19 @@ bool filemenu_handle_event(const SDL_Event &e, AppState &state, const FileMenuRe
                     auto &cost = s.costumes[c];
 
                     std::string p_path = "";
+                    std::string p_tiles = "";
                     if (cost.paint_layer)
                     {
                         p_path = dir + "/assets/sprite_" + std::to_string(i) + "_costume_" + std::to_string(c) + "_paint.png";
-                        save_paint_layer(r, cost.paint_layer, p_path);
+                        p_tiles = save_paint_layer(cost.paint_layer, p_path);
+                        if (p_tiles.empty())
+                            p_path = "";
                     }
 
                     out << "        { \"name\": \"" << escape_json(cost.name) << "\", "
                         << "\"source_path\": \"" << escape_json(cost.source_path) << "\", "
                         << "\"paint_path\": \"" << escape_json(p_path) << "\", "
+                        << "\"paint_tiles\": " << (p_tiles.empty() ? "[]" : p_tiles) << ", "
                         << "\"flip_h\": " << (cost.flip_h ? "true" : "false") << ", "
                         << "\"flip_v\": " << (cost.flip_v ? "true" : "false") << ", "
                         << "\"shapes\": [";
@@ -4,6 +4,7 @@
 #include "SDL.h"
 #include "SDL_ttf.h"
 #include "types.h"
+#include <string>
 
 struct FileMenuRects {
     SDL_Rect menu;
@@ -16,5 +17,7 @@ void filemenu_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
                    const FileMenuRects &rects);
 bool filemenu_handle_event(const SDL_Event &e, AppState &state,
                            const FileMenuRects &rects, SDL_Renderer *r); // ---> NEW: Renderer added!
+/* Replaces the current project with the project.json at path; false if it could not be read */
+bool filemenu_load_project(SDL_Renderer *r, AppState &state, const std::string &path);
 
 #endif
\ No newline at end of file
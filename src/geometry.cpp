@@ -0,0 +1,381 @@
+#include "geometry.h"
+#include "render_queue.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+static const size_t MESH_CACHE_MAX = 4096;
+
+struct MeshVertex
+{
+    float x, y;
+    Uint8 slot;
+    Uint8 alpha; // scales the slot colour's alpha; 0 on the outer edge of an AA fringe
+};
+
+struct ShapeMesh
+{
+    std::vector<MeshVertex> verts;
+    std::vector<int> indices;
+};
+
+enum ShapeKind
+{
+    SHAPE_ROUNDED_RECT,
+    SHAPE_CIRCLE,
+    SHAPE_HEXAGON,
+    SHAPE_BLOCK,
+    SHAPE_C_BLOCK
+};
+
+struct ShapeKey
+{
+    int v[10];
+    bool operator==(const ShapeKey &o) const { return std::memcmp(v, o.v, sizeof(v)) == 0; }
+};
+
+struct ShapeKeyHash
+{
+    size_t operator()(const ShapeKey &k) const
+    {
+        size_t h = 1469598103934665603ULL;
+        for (int x : k.v)
+            h = (h ^ (size_t)(unsigned)x) * 1099511628211ULL;
+        return h;
+    }
+};
+
+static std::unordered_map<ShapeKey, ShapeMesh, ShapeKeyHash> g_meshes;
+static std::vector<SDL_Vertex> g_verts;
+static std::vector<int> g_batch_indices;
+static bool g_batching = false;
+static int g_antialias = -1; // -1 until ANTIALIAS_SHAPES has been read
+
+static bool antialias()
+{
+    if (g_antialias < 0)
+    {
+        const char *aa = std::getenv("ANTIALIAS_SHAPES");
+        g_antialias = (aa && std::atoi(aa) != 0) ? 1 : 0;
+    }
+    return g_antialias == 1;
+}
+
+// ---> TESSELLATION <---
+// Shapes are built in pixel-edge coordinates: a w x h rect covers [0, w) x [0, h).
+// The old scanline fills put a radius-r corner's centre on the middle of pixel r,
+// which is an arc of radius r + 0.5 around (r + 0.5, r + 0.5).
+
+typedef std::vector<SDL_FPoint> Polygon;
+
+static int arc_segments(float radius, float sweep)
+{
+    // Keep the chord within a quarter pixel of the arc
+    if (radius <= 0.25f)
+        return 1;
+    float step = 2.0f * std::acos(1.0f - 0.25f / radius);
+    int n = (int)std::ceil(sweep / step);
+    return std::max(1, std::min(n, 32));
+}
+
+static void push_point(Polygon &poly, float x, float y)
+{
+    if (!poly.empty() && std::fabs(poly.back().x - x) < 0.01f && std::fabs(poly.back().y - y) < 0.01f)
+        return;
+    poly.push_back({x, y});
+}
+
+static void push_arc(Polygon &poly, float cx, float cy, float radius, float a0, float a1)
+{
+    int n = arc_segments(radius, a1 - a0);
+    for (int i = 0; i <= n; i++)
+    {
+        float a = a0 + (a1 - a0) * i / n;
+        push_point(poly, cx + radius * std::cos(a), cy + radius * std::sin(a));
+    }
+}
+
+static Polygon rounded_rect_polygon(float x, float y, float w, float h, int radius)
+{
+    Polygon poly;
+    float rr = radius > 0 ? radius + 0.5f : 0.0f;
+    rr = std::min(rr, std::min(w, h) * 0.5f);
+    if (rr <= 0.0f)
+    {
+        poly = {{x, y}, {x + w, y}, {x + w, y + h}, {x, y + h}};
+        return poly;
+    }
+    const float PI = 3.14159265f;
+    push_arc(poly, x + rr, y + rr, rr, PI, 1.5f * PI);
+    push_arc(poly, x + w - rr, y + rr, rr, 1.5f * PI, 2.0f * PI);
+    push_arc(poly, x + w - rr, y + h - rr, rr, 0.0f, 0.5f * PI);
+    push_arc(poly, x + rr, y + h - rr, rr, 0.5f * PI, PI);
+    if (poly.size() > 1 && std::fabs(poly.front().x - poly.back().x) < 0.01f && std::fabs(poly.front().y - poly.back().y) < 0.01f)
+        poly.pop_back();
+    return poly;
+}
+
+static Polygon hexagon_polygon(float x, float y, float w, float h)
+{
+    float p = std::min(h * 0.5f, w * 0.5f);
+    return {{x + p, y}, {x + w - p, y}, {x + w, y + h * 0.5f}, {x + w - p, y + h}, {x + p, y + h}, {x, y + h * 0.5f}};
+}
+
+/* Appends a convex polygon as a triangle fan, with an optional AA fringe */
+static void add_polygon(ShapeMesh &m, const Polygon &poly, Uint8 slot, bool aa)
+{
+    int n = (int)poly.size();
+    if (n < 3)
+        return;
+    SDL_FPoint c = {0, 0};
+    for (const auto &p : poly)
+    {
+        c.x += p.x;
+        c.y += p.y;
+    }
+    c.x /= n;
+    c.y /= n;
+
+    Polygon inner = poly, outer;
+    if (aa)
+    {
+        // Outward edge normals, then a mitred half-pixel inset and outset per vertex
+        std::vector<SDL_FPoint> normals(n);
+        for (int i = 0; i < n; i++)
+        {
+            const SDL_FPoint &a = poly[i], &b = poly[(i + 1) % n];
+            float dx = b.x - a.x, dy = b.y - a.y;
+            float len = std::sqrt(dx * dx + dy * dy);
+            SDL_FPoint nrm = {dy / len, -dx / len};
+            if (nrm.x * ((a.x + b.x) * 0.5f - c.x) + nrm.y * ((a.y + b.y) * 0.5f - c.y) < 0)
+                nrm = {-nrm.x, -nrm.y};
+            normals[i] = nrm;
+        }
+        outer.resize(n);
+        for (int i = 0; i < n; i++)
+        {
+            const SDL_FPoint &n0 = normals[(i + n - 1) % n], &n1 = normals[i];
+            float mx = n0.x + n1.x, my = n0.y + n1.y;
+            float len = std::sqrt(mx * mx + my * my);
+            if (len < 1e-4f)
+                mx = n1.x, my = n1.y, len = 1.0f;
+            mx /= len;
+            my /= len;
+            float scale = 0.5f / std::max(0.35f, mx * n1.x + my * n1.y);
+            inner[i] = {poly[i].x - mx * scale, poly[i].y - my * scale};
+            outer[i] = {poly[i].x + mx * scale, poly[i].y + my * scale};
+        }
+    }
+
+    int base = (int)m.verts.size();
+    m.verts.push_back({c.x, c.y, slot, 255});
+    for (const auto &p : inner)
+        m.verts.push_back({p.x, p.y, slot, 255});
+    for (int i = 0; i < n; i++)
+    {
+        m.indices.push_back(base);
+        m.indices.push_back(base + 1 + i);
+        m.indices.push_back(base + 1 + (i + 1) % n);
+    }
+    if (!aa)
+        return;
+    int ob = (int)m.verts.size();
+    for (const auto &p : outer)
+        m.verts.push_back({p.x, p.y, slot, 0});
+    for (int i = 0; i < n; i++)
+    {
+        int j = (i + 1) % n;
+        int quad[6] = {base + 1 + i, ob + i, ob + j, base + 1 + i, ob + j, base + 1 + j};
+        m.indices.insert(m.indices.end(), quad, quad + 6);
+    }
+}
+
+static void add_rounded_rect(ShapeMesh &m, int x, int y, int w, int h, int radius, Uint8 slot, bool aa)
+{
+    if (w <= 0 || h <= 0)
+        return;
+    add_polygon(m, rounded_rect_polygon((float)x, (float)y, (float)w, (float)h, radius), slot, aa);
+}
+
+static void build_block(ShapeMesh &m, int w, int h, const BlockOutline &o, bool aa)
+{
+    add_rounded_rect(m, 0, 0, w, h, o.radius, SLOT_BORDER, aa);
+    add_rounded_rect(m, 1, 1, w - 2, h - 2, std::max(0, o.radius - 1), SLOT_FILL, aa);
+    if (o.top_notch)
+    {
+        add_rounded_rect(m, o.notch_x, 0, o.notch_w, o.notch_h, o.notch_h / 2, SLOT_CUT, aa);
+        add_rounded_rect(m, o.notch_x, 1, o.notch_w, 2, 0, SLOT_SHADOW, false);
+    }
+    if (o.bottom_notch)
+        add_rounded_rect(m, o.notch_x, h - o.notch_h, o.notch_w, o.notch_h, o.notch_h / 2, SLOT_CUT, aa);
+}
+
+static void build_c_block(ShapeMesh &m, int w, int top_h, int inner_h, int bottom_h, int spine_w, const BlockOutline &o, bool aa)
+{
+    add_rounded_rect(m, 0, 0, w, top_h, o.radius, SLOT_BORDER, aa);
+    add_rounded_rect(m, 1, 1, w - 2, top_h - 2, o.radius, SLOT_FILL, aa);
+
+    int spine_y = top_h - 4, spine_h = inner_h + 8;
+    add_rounded_rect(m, 0, spine_y, spine_w, spine_h, 0, SLOT_FILL, false);
+    add_rounded_rect(m, 0, spine_y, 1, spine_h + 1, 0, SLOT_BORDER, false);
+
+    int bot_y = top_h + inner_h;
+    add_rounded_rect(m, 0, bot_y, w, bottom_h, o.radius, SLOT_BORDER, aa);
+    add_rounded_rect(m, 1, bot_y + 1, w - 2, bottom_h - 2, o.radius, SLOT_FILL, aa);
+
+    if (o.top_notch)
+        add_rounded_rect(m, o.notch_x, 0, o.notch_w, o.notch_h, o.notch_h / 2, SLOT_CUT, aa);
+    if (o.bottom_notch)
+        add_rounded_rect(m, o.notch_x, bot_y + bottom_h - o.notch_h, o.notch_w, o.notch_h, o.notch_h / 2, SLOT_CUT, aa);
+    // The notch of the first block inside the mouth
+    add_rounded_rect(m, spine_w + o.notch_x, top_h - o.notch_h, o.notch_w, o.notch_h, o.notch_h / 2, SLOT_FILL, aa);
+}
+
+// ---> CACHE + SUBMIT <---
+static const ShapeMesh &mesh_for(const ShapeKey &key)
+{
+    auto it = g_meshes.find(key);
+    if (it != g_meshes.end())
+        return it->second;
+    if (g_meshes.size() >= MESH_CACHE_MAX)
+        g_meshes.clear();
+
+    ShapeMesh m;
+    bool aa = key.v[1] != 0;
+    const int *p = key.v + 2;
+    switch ((ShapeKind)key.v[0])
+    {
+    case SHAPE_ROUNDED_RECT:
+        add_rounded_rect(m, 0, 0, p[0], p[1], p[2], 0, aa);
+        break;
+    case SHAPE_CIRCLE:
+        // A radius-r scanline circle spans 2r + 1 pixels
+        add_rounded_rect(m, 0, 0, 2 * p[0] + 1, 2 * p[0] + 1, p[0], 0, aa);
+        break;
+    case SHAPE_HEXAGON:
+        add_polygon(m, hexagon_polygon(0, 0, (float)p[0], (float)p[1]), 0, aa);
+        break;
+    case SHAPE_BLOCK:
+    {
+        BlockOutline o = {p[2], p[3], p[4], p[5], (p[6] & 1) != 0, (p[6] & 2) != 0};
+        build_block(m, p[0], p[1], o, aa);
+        break;
+    }
+    case SHAPE_C_BLOCK:
+    {
+        BlockOutline o = {p[5], p[6], p[7] & 0xFFFF, p[7] >> 16, false, false};
+        o.top_notch = (p[4] & (1 << 16)) != 0;
+        o.bottom_notch = (p[4] & (1 << 17)) != 0;
+        build_c_block(m, p[0], p[1], p[2], p[3], p[4] & 0xFFFF, o, aa);
+        break;
+    }
+    }
+    return g_meshes.emplace(key, std::move(m)).first->second;
+}
+
+static void render_verts(SDL_Renderer *r, const int *indices, int count)
+{
+    // Untextured geometry uses the draw blend mode; opaque slots look the same either way
+    SDL_BlendMode prev = rq_get_blend(r);
+    rq_set_blend(r, SDL_BLENDMODE_BLEND);
+    rq_geometry(r, NULL, g_verts.data(), (int)g_verts.size(), indices, count);
+    rq_set_blend(r, prev);
+}
+
+static void submit(SDL_Renderer *r, const ShapeMesh &m, float ox, float oy, const SDL_Color *slots)
+{
+    if (!r || m.indices.empty())
+        return;
+    // A batch keeps appending; otherwise the buffer holds just this shape
+    size_t base = g_batching ? g_verts.size() : 0;
+    g_verts.resize(base + m.verts.size());
+    for (size_t i = 0; i < m.verts.size(); i++)
+    {
+        const MeshVertex &v = m.verts[i];
+        SDL_Color c = slots[v.slot];
+        c.a = (Uint8)(c.a * v.alpha / 255);
+        g_verts[base + i].position = {ox + v.x, oy + v.y};
+        g_verts[base + i].color = c;
+        g_verts[base + i].tex_coord = {0.0f, 0.0f};
+    }
+    if (g_batching)
+    {
+        for (int idx : m.indices)
+            g_batch_indices.push_back((int)base + idx);
+        return;
+    }
+    render_verts(r, m.indices.data(), (int)m.indices.size());
+}
+
+void geometry_begin_batch()
+{
+    g_batching = true;
+    g_verts.clear();
+    g_batch_indices.clear();
+}
+
+void geometry_end_batch(SDL_Renderer *r)
+{
+    g_batching = false;
+    if (r && !g_batch_indices.empty())
+        render_verts(r, g_batch_indices.data(), (int)g_batch_indices.size());
+    g_verts.clear();
+    g_batch_indices.clear();
+}
+
+static ShapeKey make_key(ShapeKind kind, int a = 0, int b = 0, int c = 0, int d = 0, int e = 0, int f = 0, int g = 0, int h = 0)
+{
+    ShapeKey k = {{kind, antialias() ? 1 : 0, a, b, c, d, e, f, g, h}};
+    return k;
+}
+
+void geometry_fill_rounded_rect(SDL_Renderer *r, const SDL_Rect &rect, int radius, SDL_Color c)
+{
+    if (rect.w <= 0 || rect.h <= 0)
+        return;
+    radius = std::max(0, std::min(radius, std::min(rect.w, rect.h) / 2));
+    submit(r, mesh_for(make_key(SHAPE_ROUNDED_RECT, rect.w, rect.h, radius)), (float)rect.x, (float)rect.y, &c);
+}
+
+void geometry_fill_circle(SDL_Renderer *r, int cx, int cy, int radius, SDL_Color c)
+{
+    if (radius < 0)
+        return;
+    submit(r, mesh_for(make_key(SHAPE_CIRCLE, radius)), (float)(cx - radius), (float)(cy - radius), &c);
+}
+
+void geometry_fill_triangle(SDL_Renderer *r, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_Color col)
+{
+    ShapeMesh m;
+    m.verts = {{a.x, a.y, 0, 255}, {b.x, b.y, 0, 255}, {c.x, c.y, 0, 255}};
+    m.indices = {0, 1, 2};
+    submit(r, m, 0.0f, 0.0f, &col);
+}
+
+void geometry_fill_hexagon(SDL_Renderer *r, const SDL_Rect &rect, SDL_Color c)
+{
+    if (rect.w <= 0 || rect.h <= 0)
+        return;
+    submit(r, mesh_for(make_key(SHAPE_HEXAGON, rect.w, rect.h)), (float)rect.x, (float)rect.y, &c);
+}
+
+void geometry_fill_block(SDL_Renderer *r, const SDL_Rect &br, const BlockOutline &o, const SDL_Color slots[SLOT_COUNT])
+{
+    if (br.w <= 2 || br.h <= 2)
+        return;
+    int flags = (o.top_notch ? 1 : 0) | (o.bottom_notch ? 2 : 0);
+    submit(r, mesh_for(make_key(SHAPE_BLOCK, br.w, br.h, o.radius, o.notch_x, o.notch_w, o.notch_h, flags)), (float)br.x, (float)br.y, slots);
+}
+
+void geometry_fill_c_block(SDL_Renderer *r, int x, int y, int w, int top_h, int inner_h, int bottom_h, int spine_w,
+                           const BlockOutline &o, const SDL_Color slots[SLOT_COUNT])
+{
+    if (w <= 2 || top_h <= 2 || bottom_h <= 2)
+        return;
+    int flags = (spine_w & 0xFFFF) | (o.top_notch ? 1 << 16 : 0) | (o.bottom_notch ? 1 << 17 : 0);
+    int notch = (o.notch_w & 0xFFFF) | (o.notch_h << 16);
+    submit(r, mesh_for(make_key(SHAPE_C_BLOCK, w, top_h, inner_h, bottom_h, flags, o.radius, o.notch_x, notch)), (float)x, (float)y, slots);
+}
@@ -0,0 +1,48 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include "SDL.h"
+
+// ---> TESSELLATED SHAPES <---
+// Rounded rects, circles, pointed (boolean) capsules and whole block outlines
+// are turned into triangle meshes once per (shape, size, radius) and cached;
+// drawing one is a single rq_geometry call with the colours filled in. Inside a
+// render queue recording those merge with the shapes around them; elsewhere a
+// geometry_begin_batch / geometry_end_batch pair collects them into one call.
+// Edges get a half-pixel alpha fringe when ANTIALIAS_SHAPES=1 (off by default).
+
+/* Colour slots of the composite block meshes */
+enum ShapeSlot
+{
+    SLOT_BORDER = 0,
+    SLOT_FILL,
+    SLOT_CUT,    // notch cut-outs, drawn in the panel background colour
+    SLOT_SHADOW, // thin shade under the top notch; alpha is honoured
+    SLOT_COUNT
+};
+
+struct BlockOutline
+{
+    int radius;
+    int notch_x, notch_w, notch_h;
+    bool top_notch, bottom_notch;
+};
+
+void geometry_fill_rounded_rect(SDL_Renderer *r, const SDL_Rect &rect, int radius, SDL_Color c);
+void geometry_fill_circle(SDL_Renderer *r, int cx, int cy, int radius, SDL_Color c);
+/* Rect with both ends pointed, as used by boolean blocks and slots */
+void geometry_fill_hexagon(SDL_Renderer *r, const SDL_Rect &rect, SDL_Color c);
+/* Plain triangle; not cached, no AA fringe */
+void geometry_fill_triangle(SDL_Renderer *r, SDL_FPoint a, SDL_FPoint b, SDL_FPoint c, SDL_Color col);
+
+/* Stack block: border, 1px-inset fill, notch cut-outs and the notch shade */
+void geometry_fill_block(SDL_Renderer *r, const SDL_Rect &br, const BlockOutline &o, const SDL_Color slots[SLOT_COUNT]);
+/* C block: top arm, spine of width spine_w around the mouth, bottom arm */
+void geometry_fill_c_block(SDL_Renderer *r, int x, int y, int w, int top_h, int inner_h, int bottom_h, int spine_w,
+                           const BlockOutline &o, const SDL_Color slots[SLOT_COUNT]);
+
+/* Between these, fills are collected and drawn in one SDL_RenderGeometry call at the end */
+void geometry_begin_batch();
+void geometry_end_batch(SDL_Renderer *r);
+
+#endif
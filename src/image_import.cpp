@@ -0,0 +1,300 @@
+#include "image_import.h"
+#include "SDL_image.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+
+struct ImportJob
+{
+    ImportTarget target;
+    int sprite;
+    std::string name;
+    std::string path;
+    Uint32 project_gen, sprite_gen; // generations at request time; see image_import_cancel
+};
+
+static SDL_Thread *g_worker = nullptr;
+static SDL_mutex *g_lock = nullptr;
+static SDL_cond *g_wake = nullptr;
+static std::deque<ImportJob> g_jobs;
+static std::deque<ImportResult> g_done;
+static bool g_quit = false;
+static Uint32 g_project_gen = 0; // bumped when the project goes away
+static Uint32 g_sprite_gen = 0;  // bumped when sprite indices shift
+
+// Costume imports name their sprite by index, so they also go stale when indices shift
+static bool job_stale(const ImportJob &job)
+{
+    return job.project_gen != g_project_gen || (job.target == IMPORT_COSTUME && job.sprite_gen != g_sprite_gen);
+}
+
+// ---> AREA-AVERAGE RESAMPLER <---
+// Each output pixel is the coverage-weighted mean of the source pixels under it,
+// in premultiplied alpha so transparent edges don't bleed dark fringes.
+struct Tap
+{
+    int src;
+    float weight;
+};
+
+static void build_taps(int src_len, int dst_len, std::vector<int> &start, std::vector<Tap> &taps)
+{
+    float ratio = (float)src_len / dst_len;
+    start.assign(dst_len + 1, 0);
+    taps.clear();
+    for (int d = 0; d < dst_len; d++)
+    {
+        start[d] = (int)taps.size();
+        float a = d * ratio, b = (d + 1) * ratio;
+        for (int s = (int)a; s < (int)std::ceil(b) && s < src_len; s++)
+        {
+            float w = std::min(b, (float)(s + 1)) - std::max(a, (float)s);
+            if (w > 0.0f)
+                taps.push_back({s, w / ratio});
+        }
+    }
+    start[dst_len] = (int)taps.size();
+}
+
+static SDL_Surface *downscale(SDL_Surface *src, int dw, int dh)
+{
+    SDL_Surface *dst = SDL_CreateRGBSurfaceWithFormat(0, dw, dh, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!dst)
+        return nullptr;
+
+    std::vector<int> xs, ys;
+    std::vector<Tap> xt, yt;
+    build_taps(src->w, dw, xs, xt);
+    build_taps(src->h, dh, ys, yt);
+
+    // One horizontally resampled source row at a time, accumulated into the output row
+    std::vector<float> row(dw * 4), acc(dw * 4);
+    int cached_row = -1;
+    for (int dy = 0; dy < dh; dy++)
+    {
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        for (int t = ys[dy]; t < ys[dy + 1]; t++)
+        {
+            int sy = yt[t].src;
+            if (sy != cached_row)
+            {
+                const Uint8 *sp = (const Uint8 *)src->pixels + sy * src->pitch;
+                for (int dx = 0; dx < dw; dx++)
+                {
+                    float r = 0, g = 0, b = 0, a = 0;
+                    for (int k = xs[dx]; k < xs[dx + 1]; k++)
+                    {
+                        const Uint8 *p = sp + xt[k].src * 4;
+                        float w = xt[k].weight * p[3];
+                        r += p[0] * w;
+                        g += p[1] * w;
+                        b += p[2] * w;
+                        a += w;
+                    }
+                    float *o = &row[dx * 4];
+                    o[0] = r;
+                    o[1] = g;
+                    o[2] = b;
+                    o[3] = a;
+                }
+                cached_row = sy;
+            }
+            float w = yt[t].weight;
+            for (int i = 0; i < dw * 4; i++)
+                acc[i] += row[i] * w;
+        }
+
+        Uint8 *dp = (Uint8 *)dst->pixels + dy * dst->pitch;
+        for (int dx = 0; dx < dw; dx++)
+        {
+            const float *c = &acc[dx * 4];
+            float a = c[3];
+            if (a <= 0.0f)
+            {
+                dp[dx * 4 + 0] = dp[dx * 4 + 1] = dp[dx * 4 + 2] = dp[dx * 4 + 3] = 0;
+                continue;
+            }
+            dp[dx * 4 + 0] = (Uint8)std::min(255.0f, c[0] / a + 0.5f);
+            dp[dx * 4 + 1] = (Uint8)std::min(255.0f, c[1] / a + 0.5f);
+            dp[dx * 4 + 2] = (Uint8)std::min(255.0f, c[2] / a + 0.5f);
+            dp[dx * 4 + 3] = (Uint8)std::min(255.0f, a + 0.5f);
+        }
+    }
+    return dst;
+}
+
+SDL_Surface *image_import_decode(const std::string &path, int max_w, int max_h)
+{
+    SDL_Surface *raw = IMG_Load(path.c_str());
+    if (!raw)
+    {
+        SDL_Log("IMG_Load failed for '%s': %s", path.c_str(), IMG_GetError());
+        return nullptr;
+    }
+    SDL_Surface *surf = SDL_ConvertSurfaceFormat(raw, SDL_PIXELFORMAT_RGBA32, 0);
+    SDL_FreeSurface(raw);
+    if (!surf)
+        return nullptr;
+
+    if (surf->w <= max_w && surf->h <= max_h)
+        return surf;
+
+    float scale = std::min((float)max_w / surf->w, (float)max_h / surf->h);
+    int dw = std::max(1, (int)(surf->w * scale + 0.5f));
+    int dh = std::max(1, (int)(surf->h * scale + 0.5f));
+    SDL_Surface *small = downscale(surf, dw, dh);
+    SDL_FreeSurface(surf);
+    return small;
+}
+
+SDL_Texture *image_import_load_texture(SDL_Renderer *r, const std::string &path)
+{
+    SDL_Surface *surf = image_import_decode(path, IMPORT_MAX_W, IMPORT_MAX_H);
+    if (!surf)
+        return nullptr;
+    SDL_Texture *t = SDL_CreateTextureFromSurface(r, surf);
+    SDL_FreeSurface(surf);
+    return t;
+}
+
+// ---> WORKER <---
+static int import_worker(void *)
+{
+    TRACE_THREAD_NAME("image_import");
+    SDL_LockMutex(g_lock);
+    while (!g_quit)
+    {
+        if (g_jobs.empty())
+        {
+            SDL_CondWait(g_wake, g_lock);
+            continue;
+        }
+        ImportJob job = g_jobs.front();
+        g_jobs.pop_front();
+        SDL_UnlockMutex(g_lock);
+
+        TRACE_ZONE_BEGIN(decode_zone, "decode image");
+        SDL_Surface *surf = image_import_decode(job.path, IMPORT_MAX_W, IMPORT_MAX_H);
+        TRACE_ZONE_END(decode_zone);
+
+        SDL_LockMutex(g_lock);
+        if (job_stale(job))
+        {
+            if (surf)
+                SDL_FreeSurface(surf);
+            continue;
+        }
+        g_done.push_back({job.target, job.sprite, job.name, job.path, surf});
+    }
+    SDL_UnlockMutex(g_lock);
+    return 0;
+}
+
+bool image_import_init()
+{
+    g_lock = SDL_CreateMutex();
+    g_wake = SDL_CreateCond();
+    if (!g_lock || !g_wake)
+    {
+        SDL_Log("Image import: could not create sync objects: %s", SDL_GetError());
+        return false;
+    }
+    g_quit = false;
+    g_worker = SDL_CreateThread(import_worker, "image_import", nullptr);
+    if (!g_worker)
+    {
+        SDL_Log("Image import: could not start worker, decoding inline: %s", SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+void image_import_quit()
+{
+    if (g_worker)
+    {
+        SDL_LockMutex(g_lock);
+        g_quit = true;
+        SDL_CondSignal(g_wake);
+        SDL_UnlockMutex(g_lock);
+        SDL_WaitThread(g_worker, nullptr);
+        g_worker = nullptr;
+    }
+    for (auto &res : g_done)
+        if (res.surface)
+            SDL_FreeSurface(res.surface);
+    g_done.clear();
+    g_jobs.clear();
+    if (g_wake)
+        SDL_DestroyCond(g_wake);
+    if (g_lock)
+        SDL_DestroyMutex(g_lock);
+    g_wake = nullptr;
+    g_lock = nullptr;
+}
+
+void image_import_request(ImportTarget target, int sprite, const std::string &name, const std::string &path)
+{
+    if (!g_worker)
+    {
+        // No worker thread: decode now, still hand the result out through poll
+        g_done.push_back({target, sprite, name, path, image_import_decode(path, IMPORT_MAX_W, IMPORT_MAX_H)});
+        return;
+    }
+    SDL_LockMutex(g_lock);
+    g_jobs.push_back({target, sprite, name, path, g_project_gen, g_sprite_gen});
+    SDL_CondSignal(g_wake);
+    SDL_UnlockMutex(g_lock);
+}
+
+bool image_import_poll(ImportResult &out)
+{
+    if (g_lock)
+        SDL_LockMutex(g_lock);
+    bool got = !g_done.empty();
+    if (got)
+    {
+        out = g_done.front();
+        g_done.pop_front();
+    }
+    if (g_lock)
+        SDL_UnlockMutex(g_lock);
+    return got;
+}
+
+static void cancel(bool costumes_only)
+{
+    if (g_lock)
+        SDL_LockMutex(g_lock);
+    if (costumes_only)
+        g_sprite_gen++;
+    else
+        g_project_gen++;
+    // Queued jobs are dropped here, the one being decoded when it finishes
+    g_jobs.erase(std::remove_if(g_jobs.begin(), g_jobs.end(), job_stale), g_jobs.end());
+    for (auto it = g_done.begin(); it != g_done.end();)
+    {
+        if (costumes_only && it->target != IMPORT_COSTUME)
+        {
+            ++it;
+            continue;
+        }
+        if (it->surface)
+            SDL_FreeSurface(it->surface);
+        it = g_done.erase(it);
+    }
+    if (g_lock)
+        SDL_UnlockMutex(g_lock);
+}
+
+void image_import_cancel()
+{
+    cancel(false);
+}
+
+void image_import_cancel_costumes()
+{
+    cancel(true);
+}
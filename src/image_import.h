@@ -0,0 +1,46 @@
+#ifndef IMAGE_IMPORT_H
+#define IMAGE_IMPORT_H
+
+#include "SDL.h"
+#include <string>
+
+// ---> IMAGE IMPORT <---
+// Picked images are decoded on a worker thread and, when larger than the
+// costume canvas (1920x1440), area-averaged down to fit it. The copy in the
+// project's assets folder is left untouched so it can be re-imported at full size.
+
+static const int IMPORT_MAX_W = 1920;
+static const int IMPORT_MAX_H = 1440;
+
+enum ImportTarget
+{
+    IMPORT_SPRITE,   // new sprite
+    IMPORT_BACKDROP, // new backdrop
+    IMPORT_COSTUME   // new costume on sprite `sprite`
+};
+
+struct ImportResult
+{
+    ImportTarget target;
+    int sprite;
+    std::string name;
+    std::string path;
+    SDL_Surface *surface; // RGBA32, nullptr when decoding failed; caller frees
+};
+
+bool image_import_init();
+void image_import_quit();
+
+/* Queue a decode; results come back from image_import_poll in request order */
+void image_import_request(ImportTarget target, int sprite, const std::string &name, const std::string &path);
+bool image_import_poll(ImportResult &out);
+/* Drops every pending decode; call before the sprites and backdrops are replaced (New, Load) */
+void image_import_cancel();
+/* Drops pending costume decodes only; call before a sprite is removed, as indices shift */
+void image_import_cancel_costumes();
+
+/* Synchronous decode + downscale (used by the worker and by project loading) */
+SDL_Surface *image_import_decode(const std::string &path, int max_w, int max_h);
+SDL_Texture *image_import_load_texture(SDL_Renderer *r, const std::string &path);
+
+#endif
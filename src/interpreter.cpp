@@ -3,6 +3,8 @@
 #include "audio.h"
 #include "renderer.h"
 #include "logger.h"
+#include "stage.h"
+#include "trace.h"
 #include "SDL.h"
 #include "config.h"
 #include <cmath>
@@ -12,6 +14,7 @@
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
+#include <cstring>
 
 void interpreter_trigger_message(AppState &state, int msg_opt);
 
@@ -129,12 +132,13 @@ struct ScriptThread
 {
     std::vector<StackFrame> stack;
     unsigned int wait_until;
-    bool waiting_for_sound;
+    bool waiting_for_sound; // wait_until is when the sound ends; stop all sounds clears it
     bool waiting_for_ask;
     std::string sprite_name;
     int root_node;
 };
 static std::vector<ScriptThread> g_threads;
+static int g_blocks_last_tick = 0;
 
 static BlockInstance *interpreter_find_block(Sprite &spr, int id)
 {
@@ -144,30 +148,106 @@ static BlockInstance *interpreter_find_block(Sprite &spr, int id)
     return nullptr;
 }
 
-static void get_sprite_screen_rect(Sprite &spr, int &cx, int &cy, int &w, int &h)
+// ---> PER-TICK INPUT / STAGE SNAPSHOT <---
+// Captured once per frame by interpreter_capture_input() so sensing blocks
+// read plain fields instead of polling SDL and recomputing the stage layout.
+struct TickSnapshot
 {
-    int col_x = WINDOW_WIDTH - RIGHT_COLUMN_WIDTH;
-    int col_h = WINDOW_HEIGHT - NAVBAR_HEIGHT;
-    int stage_h = col_h * STAGE_HEIGHT_RATIO / 100;
-    int margin = 8;
-    int stage_area_x = col_x + margin;
-    int stage_area_y = NAVBAR_HEIGHT + margin;
-    int stage_area_w = RIGHT_COLUMN_WIDTH - margin * 2;
-    int stage_area_h = stage_h - margin * 2;
-
-    int stage_cx = stage_area_x + stage_area_w / 2;
-    int stage_cy = stage_area_y + stage_area_h / 2;
-
-    float scale_x = (float)stage_area_w / 480.0f;
-    float scale_y = (float)stage_area_h / 360.0f;
-
-    cx = stage_cx + (int)(spr.x * scale_x);
-    cy = stage_cy - (int)(spr.y * scale_y);
-
-    int base_w = 100;
-    int base_h = 100;
-    w = (int)((base_w * spr.size / 100.0f) * scale_x);
-    h = (int)((base_h * spr.size / 100.0f) * scale_y);
+    int mouse_x, mouse_y;               // window coords
+    float mouse_stage_x, mouse_stage_y; // Scratch coords
+    bool mouse_down;
+    Uint8 keys[SDL_NUM_SCANCODES];
+};
+static TickSnapshot g_tick = {};
+
+// ---> SENSING QUERY CACHE <---
+// Results keyed by (sprite index, query). Each entry remembers the sprite pose it
+// was computed for, so a move/turn/costume switch inside the tick invalidates it.
+// The whole cache is dropped when a new snapshot is captured, and whenever the
+// sprite list changes size, since indices may then name different sprites.
+struct SenseCacheEntry
+{
+    int sprite;
+    unsigned long long query;
+    int x, y, direction, size;
+    SDL_Texture *texture;
+    float value;
+};
+static std::vector<SenseCacheEntry> g_sense_cache;
+static size_t g_sense_sprite_count = 0; // state.sprites.size() when the cache was filled
+
+// Index of spr in state.sprites, or -1 when it is not one of them (never cached)
+static int sense_sprite_index(const AppState &state, const Sprite &spr)
+{
+    if (state.sprites.size() != g_sense_sprite_count)
+    {
+        g_sense_cache.clear();
+        g_sense_sprite_count = state.sprites.size();
+    }
+    if (state.sprites.empty() || &spr < state.sprites.data() || &spr >= state.sprites.data() + state.sprites.size())
+        return -1;
+    return (int)(&spr - state.sprites.data());
+}
+
+static bool sense_cache_lookup(const AppState &state, const Sprite &spr, unsigned long long query, float &out)
+{
+    int idx = sense_sprite_index(state, spr);
+    for (const auto &e : g_sense_cache)
+    {
+        if (e.sprite != idx || e.query != query)
+            continue;
+        if (e.x != spr.x || e.y != spr.y || e.direction != spr.direction || e.size != spr.size || e.texture != spr.texture)
+            return false;
+        out = e.value;
+        return true;
+    }
+    return false;
+}
+
+static void sense_cache_store(const AppState &state, const Sprite &spr, unsigned long long query, float value)
+{
+    int idx = sense_sprite_index(state, spr);
+    if (idx < 0)
+        return;
+    SenseCacheEntry fresh = {idx, query, spr.x, spr.y, spr.direction, spr.size, spr.texture, value};
+    for (auto &e : g_sense_cache)
+    {
+        if (e.sprite == idx && e.query == query)
+        {
+            e = fresh;
+            return;
+        }
+    }
+    g_sense_cache.push_back(fresh);
+}
+
+static unsigned long long sense_query_key(const BlockInstance &b)
+{
+    unsigned long long key = (unsigned long long)(b.subtype & 0xFF) << 56;
+    if (b.subtype == SENSB_TOUCHING_COLOR || b.subtype == SENSB_COLOR_IS_TOUCHING_COLOR)
+    {
+        key |= ((unsigned long long)b.color1.r << 40) | ((unsigned long long)b.color1.g << 32) | ((unsigned long long)b.color1.b << 24);
+        key |= ((unsigned long long)b.color2.r << 16) | ((unsigned long long)b.color2.g << 8) | (unsigned long long)b.color2.b;
+    }
+    else
+        key |= (unsigned long long)(unsigned int)b.opt;
+    return key;
+}
+
+void interpreter_capture_input(const StageRects &rects)
+{
+    // Events were already pumped by the main loop's SDL_PollEvent
+    Uint32 buttons = SDL_GetMouseState(&g_tick.mouse_x, &g_tick.mouse_y);
+    g_tick.mouse_down = (buttons & SDL_BUTTON(SDL_BUTTON_LEFT)) != 0;
+    stage_window_to_stage(rects, g_tick.mouse_x, g_tick.mouse_y, g_tick.mouse_stage_x, g_tick.mouse_stage_y);
+
+    int numkeys = 0;
+    const Uint8 *keys = SDL_GetKeyboardState(&numkeys);
+    std::memset(g_tick.keys, 0, sizeof(g_tick.keys));
+    if (keys)
+        std::memcpy(g_tick.keys, keys, std::min(numkeys, (int)SDL_NUM_SCANCODES));
+
+    g_sense_cache.clear();
 }
 
 // ---> ADDED: Helper to extract text from parameter slots
@@ -291,51 +371,20 @@ static float eval_value(AppState &state, Sprite &spr, int block_id, float defaul
             if (b->subtype == SENSB_ANSWER)
                 return std::atof(state.global_answer.c_str());
             if (b->subtype == SENSB_MOUSE_X)
-            {
-                int mx, my;
-                SDL_GetMouseState(&mx, &my);
-                int col_x = WINDOW_WIDTH - RIGHT_COLUMN_WIDTH;
-                int margin = 8;
-                int stage_area_w = RIGHT_COLUMN_WIDTH - margin * 2;
-                int stage_cx = col_x + margin + stage_area_w / 2;
-                float scale_x = 480.0f / stage_area_w;
-                return (mx - stage_cx) * scale_x;
-            }
+                return g_tick.mouse_stage_x;
             if (b->subtype == SENSB_MOUSE_Y)
-            {
-                int mx, my;
-                SDL_GetMouseState(&mx, &my);
-                int col_h = WINDOW_HEIGHT - NAVBAR_HEIGHT;
-                int stage_h = col_h * STAGE_HEIGHT_RATIO / 100;
-                int margin = 8;
-                int stage_area_h = stage_h - margin * 2;
-                int stage_cy = NAVBAR_HEIGHT + margin + stage_area_h / 2;
-                float scale_y = 360.0f / stage_area_h;
-                return (stage_cy - my) * scale_y;
-            }
+                return g_tick.mouse_stage_y;
             if (b->subtype == SENSB_DISTANCE_TO)
             {
-                int mx, my;
-                SDL_GetMouseState(&mx, &my);
-                int col_x = WINDOW_WIDTH - RIGHT_COLUMN_WIDTH;
-                int col_h = WINDOW_HEIGHT - NAVBAR_HEIGHT;
-                int stage_h = col_h * STAGE_HEIGHT_RATIO / 100;
-                int margin = 8;
-                int stage_area_w = RIGHT_COLUMN_WIDTH - margin * 2;
-                int stage_area_h = stage_h - margin * 2;
-
-                int stage_cx = col_x + margin + stage_area_w / 2;
-                int stage_cy = NAVBAR_HEIGHT + margin + stage_area_h / 2;
-
-                float scale_x = 480.0f / stage_area_w;
-                float scale_y = 360.0f / stage_area_h;
-
-                float mouse_scratch_x = (mx - stage_cx) * scale_x;
-                float mouse_scratch_y = (stage_cy - my) * scale_y;
-
-                float dx = mouse_scratch_x - spr.x;
-                float dy = mouse_scratch_y - spr.y;
-                return std::sqrt(dx * dx + dy * dy);
+                unsigned long long q = sense_query_key(*b);
+                float dist;
+                if (sense_cache_lookup(state, spr, q, dist))
+                    return dist;
+                float dx = g_tick.mouse_stage_x - spr.x;
+                float dy = g_tick.mouse_stage_y - spr.y;
+                dist = std::sqrt(dx * dx + dy * dy);
+                sense_cache_store(state, spr, q, dist);
+                return dist;
             }
             if (b->subtype == SENSB_TOUCHING || b->subtype == SENSB_KEY_PRESSED || b->subtype == SENSB_MOUSE_DOWN || b->subtype == SENSB_TOUCHING_COLOR || b->subtype == SENSB_COLOR_IS_TOUCHING_COLOR)
                 return eval_bool(state, spr, block_id) ? 1.0f : 0.0f;
@@ -425,6 +474,99 @@ static std::string eval_string(AppState &state, Sprite &spr, int block_id, const
     return text_val;
 }
 
+// Touching / color sensing. Uncached; eval_bool goes through g_sense_cache.
+static bool sense_touching(const AppState &state, Sprite &spr, const BlockInstance &b)
+{
+    if (b.subtype == SENSB_TOUCHING)
+    {
+        if (b.opt == TOUCHING_MOUSE_POINTER)
+        {
+            // Same stage-pixel bounds the stage draws and hit-tests with
+            SDL_Rect sr = stage_sprite_rect(spr);
+            float px = STAGE_WIDTH / 2.0f + g_tick.mouse_stage_x;
+            float py = STAGE_HEIGHT / 2.0f - g_tick.mouse_stage_y;
+            return (px >= sr.x && px <= sr.x + sr.w && py >= sr.y && py <= sr.y + sr.h);
+        }
+        else if (b.opt == TOUCHING_EDGE)
+        {
+            SDL_Rect sr = stage_sprite_rect(spr);
+            return (sr.x <= 0 || sr.x + sr.w >= STAGE_WIDTH || sr.y <= 0 || sr.y + sr.h >= STAGE_HEIGHT);
+        }
+        else if (b.opt == TOUCHING_SPRITE)
+            return false;
+    }
+    if (b.subtype == SENSB_TOUCHING_COLOR || b.subtype == SENSB_COLOR_IS_TOUCHING_COLOR)
+    {
+        // Stage (backdrop + pen) pixels, read back again only after either changed
+        const GraphicItem *backdrop = nullptr;
+        if (state.selected_backdrop >= 0 && state.selected_backdrop < (int)state.backdrops.size())
+            backdrop = &state.backdrops[state.selected_backdrop];
+        const Uint32 *stage = renderer_stage_snapshot_pixels(backdrop);
+        SDL_Rect area;
+        if (!stage || !renderer_sprite_pen_bounds(spr, area))
+            return false;
+
+        // ---> NEW: Get exact pixels of the Sprite to ignore transparent corners! <---
+        // Rasterized on the CPU with the same math as renderer_stamp_on_pen_layer
+        std::vector<Uint32> sprite_pixels;
+        renderer_rasterize_sprite(spr, area, sprite_pixels);
+
+        std::vector<Uint32> stage_pixels(area.w * area.h);
+        for (int row = 0; row < area.h; row++)
+            std::memcpy(&stage_pixels[row * area.w], stage + (area.y + row) * 480 + area.x, area.w * 4);
+
+        const int EPS = 10; // small epsilon for color matching
+
+        if (b.subtype == SENSB_TOUCHING_COLOR)
+        {
+            Uint8 tr = b.color1.r, tg = b.color1.g, tb_ = b.color1.b;
+            for (size_t i = 0; i < stage_pixels.size(); i++)
+            {
+                // ---> FIXED: Only trigger if the sprite pixel is NOT transparent! <---
+                if ((sprite_pixels[i] & 0xFF) < 10)
+                    continue;
+
+                Uint32 px = stage_pixels[i];
+                Uint8 r2 = (px >> 24) & 0xFF;
+                Uint8 g2 = (px >> 16) & 0xFF;
+                Uint8 b2 = (px >> 8) & 0xFF;
+                if (std::abs((int)r2 - tr) <= EPS && std::abs((int)g2 - tg) <= EPS && std::abs((int)b2 - tb_) <= EPS)
+                    return true;
+            }
+            return false;
+        }
+        else // SENSB_COLOR_IS_TOUCHING_COLOR
+        {
+            Uint8 tr1 = b.color1.r, tg1 = b.color1.g, tb1 = b.color1.b;
+            Uint8 tr2 = b.color2.r, tg2 = b.color2.g, tb2 = b.color2.b;
+            for (size_t i = 0; i < stage_pixels.size(); i++)
+            {
+                // ---> FIXED: Check if sprite pixel exists AND matches Color 1! <---
+                if ((sprite_pixels[i] & 0xFF) < 10)
+                    continue;
+
+                Uint8 sr = (sprite_pixels[i] >> 24) & 0xFF;
+                Uint8 sg = (sprite_pixels[i] >> 16) & 0xFF;
+                Uint8 sb = (sprite_pixels[i] >> 8) & 0xFF;
+
+                // Is the sprite pixel color equal to Color 1?
+                if (std::abs((int)sr - tr1) <= EPS && std::abs((int)sg - tg1) <= EPS && std::abs((int)sb - tb1) <= EPS)
+                {
+                    // Check if stage pixel behind it matches Color 2
+                    Uint32 px = stage_pixels[i];
+                    Uint8 r2 = (px >> 24) & 0xFF;
+                    Uint8 g2 = (px >> 16) & 0xFF;
+                    Uint8 b2 = (px >> 8) & 0xFF;
+                    if (std::abs((int)r2 - tr2) <= EPS && std::abs((int)g2 - tg2) <= EPS && std::abs((int)b2 - tb2) <= EPS)
+                        return true;
+                }
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
 static bool eval_bool(AppState &state, Sprite &spr, int block_id)
 {
     if (block_id == -1)
@@ -461,8 +603,7 @@ static bool eval_bool(AppState &state, Sprite &spr, int block_id)
     {
         if (b->subtype == SENSB_KEY_PRESSED)
         {
-            SDL_PumpEvents();
-            const Uint8 *keys = SDL_GetKeyboardState(NULL);
+            const Uint8 *keys = g_tick.keys;
             int opt = b->opt;
             bool pressed = false;
             if (opt == 0)
@@ -485,145 +626,17 @@ static bool eval_bool(AppState &state, Sprite &spr, int block_id)
         }
         if (b->subtype == SENSB_MOUSE_DOWN)
         {
-            SDL_PumpEvents();
-            return (SDL_GetMouseState(NULL, NULL) & SDL_BUTTON(SDL_BUTTON_LEFT)) != 0;
+            return g_tick.mouse_down;
         }
-        if (b->subtype == SENSB_TOUCHING)
+        if (b->subtype == SENSB_TOUCHING || b->subtype == SENSB_TOUCHING_COLOR || b->subtype == SENSB_COLOR_IS_TOUCHING_COLOR)
         {
-            if (b->opt == TOUCHING_MOUSE_POINTER)
-            {
-                int mx, my;
-                SDL_GetMouseState(&mx, &my);
-                int cx, cy, w, h;
-                get_sprite_screen_rect(spr, cx, cy, w, h);
-                float half_w = w / 2.0f;
-                float half_h = h / 2.0f;
-                return (mx >= cx - half_w && mx <= cx + half_w && my >= cy - half_h && my <= cy + half_h);
-            }
-            else if (b->opt == TOUCHING_EDGE)
-            {
-                float half_w = (100 * spr.size) / 200.0f;
-                float half_h = (100 * spr.size) / 200.0f;
-                return (spr.x - half_w <= -240 || spr.x + half_w >= 240 || spr.y - half_h <= -180 || spr.y + half_h >= 180);
-            }
-            else if (b->opt == TOUCHING_SPRITE)
-                return false;
-        }
-        if (b->subtype == SENSB_TOUCHING_COLOR || b->subtype == SENSB_COLOR_IS_TOUCHING_COLOR)
-        {
-            if (!g_stage_snapshot || !g_pen_renderer)
-                return false;
-
-            // Use EXACT same coordinate math as renderer_stamp_on_pen_layer
-            int spr_px = 240 + spr.x; // Scratch → pen layer x
-            int spr_py = 180 - spr.y; // Scratch → pen layer y
-
-            int tex_w = 100, tex_h = 100;
-            if (spr.texture)
-                SDL_QueryTexture(spr.texture, NULL, NULL, &tex_w, &tex_h);
-            int base_w = tex_w, base_h = tex_h;
-            const int MAX_DEFAULT = 120;
-            if (base_w > MAX_DEFAULT || base_h > MAX_DEFAULT)
-            {
-                if (base_w > base_h)
-                {
-                    base_h = base_h * MAX_DEFAULT / base_w;
-                    base_w = MAX_DEFAULT;
-                }
-                else
-                {
-                    base_w = base_w * MAX_DEFAULT / base_h;
-                    base_h = MAX_DEFAULT;
-                }
-            }
-            int sw = std::max(1, base_w * spr.size / 100);
-            int sh = std::max(1, base_h * spr.size / 100);
-
-            // Sprite's bounding box in pen-layer coords
-            int x0 = std::max(0, spr_px - sw / 2);
-            int y0 = std::max(0, spr_py - sh / 2);
-            int x1 = std::min(479, spr_px + sw / 2);
-            int y1 = std::min(359, spr_py + sh / 2);
-            if (x0 >= x1 || y0 >= y1)
-                return false;
-
-            int rw = x1 - x0, rh = y1 - y0;
-            SDL_Rect sample_rect = {x0, y0, rw, rh};
-
-            // Get pixels from the Stage (Background)
-            std::vector<Uint32> stage_pixels(rw * rh, 0);
-            SDL_Texture *prev_target = SDL_GetRenderTarget(g_pen_renderer);
-            SDL_SetRenderTarget(g_pen_renderer, g_stage_snapshot);
-            SDL_RenderReadPixels(g_pen_renderer, &sample_rect, SDL_PIXELFORMAT_ARGB8888, stage_pixels.data(), rw * 4);
-
-            // ---> NEW: Get exact pixels of the Sprite to ignore transparent corners! <---
-            std::vector<Uint32> sprite_pixels(rw * rh, 0);
-            SDL_Texture *temp_tex = SDL_CreateTexture(g_pen_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, rw, rh);
-            if (temp_tex)
-            {
-                SDL_SetTextureBlendMode(temp_tex, SDL_BLENDMODE_BLEND);
-                SDL_SetRenderTarget(g_pen_renderer, temp_tex);
-                SDL_SetRenderDrawColor(g_pen_renderer, 0, 0, 0, 0); // Clear with fully transparent background
-                SDL_RenderClear(g_pen_renderer);
-
-                // Render the sprite exactly as it appears on screen (with rotation!)
-                SDL_Rect spr_dest = {(spr_px - sw / 2) - x0, (spr_py - sh / 2) - y0, sw, sh};
-                double angle = spr.direction - 90.0;
-                SDL_Point center = {sw / 2, sh / 2};
-                SDL_RenderCopyEx(g_pen_renderer, spr.texture, NULL, &spr_dest, angle, &center, SDL_FLIP_NONE);
-                SDL_RenderReadPixels(g_pen_renderer, NULL, SDL_PIXELFORMAT_ARGB8888, sprite_pixels.data(), rw * 4);
-                SDL_DestroyTexture(temp_tex);
-            }
-            SDL_SetRenderTarget(g_pen_renderer, prev_target);
-
-            const int EPS = 10; // small epsilon for color matching
-
-            if (b->subtype == SENSB_TOUCHING_COLOR)
-            {
-                Uint8 tr = b->color1.r, tg = b->color1.g, tb_ = b->color1.b;
-                for (size_t i = 0; i < stage_pixels.size(); i++)
-                {
-                    // ---> FIXED: Only trigger if the sprite pixel is NOT transparent! <---
-                    if ((sprite_pixels[i] >> 24) < 10)
-                        continue;
-
-                    Uint32 px = stage_pixels[i];
-                    Uint8 r2 = (px >> 16) & 0xFF;
-                    Uint8 g2 = (px >> 8) & 0xFF;
-                    Uint8 b2 = (px >> 0) & 0xFF;
-                    if (std::abs((int)r2 - tr) <= EPS && std::abs((int)g2 - tg) <= EPS && std::abs((int)b2 - tb_) <= EPS)
-                        return true;
-                }
-                return false;
-            }
-            else // SENSB_COLOR_IS_TOUCHING_COLOR
-            {
-                Uint8 tr1 = b->color1.r, tg1 = b->color1.g, tb1 = b->color1.b;
-                Uint8 tr2 = b->color2.r, tg2 = b->color2.g, tb2 = b->color2.b;
-                for (size_t i = 0; i < stage_pixels.size(); i++)
-                {
-                    // ---> FIXED: Check if sprite pixel exists AND matches Color 1! <---
-                    if ((sprite_pixels[i] >> 24) < 10)
-                        continue;
-
-                    Uint8 sr = (sprite_pixels[i] >> 16) & 0xFF;
-                    Uint8 sg = (sprite_pixels[i] >> 8) & 0xFF;
-                    Uint8 sb = (sprite_pixels[i] >> 0) & 0xFF;
-
-                    // Is the sprite pixel color equal to Color 1?
-                    if (std::abs((int)sr - tr1) <= EPS && std::abs((int)sg - tg1) <= EPS && std::abs((int)sb - tb1) <= EPS)
-                    {
-                        // Check if stage pixel behind it matches Color 2
-                        Uint32 px = stage_pixels[i];
-                        Uint8 r2 = (px >> 16) & 0xFF;
-                        Uint8 g2 = (px >> 8) & 0xFF;
-                        Uint8 b2 = (px >> 0) & 0xFF;
-                        if (std::abs((int)r2 - tr2) <= EPS && std::abs((int)g2 - tg2) <= EPS && std::abs((int)b2 - tb2) <= EPS)
-                            return true;
-                    }
-                }
-                return false;
-            }
+            unsigned long long q = sense_query_key(*b);
+            float cached;
+            if (sense_cache_lookup(state, spr, q, cached))
+                return cached != 0.0f;
+            bool hit = sense_touching(state, spr, *b);
+            sense_cache_store(state, spr, q, hit ? 1.0f : 0.0f);
+            return hit;
         }
     }
 
@@ -644,8 +657,17 @@ static bool eval_bool(AppState &state, Sprite &spr, int block_id)
     return false;
 }
 
-void interpreter_tick(AppState &state)
+// Simulation clock in ms: advances by one step per tick, so waits and timed
+// bubbles last the same number of ticks at any display rate
+static double g_sim_ms = 1.0;
+
+Uint32 interpreter_time() { return (Uint32)g_sim_ms; }
+
+void interpreter_tick(AppState &state, double step_ms)
 {
+    TRACE_ZONE("interpreter_tick");
+    g_sim_ms += step_ms;
+    g_blocks_last_tick = 0;
     if (!state.running)
         return;
 
@@ -656,22 +678,14 @@ void interpreter_tick(AppState &state)
     {
         if (!state.running)
             break;
-        if (SDL_GetTicks() < g_threads[i].wait_until)
+        if (interpreter_time() < g_threads[i].wait_until)
         {
             i++;
             continue;
         }
 
-        if (g_threads[i].waiting_for_sound)
-        {
-            if (audio_is_playing())
-            {
-                i++;
-                continue;
-            }
-            else
-                g_threads[i].waiting_for_sound = false;
-        }
+        // A sound wait ends on the sim clock (wait_until), so exports hold it as long as playback would
+        g_threads[i].waiting_for_sound = false;
 
         if (g_threads[i].waiting_for_ask)
         {
@@ -700,6 +714,7 @@ void interpreter_tick(AppState &state)
             continue;
         }
         Sprite &spr = *spr_ptr;
+        TRACE_ZONE_DETAIL("script", spr.name.c_str());
 
         bool yielded = false;
         int watchdog_counter = 0;
@@ -767,6 +782,7 @@ void interpreter_tick(AppState &state)
                 frame.cur_node = -1;
                 continue;
             }
+            g_blocks_last_tick++;
             // ---> NEW: Set Normal Execution Highlight (Black) <---
             // (Only override if there isn't a current Warning/Error displaying)
             if (state.exec_highlight_type == 0 || SDL_GetTicks() > state.exec_highlight_timer)
@@ -831,21 +847,8 @@ void interpreter_tick(AppState &state)
                     }
                     else if (b->opt == TARGET_MOUSE_POINTER)
                     {
-                        int mx, my;
-                        SDL_GetMouseState(&mx, &my);
-                        int col_x = WINDOW_WIDTH - RIGHT_COLUMN_WIDTH;
-                        int col_h = WINDOW_HEIGHT - NAVBAR_HEIGHT;
-                        int stage_h = col_h * STAGE_HEIGHT_RATIO / 100;
-                        int margin = 8;
-                        int stage_area_w = RIGHT_COLUMN_WIDTH - margin * 2;
-                        int stage_area_h = stage_h - margin * 2;
-                        int stage_cx = col_x + margin + stage_area_w / 2;
-                        int stage_cy = NAVBAR_HEIGHT + margin + stage_area_h / 2;
-                        float scale_x = 480.0f / stage_area_w;
-                        float scale_y = 360.0f / stage_area_h;
-
-                        spr.x = (int)((mx - stage_cx) * scale_x);
-                        spr.y = (int)((stage_cy - my) * scale_y);
+                        spr.x = (int)g_tick.mouse_stage_x;
+                        spr.y = (int)g_tick.mouse_stage_y;
                     }
                     cmd_name = "GO_TO_TARGET";
                 }
@@ -995,7 +998,7 @@ void interpreter_tick(AppState &state)
                     spr.say_text = eval_string(state, spr, b->arg0_id, b->text);
                     spr.is_thinking = false;
                     float sec = eval_value(state, spr, b->arg1_id, b->b, b->text2);
-                    spr.say_end_time = SDL_GetTicks() + (unsigned int)(sec * 1000);
+                    spr.say_end_time = interpreter_time() + (unsigned int)(sec * 1000);
                     LogSimple(LOG_INFO, execution_cycle, b->id, "SAY_FOR", "Sprite says: '" + spr.say_text + "' for " + std::to_string(sec) + "s");
                     g_threads[i].wait_until = spr.say_end_time;
                     frame.cur_node = b->next_id;
@@ -1006,7 +1009,7 @@ void interpreter_tick(AppState &state)
                     spr.say_text = eval_string(state, spr, b->arg0_id, b->text);
                     spr.is_thinking = true;
                     float sec = eval_value(state, spr, b->arg1_id, b->b, b->text2);
-                    spr.say_end_time = SDL_GetTicks() + (unsigned int)(sec * 1000);
+                    spr.say_end_time = interpreter_time() + (unsigned int)(sec * 1000);
                     LogSimple(LOG_INFO, execution_cycle, b->id, "THINK_FOR", "Sprite thinks: '" + spr.say_text + "' for " + std::to_string(sec) + "s");
                     g_threads[i].wait_until = spr.say_end_time;
                     frame.cur_node = b->next_id;
@@ -1064,60 +1067,19 @@ void interpreter_tick(AppState &state)
                 }
                 else if (b->subtype == LB_GO_TO_LAYER)
                 {
-                    int old_layer = spr.layer_order;
-                    if (b->opt == 0)
-                    {
-                        int max_l = -999999;
-                        for (auto &s : state.sprites)
-                            if (s.layer_order > max_l)
-                                max_l = s.layer_order;
-                        spr.layer_order = max_l + 10;
-                    }
-                    else
-                    {
-                        int min_l = 999999;
-                        for (auto &s : state.sprites)
-                            if (s.layer_order < min_l)
-                                min_l = s.layer_order;
-                        spr.layer_order = min_l - 10;
-                    }
+                    int spr_idx = (int)(spr_ptr - state.sprites.data());
+                    int old_layer = stage_layer_rank(state, spr_idx);
+                    stage_layer_move(state, spr_idx, (b->opt == 0) ? (int)state.sprites.size() - 1 : 0);
                     LogEvent(LOG_INFO, execution_cycle, b->id, "GO_TO_LAYER", "Layer Order", std::to_string(old_layer), std::to_string(spr.layer_order));
                     frame.cur_node = b->next_id;
                     yielded = true;
                 }
                 else if (b->subtype == LB_GO_LAYERS)
                 {
-                    int old_layer = spr.layer_order;
+                    int spr_idx = (int)(spr_ptr - state.sprites.data());
+                    int old_layer = stage_layer_rank(state, spr_idx);
                     int steps = (int)eval_value(state, spr, b->arg0_id, b->a, b->text);
-                    std::vector<int> sorted_indices;
-                    for (int j = 0; j < (int)state.sprites.size(); j++)
-                        sorted_indices.push_back(j);
-                    std::stable_sort(sorted_indices.begin(), sorted_indices.end(), [&](int p1, int p2)
-                                     { return state.sprites[p1].layer_order < state.sprites[p2].layer_order; });
-                    int current_rank = 0, spr_idx = -1;
-                    for (size_t j = 0; j < state.sprites.size(); j++)
-                        if (&state.sprites[j] == &spr)
-                            spr_idx = j;
-                    for (size_t j = 0; j < sorted_indices.size(); j++)
-                        if (sorted_indices[j] == spr_idx)
-                        {
-                            current_rank = j;
-                            break;
-                        }
-                    int new_rank = current_rank + ((b->opt == 0) ? steps : -steps);
-                    if (new_rank < 0)
-                        new_rank = 0;
-                    if (new_rank >= (int)sorted_indices.size())
-                        new_rank = sorted_indices.size() - 1;
-                    if (new_rank != current_rank)
-                    {
-                        for (size_t j = 0; j < sorted_indices.size(); j++)
-                            state.sprites[sorted_indices[j]].layer_order = j * 10;
-                        if (b->opt == 0)
-                            spr.layer_order = new_rank * 10 + 5;
-                        else
-                            spr.layer_order = new_rank * 10 - 5;
-                    }
+                    stage_layer_move(state, spr_idx, old_layer + ((b->opt == 0) ? steps : -steps));
                     LogEvent(LOG_INFO, execution_cycle, b->id, "GO_LAYERS", "Layer Order", std::to_string(old_layer), std::to_string(spr.layer_order));
                     frame.cur_node = b->next_id;
                     yielded = true;
@@ -1166,19 +1128,28 @@ void interpreter_tick(AppState &state)
                 else if (b->subtype == SB_STOP_ALL_SOUNDS)
                 {
                     audio_stop_all();
+                    for (ScriptThread &t : g_threads)
+                        if (t.waiting_for_sound)
+                        {
+                            t.waiting_for_sound = false;
+                            t.wait_until = 0;
+                        }
                     LogSimple(LOG_INFO, execution_cycle, b->id, "STOP_ALL_SOUNDS", "Stopped all playing sounds.");
                     frame.cur_node = b->next_id;
                 }
                 else if (b->subtype == SB_START_SOUND || b->subtype == SB_PLAY_SOUND_UNTIL_DONE)
                 {
+                    unsigned int sound_ms = 0;
                     if (b->opt >= 0 && b->opt < (int)spr.sounds.size())
                     {
                         audio_play_chunk(spr.sounds[b->opt].chunk, spr.sounds[b->opt].volume);
+                        sound_ms = audio_chunk_ms(spr.sounds[b->opt].chunk);
                         LogSimple(LOG_INFO, execution_cycle, b->id, "PLAY_SOUND", "Playing sound: " + spr.sounds[b->opt].name);
                     }
                     if (b->subtype == SB_PLAY_SOUND_UNTIL_DONE)
                     {
                         g_threads[i].waiting_for_sound = true;
+                        g_threads[i].wait_until = interpreter_time() + sound_ms;
                         yielded = true;
                     }
                     frame.cur_node = b->next_id;
@@ -1189,7 +1160,7 @@ void interpreter_tick(AppState &state)
                 if (b->subtype == CB_WAIT)
                 {
                     float sec = eval_value(state, spr, b->arg0_id, b->a, b->text);
-                    g_threads[i].wait_until = SDL_GetTicks() + (unsigned int)(sec * 1000);
+                    g_threads[i].wait_until = interpreter_time() + (unsigned int)(sec * 1000);
                     LogSimple(LOG_INFO, execution_cycle, b->id, "WAIT", "Waiting for " + std::to_string(sec) + " seconds.");
                     frame.cur_node = b->next_id;
                     yielded = true;
@@ -1559,4 +1530,23 @@ void interpreter_stop_all(AppState &state)
     }
     state.ask_active = false;
     audio_stop_all();
-}
\ No newline at end of file
+}
+
+bool interpreter_busy(const AppState &state)
+{
+    return state.running && !g_threads.empty();
+}
+
+InterpreterStats interpreter_stats()
+{
+    InterpreterStats st = {0, 0, g_blocks_last_tick};
+    Uint32 now = interpreter_time();
+    for (const ScriptThread &t : g_threads)
+    {
+        if (now < t.wait_until || t.waiting_for_sound || t.waiting_for_ask)
+            st.sleeping++;
+        else
+            st.runnable++;
+    }
+    return st;
+}
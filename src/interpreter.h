@@ -2,6 +2,7 @@
 #define INTERPRETER_H
 
 #include "types.h"
+#include "stage.h"
 #include "SDL.h"
 
 void interpreter_trigger_flag(AppState &state);
@@ -11,8 +12,23 @@ void interpreter_trigger_message(AppState &state, int msg_opt);
 
 void interpreter_stop_all(AppState &state);
 
-// ---> NEW: Process running scripts every frame <---
-// ---> NEW: Process running scripts every frame <---
-void interpreter_tick(AppState &state);
+// ---> NEW: Snapshot mouse/keyboard/stage geometry once per frame, before interpreter_tick <---
+void interpreter_capture_input(const StageRects &stage_rects);
+
+// ---> NEW: Process running scripts, one fixed simulation step per call <---
+void interpreter_tick(AppState &state, double step_ms);
+/* Simulation clock (ms); use for anything scripts time, not SDL_GetTicks */
+Uint32 interpreter_time();
+
+/* True while any script still has work to do (the editor keeps redrawing) */
+bool interpreter_busy(const AppState &state);
+
+struct InterpreterStats
+{
+    int runnable; // threads that will run on the next step
+    int sleeping; // waiting on a timer, a sound or an answer
+    int blocks;   // blocks executed by the last interpreter_tick
+};
+InterpreterStats interpreter_stats();
 
 #endif
\ No newline at end of file
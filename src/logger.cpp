@@ -1,5 +1,9 @@
 #include "logger.h"
 #include "config.h" // ---> Added to access WINDOW_WIDTH
+#include "text.h"
+#include "render_queue.h"
+#include "redraw.h"
+#include "trace.h"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
@@ -53,10 +57,15 @@ static const std::string COLOR_RESET = "\033[0m";
 void ShowToast(LogLevel level, const std::string& message) {
     // پیام‌ها برای ۳.۵ ثانیه روی صفحه می‌مانند
     g_toasts.push_back({message, level, SDL_GetTicks() + 3500}); 
+    // Toasts stack under the navbar; repaint now and again when this one expires
+    SDL_Rect band = {0, NAVBAR_HEIGHT, WINDOW_WIDTH, WINDOW_HEIGHT - NAVBAR_HEIGHT};
+    redraw_invalidate(&band);
+    redraw_invalidate_at(&band, g_toasts.back().expire_time + 1);
 }
 
 // تابع رندر کردن Toast ها روی صفحه اصلی
 void RenderToasts(SDL_Renderer* r, TTF_Font* font) {
+    TRACE_ZONE("RenderToasts");
     if (!font || g_toasts.empty()) return;
     Uint32 now = SDL_GetTicks();
     
@@ -71,7 +80,7 @@ void RenderToasts(SDL_Renderer* r, TTF_Font* font) {
             it = g_toasts.erase(it); // حذف پیام‌های منقضی شده
         } else {
             int tw = 0, th = 0;
-            TTF_SizeUTF8(font, it->text.c_str(), &tw, &th);
+            text_size(font, it->text.c_str(), &tw, &th);
             
             // ---> FIXED: Prevent the toast from being wider than the screen itself
             tw = std::min(tw, win_w - 80); 
@@ -84,29 +93,19 @@ void RenderToasts(SDL_Renderer* r, TTF_Font* font) {
             SDL_Rect bg_rect = {rect_x, y_offset, rect_w, rect_h};
             
             // تعیین رنگ پس‌زمینه اخطار
-            if (it->level == LOG_ERROR) SDL_SetRenderDrawColor(r, 220, 53, 69, 240);       // قرمز ارور
-            else if (it->level == LOG_WARNING) SDL_SetRenderDrawColor(r, 255, 193, 7, 240); // زرد هشدار
-            else SDL_SetRenderDrawColor(r, 40, 167, 69, 240);                               // سبز موفقیت
+            if (it->level == LOG_ERROR) rq_set_color(r, 220, 53, 69, 240);       // قرمز ارور
+            else if (it->level == LOG_WARNING) rq_set_color(r, 255, 193, 7, 240); // زرد هشدار
+            else rq_set_color(r, 40, 167, 69, 240);                               // سبز موفقیت
             
             SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
-            SDL_RenderFillRect(r, &bg_rect);
+            rq_fill_rect(r, &bg_rect);
             
             // رسم متن
             SDL_Color tc = {255, 255, 255, 255};
             if (it->level == LOG_WARNING) tc = {0, 0, 0, 255}; // متن مشکی برای هشدار زرد
 
-            SDL_Surface* surf = TTF_RenderUTF8_Blended(font, it->text.c_str(), tc);
-            if (surf) {
-                SDL_Texture* tex = SDL_CreateTextureFromSurface(r, surf);
-                
-                // Crop text rendering if it's too long
-                SDL_Rect src_rect = {0, 0, tw, th}; 
-                SDL_Rect txt_rect = {rect_x + pad_x, y_offset + pad_y, tw, th};
-                
-                SDL_RenderCopy(r, tex, &src_rect, &txt_rect);
-                SDL_DestroyTexture(tex);
-                SDL_FreeSurface(surf);
-            }
+            // Crop text rendering if it's too long
+            text_draw_clipped(r, font, it->text.c_str(), rect_x + pad_x, y_offset + pad_y, tw, tc);
 
             y_offset += rect_h + 10; // فاصله بین چند ارور همزمان
             ++it;
@@ -21,15 +21,27 @@
 #include "sounds_tab.h"
 #include "sprite_panel.h"
 #include "renderer.h"
+#include "paint_layer.h"
+#include "costume_undo.h"
 #include "interpreter.h"
 #include "audio.h"
-
+#include "image_import.h"
+#include "redraw.h"
+#include "sprite_atlas.h"
+#include "video_export.h"
+#include "render_queue.h"
+#include "perf_overlay.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
 #include <ctime>
 #include "dotenv.h"
+#include "text.h"
 
 struct LibAsset
 {
@@ -94,27 +106,127 @@ static void load_library_backdrops(SDL_Renderer *renderer)
     }
 }
 
+static std::string import_display_name(const std::string &path)
+{
+    size_t slash = path.find_last_of('/');
+    std::string fname = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    size_t dot = fname.find_last_of('.');
+    if (dot != std::string::npos)
+        fname = fname.substr(0, dot);
+    return fname;
+}
+
+// ---> FINISHED IMPORTS (decoded off-thread, textures made here) <---
+static void apply_finished_imports(AppState &state, SDL_Renderer *renderer)
+{
+    ImportResult res;
+    while (image_import_poll(res))
+    {
+        SDL_Texture *t = res.surface ? SDL_CreateTextureFromSurface(renderer, res.surface) : nullptr;
+        if (res.surface)
+            SDL_FreeSurface(res.surface);
+        if (!t)
+        {
+            LogSimple(LOG_WARNING, 0, -1, "IMPORT", "Could not load image: " + res.path);
+            continue;
+        }
+        redraw_invalidate(NULL);
+
+        if (res.target == IMPORT_SPRITE)
+        {
+            state.sprites.push_back(Sprite(res.name, t, res.path));
+            Mix_Chunk *ds = audio_load_sound("assets/sounds/meow.wav");
+            state.sprites.back().sounds.push_back(SoundData("meow", ds, "assets/sounds/meow.wav"));
+            state.selected_sprite = state.sprites.size() - 1;
+            state.editing_target_is_stage = false;
+        }
+        else if (res.target == IMPORT_BACKDROP)
+        {
+            state.backdrops.push_back(Backdrop(res.name, t, res.path));
+            state.selected_backdrop = state.backdrops.size() - 1;
+            state.editing_target_is_stage = true;
+        }
+        else if (res.sprite >= 0 && res.sprite < (int)state.sprites.size())
+        {
+            auto &spr = state.sprites[res.sprite];
+            spr.costumes.push_back(Costume(res.name, t, res.path));
+            spr.selected_costume = spr.costumes.size() - 1;
+        }
+        else
+        {
+            SDL_DestroyTexture(t); // sprite went away while decoding
+        }
+    }
+}
+
+// ---> REDRAW INVALIDATION <---
+// Plain pointer movement only changes hover state, so it repaints the panels under
+// the old and new pointer positions; any other input repaints the whole window.
+static void invalidate_for_event(const SDL_Event &e, const AppState &state, const std::vector<SDL_Rect> &hover_panels)
+{
+    bool hover_only = e.type == SDL_MOUSEMOTION && e.motion.state == 0 && !state.drag.active &&
+                      state.mode == MODE_EDITOR && !state.player_mode && state.current_tab == TAB_CODE &&
+                      !state.file_menu_open && !state.sprite_menu_open && !state.backdrop_menu_open &&
+                      !state.var_modal_active && !state.msg_modal_active && !state.func_modal_active &&
+                      !state.new_confirm_active && !state.ask_active;
+    if (!hover_only)
+    {
+        redraw_invalidate(NULL);
+        return;
+    }
+    const SDL_Point pts[2] = {{e.motion.x - e.motion.xrel, e.motion.y - e.motion.yrel}, {e.motion.x, e.motion.y}};
+    for (const SDL_Point &p : pts)
+    {
+        const SDL_Rect *panel = NULL;
+        for (const SDL_Rect &r : hover_panels)
+            if (SDL_PointInRect(&p, &r))
+            {
+                panel = &r;
+                break;
+            }
+        redraw_invalidate(panel); // outside every panel: the whole window
+    }
+}
+
 static void render_simple_text(SDL_Renderer *r, TTF_Font *font, const char *text, int x, int y, Color c)
 {
     if (!text || text[0] == '\0')
         return;
     SDL_Color sc = {static_cast<Uint8>(c.r), static_cast<Uint8>(c.g), static_cast<Uint8>(c.b), 255};
-    SDL_Surface *surf = TTF_RenderUTF8_Blended(font, text, sc);
-    if (surf)
-    {
-        SDL_Texture *tex = SDL_CreateTextureFromSurface(r, surf);
-        SDL_Rect dst = {x, y, surf->w, surf->h};
-        SDL_RenderCopy(r, tex, NULL, &dst);
-        SDL_DestroyTexture(tex);
-        SDL_FreeSurface(surf);
-    }
+    text_draw(r, font, text, x, y, sc);
 }
 
-int main(int /*argc*/, char * /*argv*/[])
+int main(int argc, char *argv[])
 {
+    // --play project.json: open straight into player mode and run the project
+    // --export DIR [--seconds N] [--fps N] [--scale 1|2] [--yuv]: render that project offscreen and exit
+    const char *play_path = nullptr;
+    bool exporting = false;
+    ExportOptions export_opt;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--play") == 0 && i + 1 < argc)
+            play_path = argv[++i];
+        else if (std::strcmp(argv[i], "--export") == 0 && i + 1 < argc)
+        {
+            exporting = true;
+            export_opt.out_dir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            export_opt.seconds = std::atof(argv[++i]);
+        else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            export_opt.fps = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+            export_opt.scale = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--yuv") == 0)
+            export_opt.format = EXPORT_YUV;
+    }
+
     std::srand(static_cast<unsigned>(std::time(nullptr)));
 
     load_dotenv();
+    perf_overlay_init();
+    TRACE_THREAD_NAME("main");
 
     InitLogger();
 
@@ -151,7 +263,8 @@ int main(int /*argc*/, char * /*argv*/[])
         return 1;
     }
 
-    SDL_Window *window = SDL_CreateWindow("Scratch Clone", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_FULLSCREEN_DESKTOP | SDL_WINDOW_ALLOW_HIGHDPI);
+    SDL_Window *window = SDL_CreateWindow("Scratch Clone", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT,
+                                          exporting ? SDL_WINDOW_HIDDEN : (SDL_WINDOW_FULLSCREEN_DESKTOP | SDL_WINDOW_ALLOW_HIGHDPI));
     if (!window)
         return 1;
 
@@ -167,6 +280,8 @@ int main(int /*argc*/, char * /*argv*/[])
         WINDOW_HEIGHT = wh;
     }
     SDL_RenderSetLogicalSize(renderer, WINDOW_WIDTH, WINDOW_HEIGHT);
+    if (!redraw_init(renderer))
+        std::fprintf(stderr, "Warning: No retained back buffer; every frame repaints the whole window.\n");
 
     TTF_Font *font = TTF_OpenFont("assets/fonts/NotoSans-Regular.ttf", 13);
     if (!font)
@@ -189,6 +304,9 @@ int main(int /*argc*/, char * /*argv*/[])
     if (!audio_init())
         std::fprintf(stderr, "Warning: Audio failed to load. Sounds will be silent.\n");
 
+    if (!image_import_init())
+        std::fprintf(stderr, "Warning: Image imports will decode on the main thread.\n");
+
     load_library_sprites(renderer);
     load_library_backdrops(renderer);
     renderer_init_pen_layer(renderer);
@@ -210,30 +328,97 @@ int main(int /*argc*/, char * /*argv*/[])
     drag_area_layout(drag_rects);
     StageRects stage_rects;
     stage_layout(stage_rects);
+    StageRects player_rects;
+    stage_layout_player(player_rects);
     SettingsRects settings_rects;
     settings_layout(settings_rects);
     SpritePanelRects sprite_panel_rects;
     sprite_panel_layout(sprite_panel_rects);
+    const std::vector<SDL_Rect> hover_panels = {navbar_rects.bar, tab_bar_rects.bar, cat_rects.panel, pal_rects.panel,
+                                                canvas_rects.panel, stage_rects.panel, settings_rects.panel,
+                                                sprite_panel_rects.sprite_list_area, sprite_panel_rects.backdrop_area};
 
     AppState state;
     state.sprites.push_back(Sprite("Sprite1", tex.scratch_cat, "assets/sprites/scratch_cat.png"));
     Mix_Chunk *def_snd = audio_load_sound("assets/sounds/meow.wav");
     state.sprites[0].sounds.push_back(SoundData("meow", def_snd, "assets/sounds/meow.wav"));
     state.backdrops.push_back(Backdrop("backdrop1", nullptr, ""));
+    // Export steps on the same SIM_HZ clock as the editor
+    int sim_hz = SIM_HZ_DEFAULT;
+    if (const char *hz_env = std::getenv("SIM_HZ"))
+        sim_hz = std::max(1, std::min(std::atoi(hz_env), 240));
+
+    int exit_code = 0;
+    if (exporting)
+    {
+        // Without --play the default project is exported
+        bool loaded = !play_path || filemenu_load_project(renderer, state, play_path);
+        if (!loaded)
+            SDL_Log("--export: could not load %s", play_path);
+        export_opt.sim_hz = sim_hz;
+        exit_code = (loaded && video_export_run(renderer, font, state, tex, export_opt)) ? 0 : 1;
+    }
+    else if (play_path)
+    {
+        if (filemenu_load_project(renderer, state, play_path))
+        {
+            state.player_mode = true;
+            interpreter_trigger_flag(state);
+        }
+        else
+            SDL_Log("--play: could not load %s, opening the editor", play_path);
+    }
+
+    // ---> FIXED-STEP SIMULATION <---
+    // Scripts advance in SIM_HZ steps from an accumulator of real time, independent of vsync.
+    // SIM_INTERPOLATE=1 draws sprites between the last two steps on faster displays.
+    const char *interp_env = std::getenv("SIM_INTERPOLATE");
+    const bool sim_interpolate = interp_env && std::string(interp_env) == "1";
+    const double sim_step = 1.0 / (sim_hz > 0 ? sim_hz : SIM_HZ_DEFAULT);
+    double sim_acc = 0.0;
+    Uint64 sim_last = SDL_GetPerformanceCounter();
 
     SDL_StartTextInput();
-    bool quit = false;
+    bool quit = exporting;
+    bool animating = false;
+    bool step_paced = false; // only scripts without interpolation: nothing new until the next step
 
     while (!quit)
     {
+        // Sleeps here while nothing is running, animating or waiting to be repainted,
+        // and until the next simulation step while that is all there is to show
+        Uint32 step_wait_ms = 0;
+        if (step_paced)
+        {
+            double left = sim_step - sim_acc - (double)(SDL_GetPerformanceCounter() - sim_last) / SDL_GetPerformanceFrequency();
+            step_wait_ms = left > 0.0 ? (Uint32)std::ceil(left * 1000.0) : 0;
+        }
         SDL_Event e;
-        while (SDL_PollEvent(&e))
+        TRACE_ZONE_BEGIN(events_zone, "events"); // includes the idle wait
+        bool have = redraw_wait_event(e, animating, step_wait_ms);
+        perf_frame_begin(); // the frame's work starts with its events
+        for (; have; have = SDL_PollEvent(&e))
         {
+            invalidate_for_event(e, state, hover_panels);
             if (e.type == SDL_QUIT)
             {
                 quit = true;
                 break;
             }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3 && !e.key.repeat)
+            {
+                perf_overlay_toggle();
+                continue;
+            }
+#ifdef TRACE_ENABLED
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4 && !e.key.repeat)
+            {
+                char trace_path[64];
+                std::snprintf(trace_path, sizeof(trace_path), "logs/trace_%u.json", (unsigned)SDL_GetTicks());
+                trace_export(trace_path);
+                continue;
+            }
+#endif
 
             if (state.ask_active)
             {
@@ -257,6 +442,23 @@ int main(int /*argc*/, char * /*argv*/[])
                 continue;
             }
 
+            // Player mode: only the stage takes input; Escape returns to the editor
+            if (state.player_mode)
+            {
+                if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE)
+                {
+                    state.player_mode = false;
+                    state.stage_drag_active = false;
+                }
+                else
+                {
+                    if (e.type == SDL_KEYDOWN)
+                        interpreter_trigger_key(state, e.key.keysym.sym);
+                    stage_handle_event(e, state, player_rects, tex);
+                }
+                continue;
+            }
+
             // B9: "Are you sure?" modal for New project
             if (state.new_confirm_active)
             {
@@ -270,6 +472,8 @@ int main(int /*argc*/, char * /*argv*/[])
                     if (in_r(e.button.x, e.button.y, yes_btn))
                     {
                         // Confirmed: clear project
+                        costume_undo_clear();
+                        image_import_cancel();
                         for (auto &s : state.sprites)
                         {
                             for (auto &c : s.costumes)
@@ -277,9 +481,10 @@ int main(int /*argc*/, char * /*argv*/[])
                                 if (c.original_texture)
                                     SDL_DestroyTexture(c.original_texture);
                                 if (c.paint_layer)
-                                    SDL_DestroyTexture(c.paint_layer);
+                                    paint_layer_destroy(c.paint_layer);
                                 if (c.composed_texture)
                                     SDL_DestroyTexture(c.composed_texture);
+                                renderer_destroy_mips(c);
                             }
                             for (auto &snd : s.sounds)
                             {
@@ -292,10 +497,12 @@ int main(int /*argc*/, char * /*argv*/[])
                             if (b.original_texture)
                                 SDL_DestroyTexture(b.original_texture);
                             if (b.paint_layer)
-                                SDL_DestroyTexture(b.paint_layer);
+                                paint_layer_destroy(b.paint_layer);
                             if (b.composed_texture)
                                 SDL_DestroyTexture(b.composed_texture);
+                            renderer_destroy_mips(b);
                         }
+                        stage_layers_clear(state);
                         state.sprites.clear();
                         state.backdrops.clear();
                         state.drag.active = false;
@@ -672,6 +879,7 @@ int main(int /*argc*/, char * /*argv*/[])
                                         {
                                             blk.color2 = {(Uint8)palette[i].r, (Uint8)palette[i].g, (Uint8)palette[i].b, 255};
                                         }
+                                        workspace_blocks_changed(state);
                                         break;
                                     }
                                 }
@@ -713,6 +921,7 @@ int main(int /*argc*/, char * /*argv*/[])
                                     if (blk.id == state.block_input.block_id)
                                     {
                                         blk.color1 = {(Uint8)palette[i].r, (Uint8)palette[i].g, (Uint8)palette[i].b, 255};
+                                        workspace_blocks_changed(state);
                                         break;
                                     }
                                 }
@@ -738,6 +947,7 @@ int main(int /*argc*/, char * /*argv*/[])
                     else if (e.key.keysym.sym == SDLK_RETURN || e.key.keysym.sym == SDLK_ESCAPE)
                     {
                         state.active_input = INPUT_NONE;
+                        costume_undo_commit(state); // the step opened when the text shape was added
                     }
                     is_key = true;
                 }
@@ -765,7 +975,10 @@ int main(int /*argc*/, char * /*argv*/[])
                             item = &spr.costumes[spr.selected_costume];
                     }
                     if (item && state.active_shape_index >= 0 && state.active_shape_index < (int)item->shapes.size())
+                    {
                         item->shapes[state.active_shape_index].text = state.input_buffer;
+                        item->version++;
+                    }
                     continue;
                 }
             }
@@ -938,20 +1151,7 @@ int main(int /*argc*/, char * /*argv*/[])
                     if (!result.empty())
                     {
                         std::string new_path = copy_asset_to_project(state.project_name, result);
-                        SDL_Texture *t = IMG_LoadTexture(renderer, new_path.c_str());
-                        if (t)
-                        {
-                            size_t slash = result.find_last_of('/');
-                            std::string fname = (slash == std::string::npos) ? result : result.substr(slash + 1);
-                            size_t dot = fname.find_last_of('.');
-                            if (dot != std::string::npos)
-                                fname = fname.substr(0, dot);
-                            state.sprites.push_back(Sprite(fname, t, new_path));
-                            Mix_Chunk *ds = audio_load_sound("assets/sounds/meow.wav");
-                            state.sprites.back().sounds.push_back(SoundData("meow", ds, "assets/sounds/meow.wav"));
-                            state.selected_sprite = state.sprites.size() - 1;
-                            state.editing_target_is_stage = false;
-                        }
+                        image_import_request(IMPORT_SPRITE, -1, import_display_name(result), new_path);
                     }
                     state.sprite_menu_open = false;
                     consumed_menu = true;
@@ -1007,18 +1207,7 @@ int main(int /*argc*/, char * /*argv*/[])
                     if (!result.empty())
                     {
                         std::string new_path = copy_asset_to_project(state.project_name, result);
-                        SDL_Texture *t = IMG_LoadTexture(renderer, new_path.c_str());
-                        if (t)
-                        {
-                            size_t slash = result.find_last_of('/');
-                            std::string fname = (slash == std::string::npos) ? result : result.substr(slash + 1);
-                            size_t dot = fname.find_last_of('.');
-                            if (dot != std::string::npos)
-                                fname = fname.substr(0, dot);
-                            state.backdrops.push_back(Backdrop(fname, t, new_path));
-                            state.selected_backdrop = state.backdrops.size() - 1;
-                            state.editing_target_is_stage = true;
-                        }
+                        image_import_request(IMPORT_BACKDROP, -1, import_display_name(result), new_path);
                     }
                     state.backdrop_menu_open = false;
                     consumed_menu = true;
@@ -1155,6 +1344,7 @@ int main(int /*argc*/, char * /*argv*/[])
                     continue;
             }
         }
+        TRACE_ZONE_END(events_zone);
 
         if (state.trigger_costume_import)
         {
@@ -1176,67 +1366,81 @@ int main(int /*argc*/, char * /*argv*/[])
                 if (!path.empty())
                 {
                     std::string new_path = copy_asset_to_project(state.project_name, path);
-                    SDL_Texture *t = IMG_LoadTexture(renderer, new_path.c_str());
-                    if (t)
-                    {
-                        size_t slash = path.find_last_of('/');
-                        std::string fname = (slash == std::string::npos) ? path : path.substr(slash + 1);
-                        size_t dot = fname.find_last_of('.');
-                        if (dot != std::string::npos)
-                            fname = fname.substr(0, dot);
-                        if (state.editing_target_is_stage)
-                        {
-                            state.backdrops.push_back(Backdrop(fname, t, new_path));
-                            state.selected_backdrop = state.backdrops.size() - 1;
-                        }
-                        else
-                        {
-                            if (state.selected_sprite >= 0 && state.selected_sprite < (int)state.sprites.size())
-                            {
-                                auto &spr = state.sprites[state.selected_sprite];
-                                spr.costumes.push_back(Costume(fname, t, new_path));
-                                spr.selected_costume = spr.costumes.size() - 1;
-                            }
-                        }
-                    }
+                    if (state.editing_target_is_stage)
+                        image_import_request(IMPORT_BACKDROP, -1, import_display_name(path), new_path);
+                    else if (state.selected_sprite >= 0 && state.selected_sprite < (int)state.sprites.size())
+                        image_import_request(IMPORT_COSTUME, state.selected_sprite, import_display_name(path), new_path);
                 }
             }
         }
-
-        // Update stage snapshot BEFORE interpreter so touching-color has current frame data
+        apply_finished_imports(state, renderer);
+
+        Uint64 sim_now = SDL_GetPerformanceCounter();
+        sim_acc += (double)(sim_now - sim_last) / SDL_GetPerformanceFrequency();
+        sim_last = sim_now;
+        // After a stall (or an idle sleep) run a few steps, not a burst
+        sim_acc = std::min(sim_acc, sim_step * SIM_MAX_CATCHUP);
+        int sim_steps = 0;
+        while (sim_acc >= sim_step)
         {
-            SDL_Texture *backdrop_tex = nullptr;
-            if (state.selected_backdrop >= 0 && state.selected_backdrop < (int)state.backdrops.size())
-                backdrop_tex = state.backdrops[state.selected_backdrop].texture;
-            renderer_update_stage_snapshot(renderer, backdrop_tex, stage_rects.stage_area);
+            stage_save_poses(state);
+            interpreter_capture_input(state.player_mode ? player_rects : stage_rects);
+            Uint64 tick_start = SDL_GetPerformanceCounter();
+            interpreter_tick(state, sim_step * 1000.0);
+            perf_note_tick((double)(SDL_GetPerformanceCounter() - tick_start) * 1000.0 / SDL_GetPerformanceFrequency());
+            sim_acc -= sim_step;
+            sim_steps++;
         }
-
-        interpreter_tick(state);
-
-        for (auto &spr : state.sprites)
-        {
-            if (!spr.costumes.empty() && spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size())
-            {
-                update_composed_texture(spr.costumes[spr.selected_costume], renderer, font);
-                spr.texture = spr.costumes[spr.selected_costume].composed_texture;
-            }
-        }
-        if (!state.backdrops.empty() && state.selected_backdrop >= 0 && state.selected_backdrop < (int)state.backdrops.size())
+        stage_set_pose_alpha(sim_interpolate ? (float)(sim_acc / sim_step) : 1.0f);
+        renderer_flush_pen_layer();
+        costumes_tab_flush_stroke(state);
+
+        stage_update_textures(renderer, font, state);
+
+        // Scripts and sound playback repaint everything, including the frame after they finish.
+        // Without interpolation, frames between simulation steps have nothing new to show.
+        bool scripts_busy = interpreter_busy(state);
+        bool sound_busy = state.current_tab == TAB_SOUNDS && audio_is_playing();
+        bool now_animating = scripts_busy || sound_busy;
+        bool between_steps = scripts_busy && sim_steps == 0 && !sim_interpolate;
+        if ((animating || now_animating) && !between_steps)
+            redraw_invalidate(NULL);
+        animating = now_animating;
+        step_paced = scripts_busy && !sound_busy && !sim_interpolate;
+
+        Uint32 now = SDL_GetTicks();
+        if (state.exec_highlight_id != -1 && !SDL_TICKS_PASSED(now, state.exec_highlight_timer))
+            redraw_invalidate_at(&canvas_rects.panel, state.exec_highlight_timer + 1);
+        // Text carets blink every 500 ms
+        Uint32 next_blink = (now / 500 + 1) * 500;
+        if (state.ask_active)
+            redraw_invalidate_at(state.player_mode ? &player_rects.panel : &stage_rects.panel, next_blink);
+        if (state.var_modal_active || state.msg_modal_active || state.func_modal_active)
+            redraw_invalidate_at(NULL, next_blink);
+
+        if (!redraw_begin(renderer))
+            continue;
+
+        // Nothing of the editor is drawn while playing
+        if (state.player_mode)
         {
-            update_composed_texture(state.backdrops[state.selected_backdrop], renderer, font);
-            state.backdrops[state.selected_backdrop].texture = state.backdrops[state.selected_backdrop].composed_texture;
+            stage_draw_player(renderer, font, state, player_rects, tex);
+            perf_overlay_draw(renderer, font, state);
+            redraw_end(renderer);
+            continue;
         }
 
-        SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-        SDL_RenderClear(renderer);
+        // FillRect honours the dirty clip; RenderClear would wipe the retained frame
+        rq_set_color(renderer, 200, 200, 200, 255);
+        rq_fill_rect(renderer, NULL);
 
         if (state.mode == MODE_EXTENSION_LIBRARY)
         {
-            SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
-            SDL_RenderFillRect(renderer, NULL);
+            rq_set_color(renderer, 245, 245, 245, 255);
+            rq_fill_rect(renderer, NULL);
             SDL_Rect nav_bg = {0, 0, WINDOW_WIDTH, NAVBAR_HEIGHT};
-            SDL_SetRenderDrawColor(renderer, 76, 151, 255, 255);
-            SDL_RenderFillRect(renderer, &nav_bg);
+            rq_set_color(renderer, 76, 151, 255, 255);
+            rq_fill_rect(renderer, &nav_bg);
             render_simple_text(renderer, font_large, "< Back", 30, (NAVBAR_HEIGHT - 24) / 2, {255, 255, 255});
             int tw = 0;
             TTF_SizeUTF8(font_large, "Choose an Extension", &tw, NULL);
@@ -1244,15 +1448,15 @@ int main(int /*argc*/, char * /*argv*/[])
             int box_w = WINDOW_WIDTH / 3, box_h = 320, box_x = 60, box_y = NAVBAR_HEIGHT + 40;
             SDL_Rect box_rect = {box_x, box_y, box_w, box_h};
             renderer_fill_rounded_rect(renderer, &box_rect, 10, 255, 255, 255);
-            SDL_SetRenderDrawColor(renderer, 210, 210, 210, 255);
-            SDL_RenderDrawRect(renderer, &box_rect);
+            rq_set_color(renderer, 210, 210, 210, 255);
+            rq_draw_rect(renderer, &box_rect);
             int img_h = 210;
             if (pen_poster)
             {
                 SDL_Rect img_r = {box_x + 1, box_y + 1, box_w - 2, img_h};
-                SDL_RenderCopy(renderer, pen_poster, NULL, &img_r);
-                SDL_SetRenderDrawColor(renderer, 230, 230, 230, 255);
-                SDL_RenderDrawLine(renderer, box_x, box_y + img_h + 2, box_x + box_w, box_y + img_h + 2);
+                rq_copy(renderer, pen_poster, NULL, &img_r);
+                rq_set_color(renderer, 230, 230, 230, 255);
+                rq_draw_line(renderer, box_x, box_y + img_h + 2, box_x + box_w, box_y + img_h + 2);
             }
             int title_w = 0;
             TTF_SizeUTF8(font_large, "Pen", &title_w, NULL);
@@ -1263,23 +1467,23 @@ int main(int /*argc*/, char * /*argv*/[])
         }
         else if (state.mode == MODE_SPRITE_LIBRARY)
         {
-            SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
-            SDL_RenderFillRect(renderer, NULL);
+            rq_set_color(renderer, 245, 245, 245, 255);
+            rq_fill_rect(renderer, NULL);
             SDL_Rect nav_bg = {0, 0, WINDOW_WIDTH, NAVBAR_HEIGHT + 20};
-            SDL_SetRenderDrawColor(renderer, 76, 151, 255, 255);
-            SDL_RenderFillRect(renderer, &nav_bg);
+            rq_set_color(renderer, 76, 151, 255, 255);
+            rq_fill_rect(renderer, &nav_bg);
             render_simple_text(renderer, font_large, "< Back", 30, 20, {255, 255, 255});
             for (size_t i = 0; i < global_sprite_lib.size(); i++)
             {
                 int x = 50 + i * 180, y = 150;
                 SDL_Rect box = {x, y, 160, 160};
                 renderer_fill_rounded_rect(renderer, &box, 12, 255, 255, 255);
-                SDL_SetRenderDrawColor(renderer, 220, 220, 220, 255);
-                SDL_RenderDrawRect(renderer, &box);
+                rq_set_color(renderer, 220, 220, 220, 255);
+                rq_draw_rect(renderer, &box);
                 if (global_sprite_lib[i].texture)
                 {
                     SDL_Rect img_dst = {x + 30, y + 20, 100, 100};
-                    SDL_RenderCopy(renderer, global_sprite_lib[i].texture, NULL, &img_dst);
+                    rq_copy(renderer, global_sprite_lib[i].texture, NULL, &img_dst);
                 }
                 int tw = 0;
                 TTF_SizeUTF8(font_large, global_sprite_lib[i].name.c_str(), &tw, NULL);
@@ -1288,23 +1492,23 @@ int main(int /*argc*/, char * /*argv*/[])
         }
         else if (state.mode == MODE_BACKDROP_LIBRARY)
         {
-            SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
-            SDL_RenderFillRect(renderer, NULL);
+            rq_set_color(renderer, 245, 245, 245, 255);
+            rq_fill_rect(renderer, NULL);
             SDL_Rect nav_bg = {0, 0, WINDOW_WIDTH, NAVBAR_HEIGHT + 20};
-            SDL_SetRenderDrawColor(renderer, 76, 151, 255, 255);
-            SDL_RenderFillRect(renderer, &nav_bg);
+            rq_set_color(renderer, 76, 151, 255, 255);
+            rq_fill_rect(renderer, &nav_bg);
             render_simple_text(renderer, font_large, "< Back", 30, 20, {255, 255, 255});
             for (size_t i = 0; i < global_backdrop_lib.size(); i++)
             {
                 int x = 50 + i * 180, y = 150;
                 SDL_Rect box = {x, y, 160, 160};
                 renderer_fill_rounded_rect(renderer, &box, 12, 255, 255, 255);
-                SDL_SetRenderDrawColor(renderer, 220, 220, 220, 255);
-                SDL_RenderDrawRect(renderer, &box);
+                rq_set_color(renderer, 220, 220, 220, 255);
+                rq_draw_rect(renderer, &box);
                 if (global_backdrop_lib[i].texture)
                 {
                     SDL_Rect img_dst = {x + 10, y + 20, 140, 100};
-                    SDL_RenderCopy(renderer, global_backdrop_lib[i].texture, NULL, &img_dst);
+                    rq_copy(renderer, global_backdrop_lib[i].texture, NULL, &img_dst);
                 }
                 int tw = 0;
                 TTF_SizeUTF8(font_large, global_backdrop_lib[i].name.c_str(), &tw, NULL);
@@ -1315,10 +1519,13 @@ int main(int /*argc*/, char * /*argv*/[])
         {
             if (state.current_tab == TAB_CODE)
             {
+                // The code panels are recorded and sent as merged, state-sorted batches
+                render_queue_begin(renderer);
                 drag_area_draw(renderer, font, state, drag_rects);
                 canvas_draw(renderer, font, state, canvas_rects, tex);
                 categories_draw(renderer, font, state, cat_rects);
                 palette_draw(renderer, font, state, pal_rects, tex);
+                render_queue_submit(renderer);
             }
             else if (state.current_tab == TAB_COSTUMES)
             {
@@ -1330,40 +1537,43 @@ int main(int /*argc*/, char * /*argv*/[])
             }
 
             stage_draw(renderer, font, state, stage_rects, tex);
+            // The chrome around the stage is recorded too, so its shapes and text merge
+            render_queue_begin(renderer);
             settings_draw(renderer, font, state, settings_rects, tex);
             sprite_panel_draw(renderer, font, state, tex, sprite_panel_rects);
             tab_bar_draw(renderer, font, state, tab_bar_rects, tex);
             navbar_draw(renderer, font, state, navbar_rects, tex);
             filemenu_draw(renderer, font, state, filemenu_rects);
+            render_queue_submit(renderer);
         }
 
         // ---> MODALS RENDERER <---
         if (state.var_modal_active || state.msg_modal_active)
         {
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 150);
+            rq_set_color(renderer, 0, 0, 0, 150);
             SDL_Rect screen_rect = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
-            SDL_RenderFillRect(renderer, &screen_rect);
+            rq_fill_rect(renderer, &screen_rect);
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
             int mw = 400, mh = 200, mx = WINDOW_WIDTH / 2 - mw / 2, my = WINDOW_HEIGHT / 2 - mh / 2;
             SDL_Rect modal_rect = {mx, my, mw, mh};
             renderer_fill_rounded_rect(renderer, &modal_rect, 8, 255, 255, 255);
-            SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-            SDL_RenderDrawRect(renderer, &modal_rect);
+            rq_set_color(renderer, 200, 200, 200, 255);
+            rq_draw_rect(renderer, &modal_rect);
             Color textCol = {40, 40, 40};
             std::string modal_title = state.var_modal_active ? "New variable name:" : "New message name:";
             render_simple_text(renderer, font, modal_title.c_str(), modal_rect.x + 30, modal_rect.y + 30, textCol);
             SDL_Rect input_rect = {modal_rect.x + 30, modal_rect.y + 70, mw - 60, 40};
             renderer_fill_rounded_rect(renderer, &input_rect, 4, 240, 240, 240);
-            SDL_SetRenderDrawColor(renderer, 76, 151, 255, 255);
-            SDL_RenderDrawRect(renderer, &input_rect);
+            rq_set_color(renderer, 76, 151, 255, 255);
+            rq_draw_rect(renderer, &input_rect);
             render_simple_text(renderer, font, state.input_buffer.c_str(), input_rect.x + 10, input_rect.y + 12, textCol);
             if ((SDL_GetTicks() / 500) % 2 == 0)
             {
                 int tw = 0;
                 TTF_SizeUTF8(font, state.input_buffer.c_str(), &tw, NULL);
-                SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                SDL_RenderDrawLine(renderer, input_rect.x + 10 + tw + 2, input_rect.y + 10, input_rect.x + 10 + tw + 2, input_rect.y + 30);
+                rq_set_color(renderer, 0, 0, 0, 255);
+                rq_draw_line(renderer, input_rect.x + 10 + tw + 2, input_rect.y + 10, input_rect.x + 10 + tw + 2, input_rect.y + 30);
             }
             SDL_Rect submit_btn = {mx + mw - 120, my + mh - 60, 90, 40};
             renderer_fill_rounded_rect(renderer, &submit_btn, 4, 76, 151, 255);
@@ -1377,17 +1587,17 @@ int main(int /*argc*/, char * /*argv*/[])
         if (state.func_modal_active)
         {
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 150);
+            rq_set_color(renderer, 0, 0, 0, 150);
             SDL_Rect screen_rect = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
-            SDL_RenderFillRect(renderer, &screen_rect);
+            rq_fill_rect(renderer, &screen_rect);
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
             int mw = 480, mh = 360;
             int mx = WINDOW_WIDTH / 2 - mw / 2;
             int my = WINDOW_HEIGHT / 2 - mh / 2;
             SDL_Rect modal_rect = {mx, my, mw, mh};
             renderer_fill_rounded_rect(renderer, &modal_rect, 8, 255, 255, 255);
-            SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-            SDL_RenderDrawRect(renderer, &modal_rect);
+            rq_set_color(renderer, 200, 200, 200, 255);
+            rq_draw_rect(renderer, &modal_rect);
             // Header
             SDL_Rect hdr = {mx, my, mw, 48};
             renderer_fill_rounded_rect(renderer, &hdr, 8, 255, 102, 128);
@@ -1399,15 +1609,15 @@ int main(int /*argc*/, char * /*argv*/[])
                 render_simple_text(renderer, font, "Block name:", mx + 24, my + 68, textCol);
                 SDL_Rect inp = {mx + 24, my + 92, mw - 48, 40};
                 renderer_fill_rounded_rect(renderer, &inp, 4, 240, 240, 240);
-                SDL_SetRenderDrawColor(renderer, 76, 151, 255, 255);
-                SDL_RenderDrawRect(renderer, &inp);
+                rq_set_color(renderer, 76, 151, 255, 255);
+                rq_draw_rect(renderer, &inp);
                 render_simple_text(renderer, font, state.input_buffer.c_str(), inp.x + 10, inp.y + 12, textCol);
                 if ((SDL_GetTicks() / 500) % 2 == 0)
                 {
                     int tw = 0;
                     TTF_SizeUTF8(font, state.input_buffer.c_str(), &tw, NULL);
-                    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                    SDL_RenderDrawLine(renderer, inp.x + 12 + tw, inp.y + 8, inp.x + 12 + tw, inp.y + 32);
+                    rq_set_color(renderer, 0, 0, 0, 255);
+                    rq_draw_line(renderer, inp.x + 12 + tw, inp.y + 8, inp.x + 12 + tw, inp.y + 32);
                 }
                 // Next button
                 SDL_Rect next_btn = {mx + mw - 120, my + mh - 56, 90, 36};
@@ -1452,15 +1662,7 @@ int main(int /*argc*/, char * /*argv*/[])
 
                 // "define" label
                 {
-                    SDL_Surface *sf = TTF_RenderUTF8_Blended(font, "define", wc);
-                    if (sf)
-                    {
-                        SDL_Texture *tx = SDL_CreateTextureFromSurface(renderer, sf);
-                        SDL_Rect dr2 = {cpx, text_py2, sf->w, sf->h};
-                        SDL_RenderCopy(renderer, tx, NULL, &dr2);
-                        SDL_DestroyTexture(tx);
-                        SDL_FreeSurface(sf);
-                    }
+                    text_draw(renderer, font, "define", cpx, text_py2, wc);
                     cpx += tw_def + 8;
                 }
 
@@ -1468,15 +1670,9 @@ int main(int /*argc*/, char * /*argv*/[])
                 {
                     SDL_Rect pil = {cpx, pill_py2, name_pill_w, 26};
                     renderer_fill_rounded_rect(renderer, &pil, 5, 220, 80, 110);
-                    SDL_Surface *sf = TTF_RenderUTF8_Blended(font, state.func_modal_name.c_str(), wc);
-                    if (sf)
-                    {
-                        SDL_Texture *tx = SDL_CreateTextureFromSurface(renderer, sf);
-                        SDL_Rect dr2 = {pil.x + (pil.w - sf->w) / 2, pil.y + (pil.h - sf->h) / 2, sf->w, sf->h};
-                        SDL_RenderCopy(renderer, tx, NULL, &dr2);
-                        SDL_DestroyTexture(tx);
-                        SDL_FreeSurface(sf);
-                    }
+                    int nw = 0, nh = 0;
+                    text_size(font, state.func_modal_name.c_str(), &nw, &nh);
+                    text_draw(renderer, font, state.func_modal_name.c_str(), pil.x + (pil.w - nw) / 2, pil.y + (pil.h - nh) / 2, wc);
                     cpx += name_pill_w + 6;
                 }
 
@@ -1497,22 +1693,16 @@ int main(int /*argc*/, char * /*argv*/[])
                         for (int dy = 0; dy <= hh3; dy++)
                         {
                             int xo = hh3 - dy;
-                            SDL_SetRenderDrawColor(renderer, 100, 200, 80, 255);
-                            SDL_RenderDrawLine(renderer, pil.x + xo, pil.y + dy, pil.x + pil_w - xo, pil.y + dy);
-                            SDL_RenderDrawLine(renderer, pil.x + xo, pil.y + pil.h - dy, pil.x + pil_w - xo, pil.y + pil.h - dy);
+                            rq_set_color(renderer, 100, 200, 80, 255);
+                            rq_draw_line(renderer, pil.x + xo, pil.y + dy, pil.x + pil_w - xo, pil.y + dy);
+                            rq_draw_line(renderer, pil.x + xo, pil.y + pil.h - dy, pil.x + pil_w - xo, pil.y + pil.h - dy);
                         }
                     }
                     if (!p.name.empty())
                     {
-                        SDL_Surface *sf = TTF_RenderUTF8_Blended(font, p.name.c_str(), wc);
-                        if (sf)
-                        {
-                            SDL_Texture *tx = SDL_CreateTextureFromSurface(renderer, sf);
-                            SDL_Rect dr2 = {pil.x + (pil.w - sf->w) / 2, pil.y + (pil.h - sf->h) / 2, sf->w, sf->h};
-                            SDL_RenderCopy(renderer, tx, NULL, &dr2);
-                            SDL_DestroyTexture(tx);
-                            SDL_FreeSurface(sf);
-                        }
+                        int pw = 0, ph = 0;
+                        text_size(font, p.name.c_str(), &pw, &ph);
+                        text_draw(renderer, font, p.name.c_str(), pil.x + (pil.w - pw) / 2, pil.y + (pil.h - ph) / 2, wc);
                     }
                     cpx += pil_w + 6;
                 }
@@ -1558,15 +1748,15 @@ int main(int /*argc*/, char * /*argv*/[])
                     render_simple_text(renderer, font, prompt.c_str(), mx + 24, my + 138, textCol);
                     SDL_Rect inp = {mx + 24, my + 162, mw - 48, 36};
                     renderer_fill_rounded_rect(renderer, &inp, 4, 240, 240, 240);
-                    SDL_SetRenderDrawColor(renderer, 76, 151, 255, 255);
-                    SDL_RenderDrawRect(renderer, &inp);
+                    rq_set_color(renderer, 76, 151, 255, 255);
+                    rq_draw_rect(renderer, &inp);
                     render_simple_text(renderer, font, state.input_buffer.c_str(), inp.x + 10, inp.y + 10, textCol);
                     if ((SDL_GetTicks() / 500) % 2 == 0)
                     {
                         int tw = 0;
                         TTF_SizeUTF8(font, state.input_buffer.c_str(), &tw, NULL);
-                        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-                        SDL_RenderDrawLine(renderer, inp.x + 12 + tw, inp.y + 6, inp.x + 12 + tw, inp.y + 30);
+                        rq_set_color(renderer, 0, 0, 0, 255);
+                        rq_draw_line(renderer, inp.x + 12 + tw, inp.y + 6, inp.x + 12 + tw, inp.y + 30);
                     }
                     SDL_Rect ok_btn = {mx + mw - 120, my + 250, 80, 30};
                     renderer_fill_rounded_rect(renderer, &ok_btn, 4, 76, 151, 255);
@@ -1592,23 +1782,23 @@ int main(int /*argc*/, char * /*argv*/[])
         if (state.active_input == INPUT_PEN_COLOR_PICKER || state.active_input == INPUT_BLOCK_COLOR_PICKER_1 || state.active_input == INPUT_BLOCK_COLOR_PICKER_2)
         {
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 150);
+            rq_set_color(renderer, 0, 0, 0, 150);
             SDL_Rect screen_rect = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
-            SDL_RenderFillRect(renderer, &screen_rect);
+            rq_fill_rect(renderer, &screen_rect);
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
             int mw = 300, mh = 250, mx = WINDOW_WIDTH / 2 - mw / 2, my = WINDOW_HEIGHT / 2 - mh / 2;
             SDL_Rect modal_rect = {mx, my, mw, mh};
             renderer_fill_rounded_rect(renderer, &modal_rect, 8, 255, 255, 255);
-            SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-            SDL_RenderDrawRect(renderer, &modal_rect);
+            rq_set_color(renderer, 200, 200, 200, 255);
+            rq_draw_rect(renderer, &modal_rect);
             render_simple_text(renderer, font_large, "Pick Color", modal_rect.x + 100, modal_rect.y + 20, {40, 40, 40});
             Color palette[9] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 0}, {0, 255, 255}, {255, 0, 255}, {0, 0, 0}, {128, 128, 128}, {255, 255, 255}};
             for (int i = 0; i < 9; i++)
             {
                 SDL_Rect c_rect = {mx + 30 + (i % 3) * 80, my + 80 + (i / 3) * 50, 70, 40};
                 renderer_fill_rounded_rect(renderer, &c_rect, 4, palette[i].r, palette[i].g, palette[i].b);
-                SDL_SetRenderDrawColor(renderer, 100, 100, 100, 255);
-                SDL_RenderDrawRect(renderer, &c_rect);
+                rq_set_color(renderer, 100, 100, 100, 255);
+                rq_draw_rect(renderer, &c_rect);
             }
         }
         RenderToasts(renderer, font);
@@ -1617,15 +1807,15 @@ int main(int /*argc*/, char * /*argv*/[])
         if (state.new_confirm_active)
         {
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 150);
+            rq_set_color(renderer, 0, 0, 0, 150);
             SDL_Rect screen_rect = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
-            SDL_RenderFillRect(renderer, &screen_rect);
+            rq_fill_rect(renderer, &screen_rect);
             SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
             int mw = 380, mh = 180, mx2 = WINDOW_WIDTH / 2 - mw / 2, my2 = WINDOW_HEIGHT / 2 - mh / 2;
             SDL_Rect modal_rect = {mx2, my2, mw, mh};
             renderer_fill_rounded_rect(renderer, &modal_rect, 8, 255, 255, 255);
-            SDL_SetRenderDrawColor(renderer, 200, 200, 200, 255);
-            SDL_RenderDrawRect(renderer, &modal_rect);
+            rq_set_color(renderer, 200, 200, 200, 255);
+            rq_draw_rect(renderer, &modal_rect);
             render_simple_text(renderer, font_large, "Start a new project?", mx2 + 30, my2 + 30, {40, 40, 40});
             render_simple_text(renderer, font, "Unsaved changes will be lost.", mx2 + 30, my2 + 65, {120, 120, 120});
             SDL_Rect yes_btn = {mx2 + mw - 120, my2 + mh - 60, 90, 40};
@@ -1635,20 +1825,27 @@ int main(int /*argc*/, char * /*argv*/[])
             renderer_fill_rounded_rect(renderer, &no_btn, 4, 220, 220, 220);
             render_simple_text(renderer, font, "Cancel", no_btn.x + 22, no_btn.y + 12, {40, 40, 40});
         }
-        SDL_RenderPresent(renderer);
+        perf_overlay_draw(renderer, font, state);
+        redraw_end(renderer);
     }
 
     if (pen_poster)
         SDL_DestroyTexture(pen_poster);
     textures_free(tex);
+    workspace_free_cache();
+    sprite_atlas_shutdown();
+    stage_shutdown();
+    redraw_quit();
+    text_shutdown();
     TTF_CloseFont(font);
     TTF_CloseFont(font_large);
     SDL_StopTextInput();
+    image_import_quit();
     audio_quit();
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     IMG_Quit();
     TTF_Quit();
     SDL_Quit();
-    return 0;
+    return exit_code;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "navbar.h"
 #include "config.h"
 #include "renderer.h"
+#include "text.h"
+#include "render_queue.h"
 #include <cstring>
 #include <string>
 
@@ -11,7 +13,7 @@ static bool point_in_rect(int px, int py, const SDL_Rect &r)
 
 static void set_color(SDL_Renderer *r, Color c)
 {
-    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255);
+    rq_set_color(r, c.r, c.g, c.b, 255);
 }
 
 static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt,
@@ -19,14 +21,7 @@ static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt,
 {
     SDL_Color sc;
     sc.r = c.r; sc.g = c.g; sc.b = c.b; sc.a = 255;
-    SDL_Surface *s = TTF_RenderUTF8_Blended(f, txt, sc);
-    if (!s) return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst;
-    dst.x = x; dst.y = y; dst.w = s->w; dst.h = s->h;
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    text_draw(r, f, txt, x, y, sc);
 }
 
 void navbar_layout(NavbarRects &rects)
@@ -61,7 +56,7 @@ void navbar_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
 {
     /* background */
     set_color(r, COL_NAVBAR_BG);
-    SDL_RenderFillRect(r, &rects.bar);
+    rq_fill_rect(r, &rects.bar);
 
     /* logo */
     if (tex.logo) {
@@ -77,7 +72,7 @@ void navbar_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
     /* file button */
     if (state.file_menu_open) {
         set_color(r, COL_NAVBAR_FILE_HOVER);
-        SDL_RenderFillRect(r, &rects.file_btn);
+        rq_fill_rect(r, &rects.file_btn);
     }
     {
         int tx = rects.file_btn.x + (rects.file_btn.w - 22) / 2;
@@ -87,13 +82,13 @@ void navbar_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
 
     /* project name input */
     set_color(r, COL_NAVBAR_INPUT_BG);
-    SDL_RenderFillRect(r, &rects.project_input);
+    rq_fill_rect(r, &rects.project_input);
     if (state.active_input == INPUT_PROJECT_NAME) {
         set_color(r, COL_SETTINGS_INPUT_ACTIVE);
     } else {
         set_color(r, COL_NAVBAR_INPUT_BORDER);
     }
-    SDL_RenderDrawRect(r, &rects.project_input);
+    rq_draw_rect(r, &rects.project_input);
 
     {
         std::string txt;
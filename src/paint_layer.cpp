@@ -0,0 +1,545 @@
+#include "paint_layer.h"
+#include "SDL_image.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+PaintLayer *paint_layer_create(int w, int h)
+{
+    PaintLayer *pl = new PaintLayer;
+    pl->w = w;
+    pl->h = h;
+    pl->tiles_x = (w + PAINT_TILE - 1) / PAINT_TILE;
+    pl->tiles_y = (h + PAINT_TILE - 1) / PAINT_TILE;
+    pl->tiles.assign(pl->tiles_x * pl->tiles_y, nullptr);
+    pl->journal = nullptr;
+    return pl;
+}
+
+void paint_layer_destroy(PaintLayer *pl)
+{
+    if (!pl)
+        return;
+    for (PaintTile *t : pl->tiles)
+    {
+        if (!t)
+            continue;
+        if (t->texture)
+            SDL_DestroyTexture(t->texture);
+        delete t;
+    }
+    delete pl;
+}
+
+PaintTile *paint_layer_tile(PaintLayer *pl, int tx, int ty, bool create)
+{
+    if (!pl || tx < 0 || ty < 0 || tx >= pl->tiles_x || ty >= pl->tiles_y)
+        return nullptr;
+    PaintTile *&t = pl->tiles[ty * pl->tiles_x + tx];
+    if (!t && create)
+    {
+        t = new PaintTile;
+        t->pixels.assign(PAINT_TILE * PAINT_TILE, 0);
+        t->texture = nullptr;
+        t->dirty = true;
+    }
+    return t;
+}
+
+// ---> UNDO JOURNAL <---
+static void paint_tile_encode(const PaintTile *t, PaintTileBackup &b)
+{
+    std::vector<Uint32> &out = b.data;
+    out.clear();
+    b.raw = false;
+    if (!t)
+        return;
+    size_t i = 0, n = t->pixels.size();
+    while (i < n)
+    {
+        Uint32 px = t->pixels[i];
+        size_t run = 1;
+        while (i + run < n && t->pixels[i + run] == px)
+            run++;
+        out.push_back((Uint32)run);
+        out.push_back(px);
+        i += run;
+        if (out.size() >= n)
+        {
+            // Runs too short to pay off: keep the pixels as they are
+            out = t->pixels;
+            b.raw = true;
+            break;
+        }
+    }
+    out.shrink_to_fit();
+}
+
+static void paint_tile_decode(const PaintTileBackup &b, PaintTile *t)
+{
+    t->dirty = true;
+    if (b.raw)
+    {
+        std::copy_n(b.data.begin(), std::min(b.data.size(), t->pixels.size()), t->pixels.begin());
+        return;
+    }
+    size_t at = 0;
+    for (size_t i = 0; i + 1 < b.data.size() && at < t->pixels.size(); i += 2)
+    {
+        size_t run = std::min((size_t)b.data[i], t->pixels.size() - at);
+        std::fill(t->pixels.begin() + at, t->pixels.begin() + at + run, b.data[i + 1]);
+        at += run;
+    }
+}
+
+static void paint_layer_backup(PaintLayer *pl, int index)
+{
+    if (!pl->journal || pl->journaled[index])
+        return;
+    pl->journaled[index] = 1;
+    PaintTileBackup b;
+    b.index = index;
+    b.existed = pl->tiles[index] != nullptr;
+    paint_tile_encode(pl->tiles[index], b);
+    pl->journal->push_back(std::move(b));
+}
+
+void paint_layer_begin_journal(PaintLayer *pl, std::vector<PaintTileBackup> *journal)
+{
+    if (!pl)
+        return;
+    pl->journal = journal;
+    pl->journaled.assign(pl->tiles.size(), 0);
+}
+
+void paint_layer_end_journal(PaintLayer *pl)
+{
+    if (!pl)
+        return;
+    pl->journal = nullptr;
+    pl->journaled.clear();
+}
+
+void paint_layer_swap_backups(PaintLayer *pl, std::vector<PaintTileBackup> &backups)
+{
+    if (!pl)
+        return;
+    for (PaintTileBackup &b : backups)
+    {
+        if (b.index < 0 || b.index >= (int)pl->tiles.size())
+            continue;
+        PaintTile *&t = pl->tiles[b.index];
+        PaintTileBackup live;
+        live.index = b.index;
+        live.existed = t != nullptr;
+        paint_tile_encode(t, live);
+
+        if (b.existed)
+        {
+            if (!t)
+                t = paint_layer_tile(pl, b.index % pl->tiles_x, b.index / pl->tiles_x, true);
+            paint_tile_decode(b, t);
+        }
+        else if (t)
+        {
+            if (t->texture)
+                SDL_DestroyTexture(t->texture);
+            delete t;
+            t = nullptr;
+        }
+        b = std::move(live);
+    }
+}
+
+void paint_layer_clear(PaintLayer *pl)
+{
+    if (!pl)
+        return;
+    for (size_t i = 0; i < pl->tiles.size(); i++)
+    {
+        PaintTile *&t = pl->tiles[i];
+        if (!t)
+            continue;
+        paint_layer_backup(pl, (int)i);
+        if (t->texture)
+            SDL_DestroyTexture(t->texture);
+        delete t;
+        t = nullptr;
+    }
+}
+
+bool paint_tile_is_empty(const PaintTile *t)
+{
+    if (!t)
+        return true;
+    for (Uint32 px : t->pixels)
+        if (px & 0xFF)
+            return false;
+    return true;
+}
+
+// Sets x0..x1 (inclusive) on row y to px, allocating only the tiles it crosses
+static void paint_layer_set_span(PaintLayer *pl, int y, int x0, int x1, Uint32 px)
+{
+    if (y < 0 || y >= pl->h)
+        return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, pl->w - 1);
+    int ty = y / PAINT_TILE;
+    int ly = y - ty * PAINT_TILE;
+    while (x0 <= x1)
+    {
+        int tx = x0 / PAINT_TILE;
+        int end = std::min(x1, tx * PAINT_TILE + PAINT_TILE - 1);
+        // Erasing never needs to allocate
+        int index = ty * pl->tiles_x + tx;
+        if (pl->tiles[index] || px != 0)
+        {
+            paint_layer_backup(pl, index);
+            PaintTile *t = paint_layer_tile(pl, tx, ty, true);
+            Uint32 *row = &t->pixels[ly * PAINT_TILE];
+            std::fill(row + (x0 - tx * PAINT_TILE), row + (end - tx * PAINT_TILE) + 1, px);
+            t->dirty = true;
+        }
+        x0 = end + 1;
+    }
+}
+
+// Narrows [lo, hi] to the x where lo_v <= k * x + c <= hi_v holds on this row
+static bool paint_clip_slab(float k, float c, float lo_v, float hi_v, float &lo, float &hi)
+{
+    if (std::fabs(k) < 1e-6f)
+        return c >= lo_v && c <= hi_v;
+    float a = (lo_v - c) / k, b = (hi_v - c) / k;
+    if (a > b)
+        std::swap(a, b);
+    lo = std::max(lo, a);
+    hi = std::min(hi, b);
+    return lo <= hi;
+}
+
+void paint_layer_fill_capsule(PaintLayer *pl, float x0, float y0, float x1, float y1, float radius, SDL_Color color, bool erase)
+{
+    if (!pl)
+        return;
+    Uint32 px = erase ? 0u : (((Uint32)color.r << 24) | ((Uint32)color.g << 16) | ((Uint32)color.b << 8) | 0xFF);
+
+    float dx = x1 - x0, dy = y1 - y0;
+    float len = std::sqrt(dx * dx + dy * dy);
+    float ux = len > 0.0f ? dx / len : 1.0f, uy = len > 0.0f ? dy / len : 0.0f;
+    float r2 = radius * radius;
+
+    int row0 = std::max(0, (int)std::floor(std::min(y0, y1) - radius));
+    int row1 = std::min(pl->h - 1, (int)std::ceil(std::max(y0, y1) + radius));
+    for (int y = row0; y <= row1; y++)
+    {
+        // The capsule is convex, so each row is one span: the union of both
+        // end discs and the band between them
+        float cy = y + 0.5f;
+        float lo = 1e9f, hi = -1e9f;
+        const float ends[2][2] = {{x0, y0}, {x1, y1}};
+        for (const auto &e : ends)
+        {
+            float ry = cy - e[1];
+            if (ry * ry > r2)
+                continue;
+            float half = std::sqrt(r2 - ry * ry);
+            lo = std::min(lo, e[0] - half);
+            hi = std::max(hi, e[0] + half);
+        }
+        if (len > 0.0f)
+        {
+            // Along-axis in [0, len] and across-axis in [-radius, radius]
+            float blo = -1e9f, bhi = 1e9f;
+            if (paint_clip_slab(ux, uy * (cy - y0) - ux * x0, 0.0f, len, blo, bhi) &&
+                paint_clip_slab(-uy, ux * (cy - y0) + uy * x0, -radius, radius, blo, bhi))
+            {
+                lo = std::min(lo, blo);
+                hi = std::max(hi, bhi);
+            }
+        }
+        if (lo > hi)
+            continue;
+        paint_layer_set_span(pl, y, (int)std::ceil(lo - 0.5f), (int)std::floor(hi - 0.5f), px);
+    }
+}
+
+// Per-channel distance test, all four channels of 0xRRGGBBAA at once
+static inline bool paint_px_match(Uint32 px, Uint32 seed, int tolerance)
+{
+    if (px == seed)
+        return true;
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        int d = (int)((px >> shift) & 0xFF) - (int)((seed >> shift) & 0xFF);
+        if (d > tolerance || d < -tolerance)
+            return false;
+    }
+    return true;
+}
+
+// out[x] = 1 where src[x] matches seed, for one row; four pixels per step on SSE2/NEON
+static void paint_match_row(const Uint32 *src, Uint8 *out, int n, Uint32 seed, int tolerance)
+{
+    const Uint8 tol = (Uint8)std::max(0, std::min(255, tolerance));
+    int x = 0;
+#if SIMD_SSE2
+    const __m128i seed4 = _mm_set1_epi32((int)seed);
+    const __m128i tol16 = _mm_set1_epi8((char)tol);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    for (; x + 4 <= n; x += 4)
+    {
+        __m128i p = _mm_loadu_si128((const __m128i *)(src + x));
+        __m128i diff = _mm_or_si128(_mm_subs_epu8(p, seed4), _mm_subs_epu8(seed4, p));
+        __m128i within = _mm_cmpeq_epi8(_mm_subs_epu8(diff, tol16), zero); // per channel
+        __m128i all4 = _mm_cmpeq_epi32(within, _mm_cmpeq_epi32(zero, zero)); // per pixel
+        __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(all4, zero), zero);
+        int m = _mm_cvtsi128_si32(_mm_and_si128(bytes, one));
+        std::memcpy(out + x, &m, 4);
+    }
+#elif SIMD_NEON
+    const uint8x16_t seed4 = vreinterpretq_u8_u32(vdupq_n_u32(seed));
+    const uint8x16_t tol16 = vdupq_n_u8(tol);
+    for (; x + 4 <= n; x += 4)
+    {
+        uint8x16_t p = vld1q_u8((const uint8_t *)(src + x));
+        uint32x4_t all4 = vceqq_u32(vreinterpretq_u32_u8(vcleq_u8(vabdq_u8(p, seed4), tol16)), vdupq_n_u32(0xFFFFFFFFu));
+        uint8x8_t bytes = vmovn_u16(vcombine_u16(vmovn_u32(all4), vdup_n_u16(0)));
+        Uint32 m = vget_lane_u32(vreinterpret_u32_u8(vand_u8(bytes, vdup_n_u8(1))), 0);
+        std::memcpy(out + x, &m, 4);
+    }
+#endif
+    for (; x < n; x++)
+        out[x] = paint_px_match(src[x], seed, tolerance) ? 1 : 0;
+}
+
+SDL_Rect paint_layer_flood_fill(PaintLayer *pl, const Uint32 *src, int sx, int sy, SDL_Color color, int tolerance)
+{
+    SDL_Rect box = {0, 0, 0, 0};
+    if (!pl || !src || sx < 0 || sy < 0 || sx >= pl->w || sy >= pl->h)
+        return box;
+
+    const int w = pl->w, h = pl->h;
+    const Uint32 seed = src[sy * w + sx];
+    const Uint32 px = ((Uint32)color.r << 24) | ((Uint32)color.g << 16) | ((Uint32)color.b << 8) | 0xFF;
+    // open[i]: matches the seed and is not filled yet; rows are matched when first visited
+    std::vector<Uint8> open_px((size_t)w * h);
+    std::vector<Uint8> row_ready(h, 0);
+    std::vector<SDL_Point> stack;
+    stack.push_back({sx, sy});
+    int min_x = sx, max_x = sx, min_y = sy, max_y = sy;
+
+    auto row = [&](int y)
+    {
+        Uint8 *r = &open_px[(size_t)y * w];
+        if (!row_ready[y])
+        {
+            paint_match_row(src + (size_t)y * w, r, w, seed, tolerance);
+            row_ready[y] = 1;
+        }
+        return r;
+    };
+
+    while (!stack.empty())
+    {
+        SDL_Point p = stack.back();
+        stack.pop_back();
+        Uint8 *cur = row(p.y);
+        if (!cur[p.x])
+            continue;
+
+        // Grow the run left and right, then fill it as one span
+        int x0 = p.x, x1 = p.x;
+        while (x0 > 0 && cur[x0 - 1])
+            x0--;
+        while (x1 < w - 1 && cur[x1 + 1])
+            x1++;
+        std::fill(cur + x0, cur + x1 + 1, 0);
+        paint_layer_set_span(pl, p.y, x0, x1, px);
+
+        min_x = std::min(min_x, x0);
+        max_x = std::max(max_x, x1);
+        min_y = std::min(min_y, p.y);
+        max_y = std::max(max_y, p.y);
+
+        // One seed per run on the rows above and below
+        for (int ny = p.y - 1; ny <= p.y + 1; ny += 2)
+        {
+            if (ny < 0 || ny >= h)
+                continue;
+            const Uint8 *next = row(ny);
+            bool in_run = false;
+            for (int x = x0; x <= x1; x++)
+            {
+                bool ok = next[x] != 0;
+                if (ok && !in_run)
+                    stack.push_back({x, ny});
+                in_run = ok;
+            }
+        }
+    }
+
+    box = {min_x, min_y, max_x - min_x + 1, max_y - min_y + 1};
+    return box;
+}
+
+void paint_layer_upload(PaintLayer *pl, SDL_Renderer *r)
+{
+    if (!pl || !r)
+        return;
+    for (PaintTile *t : pl->tiles)
+    {
+        if (!t || !t->dirty)
+            continue;
+        if (!t->texture)
+        {
+            SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+            t->texture = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, PAINT_TILE, PAINT_TILE);
+            SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+            if (!t->texture)
+                continue;
+            SDL_SetTextureBlendMode(t->texture, SDL_BLENDMODE_BLEND);
+        }
+        SDL_UpdateTexture(t->texture, NULL, t->pixels.data(), PAINT_TILE * 4);
+        t->dirty = false;
+    }
+}
+
+void paint_layer_draw(const PaintLayer *pl, SDL_Renderer *r, SDL_RendererFlip flip)
+{
+    if (!pl)
+        return;
+    for (int ty = 0; ty < pl->tiles_y; ty++)
+    {
+        for (int tx = 0; tx < pl->tiles_x; tx++)
+        {
+            const PaintTile *t = pl->tiles[ty * pl->tiles_x + tx];
+            if (!t || !t->texture)
+                continue;
+            SDL_Rect dst = {tx * PAINT_TILE, ty * PAINT_TILE, PAINT_TILE, PAINT_TILE};
+            // Mirror the tile's slot across the whole layer, then flip its content
+            if (flip & SDL_FLIP_HORIZONTAL)
+                dst.x = pl->w - dst.x - PAINT_TILE;
+            if (flip & SDL_FLIP_VERTICAL)
+                dst.y = pl->h - dst.y - PAINT_TILE;
+            SDL_RenderCopyEx(r, t->texture, NULL, &dst, 0, NULL, flip);
+        }
+    }
+}
+
+bool paint_layer_save(const PaintLayer *pl, const std::string &path, std::vector<int> &tile_coords)
+{
+    tile_coords.clear();
+    if (!pl)
+        return false;
+
+    std::vector<const PaintTile *> used;
+    for (int ty = 0; ty < pl->tiles_y; ty++)
+        for (int tx = 0; tx < pl->tiles_x; tx++)
+        {
+            const PaintTile *t = pl->tiles[ty * pl->tiles_x + tx];
+            if (paint_tile_is_empty(t))
+                continue;
+            used.push_back(t);
+            tile_coords.push_back(tx);
+            tile_coords.push_back(ty);
+        }
+    if (used.empty())
+        return false;
+
+    int sheet_w = (int)used.size() * PAINT_TILE;
+    SDL_Surface *surf = SDL_CreateRGBSurfaceWithFormat(0, sheet_w, PAINT_TILE, 32, SDL_PIXELFORMAT_RGBA8888);
+    if (!surf)
+    {
+        SDL_Log("Paint layer save failed for '%s': %s", path.c_str(), SDL_GetError());
+        tile_coords.clear();
+        return false;
+    }
+    for (size_t i = 0; i < used.size(); i++)
+        for (int row = 0; row < PAINT_TILE; row++)
+        {
+            Uint8 *dst = (Uint8 *)surf->pixels + row * surf->pitch + i * PAINT_TILE * 4;
+            std::memcpy(dst, &used[i]->pixels[row * PAINT_TILE], PAINT_TILE * 4);
+        }
+    int rc = IMG_SavePNG(surf, path.c_str());
+    SDL_FreeSurface(surf);
+    if (rc != 0)
+    {
+        SDL_Log("IMG_SavePNG failed for '%s': %s", path.c_str(), IMG_GetError());
+        tile_coords.clear();
+        return false;
+    }
+    return true;
+}
+
+static SDL_Surface *load_rgba(const std::string &path)
+{
+    SDL_Surface *raw = IMG_Load(path.c_str());
+    if (!raw)
+    {
+        SDL_Log("IMG_Load failed for '%s': %s", path.c_str(), IMG_GetError());
+        return nullptr;
+    }
+    SDL_Surface *conv = SDL_ConvertSurfaceFormat(raw, SDL_PIXELFORMAT_RGBA8888, 0);
+    SDL_FreeSurface(raw);
+    return conv;
+}
+
+PaintLayer *paint_layer_load_tiles(const std::string &path, const std::vector<int> &tile_coords, int w, int h)
+{
+    SDL_Surface *surf = load_rgba(path);
+    if (!surf)
+        return nullptr;
+    PaintLayer *pl = paint_layer_create(w, h);
+    int count = (int)tile_coords.size() / 2;
+    for (int i = 0; i < count && (i + 1) * PAINT_TILE <= surf->w && surf->h >= PAINT_TILE; i++)
+    {
+        PaintTile *t = paint_layer_tile(pl, tile_coords[i * 2], tile_coords[i * 2 + 1], true);
+        if (!t)
+            continue;
+        for (int row = 0; row < PAINT_TILE; row++)
+        {
+            const Uint8 *src = (const Uint8 *)surf->pixels + row * surf->pitch + i * PAINT_TILE * 4;
+            std::memcpy(&t->pixels[row * PAINT_TILE], src, PAINT_TILE * 4);
+        }
+    }
+    SDL_FreeSurface(surf);
+    return pl;
+}
+
+PaintLayer *paint_layer_load_image(const std::string &path, int w, int h)
+{
+    SDL_Surface *surf = load_rgba(path);
+    if (!surf)
+        return nullptr;
+    PaintLayer *pl = paint_layer_create(w, h);
+    // Nearest-neighbour stretch to the layer size, skipping fully transparent tiles
+    for (int ty = 0; ty < pl->tiles_y; ty++)
+        for (int tx = 0; tx < pl->tiles_x; tx++)
+        {
+            PaintTile *t = nullptr;
+            for (int ly = 0; ly < PAINT_TILE; ly++)
+            {
+                int y = ty * PAINT_TILE + ly;
+                if (y >= h)
+                    break;
+                const Uint32 *src_row = (const Uint32 *)((const Uint8 *)surf->pixels + (y * surf->h / h) * surf->pitch);
+                for (int lx = 0; lx < PAINT_TILE; lx++)
+                {
+                    int x = tx * PAINT_TILE + lx;
+                    if (x >= w)
+                        break;
+                    Uint32 px = src_row[x * surf->w / w];
+                    if (!(px & 0xFF))
+                        continue;
+                    if (!t)
+                        t = paint_layer_tile(pl, tx, ty, true);
+                    t->pixels[ly * PAINT_TILE + lx] = px;
+                }
+            }
+        }
+    SDL_FreeSurface(surf);
+    return pl;
+}
@@ -0,0 +1,75 @@
+#ifndef PAINT_LAYER_H
+#define PAINT_LAYER_H
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+
+// ---> SPARSE PAINT LAYER <---
+// Brush/eraser pixels of one costume or backdrop, kept as 64x64 RGBA8888 tiles
+// (0xRRGGBBAA, straight alpha). A tile only exists once something touched it.
+static const int PAINT_TILE = 64;
+
+struct PaintTile
+{
+    std::vector<Uint32> pixels; // PAINT_TILE * PAINT_TILE
+    SDL_Texture *texture;       // streaming copy, created on first upload
+    bool dirty;
+};
+
+// Earlier content of one tile: run-length encoded as (count, pixel) pairs, or the
+// plain pixels when encoding would not make it smaller (noisy or gradient tiles)
+struct PaintTileBackup
+{
+    int index;                // into PaintLayer::tiles
+    bool existed;             // false = the tile was absent
+    bool raw;                 // data holds the pixels as they are
+    std::vector<Uint32> data;
+};
+
+struct PaintLayer
+{
+    int w, h;
+    int tiles_x, tiles_y;
+    std::vector<PaintTile *> tiles; // row-major, nullptr = never painted
+
+    // While set, each tile is backed up here before its first change
+    std::vector<PaintTileBackup> *journal;
+    std::vector<Uint8> journaled;
+};
+
+PaintLayer *paint_layer_create(int w, int h);
+void paint_layer_destroy(PaintLayer *pl);
+
+/* Undo support: record tiles before they change / swap recorded tiles with the live ones */
+void paint_layer_begin_journal(PaintLayer *pl, std::vector<PaintTileBackup> *journal);
+void paint_layer_end_journal(PaintLayer *pl);
+void paint_layer_swap_backups(PaintLayer *pl, std::vector<PaintTileBackup> &backups);
+/* Drops every tile (journaled, so it can be undone) */
+void paint_layer_clear(PaintLayer *pl);
+
+/* Tile at tile coords (tx, ty); allocates a transparent one when create is set */
+PaintTile *paint_layer_tile(PaintLayer *pl, int tx, int ty, bool create);
+bool paint_tile_is_empty(const PaintTile *t);
+
+/* Hard-edged round-capped segment (a brush stroke piece), one span per row */
+void paint_layer_fill_capsule(PaintLayer *pl, float x0, float y0, float x1, float y1, float radius, SDL_Color color, bool erase);
+
+/* Scanline flood fill from (sx, sy). src is the composed image in layer space
+   (w * h RGBA8888, unflipped); pixels whose channels all lie within tolerance
+   of the seed get the fill colour in the layer. Returns the filled bounds. */
+SDL_Rect paint_layer_flood_fill(PaintLayer *pl, const Uint32 *src, int sx, int sy, SDL_Color color, int tolerance);
+
+/* Push dirty tiles to their textures */
+void paint_layer_upload(PaintLayer *pl, SDL_Renderer *r);
+/* Composite present tiles over the current target (sized w x h), with item flips */
+void paint_layer_draw(const PaintLayer *pl, SDL_Renderer *r, SDL_RendererFlip flip);
+
+/* Save: non-empty tiles packed side by side in one PNG, plus their (tx, ty) pairs.
+   Returns false (and writes nothing) when the layer is blank. */
+bool paint_layer_save(const PaintLayer *pl, const std::string &path, std::vector<int> &tile_coords);
+PaintLayer *paint_layer_load_tiles(const std::string &path, const std::vector<int> &tile_coords, int w, int h);
+/* Older projects stored the whole layer as one full-size PNG */
+PaintLayer *paint_layer_load_image(const std::string &path, int w, int h);
+
+#endif
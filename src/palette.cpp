@@ -3,6 +3,9 @@
 #include "block_ui.h"
 #include "renderer.h"
 #include "workspace.h"
+#include "text.h"
+#include "render_queue.h"
+#include "trace.h"
 #include <SDL_ttf.h>
 
 static bool point_in_rect(int px, int py, const SDL_Rect &r) { return px >= r.x && px < r.x + r.w && py >= r.y && py < r.y + r.h; }
@@ -12,15 +15,7 @@ static void render_simple_text(SDL_Renderer *r, TTF_Font *font, const char *text
     if (!text || text[0] == '\0')
         return;
     SDL_Color sc = {static_cast<Uint8>(c.r), static_cast<Uint8>(c.g), static_cast<Uint8>(c.b), 255};
-    SDL_Surface *surf = TTF_RenderUTF8_Blended(font, text, sc);
-    if (surf)
-    {
-        SDL_Texture *tex = SDL_CreateTextureFromSurface(r, surf);
-        SDL_Rect dst = {x, y, surf->w, surf->h};
-        SDL_RenderCopy(r, tex, NULL, &dst);
-        SDL_DestroyTexture(tex);
-        SDL_FreeSurface(surf);
-    }
+    text_draw(r, font, text, x, y, sc);
 }
 
 void palette_layout(PaletteRects &rects)
@@ -33,22 +28,29 @@ void palette_layout(PaletteRects &rects)
 
 void palette_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const PaletteRects &rects, const Textures &tex)
 {
+    TRACE_ZONE("palette_draw");
     Color bg = {249, 249, 249};
-    SDL_SetRenderDrawColor(r, bg.r, bg.g, bg.b, 255);
-    SDL_RenderFillRect(r, &rects.panel);
-    SDL_SetRenderDrawColor(r, 220, 220, 220, 255);
-    SDL_RenderDrawLine(r, rects.panel.x + rects.panel.w - 1, rects.panel.y, rects.panel.x + rects.panel.w - 1, rects.panel.y + rects.panel.h);
+    rq_set_color(r, bg.r, bg.g, bg.b, 255);
+    rq_fill_rect(r, &rects.panel);
+    rq_set_color(r, 220, 220, 220, 255);
+    rq_draw_line(r, rects.panel.x + rects.panel.w - 1, rects.panel.y, rects.panel.x + rects.panel.w - 1, rects.panel.y + rects.panel.h);
 
     int bx = rects.panel.x + 12;
-    SDL_RenderSetClipRect(r, &rects.panel);
+    // Contents stay inside the panel and the frame's dirty clip, which is put back on exit
+    SDL_Rect outer_clip;
+    bool outer_clipped = rq_get_clip(r, &outer_clip);
+    SDL_Rect clip = rects.panel;
+    if (outer_clipped && !SDL_IntersectRect(&rects.panel, &outer_clip, &clip))
+        return;
+    rq_set_clip(r, &clip);
     int by = rects.panel.y + 60;
 
     if (state.selected_category == 7) // Variables
     {
         SDL_Rect btn_rect = {bx, by, 130, 30};
         renderer_fill_rounded_rect(r, &btn_rect, 4, 240, 240, 240);
-        SDL_SetRenderDrawColor(r, 180, 180, 180, 255);
-        SDL_RenderDrawRect(r, &btn_rect);
+        rq_set_color(r, 180, 180, 180, 255);
+        rq_draw_rect(r, &btn_rect);
         render_simple_text(r, font, "Make a Variable", btn_rect.x + 14, btn_rect.y + 7, (Color){40, 40, 40});
         by += 50;
     }
@@ -56,8 +58,8 @@ void palette_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const
     {
         SDL_Rect btn_rect = {bx, by, 130, 30};
         renderer_fill_rounded_rect(r, &btn_rect, 4, 240, 240, 240);
-        SDL_SetRenderDrawColor(r, 180, 180, 180, 255);
-        SDL_RenderDrawRect(r, &btn_rect);
+        rq_set_color(r, 180, 180, 180, 255);
+        rq_draw_rect(r, &btn_rect);
         render_simple_text(r, font, "Make a Message", btn_rect.x + 12, btn_rect.y + 7, (Color){40, 40, 40});
         by += 50;
     }
@@ -75,7 +77,7 @@ void palette_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const
             SDL_Rect br = myblocks_call_block_rect(state, fn.name, bx, by);
             by += br.h + 12;
         }
-        SDL_RenderSetClipRect(r, nullptr); // <--- ADD THIS LINE to reset clipping
+        rq_set_clip(r, outer_clipped ? &outer_clip : nullptr);
         return; // Skip generic block rendering
     }
 
@@ -198,7 +200,7 @@ void palette_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const
             padding = 28;
         by += br.h + padding;
     }
-    SDL_RenderSetClipRect(r, nullptr);
+    rq_set_clip(r, outer_clipped ? &outer_clip : nullptr);
 }
 
 bool palette_handle_event(const SDL_Event &e, AppState &state, const PaletteRects &rects, TTF_Font *font)
@@ -265,12 +267,11 @@ bool palette_handle_event(const SDL_Event &e, AppState &state, const PaletteRect
                         state.drag.palette_kind = BK_MY_BLOCKS;
                         state.drag.palette_subtype = (int)MYB_CALL;
                         state.drag.palette_text = fn.name;
-                        state.drag.off_x = mx - bx;
-                        state.drag.off_y = my - by;
-                        state.drag.ghost_x = bx;
-                        state.drag.ghost_y = by;
-                        state.drag.mouse_x = mx;
-                        state.drag.mouse_y = my;
+                        workspace_screen_to_world(state, mx, my, state.drag.mouse_x, state.drag.mouse_y);
+                        state.drag.off_x = (int)((mx - bx) / state.ws_zoom);
+                        state.drag.off_y = (int)((my - by) / state.ws_zoom);
+                        state.drag.ghost_x = state.drag.mouse_x - state.drag.off_x;
+                        state.drag.ghost_y = state.drag.mouse_y - state.drag.off_y;
                         state.drag.snap_valid = false;
                         state.drag.snap_target_id = -1;
                         return true;
@@ -321,12 +322,12 @@ bool palette_handle_event(const SDL_Event &e, AppState &state, const PaletteRect
                     state.drag.palette_kind = defs[i].kind;
                     state.drag.palette_subtype = defs[i].subtype;
                     state.drag.palette_text = defs[i].label;
-                    state.drag.off_x = mx - bx;
-                    state.drag.off_y = my - by;
-                    state.drag.ghost_x = bx;
-                    state.drag.ghost_y = by;
-                    state.drag.mouse_x = mx;
-                    state.drag.mouse_y = my;
+                    // Drag state lives in workspace coordinates (see the code-area camera)
+                    workspace_screen_to_world(state, mx, my, state.drag.mouse_x, state.drag.mouse_y);
+                    state.drag.off_x = (int)((mx - bx) / state.ws_zoom);
+                    state.drag.off_y = (int)((my - by) / state.ws_zoom);
+                    state.drag.ghost_x = state.drag.mouse_x - state.drag.off_x;
+                    state.drag.ghost_y = state.drag.mouse_y - state.drag.off_y;
                     state.drag.snap_valid = false;
                     state.drag.snap_target_id = -1;
                     return true;
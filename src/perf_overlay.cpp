@@ -0,0 +1,196 @@
+#include "perf_overlay.h"
+#include "config.h"
+#include "interpreter.h"
+#include "redraw.h"
+#include "render_queue.h"
+#include "sprite_atlas.h"
+#include "stage.h"
+#include "text.h"
+#include "workspace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static const int HISTORY = 240;       // frames kept for the histogram and percentiles
+static const int TICK_HISTORY = 60;   // interpreter steps averaged
+static const int BUCKETS = 34;        // 1 ms each; the last one collects everything slower
+static const Uint32 REFRESH_MS = 250; // repaint rate of the panel while nothing else redraws
+static const int PANEL_W = 270;
+static const int LINE_H = 16;
+
+static bool g_visible = false;
+static Uint64 g_frame_start = 0;
+static double g_frames[HISTORY];
+static int g_frame_count = 0; // total recorded; the ring holds the last HISTORY
+static double g_ticks[TICK_HISTORY];
+static int g_tick_count = 0;
+static double g_last_tick = 0.0;
+static int g_compose_calls = 0, g_recomposed = 0;           // this frame so far
+static int g_last_compose_calls = 0, g_last_recomposed = 0; // last finished frame
+static Uint32 g_next_refresh = 0;
+
+void perf_overlay_init()
+{
+    const char *env = std::getenv("PERF_OVERLAY");
+    g_visible = env && std::atoi(env) != 0;
+}
+
+void perf_overlay_toggle()
+{
+    g_visible = !g_visible;
+    redraw_invalidate(NULL);
+}
+
+bool perf_overlay_visible()
+{
+    return g_visible;
+}
+
+void perf_frame_begin()
+{
+    g_frame_start = SDL_GetPerformanceCounter();
+    g_compose_calls = g_recomposed = 0;
+}
+
+void perf_note_tick(double ms)
+{
+    g_last_tick = ms;
+    g_ticks[g_tick_count % TICK_HISTORY] = ms;
+    g_tick_count++;
+}
+
+void perf_note_compose(bool recomposed)
+{
+    g_compose_calls++;
+    if (recomposed)
+        g_recomposed++;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty())
+        return 0.0;
+    size_t k = std::min(v.size() - 1, (size_t)(p * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static size_t texture_bytes(SDL_Texture *t)
+{
+    int w = 0, h = 0;
+    if (!t || SDL_QueryTexture(t, NULL, NULL, &w, &h) != 0)
+        return 0;
+    return (size_t)w * h * 4;
+}
+
+static size_t item_bytes(const GraphicItem &item)
+{
+    size_t bytes = texture_bytes(item.original_texture) + texture_bytes(item.composed_texture);
+    if (item.texture != item.original_texture)
+        bytes += texture_bytes(item.texture);
+    for (SDL_Texture *m : item.mips)
+        bytes += texture_bytes(m);
+    return bytes;
+}
+
+// Costumes, backdrops and the renderer-side caches; icons and the pen layer are fixed and left out
+static size_t texture_memory(const AppState &state)
+{
+    size_t bytes = workspace_cache_bytes() + sprite_atlas_bytes() + text_atlas_bytes() + texture_bytes(stage_texture());
+    for (const Sprite &spr : state.sprites)
+        for (const GraphicItem &c : spr.costumes)
+            bytes += item_bytes(c);
+    for (const GraphicItem &b : state.backdrops)
+        bytes += item_bytes(b);
+    return bytes;
+}
+
+static void draw_line(SDL_Renderer *r, TTF_Font *font, int x, int &y, const char *txt)
+{
+    text_draw(r, font, txt, x, y, {230, 230, 230, 255});
+    y += LINE_H;
+}
+
+void perf_overlay_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state)
+{
+    double frame_ms = (double)(SDL_GetPerformanceCounter() - g_frame_start) * 1000.0 / SDL_GetPerformanceFrequency();
+    g_frames[g_frame_count % HISTORY] = frame_ms;
+    g_frame_count++;
+    g_last_compose_calls = g_compose_calls;
+    g_last_recomposed = g_recomposed;
+    if (!g_visible || !r || !font)
+        return;
+
+    const int lines = 9, hist_h = 40;
+    SDL_Rect panel = {WINDOW_WIDTH - PANEL_W - 8, NAVBAR_HEIGHT + 8, PANEL_W, 12 + hist_h + 8 + lines * LINE_H + 8};
+    // Keep the numbers moving while the rest of the window is idle
+    Uint32 now = SDL_GetTicks();
+    if (SDL_TICKS_PASSED(now, g_next_refresh))
+    {
+        g_next_refresh = now + REFRESH_MS;
+        redraw_invalidate_at(&panel, g_next_refresh);
+    }
+
+    int n = std::min(g_frame_count, HISTORY);
+    std::vector<double> frames(g_frames, g_frames + n);
+    double p50 = percentile(frames, 0.50), p99 = percentile(frames, 0.99);
+    int counts[BUCKETS] = {0};
+    for (double ms : frames)
+        counts[std::min(BUCKETS - 1, std::max(0, (int)ms))]++;
+    int peak = *std::max_element(counts, counts + BUCKETS);
+
+    rq_set_blend(r, SDL_BLENDMODE_BLEND);
+    rq_set_color(r, 20, 20, 28, 210);
+    rq_fill_rect(r, &panel);
+
+    // Histogram of recent frame times, 1 ms per bar; p50 in green, p99 in red
+    const int bar_w = (PANEL_W - 24) / BUCKETS;
+    const int hx = panel.x + 12, hy = panel.y + 12;
+    rq_set_color(r, 120, 170, 255, 255);
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        if (counts[i] == 0)
+            continue;
+        int h = std::max(1, counts[i] * hist_h / std::max(1, peak));
+        SDL_Rect bar = {hx + i * bar_w, hy + hist_h - h, bar_w - 1, h};
+        rq_fill_rect(r, &bar);
+    }
+    rq_set_color(r, 90, 220, 120, 255);
+    int x50 = hx + std::min(BUCKETS - 1, (int)p50) * bar_w + bar_w / 2;
+    rq_draw_line(r, x50, hy, x50, hy + hist_h);
+    rq_set_color(r, 255, 90, 90, 255);
+    int x99 = hx + std::min(BUCKETS - 1, (int)p99) * bar_w + bar_w / 2;
+    rq_draw_line(r, x99, hy, x99, hy + hist_h);
+    rq_set_blend(r, SDL_BLENDMODE_NONE);
+
+    double tick_avg = 0.0;
+    int tn = std::min(g_tick_count, TICK_HISTORY);
+    for (int i = 0; i < tn; i++)
+        tick_avg += g_ticks[i];
+    if (tn > 0)
+        tick_avg /= tn;
+    InterpreterStats is = interpreter_stats();
+    const RenderStats &rs = render_stats();
+
+    char buf[96];
+    int tx = panel.x + 12, ty = hy + hist_h + 8;
+    std::snprintf(buf, sizeof(buf), "frame %.2f ms   p50 %.2f   p99 %.2f", frame_ms, p50, p99);
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "tick %.2f ms   avg %.2f ms", g_last_tick, tick_avg);
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "threads %d runnable, %d sleeping", is.runnable, is.sleeping);
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "blocks/tick %d", is.blocks);
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "draw calls %d   (from %d commands)", rs.draw_calls, rs.commands);
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "texture switches %d   targets %d", rs.texture_switches, rs.target_switches);
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "state changes %d", rs.state_changes);
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "texture memory %.1f MB", texture_memory(state) / (1024.0 * 1024.0));
+    draw_line(r, font, tx, ty, buf);
+    std::snprintf(buf, sizeof(buf), "composed %d calls, %d redrawn", g_last_compose_calls, g_last_recomposed);
+    draw_line(r, font, tx, ty, buf);
+}
@@ -0,0 +1,35 @@
+#ifndef PERF_OVERLAY_H
+#define PERF_OVERLAY_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "types.h"
+
+// ---> PERFORMANCE OVERLAY <---
+// F3, or PERF_OVERLAY=1 in .env, shows a panel in the top-right corner that
+// breaks a frame down by subsystem. It shows:
+//  - frame work time, as a histogram of recent frames with p50/p99;
+//  - interpreter step time, script threads and blocks per step;
+//  - render counters and texture memory. Every draw of the frame goes through
+//    the rq_ calls, recorded or passed straight to SDL, and is counted; only the
+//    SDL_RenderCopyEx draws (pen stamps, flipped paint tiles, the unbatched
+//    sprite fallback) and the final present are left out;
+//  - costume compositions.
+// The counters are kept whether or not the panel is shown.
+
+/* Reads PERF_OVERLAY; call after load_dotenv */
+void perf_overlay_init();
+void perf_overlay_toggle();
+bool perf_overlay_visible();
+
+/* Marks the start of a frame's work; call as soon as the event wait returns */
+void perf_frame_begin();
+/* Wall time of one interpreter_tick */
+void perf_note_tick(double ms);
+/* One update_composed_texture call; recomposed when it actually redrew the costume */
+void perf_note_compose(bool recomposed);
+
+/* Ends the frame's timing and, when visible, draws the panel; call right before redraw_end */
+void perf_overlay_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state);
+
+#endif
@@ -0,0 +1,166 @@
+#include "redraw.h"
+#include "config.h"
+#include "render_queue.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Upper bound on one idle sleep, so off-thread work (image imports) is still picked up
+static const Uint32 IDLE_WAIT_MS = 100;
+
+struct RedrawTimer
+{
+    Uint32 at;
+    SDL_Rect rect;
+};
+
+static SDL_Texture *g_back = nullptr;
+static SDL_Renderer *g_renderer = nullptr;
+static float g_scale = 1.0f;
+static SDL_Rect g_dirty = {0, 0, 0, 0};
+static bool g_have_dirty = false;
+static bool g_no_targets = false;
+static bool g_frame_on_back = false; // the frame in progress is drawn into g_back
+static std::vector<RedrawTimer> g_timers;
+
+static SDL_Rect window_rect() { return {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT}; }
+
+static bool same_rect(const SDL_Rect &a, const SDL_Rect &b) { return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h; }
+
+// (Re)creates the back buffer at the renderer's output resolution
+static bool ensure_back_buffer()
+{
+    if (!g_renderer || g_no_targets)
+        return false;
+    int ow = 0, oh = 0;
+    if (SDL_GetRendererOutputSize(g_renderer, &ow, &oh) != 0 || ow <= 0 || oh <= 0)
+        return false;
+    float scale = std::min((float)ow / WINDOW_WIDTH, (float)oh / WINDOW_HEIGHT);
+    int tw = (int)std::ceil(WINDOW_WIDTH * scale);
+    int th = (int)std::ceil(WINDOW_HEIGHT * scale);
+
+    int cw = 0, ch = 0;
+    if (g_back)
+        SDL_QueryTexture(g_back, NULL, NULL, &cw, &ch);
+    if (g_back && cw == tw && ch == th)
+        return true;
+    if (g_back)
+        SDL_DestroyTexture(g_back);
+    g_back = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, tw, th);
+    if (!g_back)
+    {
+        SDL_Log("Redraw: no back buffer, repainting whole frames: %s", SDL_GetError());
+        g_no_targets = true;
+        return false;
+    }
+    SDL_SetTextureBlendMode(g_back, SDL_BLENDMODE_NONE);
+    g_scale = scale;
+    redraw_invalidate(NULL);
+    return true;
+}
+
+bool redraw_init(SDL_Renderer *r)
+{
+    g_renderer = r;
+    g_no_targets = !SDL_RenderTargetSupported(r);
+    redraw_invalidate(NULL);
+    return ensure_back_buffer();
+}
+
+void redraw_quit()
+{
+    if (g_back)
+        SDL_DestroyTexture(g_back);
+    g_back = nullptr;
+    g_renderer = nullptr;
+    g_timers.clear();
+}
+
+void redraw_invalidate(const SDL_Rect *rect)
+{
+    SDL_Rect win = window_rect();
+    SDL_Rect r = win;
+    if (rect && !SDL_IntersectRect(rect, &win, &r))
+        return;
+    if (g_have_dirty)
+        SDL_UnionRect(&g_dirty, &r, &g_dirty);
+    else
+        g_dirty = r;
+    g_have_dirty = true;
+}
+
+void redraw_invalidate_at(const SDL_Rect *rect, Uint32 ticks)
+{
+    SDL_Rect r = rect ? *rect : window_rect();
+    for (const RedrawTimer &t : g_timers)
+        if (t.at == ticks && same_rect(t.rect, r))
+            return;
+    g_timers.push_back({ticks, r});
+}
+
+static void fire_timers()
+{
+    Uint32 now = SDL_GetTicks();
+    for (size_t i = 0; i < g_timers.size();)
+    {
+        if (SDL_TICKS_PASSED(now, g_timers[i].at))
+        {
+            redraw_invalidate(&g_timers[i].rect);
+            g_timers[i] = g_timers.back();
+            g_timers.pop_back();
+        }
+        else
+            i++;
+    }
+}
+
+bool redraw_wait_event(SDL_Event &e, bool busy, Uint32 busy_wait_ms)
+{
+    fire_timers();
+    if (g_have_dirty || (busy && busy_wait_ms == 0))
+        return SDL_PollEvent(&e) != 0;
+
+    Uint32 now = SDL_GetTicks();
+    Uint32 wait = busy ? busy_wait_ms : IDLE_WAIT_MS;
+    for (const RedrawTimer &t : g_timers)
+        wait = std::min(wait, t.at - now);
+    bool got = SDL_WaitEventTimeout(&e, (int)wait) != 0;
+    fire_timers();
+    return got;
+}
+
+bool redraw_begin(SDL_Renderer *r)
+{
+    fire_timers();
+    if (!g_have_dirty)
+        return false;
+    bool retained = ensure_back_buffer(); // may widen the dirty rect to the whole window
+    g_have_dirty = false;
+    g_frame_on_back = retained;
+    if (!retained)
+    {
+        // No retained buffer: the whole window is painted straight to the screen
+        rq_set_target(r, NULL);
+        return true;
+    }
+    rq_set_target(r, g_back);
+    SDL_RenderSetScale(r, g_scale, g_scale);
+    SDL_RenderSetClipRect(r, &g_dirty);
+    return true;
+}
+
+void redraw_end(SDL_Renderer *r)
+{
+    TRACE_ZONE("present");
+    if (g_frame_on_back)
+    {
+        SDL_RenderSetClipRect(r, NULL);
+        rq_set_target(r, NULL);
+        SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
+        SDL_RenderClear(r);
+        SDL_RenderCopy(r, g_back, NULL, NULL);
+    }
+    SDL_RenderPresent(r);
+    render_stats_end_frame();
+}
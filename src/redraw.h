@@ -0,0 +1,29 @@
+#ifndef REDRAW_H
+#define REDRAW_H
+
+#include "SDL.h"
+
+// ---> ON-DEMAND REDRAW <---
+// The window is painted into a retained back buffer. Whatever changes marks
+// its rect dirty; a frame repaints only the union of the dirty rects (the UI is
+// drawn with that as the clip) and presents the buffer. With nothing dirty and
+// nothing animating, the main loop sleeps in SDL_WaitEventTimeout instead.
+
+bool redraw_init(SDL_Renderer *r);
+void redraw_quit();
+
+/* Marks a logical-window rect for repaint; NULL means the whole window */
+void redraw_invalidate(const SDL_Rect *rect);
+/* Same, once SDL_GetTicks() reaches ticks (caret blinks, timed highlights) */
+void redraw_invalidate_at(const SDL_Rect *rect, Uint32 ticks);
+
+/* Next event: polls while dirty or busy (waiting up to busy_wait_ms if that is not 0),
+   otherwise waits until an event or the next timer */
+bool redraw_wait_event(SDL_Event &e, bool busy, Uint32 busy_wait_ms);
+
+/* Binds the back buffer clipped to the dirty area; false when there is nothing to paint */
+bool redraw_begin(SDL_Renderer *r);
+/* Copies the back buffer to the window and presents it */
+void redraw_end(SDL_Renderer *r);
+
+#endif
@@ -0,0 +1,685 @@
+#include "render_queue.h"
+#include "trace.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <unordered_set>
+#include <vector>
+
+static const int MERGE_LOOKBACK = 32; // same-layer batches searched for a compatible one
+
+enum BatchKind
+{
+    BATCH_CLEAR,
+    BATCH_GEOMETRY, // fills, copies and geometry, as indexed triangles
+    BATCH_LINES     // diagonal lines; axis-aligned ones become fills
+};
+
+/* Render state as the recorded code sees it */
+struct DrawState
+{
+    SDL_Texture *target;
+    float sx, sy;
+    bool clipped;
+    SDL_Rect clip;
+    SDL_Color color;
+    SDL_BlendMode blend;
+};
+
+struct Batch
+{
+    BatchKind kind;
+    int layer;
+    SDL_Texture *tex;
+    SDL_BlendMode blend; // the texture's for textured geometry, the draw blend otherwise
+    SDL_Color color;     // clears and lines
+    float sx, sy;
+    bool clipped;
+    SDL_Rect clip;
+    SDL_Rect bounds; // target pixels, already cut to the clip
+    std::vector<SDL_Vertex> verts;
+    std::vector<int> indices;
+    std::vector<SDL_Point> lines; // endpoint pairs
+};
+
+/* Everything recorded for one render target, in recording order */
+struct Pass
+{
+    SDL_Texture *target;
+    std::vector<int> batches;
+};
+
+static bool g_recording = false;
+static DrawState g_cur;
+static DrawState g_window; // what the window target gets back when a texture target is unbound
+static bool g_window_known = false;
+static SDL_Texture *g_frame_target = nullptr;
+static int g_layer = RQ_LAYER_BASE;
+static std::vector<Batch> g_batches; // pool; the first g_batch_count are in use
+static size_t g_batch_count = 0;
+static std::vector<Pass> g_passes;
+static int g_pass = -1;
+static std::unordered_set<SDL_Texture *> g_sampled; // textures read by recorded commands
+static SDL_Texture *g_direct_tex = nullptr; // last texture drawn outside a recording
+static RenderStats g_frame = {0, 0, 0, 0, 0};
+static RenderStats g_last = {0, 0, 0, 0, 0};
+
+static void read_state(SDL_Renderer *r, DrawState &s)
+{
+    s.target = SDL_GetRenderTarget(r);
+    SDL_RenderGetScale(r, &s.sx, &s.sy);
+    s.clipped = SDL_RenderIsClipEnabled(r);
+    SDL_RenderGetClipRect(r, &s.clip);
+    SDL_GetRenderDrawColor(r, &s.color.r, &s.color.g, &s.color.b, &s.color.a);
+    SDL_GetRenderDrawBlendMode(r, &s.blend);
+}
+
+static int find_pass(SDL_Texture *target)
+{
+    for (size_t i = 0; i < g_passes.size(); i++)
+        if (g_passes[i].target == target)
+            return (int)i;
+    return -1;
+}
+
+static int pass_for(SDL_Texture *target)
+{
+    int p = find_pass(target);
+    if (p >= 0)
+        return p;
+    g_passes.push_back({target, {}});
+    return (int)g_passes.size() - 1;
+}
+
+// Offscreen passes run in the order they were started, the frame's target last
+static int pass_rank(int p)
+{
+    return g_passes[p].target == g_frame_target ? (int)g_passes.size() : p;
+}
+
+// ---> SUBMIT <---
+static void apply_view(SDL_Renderer *r, const Batch &b, DrawState &sdl)
+{
+    if (b.sx != sdl.sx || b.sy != sdl.sy)
+    {
+        SDL_RenderSetScale(r, b.sx, b.sy);
+        sdl.sx = b.sx;
+        sdl.sy = b.sy;
+        g_frame.state_changes++;
+    }
+    if (b.clipped != sdl.clipped || (b.clipped && !SDL_RectEquals(&b.clip, &sdl.clip)))
+    {
+        SDL_RenderSetClipRect(r, b.clipped ? &b.clip : NULL);
+        sdl.clipped = b.clipped;
+        sdl.clip = b.clipped ? b.clip : SDL_Rect{0, 0, 0, 0};
+        g_frame.state_changes++;
+    }
+}
+
+static void apply_color(SDL_Renderer *r, SDL_Color c, DrawState &sdl)
+{
+    if (c.r == sdl.color.r && c.g == sdl.color.g && c.b == sdl.color.b && c.a == sdl.color.a)
+        return;
+    SDL_SetRenderDrawColor(r, c.r, c.g, c.b, c.a);
+    sdl.color = c;
+    g_frame.state_changes++;
+}
+
+static void apply_blend(SDL_Renderer *r, SDL_BlendMode mode, DrawState &sdl)
+{
+    if (mode == sdl.blend)
+        return;
+    SDL_SetRenderDrawBlendMode(r, mode);
+    sdl.blend = mode;
+    g_frame.state_changes++;
+}
+
+static void draw_batch(SDL_Renderer *r, const Batch &b, DrawState &sdl, SDL_Texture *&bound)
+{
+    apply_view(r, b, sdl);
+    switch (b.kind)
+    {
+    case BATCH_CLEAR:
+        apply_color(r, b.color, sdl);
+        SDL_RenderClear(r);
+        g_frame.draw_calls++;
+        break;
+    case BATCH_LINES:
+        apply_color(r, b.color, sdl);
+        apply_blend(r, b.blend, sdl);
+        for (size_t i = 0; i + 1 < b.lines.size(); i += 2)
+            SDL_RenderDrawLine(r, b.lines[i].x, b.lines[i].y, b.lines[i + 1].x, b.lines[i + 1].y);
+        g_frame.draw_calls += (int)b.lines.size() / 2;
+        break;
+    case BATCH_GEOMETRY:
+    {
+        // The texture's mode may have been changed since recording; put it back after
+        SDL_BlendMode tex_mode = b.blend;
+        if (b.tex)
+        {
+            SDL_GetTextureBlendMode(b.tex, &tex_mode);
+            if (tex_mode != b.blend)
+            {
+                SDL_SetTextureBlendMode(b.tex, b.blend);
+                g_frame.state_changes++;
+            }
+        }
+        else
+            apply_blend(r, b.blend, sdl);
+        if (b.tex != bound)
+        {
+            bound = b.tex;
+            g_frame.state_changes++;
+            if (b.tex)
+                g_frame.texture_switches++;
+        }
+        SDL_RenderGeometry(r, b.tex, b.verts.data(), (int)b.verts.size(), b.indices.data(), (int)b.indices.size());
+        g_frame.draw_calls++;
+        if (b.tex && tex_mode != b.blend)
+        {
+            SDL_SetTextureBlendMode(b.tex, tex_mode);
+            g_frame.state_changes++;
+        }
+        break;
+    }
+    }
+}
+
+static void run_passes(SDL_Renderer *r)
+{
+    DrawState sdl;
+    read_state(r, sdl);
+    SDL_Texture *bound = nullptr;
+
+    std::vector<int> order(g_passes.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = (int)i;
+    std::stable_sort(order.begin(), order.end(), [](int a, int b) { return pass_rank(a) < pass_rank(b); });
+    for (int p : order)
+    {
+        Pass &pass = g_passes[p];
+        if (pass.batches.empty())
+            continue;
+        if (pass.target != sdl.target)
+        {
+            // SDL resets scale and clip when the target changes
+            SDL_SetRenderTarget(r, pass.target);
+            g_frame.target_switches++;
+            read_state(r, sdl);
+        }
+        std::stable_sort(pass.batches.begin(), pass.batches.end(),
+                         [](int a, int b) { return g_batches[a].layer < g_batches[b].layer; });
+        for (int i : pass.batches)
+            draw_batch(r, g_batches[i], sdl, bound);
+    }
+
+    // Leave SDL where the recorded code thinks it is
+    if (sdl.target != g_cur.target)
+    {
+        SDL_SetRenderTarget(r, g_cur.target);
+        g_frame.target_switches++;
+        read_state(r, sdl);
+    }
+    Batch view;
+    view.sx = g_cur.sx;
+    view.sy = g_cur.sy;
+    view.clipped = g_cur.clipped;
+    view.clip = g_cur.clip;
+    apply_view(r, view, sdl);
+    apply_color(r, g_cur.color, sdl);
+    apply_blend(r, g_cur.blend, sdl);
+
+    g_passes.clear();
+    g_batch_count = 0;
+    g_sampled.clear();
+    g_pass = pass_for(g_cur.target);
+}
+
+void render_queue_begin(SDL_Renderer *r)
+{
+    if (!r || g_recording)
+        return;
+    read_state(r, g_cur);
+    g_window = g_cur;
+    g_window_known = g_cur.target == nullptr;
+    g_frame_target = g_cur.target;
+    g_layer = RQ_LAYER_BASE;
+    g_passes.clear();
+    g_batch_count = 0;
+    g_sampled.clear();
+    g_pass = pass_for(g_cur.target);
+    g_recording = true;
+}
+
+void render_queue_flush(SDL_Renderer *r)
+{
+    if (g_recording && r)
+        run_passes(r);
+}
+
+void render_queue_submit(SDL_Renderer *r)
+{
+    TRACE_ZONE("render_queue_submit");
+    render_queue_flush(r);
+    g_recording = false;
+}
+
+bool render_queue_recording()
+{
+    return g_recording;
+}
+
+void rq_set_layer(int layer)
+{
+    g_layer = layer;
+}
+
+// ---> RECORDING <---
+static SDL_Rect target_rect(SDL_Renderer *r)
+{
+    int w = 0, h = 0;
+    if (g_cur.target)
+        SDL_QueryTexture(g_cur.target, NULL, NULL, &w, &h);
+    else
+        SDL_GetRendererOutputSize(r, &w, &h);
+    return {0, 0, (int)std::ceil(w / g_cur.sx), (int)std::ceil(h / g_cur.sy)};
+}
+
+// Logical box to target pixels, cut to the clip; false when nothing would be drawn
+static bool to_pixels(float x0, float y0, float x1, float y1, SDL_Rect &out)
+{
+    int px0 = (int)std::floor(x0 * g_cur.sx), py0 = (int)std::floor(y0 * g_cur.sy);
+    int px1 = (int)std::ceil(x1 * g_cur.sx), py1 = (int)std::ceil(y1 * g_cur.sy);
+    out = {px0, py0, px1 - px0, py1 - py0};
+    if (!g_cur.clipped)
+        return out.w > 0 && out.h > 0;
+    const SDL_Rect &c = g_cur.clip;
+    int cx0 = (int)std::floor(c.x * g_cur.sx), cy0 = (int)std::floor(c.y * g_cur.sy);
+    SDL_Rect clip = {cx0, cy0, (int)std::ceil((c.x + c.w) * g_cur.sx) - cx0, (int)std::ceil((c.y + c.h) * g_cur.sy) - cy0};
+    return SDL_IntersectRect(&out, &clip, &out) == SDL_TRUE;
+}
+
+static bool compatible(const Batch &b, BatchKind kind, SDL_Texture *tex, SDL_BlendMode blend, SDL_Color color)
+{
+    if (b.kind != kind || b.tex != tex || b.blend != blend || b.sx != g_cur.sx || b.sy != g_cur.sy)
+        return false;
+    if (b.clipped != g_cur.clipped || (b.clipped && !SDL_RectEquals(&b.clip, &g_cur.clip)))
+        return false;
+    return kind != BATCH_LINES || (b.color.r == color.r && b.color.g == color.g && b.color.b == color.b && b.color.a == color.a);
+}
+
+// Joins the newest compatible batch of this layer that nothing drawn since overlaps, or starts one
+static Batch &record(BatchKind kind, SDL_Texture *tex, SDL_BlendMode blend, SDL_Color color, const SDL_Rect &bounds)
+{
+    std::vector<int> &list = g_passes[g_pass].batches;
+    int scanned = 0;
+    for (int i = (int)list.size() - 1; kind != BATCH_CLEAR && i >= 0 && scanned < MERGE_LOOKBACK; i--)
+    {
+        Batch &b = g_batches[list[i]];
+        if (b.layer != g_layer)
+            continue;
+        scanned++;
+        if (compatible(b, kind, tex, blend, color))
+        {
+            SDL_UnionRect(&b.bounds, &bounds, &b.bounds);
+            return b;
+        }
+        if (b.kind == BATCH_CLEAR || SDL_HasIntersection(&b.bounds, &bounds))
+            break;
+    }
+
+    if (g_batch_count == g_batches.size())
+        g_batches.emplace_back();
+    Batch &b = g_batches[g_batch_count];
+    list.push_back((int)g_batch_count++);
+    b.kind = kind;
+    b.layer = g_layer;
+    b.tex = tex;
+    b.blend = blend;
+    b.color = color;
+    b.sx = g_cur.sx;
+    b.sy = g_cur.sy;
+    b.clipped = g_cur.clipped;
+    b.clip = g_cur.clip;
+    b.bounds = bounds;
+    b.verts.clear();
+    b.indices.clear();
+    b.lines.clear();
+    return b;
+}
+
+static void push_quad(Batch &b, float x0, float y0, float x1, float y1, SDL_Color c, float u0, float v0, float u1, float v1)
+{
+    int base = (int)b.verts.size();
+    b.verts.push_back({{x0, y0}, c, {u0, v0}});
+    b.verts.push_back({{x1, y0}, c, {u1, v0}});
+    b.verts.push_back({{x1, y1}, c, {u1, v1}});
+    b.verts.push_back({{x0, y1}, c, {u0, v1}});
+    const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for (int k : quad)
+        b.indices.push_back(base + k);
+}
+
+static void record_fill(const SDL_Rect &rc)
+{
+    SDL_Rect px;
+    if (rc.w <= 0 || rc.h <= 0 || !to_pixels((float)rc.x, (float)rc.y, (float)(rc.x + rc.w), (float)(rc.y + rc.h), px))
+        return;
+    // An opaque colour comes out the same blended, so it can share a batch with the shape meshes
+    SDL_BlendMode mode = g_cur.blend;
+    if (mode == SDL_BLENDMODE_NONE && g_cur.color.a == 255)
+        mode = SDL_BLENDMODE_BLEND;
+    Batch &b = record(BATCH_GEOMETRY, nullptr, mode, g_cur.color, px);
+    push_quad(b, (float)rc.x, (float)rc.y, (float)(rc.x + rc.w), (float)(rc.y + rc.h), g_cur.color, 0, 0, 0, 0);
+}
+
+// A texture read here must not be drawn into later in the recording, nor drawn after this pass
+static void note_sampled(SDL_Renderer *r, SDL_Texture *tex)
+{
+    int p = find_pass(tex);
+    if (p >= 0 && pass_rank(p) > pass_rank(g_pass))
+        run_passes(r);
+    g_sampled.insert(tex);
+}
+
+// ---> STATE <---
+void rq_set_target(SDL_Renderer *r, SDL_Texture *target)
+{
+    if (!g_recording)
+    {
+        SDL_SetRenderTarget(r, target);
+        g_frame.target_switches++;
+        return;
+    }
+    if (target == g_cur.target)
+        return;
+    if (target && g_sampled.count(target))
+        run_passes(r);
+    if (!target && !g_window_known)
+    {
+        // The window's saved scale and clip are only known to SDL
+        run_passes(r);
+        SDL_SetRenderTarget(r, NULL);
+        g_frame.target_switches++;
+        read_state(r, g_cur);
+        g_pass = pass_for(NULL);
+        return;
+    }
+    if (!g_cur.target)
+    {
+        g_window = g_cur;
+        g_window_known = true;
+    }
+    SDL_Color color = g_cur.color;
+    SDL_BlendMode blend = g_cur.blend;
+    if (target)
+    {
+        g_cur.sx = g_cur.sy = 1.0f;
+        g_cur.clipped = false;
+        g_cur.clip = {0, 0, 0, 0};
+    }
+    else
+        g_cur = g_window;
+    g_cur.target = target;
+    g_cur.color = color;
+    g_cur.blend = blend;
+    g_pass = pass_for(target);
+}
+
+SDL_Texture *rq_get_target(SDL_Renderer *r)
+{
+    return g_recording ? g_cur.target : SDL_GetRenderTarget(r);
+}
+
+void rq_set_scale(SDL_Renderer *r, float sx, float sy)
+{
+    if (!g_recording)
+    {
+        SDL_RenderSetScale(r, sx, sy);
+        g_frame.state_changes++;
+        return;
+    }
+    g_cur.sx = sx;
+    g_cur.sy = sy;
+}
+
+void rq_get_scale(SDL_Renderer *r, float *sx, float *sy)
+{
+    if (!g_recording)
+    {
+        SDL_RenderGetScale(r, sx, sy);
+        return;
+    }
+    if (sx)
+        *sx = g_cur.sx;
+    if (sy)
+        *sy = g_cur.sy;
+}
+
+void rq_set_clip(SDL_Renderer *r, const SDL_Rect *clip)
+{
+    if (!g_recording)
+    {
+        SDL_RenderSetClipRect(r, clip);
+        g_frame.state_changes++;
+        return;
+    }
+    g_cur.clipped = clip != NULL;
+    g_cur.clip = clip ? *clip : SDL_Rect{0, 0, 0, 0};
+}
+
+bool rq_get_clip(SDL_Renderer *r, SDL_Rect *clip)
+{
+    if (!g_recording)
+    {
+        if (clip)
+            SDL_RenderGetClipRect(r, clip);
+        return SDL_RenderIsClipEnabled(r) == SDL_TRUE;
+    }
+    if (clip)
+        *clip = g_cur.clip;
+    return g_cur.clipped;
+}
+
+void rq_set_color(SDL_Renderer *r, Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha)
+{
+    if (!g_recording)
+    {
+        SDL_SetRenderDrawColor(r, red, green, blue, alpha);
+        g_frame.state_changes++;
+        return;
+    }
+    g_cur.color = {red, green, blue, alpha};
+}
+
+void rq_set_blend(SDL_Renderer *r, SDL_BlendMode mode)
+{
+    if (!g_recording)
+    {
+        SDL_SetRenderDrawBlendMode(r, mode);
+        g_frame.state_changes++;
+        return;
+    }
+    g_cur.blend = mode;
+}
+
+SDL_BlendMode rq_get_blend(SDL_Renderer *r)
+{
+    if (g_recording)
+        return g_cur.blend;
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+    SDL_GetRenderDrawBlendMode(r, &mode);
+    return mode;
+}
+
+// ---> DRAWING <---
+static void note_direct_texture(SDL_Texture *tex)
+{
+    if (!tex || tex == g_direct_tex)
+        return;
+    g_direct_tex = tex;
+    g_frame.texture_switches++;
+}
+
+void rq_clear(SDL_Renderer *r)
+{
+    g_frame.commands++;
+    if (!g_recording)
+    {
+        SDL_RenderClear(r);
+        g_frame.draw_calls++;
+        return;
+    }
+    // Clears ignore the clip, so nothing recorded before one moves past it
+    const int edge = 1 << 29;
+    record(BATCH_CLEAR, nullptr, SDL_BLENDMODE_NONE, g_cur.color, {-edge, -edge, 2 * edge, 2 * edge});
+}
+
+void rq_fill_rect(SDL_Renderer *r, const SDL_Rect *rect)
+{
+    g_frame.commands++;
+    if (!g_recording)
+    {
+        SDL_RenderFillRect(r, rect);
+        g_frame.draw_calls++;
+        return;
+    }
+    record_fill(rect ? *rect : target_rect(r));
+}
+
+void rq_draw_rect(SDL_Renderer *r, const SDL_Rect *rect)
+{
+    g_frame.commands++;
+    if (!g_recording)
+    {
+        SDL_RenderDrawRect(r, rect);
+        g_frame.draw_calls++;
+        return;
+    }
+    SDL_Rect rc = rect ? *rect : target_rect(r);
+    if (rc.w <= 0 || rc.h <= 0)
+        return;
+    // The same pixels as SDL's outline: full-width top and bottom rows, sides in between
+    record_fill({rc.x, rc.y, rc.w, 1});
+    if (rc.h > 1)
+        record_fill({rc.x, rc.y + rc.h - 1, rc.w, 1});
+    record_fill({rc.x, rc.y + 1, 1, rc.h - 2});
+    if (rc.w > 1)
+        record_fill({rc.x + rc.w - 1, rc.y + 1, 1, rc.h - 2});
+}
+
+void rq_draw_line(SDL_Renderer *r, int x1, int y1, int x2, int y2)
+{
+    g_frame.commands++;
+    if (!g_recording)
+    {
+        SDL_RenderDrawLine(r, x1, y1, x2, y2);
+        g_frame.draw_calls++;
+        return;
+    }
+    int x0 = std::min(x1, x2), y0 = std::min(y1, y2);
+    int w = std::abs(x2 - x1) + 1, h = std::abs(y2 - y1) + 1;
+    if (x1 == x2 || y1 == y2)
+    {
+        record_fill({x0, y0, w, h});
+        return;
+    }
+    SDL_Rect px;
+    if (!to_pixels((float)x0, (float)y0, (float)(x0 + w), (float)(y0 + h), px))
+        return;
+    Batch &b = record(BATCH_LINES, nullptr, g_cur.blend, g_cur.color, px);
+    b.lines.push_back({x1, y1});
+    b.lines.push_back({x2, y2});
+}
+
+void rq_copy(SDL_Renderer *r, SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *dst)
+{
+    g_frame.commands++;
+    if (!g_recording)
+    {
+        SDL_RenderCopy(r, tex, src, dst);
+        g_frame.draw_calls++;
+        note_direct_texture(tex);
+        return;
+    }
+    int tw = 0, th = 0;
+    if (!tex || SDL_QueryTexture(tex, NULL, NULL, &tw, &th) != 0 || tw <= 0 || th <= 0)
+        return;
+    SDL_Rect s = src ? *src : SDL_Rect{0, 0, tw, th};
+    SDL_Rect d = dst ? *dst : target_rect(r);
+    SDL_Rect px;
+    if (d.w <= 0 || d.h <= 0 || !to_pixels((float)d.x, (float)d.y, (float)(d.x + d.w), (float)(d.y + d.h), px))
+        return;
+    note_sampled(r, tex);
+
+    // RenderGeometry ignores the texture's colour and alpha mod; they go into the vertices
+    SDL_Color c = {255, 255, 255, 255};
+    SDL_GetTextureColorMod(tex, &c.r, &c.g, &c.b);
+    SDL_GetTextureAlphaMod(tex, &c.a);
+    SDL_BlendMode mode = SDL_BLENDMODE_NONE;
+    SDL_GetTextureBlendMode(tex, &mode);
+    Batch &b = record(BATCH_GEOMETRY, tex, mode, c, px);
+    push_quad(b, (float)d.x, (float)d.y, (float)(d.x + d.w), (float)(d.y + d.h), c,
+              (float)s.x / tw, (float)s.y / th, (float)(s.x + s.w) / tw, (float)(s.y + s.h) / th);
+}
+
+void rq_geometry(SDL_Renderer *r, SDL_Texture *tex, const SDL_Vertex *verts, int num_verts,
+                 const int *indices, int num_indices)
+{
+    g_frame.commands++;
+    if (!g_recording)
+    {
+        SDL_RenderGeometry(r, tex, verts, num_verts, indices, num_indices);
+        g_frame.draw_calls++;
+        note_direct_texture(tex);
+        return;
+    }
+    if (!verts || num_verts <= 0)
+        return;
+    float x0 = verts[0].position.x, y0 = verts[0].position.y, x1 = x0, y1 = y0;
+    for (int i = 1; i < num_verts; i++)
+    {
+        x0 = std::min(x0, verts[i].position.x);
+        y0 = std::min(y0, verts[i].position.y);
+        x1 = std::max(x1, verts[i].position.x);
+        y1 = std::max(y1, verts[i].position.y);
+    }
+    SDL_Rect px;
+    if (!to_pixels(x0, y0, x1, y1, px))
+        return;
+    SDL_BlendMode mode = g_cur.blend;
+    if (tex)
+    {
+        note_sampled(r, tex);
+        SDL_GetTextureBlendMode(tex, &mode);
+    }
+    Batch &b = record(BATCH_GEOMETRY, tex, mode, g_cur.color, px);
+    int base = (int)b.verts.size();
+    b.verts.insert(b.verts.end(), verts, verts + num_verts);
+    if (indices)
+        for (int i = 0; i < num_indices; i++)
+            b.indices.push_back(base + indices[i]);
+    else
+        for (int i = 0; i < num_verts; i++)
+            b.indices.push_back(base + i);
+}
+
+void rq_destroy_texture(SDL_Renderer *r, SDL_Texture *tex)
+{
+    if (!tex)
+        return;
+    if (g_recording && (g_sampled.count(tex) || find_pass(tex) >= 0))
+        run_passes(r);
+    SDL_DestroyTexture(tex);
+}
+
+const RenderStats &render_stats()
+{
+    return g_last;
+}
+
+void render_stats_end_frame()
+{
+    g_last = g_frame;
+    g_frame = {0, 0, 0, 0, 0};
+}
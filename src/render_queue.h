@@ -0,0 +1,68 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "SDL.h"
+
+// ---> RENDER COMMAND QUEUE <---
+// The rq_ calls mirror the SDL render calls the UI uses. Outside a recording they
+// go straight to SDL. Between render_queue_begin and render_queue_submit they are
+// recorded instead: fills and copies become vertex-coloured quads, and a command
+// joins an earlier batch with the same texture, blend, clip and scale whenever
+// nothing drawn in between overlaps it. At submit, offscreen targets are drawn
+// first, then the frame's target; each target's batches go out in layer order.
+// Code inside a recording must not draw to the frame's target through SDL directly.
+
+struct RenderStats
+{
+    int commands;         // rq_ draw calls made by the UI
+    int draw_calls;       // SDL draw calls they turned into
+    int state_changes;    // colour, blend, clip, scale and texture changes sent to SDL
+    int texture_switches; // draws with a different texture than the draw before
+    int target_switches;  // SDL_SetRenderTarget calls
+};
+
+/* Layers are drawn in increasing order within a target; each recording starts on RQ_LAYER_BASE */
+enum RenderLayer
+{
+    RQ_LAYER_BASE = 0,
+    RQ_LAYER_OVERLAY
+};
+
+void render_queue_begin(SDL_Renderer *r);
+/* Draws what has been recorded so far and keeps recording */
+void render_queue_flush(SDL_Renderer *r);
+/* Draws what has been recorded and stops recording; SDL is left in the recorded state */
+void render_queue_submit(SDL_Renderer *r);
+bool render_queue_recording();
+
+void rq_set_layer(int layer);
+
+void rq_set_target(SDL_Renderer *r, SDL_Texture *target);
+SDL_Texture *rq_get_target(SDL_Renderer *r);
+void rq_set_scale(SDL_Renderer *r, float sx, float sy);
+void rq_get_scale(SDL_Renderer *r, float *sx, float *sy);
+/* NULL turns clipping off */
+void rq_set_clip(SDL_Renderer *r, const SDL_Rect *clip);
+/* True when clipping is on; clip gets the rect (empty when off) */
+bool rq_get_clip(SDL_Renderer *r, SDL_Rect *clip);
+void rq_set_color(SDL_Renderer *r, Uint8 red, Uint8 green, Uint8 blue, Uint8 alpha);
+void rq_set_blend(SDL_Renderer *r, SDL_BlendMode mode);
+SDL_BlendMode rq_get_blend(SDL_Renderer *r);
+
+void rq_clear(SDL_Renderer *r);
+/* NULL fills the whole target */
+void rq_fill_rect(SDL_Renderer *r, const SDL_Rect *rect);
+void rq_draw_rect(SDL_Renderer *r, const SDL_Rect *rect);
+void rq_draw_line(SDL_Renderer *r, int x1, int y1, int x2, int y2);
+void rq_copy(SDL_Renderer *r, SDL_Texture *tex, const SDL_Rect *src, const SDL_Rect *dst);
+void rq_geometry(SDL_Renderer *r, SDL_Texture *tex, const SDL_Vertex *verts, int num_verts,
+                 const int *indices, int num_indices);
+/* Destroys a texture, first drawing any recorded command that uses it */
+void rq_destroy_texture(SDL_Renderer *r, SDL_Texture *tex);
+
+/* Counters of the last finished frame */
+const RenderStats &render_stats();
+/* Closes the frame's counters; called once per presented frame */
+void render_stats_end_frame();
+
+#endif
@@ -1,20 +1,19 @@
 #include "renderer.h"
+#include "geometry.h"
+#include "render_queue.h"
+#include "simd.h"
+#include "trace.h"
 #include "SDL_image.h"
 #include <cmath>
+#include <cstring>
 #include <algorithm>
+#include <vector>
 
 void renderer_fill_circle(SDL_Renderer *r, int cx, int cy, int radius,
                           int red, int green, int blue)
 {
-    SDL_SetRenderDrawColor(r, red, green, blue, 255);
-    for (int dy = -radius; dy <= radius; ++dy)
-    {
-        int dx = 0;
-        while (dx * dx + dy * dy <= radius * radius)
-            ++dx;
-        --dx;
-        SDL_RenderDrawLine(r, cx - dx, cy + dy, cx + dx, cy + dy);
-    }
+    rq_set_color(r, red, green, blue, 255);
+    geometry_fill_circle(r, cx, cy, radius, {(Uint8)red, (Uint8)green, (Uint8)blue, 255});
 }
 
 void renderer_draw_circle(SDL_Renderer *r, int cx, int cy, int radius,
@@ -48,51 +47,9 @@ void renderer_draw_circle(SDL_Renderer *r, int cx, int cy, int radius,
 void renderer_fill_rounded_rect(SDL_Renderer *r, const SDL_Rect *rect,
                                 int radius, int red, int green, int blue)
 {
-    SDL_SetRenderDrawColor(r, red, green, blue, 255);
-
-    /* center body */
-    SDL_Rect body;
-    body.x = rect->x + radius;
-    body.y = rect->y;
-    body.w = rect->w - 2 * radius;
-    body.h = rect->h;
-    SDL_RenderFillRect(r, &body);
-
-    /* left strip */
-    SDL_Rect left;
-    left.x = rect->x;
-    left.y = rect->y + radius;
-    left.w = radius;
-    left.h = rect->h - 2 * radius;
-    SDL_RenderFillRect(r, &left);
-
-    /* right strip */
-    SDL_Rect right;
-    right.x = rect->x + rect->w - radius;
-    right.y = rect->y + radius;
-    right.w = radius;
-    right.h = rect->h - 2 * radius;
-    SDL_RenderFillRect(r, &right);
-
-    /* four corners */
-    int corners[4][2] = {
-        {rect->x + radius, rect->y + radius},
-        {rect->x + rect->w - radius - 1, rect->y + radius},
-        {rect->x + radius, rect->y + rect->h - radius - 1},
-        {rect->x + rect->w - radius - 1, rect->y + rect->h - radius - 1}};
-    for (int c = 0; c < 4; ++c)
-    {
-        int ccx = corners[c][0];
-        int ccy = corners[c][1];
-        for (int dy = -radius; dy <= radius; ++dy)
-        {
-            int dx = 0;
-            while (dx * dx + dy * dy <= radius * radius)
-                ++dx;
-            --dx;
-            SDL_RenderDrawLine(r, ccx - dx, ccy + dy, ccx + dx, ccy + dy);
-        }
-    }
+    // Callers that go on to draw lines or rects expect this colour to be set
+    rq_set_color(r, red, green, blue, 255);
+    geometry_fill_rounded_rect(r, *rect, radius, {(Uint8)red, (Uint8)green, (Uint8)blue, 255});
 }
 
 SDL_Texture *renderer_load_texture(SDL_Renderer *r, const char *path)
@@ -116,7 +73,7 @@ void renderer_draw_texture(SDL_Renderer *r, SDL_Texture *tex, const SDL_Rect *ds
 {
     if (tex)
     {
-        SDL_RenderCopy(r, tex, NULL, dst);
+        rq_copy(r, tex, NULL, dst);
     }
 }
 
@@ -141,132 +98,575 @@ void renderer_draw_texture_fit(SDL_Renderer *r, SDL_Texture *tex, const SDL_Rect
     fit.y = dst->y + (dst->h - fh) / 2;
     fit.w = fw;
     fit.h = fh;
-    SDL_RenderCopy(r, tex, NULL, &fit);
+    rq_copy(r, tex, NULL, &fit);
+}
+
+// ---> COSTUME MIP CHAIN <---
+// The chain costs about a third of the composed texture on top of it (1/4 + 1/16 + ...):
+// ~3.7 MB per 1920x1440 costume. The full-size level stays, as it is the composition
+// target and the editor canvas draws from it; the levels buy filtered, cheaper sampling
+// at stage and thumbnail sizes, not memory. The performance overlay counts them.
+static const int MIP_LEVELS = 4;
+
+void renderer_build_mips(SDL_Renderer *r, GraphicItem &item)
+{
+    if (!r || !item.composed_texture)
+        return;
+
+    int w = 0, h = 0;
+    SDL_QueryTexture(item.composed_texture, NULL, NULL, &w, &h);
+
+    SDL_Texture *prev_target = SDL_GetRenderTarget(r);
+    SDL_Texture *src = item.composed_texture;
+    for (int level = 0; level < MIP_LEVELS; level++)
+    {
+        w /= 2;
+        h /= 2;
+        if (w < 1 || h < 1)
+            break;
+        if (level >= (int)item.mips.size())
+        {
+            SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+            SDL_Texture *mip = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+            SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+            if (!mip)
+                break;
+            SDL_SetTextureBlendMode(mip, SDL_BLENDMODE_BLEND);
+            item.mips.push_back(mip);
+        }
+
+        // An exact 2:1 linear-filtered copy samples between 4 texels: a 2x2 box filter
+        SDL_SetRenderTarget(r, item.mips[level]);
+        rq_set_color(r, 0, 0, 0, 0);
+        rq_clear(r);
+        SDL_BlendMode src_blend = SDL_BLENDMODE_BLEND;
+        SDL_GetTextureBlendMode(src, &src_blend);
+        SDL_SetTextureBlendMode(src, SDL_BLENDMODE_NONE);
+        rq_copy(r, src, NULL, NULL);
+        SDL_SetTextureBlendMode(src, src_blend);
+        src = item.mips[level];
+    }
+    SDL_SetRenderTarget(r, prev_target);
+}
+
+void renderer_destroy_mips(GraphicItem &item)
+{
+    for (SDL_Texture *mip : item.mips)
+        if (mip)
+            SDL_DestroyTexture(mip);
+    item.mips.clear();
+}
+
+SDL_Texture *renderer_pick_level(const GraphicItem &item, int w, int h)
+{
+    SDL_Texture *best = item.composed_texture ? item.composed_texture : item.texture;
+    if (!item.composed_texture)
+        return best;
+    for (SDL_Texture *mip : item.mips)
+    {
+        int mw = 0, mh = 0;
+        SDL_QueryTexture(mip, NULL, NULL, &mw, &mh);
+        if (mw < w || mh < h)
+            break;
+        best = mip;
+    }
+    return best;
 }
 
 // ---> PEN ENGINE IMPLEMENTATION (Using your exact math!) <---
+// The pen layer lives in a CPU RGBA8888 buffer (0xRRGGBBAA, straight alpha).
+// Strokes and stamps are rasterized straight into it and only the dirty
+// rectangle is uploaded to the streaming g_pen_layer, once per frame.
 SDL_Renderer *g_pen_renderer = nullptr;
 SDL_Texture *g_pen_layer = nullptr;
 SDL_Texture *g_stage_snapshot = nullptr;
 
+static const int PEN_W = 480;
+static const int PEN_H = 360;
+
+static std::vector<Uint32> g_pen_pixels;
+static SDL_Rect g_pen_dirty = {0, 0, 0, 0};
+static bool g_pen_has_dirty = false;
+
+static unsigned int g_pen_serial = 1; // new value whenever g_pen_pixels change
+
+// What g_stage_snapshot was last drawn from; drawn again when any of it differs
+struct SnapshotKey
+{
+    SDL_Texture *backdrop;
+    unsigned int backdrop_serial;
+    unsigned int pen_serial;
+};
+static SnapshotKey g_snapshot_key = {nullptr, 0, 0}; // pen_serial 0: never drawn
+static std::vector<Uint32> g_snapshot_pixels;
+static bool g_snapshot_pixels_valid = false;
+
+// Sprite pixels pre-scaled (and flipped) to stamp size, read back once per frame
+struct StampSource
+{
+    SDL_Texture *tex;
+    int w, h;
+    SDL_RendererFlip flip;
+    std::vector<Uint32> pixels;
+};
+static std::vector<StampSource> g_stamp_sources;
+
+// ---> PEN COMMAND BUFFER <---
+// Pen blocks only record what to draw. renderer_flush_pen_layer() replays the
+// list once per frame: a clear drops everything queued before it, touching
+// collinear segments of the same pen are merged into one stroke, and all
+// stamp sources for the frame are fetched in a single render-target pass.
+struct PenStamp
+{
+    SDL_Texture *tex;
+    SDL_RendererFlip flip;
+    int w, h;
+    int x, y, direction;
+};
+
+enum PenCmdType
+{
+    PEN_CMD_CLEAR,
+    PEN_CMD_LINE,
+    PEN_CMD_STAMP
+};
+
+struct PenCommand
+{
+    PenCmdType type;
+    float x0, y0, x1, y1;
+    float radius;
+    SDL_Color color;
+    PenStamp stamp;
+};
+static std::vector<PenCommand> g_pen_cmds;
+
+static const int STAMP_ATLAS_MAX = 2048;
+
+static void pen_mark_dirty(int x0, int y0, int x1, int y1)
+{
+    // inclusive-exclusive box, clipped to the layer
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, PEN_W);
+    y1 = std::min(y1, PEN_H);
+    if (x0 >= x1 || y0 >= y1)
+        return;
+    g_pen_serial++;
+    if (!g_pen_has_dirty)
+    {
+        g_pen_dirty = {x0, y0, x1 - x0, y1 - y0};
+        g_pen_has_dirty = true;
+        return;
+    }
+    int dx1 = std::max(g_pen_dirty.x + g_pen_dirty.w, x1);
+    int dy1 = std::max(g_pen_dirty.y + g_pen_dirty.h, y1);
+    g_pen_dirty.x = std::min(g_pen_dirty.x, x0);
+    g_pen_dirty.y = std::min(g_pen_dirty.y, y0);
+    g_pen_dirty.w = dx1 - g_pen_dirty.x;
+    g_pen_dirty.h = dy1 - g_pen_dirty.y;
+}
+
+// Source-over for straight alpha. sa is 0..255.
+static inline Uint32 pen_blend_over(Uint32 dst, int sr, int sg, int sb, int sa)
+{
+    if (sa >= 255)
+        return ((Uint32)sr << 24) | ((Uint32)sg << 16) | ((Uint32)sb << 8) | 0xFF;
+    if (sa <= 0)
+        return dst;
+    int da = dst & 0xFF;
+    int inv = 255 - sa;
+    int oa = sa + (da * inv + 127) / 255;
+    int dw = da * inv / 255; // dst weight, scaled so sa + dw ~= oa
+    int r = (sr * sa + (int)((dst >> 24) & 0xFF) * dw) / oa;
+    int g = (sg * sa + (int)((dst >> 16) & 0xFF) * dw) / oa;
+    int b = (sb * sa + (int)((dst >> 8) & 0xFF) * dw) / oa;
+    return ((Uint32)r << 24) | ((Uint32)g << 16) | ((Uint32)b << 8) | (Uint32)oa;
+}
+
+static inline void pen_fill_pixel(Uint32 &px, int cov, Uint32 solid, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    int sa = (cov * a + 127) / 255;
+    if (sa == 255)
+        px = solid;
+    else if (sa > 0)
+        px = pen_blend_over(px, r, g, b, sa);
+}
+
+#if SIMD_SSE2
+// Exact x / 255 for 16-bit lanes holding at most 255 * 255
+static inline __m128i div255_epu16(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+#elif SIMD_NEON
+static inline uint16x8_t div255_u16(uint16x8_t x)
+{
+    return vshrq_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)), vshrq_n_u16(x, 8)), 8);
+}
+#endif
+
+// Span filler: blends one color over n pixels using per-pixel coverage (0..255).
+// Fully covered pixels of an opaque color are plain stores. The vector path takes
+// four pixels at a time: empty and fully covered groups are skipped or stored, and
+// over an opaque destination the blend reduces to (src * sa + dst * (255 - sa)) / 255,
+// which matches pen_blend_over exactly. Groups over translucent pixels go scalar.
+static void pen_fill_span(Uint32 *row, const Uint8 *cov, int n, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    const Uint32 solid = ((Uint32)r << 24) | ((Uint32)g << 16) | ((Uint32)b << 8) | 0xFF;
+    int i = 0;
+#if SIMD_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i all255 = _mm_set1_epi16(255);
+    const __m128i alpha_mask = _mm_set1_epi32(0xFF);
+    const __m128i a16 = _mm_set1_epi16(a);
+    const __m128i src16 = _mm_set_epi16(r, g, b, 255, r, g, b, 255); // two pixels, A in the low byte
+    for (; i + 4 <= n; i += 4)
+    {
+        Uint32 c4;
+        std::memcpy(&c4, cov + i, 4);
+        // Lanes 0..3: (cov * a + 127) / 255 for the four pixels
+        __m128i sa = div255_epu16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)c4), zero), a16),
+                                                _mm_set1_epi16(127)));
+        if ((_mm_movemask_epi8(_mm_cmpeq_epi16(sa, zero)) & 0xFF) == 0xFF)
+            continue;
+        __m128i *p = (__m128i *)(row + i);
+        if ((_mm_movemask_epi8(_mm_cmpeq_epi16(sa, all255)) & 0xFF) == 0xFF)
+        {
+            _mm_storeu_si128(p, _mm_set1_epi32((int)solid));
+            continue;
+        }
+        __m128i d = _mm_loadu_si128(p);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(d, alpha_mask), alpha_mask)) != 0xFFFF)
+        {
+            for (int k = 0; k < 4; k++)
+                pen_fill_pixel(row[i + k], cov[i + k], solid, r, g, b, a);
+            continue;
+        }
+        __m128i s2 = _mm_unpacklo_epi16(sa, sa);
+        __m128i sa_lo = _mm_unpacklo_epi32(s2, s2), sa_hi = _mm_unpackhi_epi32(s2, s2);
+        __m128i d_lo = _mm_unpacklo_epi8(d, zero), d_hi = _mm_unpackhi_epi8(d, zero);
+        __m128i o_lo = div255_epu16(_mm_add_epi16(_mm_mullo_epi16(src16, sa_lo), _mm_mullo_epi16(d_lo, _mm_sub_epi16(all255, sa_lo))));
+        __m128i o_hi = div255_epu16(_mm_add_epi16(_mm_mullo_epi16(src16, sa_hi), _mm_mullo_epi16(d_hi, _mm_sub_epi16(all255, sa_hi))));
+        _mm_storeu_si128(p, _mm_packus_epi16(o_lo, o_hi));
+    }
+#elif SIMD_NEON
+    static const uint8_t spread[16] = {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3};
+    const uint8x16_t spread_idx = vld1q_u8(spread);
+    const uint8x16_t src8 = vreinterpretq_u8_u32(vdupq_n_u32(solid));
+    const uint32x4_t alpha_mask = vdupq_n_u32(0xFF);
+    for (; i + 4 <= n; i += 4)
+    {
+        Uint32 c4;
+        std::memcpy(&c4, cov + i, 4);
+        uint16x8_t x = vaddq_u16(vmull_u8(vcreate_u8(c4), vdup_n_u8(a)), vdupq_n_u16(127));
+        uint8x8_t sa8 = vmovn_u16(div255_u16(x)); // lanes 0..3
+        Uint32 sa4 = vget_lane_u32(vreinterpret_u32_u8(sa8), 0);
+        if (sa4 == 0)
+            continue;
+        uint8_t *p = (uint8_t *)(row + i);
+        if (sa4 == 0xFFFFFFFFu)
+        {
+            vst1q_u8(p, src8);
+            continue;
+        }
+        uint8x16_t d = vld1q_u8(p);
+        if (vminvq_u32(vceqq_u32(vandq_u32(vreinterpretq_u32_u8(d), alpha_mask), alpha_mask)) == 0)
+        {
+            for (int k = 0; k < 4; k++)
+                pen_fill_pixel(row[i + k], cov[i + k], solid, r, g, b, a);
+            continue;
+        }
+        uint8x16_t sa = vqtbl1q_u8(vcombine_u8(sa8, sa8), spread_idx);
+        uint8x16_t inv = vsubq_u8(vdupq_n_u8(255), sa);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(src8), vget_low_u8(sa)), vget_low_u8(d), vget_low_u8(inv));
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(src8), vget_high_u8(sa)), vget_high_u8(d), vget_high_u8(inv));
+        vst1q_u8(p, vcombine_u8(vmovn_u16(div255_u16(lo)), vmovn_u16(div255_u16(hi))));
+    }
+#endif
+    for (; i < n; i++)
+        pen_fill_pixel(row[i], cov[i], solid, r, g, b, a);
+}
+
+// Anti-aliased capsule (thick line with round caps) from (x0,y0) to (x1,y1).
+// Each row is clipped analytically to the capsule, then coverage is computed
+// from the distance to the segment and handed to the span filler.
+static void pen_draw_capsule(float x0, float y0, float x1, float y1, float radius, SDL_Color color)
+{
+    if (g_pen_pixels.empty())
+        return;
+
+    const float reach = radius + 0.5f; // where coverage falls to 0
+    int bx0 = (int)std::floor(std::min(x0, x1) - reach);
+    int by0 = (int)std::floor(std::min(y0, y1) - reach);
+    int bx1 = (int)std::ceil(std::max(x0, x1) + reach) + 1;
+    int by1 = (int)std::ceil(std::max(y0, y1) + reach) + 1;
+    by0 = std::max(by0, 0);
+    by1 = std::min(by1, PEN_H);
+    bx0 = std::max(bx0, 0);
+    bx1 = std::min(bx1, PEN_W);
+    if (bx0 >= bx1 || by0 >= by1)
+        return;
+
+    const float dx = x1 - x0;
+    const float dy = y1 - y0;
+    const float len2 = dx * dx + dy * dy;
+    const float len = std::sqrt(len2);
+
+    static std::vector<Uint8> cov;
+    cov.resize(PEN_W);
+
+    for (int py = by0; py < by1; py++)
+    {
+        float fy = py + 0.5f;
+
+        // x-extent of this row inside the (slightly grown) capsule
+        float lo = 1e9f, hi = -1e9f;
+        float ry0 = fy - y0;
+        float ry1 = fy - y1;
+        if (std::fabs(ry0) <= reach)
+        {
+            float h = std::sqrt(reach * reach - ry0 * ry0);
+            lo = std::min(lo, x0 - h);
+            hi = std::max(hi, x0 + h);
+        }
+        if (std::fabs(ry1) <= reach)
+        {
+            float h = std::sqrt(reach * reach - ry1 * ry1);
+            lo = std::min(lo, x1 - h);
+            hi = std::max(hi, x1 + h);
+        }
+        if (len > 0.0001f)
+        {
+            // band: 0 <= u <= len2 and |v| <= reach*len, both linear in x
+            float blo = -1e9f, bhi = 1e9f;
+            float u0 = -x0 * dx + ry0 * dy; // u = x*dx + u0
+            float v0 = -x0 * dy - ry0 * dx; // v = x*dy + v0
+            if (std::fabs(dx) > 0.0001f)
+            {
+                float a1 = (0.0f - u0) / dx, a2 = (len2 - u0) / dx;
+                blo = std::max(blo, std::min(a1, a2));
+                bhi = std::min(bhi, std::max(a1, a2));
+            }
+            else if (u0 < 0.0f || u0 > len2)
+                bhi = blo - 1.0f;
+            if (std::fabs(dy) > 0.0001f)
+            {
+                float a1 = (-reach * len - v0) / dy, a2 = (reach * len - v0) / dy;
+                blo = std::max(blo, std::min(a1, a2));
+                bhi = std::min(bhi, std::max(a1, a2));
+            }
+            else if (std::fabs(v0) > reach * len)
+                bhi = blo - 1.0f;
+            if (blo <= bhi)
+            {
+                lo = std::min(lo, blo);
+                hi = std::max(hi, bhi);
+            }
+        }
+        if (lo > hi)
+            continue;
+
+        int sx0 = std::max(bx0, (int)std::floor(lo));
+        int sx1 = std::min(bx1, (int)std::ceil(hi) + 1);
+        if (sx0 >= sx1)
+            continue;
+
+        for (int px = sx0; px < sx1; px++)
+        {
+            float fx = px + 0.5f;
+            float t = 0.0f;
+            if (len2 > 0.0f)
+                t = std::min(1.0f, std::max(0.0f, ((fx - x0) * dx + (fy - y0) * dy) / len2));
+            float ex = fx - (x0 + t * dx);
+            float ey = fy - (y0 + t * dy);
+            float c = reach - std::sqrt(ex * ex + ey * ey);
+            c = std::min(1.0f, std::max(0.0f, c));
+            cov[px - sx0] = (Uint8)(c * 255.0f + 0.5f);
+        }
+        pen_fill_span(&g_pen_pixels[py * PEN_W + sx0], cov.data(), sx1 - sx0, color.r, color.g, color.b, color.a);
+    }
+    pen_mark_dirty(bx0, by0, bx1, by1);
+}
+
 void renderer_init_pen_layer(SDL_Renderer *r)
 {
-    g_pen_renderer = r;
+    if (r)
+        g_pen_renderer = r;
     if (g_pen_layer)
         SDL_DestroyTexture(g_pen_layer);
     if (g_stage_snapshot)
         SDL_DestroyTexture(g_stage_snapshot);
+    g_pen_layer = nullptr;
+    g_stage_snapshot = nullptr;
+    g_stamp_sources.clear();
+    g_pen_cmds.clear();
+    g_snapshot_key = {nullptr, 0, 0};
+    g_snapshot_pixels_valid = false;
+
+    g_pen_pixels.assign(PEN_W * PEN_H, 0);
+    if (!g_pen_renderer)
+        return;
 
-    g_pen_layer = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, 480, 360);
+    g_pen_layer = SDL_CreateTexture(g_pen_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, PEN_W, PEN_H);
     SDL_SetTextureBlendMode(g_pen_layer, SDL_BLENDMODE_BLEND);
 
     // Stage snapshot for color sensing - use ARGB8888 (native GPU format on most platforms)
-    g_stage_snapshot = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, 480, 360);
+    g_stage_snapshot = SDL_CreateTexture(g_pen_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, PEN_W, PEN_H);
     SDL_SetTextureBlendMode(g_stage_snapshot, SDL_BLENDMODE_BLEND);
 
     renderer_clear_pen_layer();
+    renderer_flush_pen_layer();
 }
 
-// Called after stage_draw to capture backdrop+pen pixels for color sensing
-void renderer_update_stage_snapshot(SDL_Renderer *r, SDL_Texture *backdrop_tex, const SDL_Rect &stage_area)
+// The snapshot is drawn from the backdrop and the pen layer as sensing asks for it,
+// not from the stage panel, so it is current even when the panel is not repainted,
+// the offscreen stage is unavailable, or several steps run in one frame.
+static void draw_stage_snapshot(SDL_Texture *backdrop)
 {
-    if (!g_stage_snapshot || !r) return;
-
+    TRACE_ZONE("draw stage snapshot");
+    SDL_Renderer *r = g_pen_renderer;
     SDL_Texture *prev_target = SDL_GetRenderTarget(r);
+    float sx = 1.0f, sy = 1.0f;
+    SDL_RenderGetScale(r, &sx, &sy);
+
+    // White under the backdrop, as the stage draws it
     SDL_SetRenderTarget(r, g_stage_snapshot);
+    SDL_RenderSetScale(r, 1.0f, 1.0f);
+    rq_set_color(r, 255, 255, 255, 255);
+    rq_fill_rect(r, NULL);
+    if (backdrop)
+        rq_copy(r, backdrop, NULL, NULL);
+    if (g_pen_layer)
+        rq_copy(r, g_pen_layer, NULL, NULL);
+
+    SDL_SetRenderTarget(r, prev_target);
+    SDL_RenderSetScale(r, sx, sy);
+    g_snapshot_pixels_valid = false;
+}
 
-    // Fill white (default backdrop)
-    SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-    SDL_RenderClear(r);
+const Uint32 *renderer_stage_snapshot_pixels(const GraphicItem *backdrop)
+{
+    if (!g_stage_snapshot || !g_pen_renderer)
+        return nullptr;
+    // Strokes and stamps of earlier steps in this frame are still queued
+    renderer_flush_pen_layer();
 
-    // Draw backdrop stretched to 480x360
-    if (backdrop_tex)
+    SnapshotKey key = {nullptr, 0, g_pen_serial};
+    if (backdrop)
     {
-        SDL_Rect dest = {0, 0, 480, 360};
-        SDL_RenderCopy(r, backdrop_tex, NULL, &dest);
+        key.backdrop = backdrop->texture;
+        if (key.backdrop && key.backdrop == backdrop->composed_texture)
+            key.backdrop = renderer_pick_level(*backdrop, PEN_W, PEN_H);
+        key.backdrop_serial = backdrop->composed_serial;
     }
-
-    // Draw pen layer on top
-    if (g_pen_layer)
+    if (key.backdrop != g_snapshot_key.backdrop || key.backdrop_serial != g_snapshot_key.backdrop_serial ||
+        key.pen_serial != g_snapshot_key.pen_serial)
     {
-        SDL_Rect dest = {0, 0, 480, 360};
-        SDL_RenderCopy(r, g_pen_layer, NULL, &dest);
+        draw_stage_snapshot(key.backdrop);
+        g_snapshot_key = key;
     }
 
-    SDL_SetRenderTarget(r, prev_target);
+    if (!g_snapshot_pixels_valid)
+    {
+        TRACE_ZONE("snapshot readback");
+        g_snapshot_pixels.resize(PEN_W * PEN_H);
+        SDL_Texture *prev_target = SDL_GetRenderTarget(g_pen_renderer);
+        SDL_SetRenderTarget(g_pen_renderer, g_stage_snapshot);
+        SDL_RenderReadPixels(g_pen_renderer, NULL, SDL_PIXELFORMAT_RGBA8888, g_snapshot_pixels.data(), PEN_W * 4);
+        SDL_SetRenderTarget(g_pen_renderer, prev_target);
+        g_snapshot_pixels_valid = true;
+    }
+    return g_snapshot_pixels.data();
 }
 
-void renderer_clear_pen_layer()
+static void pen_clear_pixels()
 {
-    if (!g_pen_layer || !g_pen_renderer)
+    if (g_pen_pixels.empty())
         return;
+    std::fill(g_pen_pixels.begin(), g_pen_pixels.end(), 0u); // Transparent Background
+    pen_mark_dirty(0, 0, PEN_W, PEN_H);
+}
 
-    SDL_Texture *prev_target = SDL_GetRenderTarget(g_pen_renderer);
-    SDL_SetRenderTarget(g_pen_renderer, g_pen_layer);
-    SDL_SetRenderDrawColor(g_pen_renderer, 0, 0, 0, 0); // Transparent Background
-    SDL_RenderClear(g_pen_renderer);
-    SDL_SetRenderTarget(g_pen_renderer, prev_target); // Safely restore
+void renderer_clear_pen_layer()
+{
+    // Nothing queued before a clear can ever be visible
+    g_pen_cmds.clear();
+    PenCommand cmd = {};
+    cmd.type = PEN_CMD_CLEAR;
+    g_pen_cmds.push_back(cmd);
 }
 
 void renderer_draw_line_on_pen_layer(int x1, int y1, int x2, int y2, int size, SDL_Color color)
 {
-    if (!g_pen_layer || !g_pen_renderer)
-        return;
-
-    SDL_Texture *prev_target = SDL_GetRenderTarget(g_pen_renderer);
-    SDL_SetRenderTarget(g_pen_renderer, g_pen_layer);
-
-    // Convert Scratch coordinates to Window screen coordinates
-    int screen_x1 = x1 + 240;
-    int screen_y1 = 180 - y1;
-    int screen_x2 = x2 + 240;
-    int screen_y2 = 180 - y2;
-
-    int dx = screen_x2 - screen_x1;
-    int dy = screen_y2 - screen_y1;
-    int steps = std::max(abs(dx), abs(dy));
-
-    // Draw thick interpolated line
-    if (steps == 0)
-    {
-        renderer_fill_circle(g_pen_renderer, screen_x1, screen_y1, size, color.r, color.g, color.b);
-    }
-    else
+    // Convert Scratch coordinates to pen layer pixel centers
+    float sx1 = x1 + 240 + 0.5f;
+    float sy1 = 180 - y1 + 0.5f;
+    float sx2 = x2 + 240 + 0.5f;
+    float sy2 = 180 - y2 + 0.5f;
+    // Same footprint as the old circle-per-step stroke (radius == size)
+    float radius = (float)size;
+
+    if (!g_pen_cmds.empty())
     {
-        float x_inc = dx / (float)steps;
-        float y_inc = dy / (float)steps;
-        float cx = screen_x1;
-        float cy = screen_y1;
-        for (int i = 0; i <= steps; i++)
+        PenCommand &last = g_pen_cmds.back();
+        if (last.type == PEN_CMD_LINE && last.radius == radius &&
+            last.color.r == color.r && last.color.g == color.g && last.color.b == color.b && last.color.a == color.a &&
+            last.x1 == sx1 && last.y1 == sy1)
         {
-            renderer_fill_circle(g_pen_renderer, (int)cx, (int)cy, size, color.r, color.g, color.b);
-            cx += x_inc;
-            cy += y_inc;
+            float ax = last.x1 - last.x0, ay = last.y1 - last.y0;
+            float bx = sx2 - sx1, by = sy2 - sy1;
+            // Continues in the same direction (or either part is a dot): one capsule covers both
+            if (ax * by - ay * bx == 0.0f && ax * bx + ay * by >= 0.0f)
+            {
+                if (ax == 0.0f && ay == 0.0f)
+                {
+                    last.x0 = sx1;
+                    last.y0 = sy1;
+                }
+                last.x1 = sx2;
+                last.y1 = sy2;
+                return;
+            }
         }
     }
-    SDL_SetRenderTarget(g_pen_renderer, prev_target);
+
+    PenCommand cmd = {};
+    cmd.type = PEN_CMD_LINE;
+    cmd.x0 = sx1;
+    cmd.y0 = sy1;
+    cmd.x1 = sx2;
+    cmd.y1 = sy2;
+    cmd.radius = radius;
+    cmd.color = color;
+    g_pen_cmds.push_back(cmd);
 }
 
-void renderer_stamp_on_pen_layer(const Sprite &spr)
+// ---> SPRITE RASTER (shared by stamp and color sensing) <---
+static SDL_Texture *pen_sprite_texture(const Sprite &spr, SDL_RendererFlip &flip)
 {
     // B11 FIX: prefer composed_texture (has paint strokes) over raw texture
     SDL_Texture *draw_tex = nullptr;
+    flip = SDL_FLIP_NONE;
     if (!spr.costumes.empty() && spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size())
     {
         const auto &cost = spr.costumes[spr.selected_costume];
         draw_tex = cost.composed_texture ? cost.composed_texture : cost.texture;
+        if (cost.flip_h) flip = (SDL_RendererFlip)(flip | SDL_FLIP_HORIZONTAL);
+        if (cost.flip_v) flip = (SDL_RendererFlip)(flip | SDL_FLIP_VERTICAL);
     }
     if (!draw_tex) draw_tex = spr.texture;
-    if (!g_pen_layer || !g_pen_renderer || !draw_tex)
-        return;
-        
-    SDL_Texture *prev_target = SDL_GetRenderTarget(g_pen_renderer);
-    SDL_SetRenderTarget(g_pen_renderer, g_pen_layer);
+    return draw_tex;
+}
+
+static bool pen_stamp_params(const Sprite &spr, PenStamp &st)
+{
+    st.tex = pen_sprite_texture(spr, st.flip);
+    if (!st.tex)
+        return false;
 
-    int cx = 240 + spr.x;
-    int cy = 180 - spr.y;
     int tex_w = 100, tex_h = 100;
-    SDL_QueryTexture(draw_tex, NULL, NULL, &tex_w, &tex_h);
+    SDL_QueryTexture(st.tex, NULL, NULL, &tex_w, &tex_h);
 
     // YOUR EXACT MATH
     int base_w = tex_w, base_h = tex_h;
@@ -284,28 +684,242 @@ void renderer_stamp_on_pen_layer(const Sprite &spr)
             base_h = MAX_DEFAULT;
         }
     }
-    int w = (base_w * spr.size) / 100;
-    int h = (base_h * spr.size) / 100;
-    SDL_Rect dest = {cx - w / 2, cy - h / 2, w, h};
-
-    double angle = spr.direction - 90.0;
-    
-    // 1. Check Flips
-    SDL_RendererFlip flip = SDL_FLIP_NONE;
-    if (!spr.costumes.empty() && spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size()) {
-        if (spr.costumes[spr.selected_costume].flip_h) flip = (SDL_RendererFlip)(flip | SDL_FLIP_HORIZONTAL);
-        if (spr.costumes[spr.selected_costume].flip_v) flip = (SDL_RendererFlip)(flip | SDL_FLIP_VERTICAL);
+    st.w = (base_w * spr.size) / 100;
+    st.h = (base_h * spr.size) / 100;
+
+    // Sample from the mip level nearest the stamp size
+    if (!spr.costumes.empty() && spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size())
+    {
+        const auto &cost = spr.costumes[spr.selected_costume];
+        if (cost.composed_texture && st.tex == cost.composed_texture)
+            st.tex = renderer_pick_level(cost, st.w, st.h);
+    }
+    st.x = spr.x;
+    st.y = spr.y;
+    st.direction = spr.direction;
+    return st.w > 0 && st.h > 0;
+}
+
+static const StampSource *pen_find_source(const PenStamp &st)
+{
+    for (const auto &src : g_stamp_sources)
+        if (src.tex == st.tex && src.w == st.w && src.h == st.h && src.flip == st.flip)
+            return &src;
+    return nullptr;
+}
+
+// Scales/flips every stamp in `wanted` into one shelf-packed target and reads
+// it back with a single SDL_RenderReadPixels. Oversized stamps get their own pass.
+static void pen_load_stamp_sources(const std::vector<PenStamp> &wanted)
+{
+    if (!g_pen_renderer)
+        return;
+
+    std::vector<PenStamp> missing;
+    for (const auto &st : wanted)
+    {
+        if (pen_find_source(st))
+            continue;
+        bool dup = false;
+        for (const auto &m : missing)
+            if (m.tex == st.tex && m.w == st.w && m.h == st.h && m.flip == st.flip)
+                dup = true;
+        if (!dup)
+            missing.push_back(st);
     }
 
-    // 2. Safely apply Blend Mode so backgrounds stay transparent!
-    SDL_BlendMode oldMode;
-    SDL_GetTextureBlendMode(draw_tex, &oldMode);
-    SDL_SetTextureBlendMode(draw_tex, SDL_BLENDMODE_BLEND);
-
-    // 3. Draw!
-    SDL_RenderCopyEx(g_pen_renderer, draw_tex, NULL, &dest, angle, NULL, flip);
-    
-    // 4. Safely restore
-    SDL_SetTextureBlendMode(draw_tex, oldMode);
-    SDL_SetRenderTarget(g_pen_renderer, prev_target);
-}
\ No newline at end of file
+    size_t next = 0;
+    while (next < missing.size())
+    {
+        // Shelf-pack as many as fit
+        std::vector<SDL_Rect> slots;
+        int cur_x = 0, cur_y = 0, shelf_h = 0, atlas_w = 0;
+        size_t end = next;
+        for (; end < missing.size(); end++)
+        {
+            int w = missing[end].w, h = missing[end].h;
+            if (w > STAMP_ATLAS_MAX || h > STAMP_ATLAS_MAX)
+            {
+                if (end == next)
+                {
+                    slots.push_back({0, 0, w, h});
+                    atlas_w = w;
+                    cur_y = 0;
+                    shelf_h = h;
+                    end++;
+                }
+                break;
+            }
+            if (cur_x + w > STAMP_ATLAS_MAX)
+            {
+                cur_x = 0;
+                cur_y += shelf_h;
+                shelf_h = 0;
+            }
+            if (cur_y + h > STAMP_ATLAS_MAX)
+                break;
+            slots.push_back({cur_x, cur_y, w, h});
+            cur_x += w;
+            shelf_h = std::max(shelf_h, h);
+            atlas_w = std::max(atlas_w, cur_x);
+        }
+        int atlas_h = cur_y + shelf_h;
+
+        SDL_Texture *tmp = SDL_CreateTexture(g_pen_renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, atlas_w, atlas_h);
+        if (!tmp)
+        {
+            SDL_Log("Stamp atlas (%dx%d) failed: %s", atlas_w, atlas_h, SDL_GetError());
+            return;
+        }
+
+        SDL_Texture *prev_target = SDL_GetRenderTarget(g_pen_renderer);
+        SDL_SetRenderTarget(g_pen_renderer, tmp);
+        rq_set_color(g_pen_renderer, 0, 0, 0, 0);
+        rq_clear(g_pen_renderer);
+        for (size_t i = next; i < end; i++)
+        {
+            // Copy straight alpha through unchanged so the CPU blend sees real edges
+            const PenStamp &st = missing[i];
+            SDL_BlendMode oldMode;
+            SDL_GetTextureBlendMode(st.tex, &oldMode);
+            SDL_SetTextureBlendMode(st.tex, SDL_BLENDMODE_NONE);
+            SDL_RenderCopyEx(g_pen_renderer, st.tex, NULL, &slots[i - next], 0.0, NULL, st.flip);
+            SDL_SetTextureBlendMode(st.tex, oldMode);
+        }
+        std::vector<Uint32> atlas(atlas_w * atlas_h, 0);
+        SDL_RenderReadPixels(g_pen_renderer, NULL, SDL_PIXELFORMAT_RGBA8888, atlas.data(), atlas_w * 4);
+        SDL_SetRenderTarget(g_pen_renderer, prev_target);
+        SDL_DestroyTexture(tmp);
+
+        for (size_t i = next; i < end; i++)
+        {
+            const PenStamp &st = missing[i];
+            const SDL_Rect &slot = slots[i - next];
+            StampSource src = {st.tex, st.w, st.h, st.flip, std::vector<Uint32>(st.w * st.h)};
+            for (int row = 0; row < st.h; row++)
+                std::copy(&atlas[(slot.y + row) * atlas_w + slot.x], &atlas[(slot.y + row) * atlas_w + slot.x] + st.w, &src.pixels[row * st.w]);
+            g_stamp_sources.push_back(std::move(src));
+        }
+        next = end;
+    }
+}
+
+// Rotated bounding box of the stamp in pen-layer coords (unclipped)
+static void pen_stamp_bounds(const PenStamp &st, float &cx, float &cy, SDL_Rect &box)
+{
+    cx = (240 + st.x) - st.w / 2 + st.w * 0.5f;
+    cy = (180 - st.y) - st.h / 2 + st.h * 0.5f;
+    double rad = (st.direction - 90.0) * M_PI / 180.0;
+    float ex = (float)(std::fabs(st.w * std::cos(rad)) + std::fabs(st.h * std::sin(rad))) * 0.5f;
+    float ey = (float)(std::fabs(st.w * std::sin(rad)) + std::fabs(st.h * std::cos(rad))) * 0.5f;
+    box.x = (int)std::floor(cx - ex);
+    box.y = (int)std::floor(cy - ey);
+    box.w = (int)std::ceil(cx + ex) - box.x;
+    box.h = (int)std::ceil(cy + ey) - box.y;
+}
+
+// Draws the stamp (size, rotation, flips) over buf, whose pixel (0,0) is
+// pen-layer pixel (area.x, area.y). Matches SDL_RenderCopyEx's clockwise rotation.
+// Returns the touched box in pen-layer coords.
+static bool pen_raster_stamp(const PenStamp &st, Uint32 *buf, const SDL_Rect &area, SDL_Rect &touched)
+{
+    const StampSource *src = pen_find_source(st);
+    if (!src)
+        return false;
+
+    float cx, cy;
+    SDL_Rect box;
+    pen_stamp_bounds(st, cx, cy, box);
+    if (!SDL_IntersectRect(&box, &area, &touched))
+        return false;
+
+    double rad = (st.direction - 90.0) * M_PI / 180.0;
+    float cs = (float)std::cos(rad), sn = (float)std::sin(rad);
+    for (int py = touched.y; py < touched.y + touched.h; py++)
+    {
+        Uint32 *row = buf + (py - area.y) * area.w;
+        float ry = py + 0.5f - cy;
+        for (int px = touched.x; px < touched.x + touched.w; px++)
+        {
+            float rx = px + 0.5f - cx;
+            int sx = (int)std::floor(rx * cs + ry * sn + st.w * 0.5f);
+            int sy = (int)std::floor(-rx * sn + ry * cs + st.h * 0.5f);
+            if (sx < 0 || sy < 0 || sx >= st.w || sy >= st.h)
+                continue;
+            Uint32 sp = src->pixels[sy * st.w + sx];
+            Uint32 &d = row[px - area.x];
+            d = pen_blend_over(d, (sp >> 24) & 0xFF, (sp >> 16) & 0xFF, (sp >> 8) & 0xFF, sp & 0xFF);
+        }
+    }
+    return true;
+}
+
+bool renderer_sprite_pen_bounds(const Sprite &spr, SDL_Rect &out)
+{
+    PenStamp st;
+    if (!pen_stamp_params(spr, st))
+        return false;
+    float cx, cy;
+    SDL_Rect box;
+    pen_stamp_bounds(st, cx, cy, box);
+    SDL_Rect layer = {0, 0, PEN_W, PEN_H};
+    return SDL_IntersectRect(&box, &layer, &out) == SDL_TRUE;
+}
+
+void renderer_rasterize_sprite(const Sprite &spr, const SDL_Rect &area, std::vector<Uint32> &out)
+{
+    out.assign(area.w * area.h, 0);
+    PenStamp st;
+    if (!pen_stamp_params(spr, st))
+        return;
+    pen_load_stamp_sources(std::vector<PenStamp>(1, st));
+    SDL_Rect touched;
+    pen_raster_stamp(st, out.data(), area, touched);
+}
+
+void renderer_stamp_on_pen_layer(const Sprite &spr)
+{
+    PenCommand cmd = {};
+    cmd.type = PEN_CMD_STAMP;
+    if (!pen_stamp_params(spr, cmd.stamp))
+        return;
+    g_pen_cmds.push_back(cmd);
+}
+
+void renderer_flush_pen_layer()
+{
+    if (!g_pen_cmds.empty() && !g_pen_pixels.empty())
+    {
+        std::vector<PenStamp> stamps;
+        for (const auto &cmd : g_pen_cmds)
+            if (cmd.type == PEN_CMD_STAMP)
+                stamps.push_back(cmd.stamp);
+        if (!stamps.empty())
+            pen_load_stamp_sources(stamps);
+
+        SDL_Rect layer = {0, 0, PEN_W, PEN_H};
+        for (const auto &cmd : g_pen_cmds)
+        {
+            if (cmd.type == PEN_CMD_CLEAR)
+                pen_clear_pixels();
+            else if (cmd.type == PEN_CMD_LINE)
+                pen_draw_capsule(cmd.x0, cmd.y0, cmd.x1, cmd.y1, cmd.radius, cmd.color);
+            else
+            {
+                SDL_Rect touched;
+                if (pen_raster_stamp(cmd.stamp, g_pen_pixels.data(), layer, touched))
+                    pen_mark_dirty(touched.x, touched.y, touched.x + touched.w, touched.y + touched.h);
+            }
+        }
+    }
+    g_pen_cmds.clear();
+    g_stamp_sources.clear();
+
+    if (!g_pen_has_dirty)
+        return;
+    g_pen_has_dirty = false;
+    if (!g_pen_layer)
+        return;
+    const Uint32 *src = &g_pen_pixels[g_pen_dirty.y * PEN_W + g_pen_dirty.x];
+    SDL_UpdateTexture(g_pen_layer, &g_pen_dirty, src, PEN_W * 4);
+}
@@ -3,6 +3,7 @@
 
 #include "SDL.h"
 #include "types.h"
+#include <vector>
 
 /* Circle drawing */
 void renderer_fill_circle(SDL_Renderer *r, int cx, int cy, int radius, int red, int green, int blue);
@@ -20,16 +21,29 @@ void renderer_draw_texture(SDL_Renderer *r, SDL_Texture *tex, const SDL_Rect *ds
 /* Draw texture keeping aspect ratio, centered in dst rect */
 void renderer_draw_texture_fit(SDL_Renderer *r, SDL_Texture *tex, const SDL_Rect *dst);
 
+/* Mip chain of a composed costume/backdrop (1/2 .. 1/16, box filtered) */
+void renderer_build_mips(SDL_Renderer *r, GraphicItem &item);
+void renderer_destroy_mips(GraphicItem &item);
+/* Smallest level that still covers w x h; falls back to the full texture */
+SDL_Texture* renderer_pick_level(const GraphicItem &item, int w, int h);
+
 // ---> PEN LAYER ENGINE <---
 extern SDL_Texture* g_pen_layer;
 extern SDL_Renderer* g_pen_renderer;
 extern SDL_Texture* g_stage_snapshot;
 
-void renderer_update_stage_snapshot(SDL_Renderer *r, SDL_Texture *backdrop_tex, const SDL_Rect &stage_area);
-
 void renderer_init_pen_layer(SDL_Renderer* r);
 void renderer_clear_pen_layer();
 void renderer_draw_line_on_pen_layer(int x1, int y1, int x2, int y2, int size, SDL_Color color);
 void renderer_stamp_on_pen_layer(const Sprite& spr);
 
+/* Upload the dirty part of the CPU pen buffer to g_pen_layer. Call once per frame. */
+void renderer_flush_pen_layer();
+
+/* Color sensing helpers (pen-layer coords, RGBA8888 pixels) */
+/* Backdrop + pen pixels; redrawn and read back only when either changed since the last call */
+const Uint32* renderer_stage_snapshot_pixels(const GraphicItem* backdrop);
+bool renderer_sprite_pen_bounds(const Sprite& spr, SDL_Rect& out);
+void renderer_rasterize_sprite(const Sprite& spr, const SDL_Rect& area, std::vector<Uint32>& out);
+
 #endif
\ No newline at end of file
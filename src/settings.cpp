@@ -1,36 +1,31 @@
 #include "settings.h"
 #include "config.h"
 #include "renderer.h"
+#include "text.h"
+#include "render_queue.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <string>
 
 static bool point_in_rect(int px, int py, const SDL_Rect &r) { return px >= r.x && px < r.x + r.w && py >= r.y && py < r.y + r.h; }
-static void set_color(SDL_Renderer *r, Color c) { SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255); }
+static void set_color(SDL_Renderer *r, Color c) { rq_set_color(r, c.r, c.g, c.b, 255); }
 
 static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt, int x, int y, Color c)
 {
     SDL_Color sc = {(Uint8)c.r, (Uint8)c.g, (Uint8)c.b, 255};
-    SDL_Surface *s = TTF_RenderUTF8_Blended(f, txt, sc);
-    if (!s)
-        return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst = {x, y, s->w, s->h};
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    text_draw(r, f, txt, x, y, sc);
 }
 
 static void draw_input_box(SDL_Renderer *r, TTF_Font *font, const SDL_Rect &rect, const char *text, bool active)
 {
     set_color(r, COL_SETTINGS_INPUT_BG);
-    SDL_RenderFillRect(r, &rect);
+    rq_fill_rect(r, &rect);
     if (active)
         set_color(r, COL_SETTINGS_INPUT_ACTIVE);
     else
         set_color(r, COL_SETTINGS_INPUT_BORDER);
-    SDL_RenderDrawRect(r, &rect);
+    rq_draw_rect(r, &rect);
     if (text[0] != '\0')
     {
         int tx = rect.x + 8;
@@ -72,15 +67,15 @@ void settings_layout(SettingsRects &rects)
 
 void settings_draw(SDL_Renderer *r, TTF_Font *font, AppState &state, const SettingsRects &rects, const Textures &tex)
 {
-    SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-    SDL_RenderFillRect(r, &rects.panel);
+    rq_set_color(r, 255, 255, 255, 255);
+    rq_fill_rect(r, &rects.panel);
 
     // ---> FIXED: SEPARATORS AND LEFT BORDER <---
     set_color(r, COL_SETTINGS_BORDER);
-    SDL_RenderDrawLine(r, rects.panel.x, rects.panel.y, rects.panel.x + rects.panel.w, rects.panel.y);
-    SDL_RenderDrawLine(r, rects.panel.x, rects.panel.y + rects.panel.h - 1, rects.panel.x + rects.panel.w, rects.panel.y + rects.panel.h - 1);
-    SDL_SetRenderDrawColor(r, 220, 220, 220, 255);
-    SDL_RenderDrawLine(r, rects.panel.x, rects.panel.y, rects.panel.x, rects.panel.y + rects.panel.h);
+    rq_draw_line(r, rects.panel.x, rects.panel.y, rects.panel.x + rects.panel.w, rects.panel.y);
+    rq_draw_line(r, rects.panel.x, rects.panel.y + rects.panel.h - 1, rects.panel.x + rects.panel.w, rects.panel.y + rects.panel.h - 1);
+    rq_set_color(r, 220, 220, 220, 255);
+    rq_draw_line(r, rects.panel.x, rects.panel.y, rects.panel.x, rects.panel.y + rects.panel.h);
 
     int ty_offset = (SETTINGS_INPUT_H - 13) / 2;
 
@@ -140,17 +135,17 @@ void settings_draw(SDL_Renderer *r, TTF_Font *font, AppState &state, const Setti
         draw_input_box(r, font, rects.dir_input, active_spr ? buf : "-", false);
     }
 
-    SDL_SetRenderDrawColor(r, 240, 240, 240, 255);
-    SDL_RenderFillRect(r, &rects.vis_on_btn);
-    SDL_RenderFillRect(r, &rects.vis_off_btn);
+    rq_set_color(r, 240, 240, 240, 255);
+    rq_fill_rect(r, &rects.vis_on_btn);
+    rq_fill_rect(r, &rects.vis_off_btn);
     bool is_vis = active_spr ? active_spr->visible : false;
     SDL_Rect active_vis = is_vis ? rects.vis_on_btn : rects.vis_off_btn;
-    SDL_SetRenderDrawColor(r, 215, 230, 255, 255);
-    SDL_RenderFillRect(r, &active_vis);
+    rq_set_color(r, 215, 230, 255, 255);
+    rq_fill_rect(r, &active_vis);
 
     set_color(r, COL_SETTINGS_INPUT_BORDER);
-    SDL_RenderDrawRect(r, &rects.vis_on_btn);
-    SDL_RenderDrawRect(r, &rects.vis_off_btn);
+    rq_draw_rect(r, &rects.vis_on_btn);
+    rq_draw_rect(r, &rects.vis_off_btn);
     if (tex.vis_on_active)
         renderer_draw_texture_fit(r, tex.vis_on_active, &rects.vis_on_btn);
     if (tex.vis_off_inactive)
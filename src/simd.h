@@ -0,0 +1,17 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// ---> SIMD SELECTION <---
+// The baseline vector ISA of the target, so no build flags are needed:
+// SSE2 on x86-64 (and x86 built with it), NEON on AArch64.
+// Code using these keeps a scalar loop for other targets and for tails.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#endif
@@ -2,6 +2,8 @@
 #include "config.h"
 #include "renderer.h"
 #include "audio.h"
+#include "text.h"
+#include "render_queue.h"
 #include <cstdio>
 #include <cstdlib>
 #include <string>
@@ -9,20 +11,13 @@
 static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt, int x, int y, Uint8 cr, Uint8 cg, Uint8 cb)
 {
     SDL_Color sc = {cr, cg, cb, 255};
-    SDL_Surface *surf = TTF_RenderUTF8_Blended(f, txt, sc);
-    if (!surf)
-        return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, surf);
-    SDL_Rect dst = {x, y, surf->w, surf->h};
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(surf);
+    text_draw(r, f, txt, x, y, sc);
 }
 
 static void fill_rounded(SDL_Renderer *r, SDL_Rect *rect, int radius, Uint8 cr, Uint8 cg, Uint8 cb)
 {
-    SDL_SetRenderDrawColor(r, cr, cg, cb, 255);
-    SDL_RenderFillRect(r, rect);
+    rq_set_color(r, cr, cg, cb, 255);
+    rq_fill_rect(r, rect);
 }
 
 static bool point_in(const SDL_Rect &r, int x, int y) { return x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h; }
@@ -34,14 +29,14 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
     int panel_h = WINDOW_HEIGHT - top_y;
 
     SDL_Rect left_panel = {0, top_y, left_w, panel_h};
-    SDL_SetRenderDrawColor(r, 235, 245, 255, 255);
-    SDL_RenderFillRect(r, &left_panel);
-    SDL_SetRenderDrawColor(r, 200, 220, 240, 255);
-    SDL_RenderDrawLine(r, left_w, top_y, left_w, WINDOW_HEIGHT);
+    rq_set_color(r, 235, 245, 255, 255);
+    rq_fill_rect(r, &left_panel);
+    rq_set_color(r, 200, 220, 240, 255);
+    rq_draw_line(r, left_w, top_y, left_w, WINDOW_HEIGHT);
 
     SDL_Rect right_panel = {left_w + 1, top_y, WINDOW_WIDTH - left_w, panel_h};
-    SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-    SDL_RenderFillRect(r, &right_panel);
+    rq_set_color(r, 255, 255, 255, 255);
+    rq_fill_rect(r, &right_panel);
 
     if (state.selected_sprite < 0 || state.selected_sprite >= (int)state.sprites.size())
         return;
@@ -61,8 +56,8 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
         else
         {
             fill_rounded(r, &box, 6, 255, 255, 255);
-            SDL_SetRenderDrawColor(r, 180, 180, 180, 255);
-            SDL_RenderDrawRect(r, &box);
+            rq_set_color(r, 180, 180, 180, 255);
+            rq_draw_rect(r, &box);
         }
 
         SDL_Texture *ic = tex.vol_up;
@@ -74,7 +69,7 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
         if (ic)
         {
             SDL_Rect ic_r = {box.x + 10, box.y + 14, 32, 32};
-            SDL_RenderCopy(r, ic, NULL, &ic_r);
+            rq_copy(r, ic, NULL, &ic_r);
         }
 
         if ((int)i == spr.selected_sound)
@@ -85,7 +80,7 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
         if ((int)i == spr.selected_sound && tex.delete_sprite)
         {
             SDL_Rect del_r = {box.x + box.w - 20, box.y - 8, 24, 24};
-            SDL_RenderCopy(r, tex.delete_sprite, NULL, &del_r);
+            rq_copy(r, tex.delete_sprite, NULL, &del_r);
         }
         sy += 70;
     }
@@ -103,8 +98,8 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
         draw_text(r, font, "Sound Name:", rx, ry + 5, 40, 40, 40);
         SDL_Rect name_box = {rx + 110, ry, 200, 30};
         fill_rounded(r, &name_box, 4, 255, 255, 255);
-        SDL_SetRenderDrawColor(r, state.active_input == INPUT_SOUND_NAME ? 77 : 120, state.active_input == INPUT_SOUND_NAME ? 151 : 120, state.active_input == INPUT_SOUND_NAME ? 255 : 120, 255);
-        SDL_RenderDrawRect(r, &name_box);
+        rq_set_color(r, state.active_input == INPUT_SOUND_NAME ? 77 : 120, state.active_input == INPUT_SOUND_NAME ? 151 : 120, state.active_input == INPUT_SOUND_NAME ? 255 : 120, 255);
+        rq_draw_rect(r, &name_box);
         std::string n_txt = (state.active_input == INPUT_SOUND_NAME) ? state.input_buffer + "|" : snd.name;
         draw_text(r, font, n_txt.c_str(), name_box.x + 10, name_box.y + 6, 0, 0, 0);
 
@@ -113,8 +108,8 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
         draw_text(r, font, "Volume %:", rx, ry + 5, 40, 40, 40);
         SDL_Rect vol_box = {rx + 110, ry, 60, 30};
         fill_rounded(r, &vol_box, 4, 255, 255, 255);
-        SDL_SetRenderDrawColor(r, state.active_input == INPUT_SOUND_VOLUME ? 77 : 120, state.active_input == INPUT_SOUND_VOLUME ? 151 : 120, state.active_input == INPUT_SOUND_VOLUME ? 255 : 120, 255);
-        SDL_RenderDrawRect(r, &vol_box);
+        rq_set_color(r, state.active_input == INPUT_SOUND_VOLUME ? 77 : 120, state.active_input == INPUT_SOUND_VOLUME ? 151 : 120, state.active_input == INPUT_SOUND_VOLUME ? 255 : 120, 255);
+        rq_draw_rect(r, &vol_box);
         char vb[32];
         std::snprintf(vb, sizeof(vb), "%d", snd.volume);
         std::string v_txt = (state.active_input == INPUT_SOUND_VOLUME) ? state.input_buffer + "|" : vb;
@@ -128,7 +123,7 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
         if (tex.play_icon && !is_playing)
         {
             SDL_Rect ic_r = {play_btn.x + 15, play_btn.y + 9, 32, 32};
-            SDL_RenderCopy(r, tex.play_icon, NULL, &ic_r);
+            rq_copy(r, tex.play_icon, NULL, &ic_r);
         }
         draw_text(r, font, is_playing ? "Pause" : "Play", play_btn.x + (is_playing ? 35 : 55), play_btn.y + 15, 255, 255, 255);
 
@@ -142,7 +137,7 @@ void sounds_tab_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, con
         if (tex.vol_mute)
         {
             SDL_Rect ic_r = {mute_btn.x + 15, mute_btn.y + 9, 32, 32};
-            SDL_RenderCopy(r, tex.vol_mute, NULL, &ic_r);
+            rq_copy(r, tex.vol_mute, NULL, &ic_r);
         }
         draw_text(r, font, is_muted ? "Unmute" : "Mute", mute_btn.x + 55, mute_btn.y + 15, is_muted ? 255 : 40, is_muted ? 255 : 40, is_muted ? 255 : 40);
     }
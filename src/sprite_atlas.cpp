@@ -0,0 +1,248 @@
+#include "sprite_atlas.h"
+#include "renderer.h"
+#include "render_queue.h"
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+static const int PAGE_SIZE = 1024;
+static const int MAX_PAGES = 4;
+static const int ENTRY_MIN = 16;
+static const int ENTRY_MAX = 256; // bigger on-screen sprites sample their own texture
+static const int PAD = 1;         // transparent border so filtering never reaches a neighbour
+
+struct AtlasKey
+{
+    SDL_Texture *tex;
+    unsigned int serial; // changes whenever a costume is recomposed
+    int tex_w, tex_h;    // guards against a freed texture's address being reused
+    int bucket;
+    bool operator==(const AtlasKey &o) const
+    {
+        return tex == o.tex && serial == o.serial && tex_w == o.tex_w && tex_h == o.tex_h && bucket == o.bucket;
+    }
+};
+
+struct AtlasKeyHash
+{
+    size_t operator()(const AtlasKey &k) const
+    {
+        size_t h = std::hash<const void *>()(k.tex);
+        h = (h ^ k.serial) * 1099511628211ULL;
+        h = (h ^ (size_t)(k.tex_w * 65536 + k.tex_h)) * 1099511628211ULL;
+        return (h ^ (size_t)k.bucket) * 1099511628211ULL;
+    }
+};
+
+struct AtlasEntry
+{
+    int page;
+    SDL_Rect src;
+};
+
+struct AtlasPage
+{
+    SDL_Texture *texture;
+    int shelf_x, shelf_y, shelf_h;
+};
+
+static SDL_Renderer *g_renderer = nullptr;
+static std::vector<AtlasPage> g_pages;
+static std::unordered_map<AtlasKey, AtlasEntry, AtlasKeyHash> g_entries;
+static bool g_disabled = false;
+
+static std::vector<SDL_Vertex> g_verts;
+static std::vector<int> g_indices;
+static int g_batch_page = -1;
+
+static void reset_pages()
+{
+    g_entries.clear();
+    for (AtlasPage &p : g_pages)
+        p.shelf_x = p.shelf_y = p.shelf_h = 0;
+}
+
+static bool shelf_alloc(AtlasPage &p, int w, int h, SDL_Rect &out)
+{
+    if (p.shelf_x + w > PAGE_SIZE)
+    {
+        p.shelf_x = 0;
+        p.shelf_y += p.shelf_h;
+        p.shelf_h = 0;
+    }
+    if (p.shelf_y + h > PAGE_SIZE)
+        return false;
+    out = {p.shelf_x, p.shelf_y, w, h};
+    p.shelf_x += w;
+    p.shelf_h = std::max(p.shelf_h, h);
+    return true;
+}
+
+// Finds room for a w x h cell: existing pages, then a new page, then start over
+static int alloc_cell(SDL_Renderer *r, int w, int h, SDL_Rect &out)
+{
+    for (int i = 0; i < (int)g_pages.size(); i++)
+        if (shelf_alloc(g_pages[i], w, h, out))
+            return i;
+    if ((int)g_pages.size() < MAX_PAGES)
+    {
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+        SDL_Texture *t = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, PAGE_SIZE, PAGE_SIZE);
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+        if (t)
+        {
+            SDL_SetTextureBlendMode(t, SDL_BLENDMODE_BLEND);
+            g_pages.push_back({t, 0, 0, 0});
+            if (shelf_alloc(g_pages.back(), w, h, out))
+                return (int)g_pages.size() - 1;
+        }
+        else
+            SDL_Log("Sprite atlas page failed: %s", SDL_GetError());
+    }
+    if (g_pages.empty())
+        return -1;
+    // Every page is full: queued quads go out first, then entries are rebuilt as sprites are drawn
+    sprite_atlas_flush(r);
+    reset_pages();
+    return shelf_alloc(g_pages[0], w, h, out) ? 0 : -1;
+}
+
+static const AtlasEntry *entry_for(SDL_Renderer *r, SDL_Texture *tex, const GraphicItem *item, int bucket)
+{
+    int tw = 0, th = 0;
+    SDL_QueryTexture(tex, NULL, NULL, &tw, &th);
+    if (tw <= 0 || th <= 0)
+        return nullptr;
+    AtlasKey key = {tex, item ? item->composed_serial : 0, tw, th, bucket};
+    auto it = g_entries.find(key);
+    if (it != g_entries.end())
+        return &it->second;
+    int ew = std::max(1, (int)std::lround((double)tw * bucket / std::max(tw, th)));
+    int eh = std::max(1, (int)std::lround((double)th * bucket / std::max(tw, th)));
+
+    SDL_Rect cell;
+    int page = alloc_cell(r, ew + PAD * 2, eh + PAD * 2, cell);
+    if (page < 0)
+        return nullptr;
+    AtlasEntry e = {page, {cell.x + PAD, cell.y + PAD, ew, eh}};
+
+    // Copy (not blend) the nearest mip into the cell; the page keeps straight alpha like the costume
+    SDL_Texture *src = item ? renderer_pick_level(*item, ew, eh) : tex;
+    SDL_Texture *prev_target = SDL_GetRenderTarget(r);
+    float sx = 1.0f, sy = 1.0f;
+    SDL_RenderGetScale(r, &sx, &sy);
+    SDL_Rect prev_clip;
+    bool prev_clipped = SDL_RenderIsClipEnabled(r);
+    SDL_RenderGetClipRect(r, &prev_clip);
+    SDL_BlendMode prev_draw = SDL_BLENDMODE_NONE, prev_src = SDL_BLENDMODE_BLEND;
+    SDL_GetRenderDrawBlendMode(r, &prev_draw);
+    SDL_GetTextureBlendMode(src, &prev_src);
+
+    rq_set_target(r, g_pages[page].texture);
+    SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+    rq_set_color(r, 0, 0, 0, 0);
+    rq_fill_rect(r, &cell);
+    SDL_SetTextureBlendMode(src, SDL_BLENDMODE_NONE);
+    rq_copy(r, src, NULL, &e.src);
+    SDL_SetTextureBlendMode(src, prev_src);
+
+    rq_set_target(r, prev_target);
+    SDL_RenderSetScale(r, sx, sy);
+    SDL_RenderSetClipRect(r, prev_clipped ? &prev_clip : NULL);
+    SDL_SetRenderDrawBlendMode(r, prev_draw);
+    return &g_entries.emplace(key, e).first->second;
+}
+
+static void draw_direct(SDL_Renderer *r, SDL_Texture *tex, const GraphicItem *item, const SDL_Rect &dest, double angle)
+{
+    sprite_atlas_flush(r);
+    SDL_Texture *src = item ? renderer_pick_level(*item, dest.w, dest.h) : tex;
+    SDL_RenderCopyEx(r, src, NULL, &dest, angle, NULL, SDL_FLIP_NONE);
+}
+
+void sprite_atlas_draw(SDL_Renderer *r, SDL_Texture *tex, const GraphicItem *item, const SDL_Rect &dest, double angle)
+{
+    if (!r || !tex || dest.w <= 0 || dest.h <= 0)
+        return;
+    if (g_renderer != r)
+    {
+        sprite_atlas_shutdown();
+        g_renderer = r;
+        g_disabled = !SDL_RenderTargetSupported(r);
+    }
+
+    // Entries come in power-of-two sizes of the on-screen (output pixel) extent
+    float sx = 1.0f, sy = 1.0f;
+    SDL_RenderGetScale(r, &sx, &sy);
+    float px = std::max(dest.w * sx, dest.h * sy);
+    int bucket = ENTRY_MIN;
+    while (bucket < px && bucket <= ENTRY_MAX)
+        bucket *= 2;
+    const AtlasEntry *e = (g_disabled || bucket > ENTRY_MAX) ? nullptr : entry_for(r, tex, item, bucket);
+    if (!e)
+    {
+        draw_direct(r, tex, item, dest, angle);
+        return;
+    }
+
+    if (e->page != g_batch_page)
+    {
+        sprite_atlas_flush(r);
+        g_batch_page = e->page;
+    }
+
+    // Same corners SDL_RenderCopyEx would produce: clockwise rotation about the rect centre
+    float cx = dest.x + dest.w * 0.5f, cy = dest.y + dest.h * 0.5f;
+    float hw = dest.w * 0.5f, hh = dest.h * 0.5f;
+    double rad = angle * M_PI / 180.0;
+    float c = (float)std::cos(rad), s = (float)std::sin(rad);
+    const float corners[4][2] = {{-hw, -hh}, {hw, -hh}, {hw, hh}, {-hw, hh}};
+    const float inv = 1.0f / PAGE_SIZE;
+    const float uv[4][2] = {{(float)e->src.x, (float)e->src.y},
+                            {(float)(e->src.x + e->src.w), (float)e->src.y},
+                            {(float)(e->src.x + e->src.w), (float)(e->src.y + e->src.h)},
+                            {(float)e->src.x, (float)(e->src.y + e->src.h)}};
+    int base = (int)g_verts.size();
+    SDL_Color white = {255, 255, 255, 255};
+    for (int i = 0; i < 4; i++)
+    {
+        float x = cx + corners[i][0] * c - corners[i][1] * s;
+        float y = cy + corners[i][0] * s + corners[i][1] * c;
+        g_verts.push_back({{x, y}, white, {uv[i][0] * inv, uv[i][1] * inv}});
+    }
+    const int quad[6] = {0, 1, 2, 0, 2, 3};
+    for (int k : quad)
+        g_indices.push_back(base + k);
+}
+
+void sprite_atlas_flush(SDL_Renderer *r)
+{
+    if (r && !g_indices.empty() && g_batch_page >= 0 && g_batch_page < (int)g_pages.size())
+        rq_geometry(r, g_pages[g_batch_page].texture, g_verts.data(), (int)g_verts.size(), g_indices.data(), (int)g_indices.size());
+    g_verts.clear();
+    g_indices.clear();
+    g_batch_page = -1;
+}
+
+size_t sprite_atlas_bytes()
+{
+    size_t bytes = 0;
+    for (const AtlasPage &p : g_pages)
+        if (p.texture)
+            bytes += (size_t)PAGE_SIZE * PAGE_SIZE * 4;
+    return bytes;
+}
+
+void sprite_atlas_shutdown()
+{
+    g_verts.clear();
+    g_indices.clear();
+    g_batch_page = -1;
+    g_entries.clear();
+    for (AtlasPage &p : g_pages)
+        if (p.texture)
+            SDL_DestroyTexture(p.texture);
+    g_pages.clear();
+    g_renderer = nullptr;
+}
@@ -0,0 +1,23 @@
+#ifndef SPRITE_ATLAS_H
+#define SPRITE_ATLAS_H
+
+#include "SDL.h"
+#include "types.h"
+
+// ---> STAGE SPRITE ATLAS <---
+// Costumes are copied, at roughly the size they appear on the stage, into a
+// few shared atlas pages. Sprites drawn through here become rotated quads that
+// are collected and sent as one SDL_RenderGeometry call per run of the same
+// page, instead of one SDL_RenderCopyEx per sprite on a full-size texture.
+
+/* Queues tex drawn into dest, rotated clockwise by angle degrees about its centre.
+   item is the costume tex was composed from (mips and cache key), or NULL for plain textures. */
+void sprite_atlas_draw(SDL_Renderer *r, SDL_Texture *tex, const GraphicItem *item, const SDL_Rect &dest, double angle);
+/* Draws whatever is queued; call before drawing anything else on top */
+void sprite_atlas_flush(SDL_Renderer *r);
+/* Bytes held by the atlas pages */
+size_t sprite_atlas_bytes();
+/* Frees the atlas pages; call before the renderer is destroyed */
+void sprite_atlas_shutdown();
+
+#endif
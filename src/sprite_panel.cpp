@@ -1,7 +1,13 @@
 #include "sprite_panel.h"
 #include "config.h"
 #include "renderer.h"
+#include "costume_undo.h"
+#include "costumes_tab.h"
+#include "image_import.h"
+#include "stage.h"
 #include "logger.h" // ---> Logger Integrated!
+#include "text.h"
+#include "render_queue.h"
 #include <cstdio>
 #include <cmath>
 #include <string>
@@ -9,29 +15,36 @@
 static void sp_draw_text_centered(SDL_Renderer *r, TTF_Font *font, const char *txt, int cx, int cy, Uint8 cr, Uint8 cg, Uint8 cb)
 {
     SDL_Color col = {cr, cg, cb, 255};
-    SDL_Surface *s = TTF_RenderUTF8_Blended(font, txt, col);
-    if (!s)
-        return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst = {cx - s->w / 2, cy - s->h / 2, s->w, s->h};
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    int w = 0, h = 0;
+    text_size(font, txt, &w, &h);
+    text_draw(r, font, txt, cx - w / 2, cy - h / 2, col);
+}
+
+// Thumbnail source: the costume mip nearest the thumb size
+static SDL_Texture *sp_thumb_texture(const Sprite &spr, const SDL_Rect &thumb)
+{
+    if (spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size())
+    {
+        const Costume &c = spr.costumes[spr.selected_costume];
+        if (c.composed_texture && c.composed_texture == spr.texture)
+            return renderer_pick_level(c, thumb.w, thumb.h);
+    }
+    return spr.texture;
 }
 
 static bool sp_point_in(const SDL_Rect &r, int x, int y) { return x >= r.x && x < r.x + r.w && y >= r.y && y < r.y + r.h; }
 static void sp_fill_rect(SDL_Renderer *r, const SDL_Rect &rc, Uint8 cr, Uint8 cg, Uint8 cb, Uint8 ca)
 {
-    SDL_SetRenderDrawColor(r, cr, cg, cb, ca);
-    SDL_RenderFillRect(r, &rc);
+    rq_set_color(r, cr, cg, cb, ca);
+    rq_fill_rect(r, &rc);
 }
 static void sp_draw_circle(SDL_Renderer *r, int cx, int cy, int rad, Uint8 cr, Uint8 cg, Uint8 cb)
 {
-    SDL_SetRenderDrawColor(r, cr, cg, cb, 255);
+    rq_set_color(r, cr, cg, cb, 255);
     for (int dy = -rad; dy <= rad; dy++)
     {
         int dx = (int)std::sqrt((double)(rad * rad - dy * dy));
-        SDL_RenderDrawLine(r, cx - dx, cy + dy, cx + dx, cy + dy);
+        rq_draw_line(r, cx - dx, cy + dy, cx + dx, cy + dy);
     }
 }
 
@@ -70,10 +83,10 @@ void sprite_panel_layout(SpritePanelRects &rects)
 void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const Textures &tex, const SpritePanelRects &rects)
 {
     sp_fill_rect(r, rects.sprite_list_area, 233, 238, 242, 255);
-    SDL_SetRenderDrawColor(r, 220, 220, 220, 255);
-    SDL_RenderDrawLine(r, rects.backdrop_area.x, rects.backdrop_area.y, rects.backdrop_area.x, rects.backdrop_area.y + rects.backdrop_area.h);
-    SDL_RenderDrawLine(r, rects.sprite_list_area.x, rects.sprite_list_area.y, rects.sprite_list_area.x + rects.sprite_list_area.w + rects.backdrop_area.w, rects.sprite_list_area.y);
-    SDL_RenderDrawLine(r, rects.sprite_list_area.x, rects.sprite_list_area.y, rects.sprite_list_area.x, rects.sprite_list_area.y + rects.sprite_list_area.h);
+    rq_set_color(r, 220, 220, 220, 255);
+    rq_draw_line(r, rects.backdrop_area.x, rects.backdrop_area.y, rects.backdrop_area.x, rects.backdrop_area.y + rects.backdrop_area.h);
+    rq_draw_line(r, rects.sprite_list_area.x, rects.sprite_list_area.y, rects.sprite_list_area.x + rects.sprite_list_area.w + rects.backdrop_area.w, rects.sprite_list_area.y);
+    rq_draw_line(r, rects.sprite_list_area.x, rects.sprite_list_area.y, rects.sprite_list_area.x, rects.sprite_list_area.y + rects.sprite_list_area.h);
 
     int grid_x = rects.sprite_list_area.x + 12, grid_y = rects.sprite_list_area.y + 12;
     for (size_t i = 0; i < state.sprites.size(); i++)
@@ -90,26 +103,26 @@ void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
             int cx = border.x + border.w - 10;
             int cy = border.y + 2;
             sp_draw_circle(r, cx, cy, 12, 255, 60, 60);
-            SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
+            rq_set_color(r, 255, 255, 255, 255);
             int d = 4;
             for (int w = -1; w <= 1; w++)
             {
-                SDL_RenderDrawLine(r, cx - d + w, cy - d, cx + d + w, cy + d);
-                SDL_RenderDrawLine(r, cx - d + w, cy + d, cx + d + w, cy - d);
+                rq_draw_line(r, cx - d + w, cy - d, cx + d + w, cy + d);
+                rq_draw_line(r, cx - d + w, cy + d, cx + d + w, cy - d);
             }
 
             if (state.sprites[i].texture)
-                SDL_RenderCopy(r, state.sprites[i].texture, NULL, &thumb);
+                rq_copy(r, sp_thumb_texture(state.sprites[i], thumb), NULL, &thumb);
             sp_draw_text_centered(r, font, state.sprites[i].name.c_str(), thumb.x + thumb.w / 2, thumb.y + thumb.h + 8, 255, 255, 255);
         }
         else
         {
             SDL_Rect inner = {thumb.x - 2, thumb.y - 2, thumb.w + 4, thumb.h + 4};
             sp_fill_rect(r, inner, 255, 255, 255, 255);
-            SDL_SetRenderDrawColor(r, 200, 200, 200, 255);
-            SDL_RenderDrawRect(r, &inner);
+            rq_set_color(r, 200, 200, 200, 255);
+            rq_draw_rect(r, &inner);
             if (state.sprites[i].texture)
-                SDL_RenderCopy(r, state.sprites[i].texture, NULL, &thumb);
+                rq_copy(r, sp_thumb_texture(state.sprites[i], thumb), NULL, &thumb);
             sp_draw_text_centered(r, font, state.sprites[i].name.c_str(), thumb.x + thumb.w / 2, thumb.y + thumb.h + 8, 80, 80, 80);
         }
 
@@ -126,7 +139,7 @@ void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
     if (tex.sprite_btn_icon)
     {
         SDL_Rect ir = {cx - 12, cy - 12, 24, 24};
-        SDL_RenderCopy(r, tex.sprite_btn_icon, NULL, &ir);
+        rq_copy(r, tex.sprite_btn_icon, NULL, &ir);
     }
     else
         sp_draw_text_centered(r, font, "+", cx, cy, 255, 255, 255);
@@ -142,7 +155,7 @@ void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
             if (icons[i])
             {
                 SDL_Rect ir = {icx - 10, icy - 10, 20, 20};
-                SDL_RenderCopy(r, icons[i], NULL, &ir);
+                rq_copy(r, icons[i], NULL, &ir);
             }
         }
     }
@@ -156,13 +169,17 @@ void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
         sp_fill_rect(r, border, 77, 151, 255, 255);
     }
 
-    SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-    SDL_RenderFillRect(r, const_cast<SDL_Rect *>(&rects.backdrop_thumb));
+    rq_set_color(r, 255, 255, 255, 255);
+    rq_fill_rect(r, &rects.backdrop_thumb);
 
     if (state.selected_backdrop >= 0 && state.selected_backdrop < (int)state.backdrops.size())
     {
-        if (state.backdrops[state.selected_backdrop].texture)
-            SDL_RenderCopy(r, state.backdrops[state.selected_backdrop].texture, NULL, const_cast<SDL_Rect *>(&rects.backdrop_thumb));
+        const Backdrop &bd = state.backdrops[state.selected_backdrop];
+        if (bd.texture)
+        {
+            SDL_Texture *bd_tex = bd.texture == bd.composed_texture ? renderer_pick_level(bd, rects.backdrop_thumb.w, rects.backdrop_thumb.h) : bd.texture;
+            rq_copy(r, bd_tex, NULL, &rects.backdrop_thumb);
+        }
         sp_draw_text_centered(r, font, "Backdrops", rects.backdrop_area.x + rects.backdrop_area.w / 2, rects.backdrop_label.y + 12, 100, 100, 100);
         sp_draw_text_centered(r, font, state.backdrops[state.selected_backdrop].name.c_str(), rects.backdrop_area.x + rects.backdrop_area.w / 2, rects.backdrop_label.y + 30, 140, 140, 140);
     }
@@ -172,8 +189,8 @@ void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
         sp_draw_text_centered(r, font, "1", rects.backdrop_area.x + rects.backdrop_area.w / 2, rects.backdrop_label.y + 30, 140, 140, 140);
     }
 
-    SDL_SetRenderDrawColor(r, 200, 200, 200, 255);
-    SDL_RenderDrawRect(r, const_cast<SDL_Rect *>(&rects.backdrop_thumb));
+    rq_set_color(r, 200, 200, 200, 255);
+    rq_draw_rect(r, &rects.backdrop_thumb);
 
     cx = rects.backdrop_btn.x + BTN_RAD;
     cy = rects.backdrop_btn.y + BTN_RAD;
@@ -181,7 +198,7 @@ void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
     if (tex.backdrop_btn_icon)
     {
         SDL_Rect ir = {cx - 12, cy - 12, 24, 24};
-        SDL_RenderCopy(r, tex.backdrop_btn_icon, NULL, &ir);
+        rq_copy(r, tex.backdrop_btn_icon, NULL, &ir);
     }
     else
         sp_draw_text_centered(r, font, "+", cx, cy, 255, 255, 255);
@@ -197,7 +214,7 @@ void sprite_panel_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, c
             if (icons[i])
             {
                 SDL_Rect ir = {icx - 10, icy - 10, 20, 20};
-                SDL_RenderCopy(r, icons[i], NULL, &ir);
+                rq_copy(r, icons[i], NULL, &ir);
             }
         }
     }
@@ -246,10 +263,16 @@ bool sprite_panel_handle_event(const SDL_Event &e, AppState &state, const Sprite
                         std::string deleted_name = state.sprites[i].name;
 
                         for (auto &c : state.sprites[i].costumes)
+                        {
                             delete_asset_from_project(c.source_path);
+                            release_composed_texture(c);
+                        }
                         for (auto &s : state.sprites[i].sounds)
                             delete_asset_from_project(s.source_path);
 
+                        costume_undo_clear(); // sprite indices shift
+                        image_import_cancel_costumes();
+                        stage_layer_remove(state, i);
                         state.sprites.erase(state.sprites.begin() + i);
 
                         LogSimple(LOG_INFO, 0, -1, "DELETE_SPRITE", "Deleted Sprite: " + deleted_name); // ---> LOGGED
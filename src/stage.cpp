@@ -2,10 +2,93 @@
 #include "config.h"
 #include "renderer.h"
 #include "interpreter.h"
+#include "text.h"
+#include "geometry.h"
+#include "sprite_atlas.h"
+#include "render_queue.h"
+#include "costumes_tab.h"
+#include "trace.h"
 #include <algorithm>
+#include <cmath>
 
 static bool point_in_rect(int px, int py, const SDL_Rect &r) { return px >= r.x && px < r.x + r.w && py >= r.y && py < r.y + r.h; }
-static void set_color(SDL_Renderer *r, Color c) { SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255); }
+static void set_color(SDL_Renderer *r, Color c) { rq_set_color(r, c.r, c.g, c.b, 255); }
+
+// ---> LAYER ORDER <---
+// Kept in sync step by step instead of being re-checked on every call. Sprites
+// are only ever appended, and each new one starts above every existing layer, so
+// new indices go on top. The places that erase or clear sprites call
+// stage_layer_remove / stage_layers_clear first.
+static void layers_sync(const AppState &state)
+{
+    std::vector<int> &order = state.sprite_layers.order;
+    for (int i = (int)order.size(); i < (int)state.sprites.size(); i++)
+        order.push_back(i);
+}
+
+const std::vector<int> &stage_layers(const AppState &state)
+{
+    layers_sync(state);
+    return state.sprite_layers.order;
+}
+
+// Syncs the order and gives the sprites added since the last call their rank
+static const std::vector<int> &layers_ranked(AppState &state)
+{
+    layers_sync(state);
+    const SpriteLayers &layers = state.sprite_layers;
+    for (int i = (int)layers.ranked; i < (int)layers.order.size(); i++)
+        state.sprites[layers.order[i]].layer_order = i;
+    layers.ranked = layers.order.size();
+    return layers.order;
+}
+
+int stage_layer_rank(AppState &state, int sprite_idx)
+{
+    if (sprite_idx < 0 || sprite_idx >= (int)state.sprites.size())
+        return -1;
+    layers_ranked(state);
+    return state.sprites[sprite_idx].layer_order;
+}
+
+void stage_layer_move(AppState &state, int sprite_idx, int rank)
+{
+    int from = stage_layer_rank(state, sprite_idx);
+    if (from < 0)
+        return;
+    std::vector<int> &order = state.sprite_layers.order;
+    int to = std::max(0, std::min(rank, (int)order.size() - 1));
+    if (to == from)
+        return;
+    if (to > from)
+        std::rotate(order.begin() + from, order.begin() + from + 1, order.begin() + to + 1);
+    else
+        std::rotate(order.begin() + to, order.begin() + from, order.begin() + from + 1);
+    for (int i = std::min(from, to); i <= std::max(from, to); i++)
+        state.sprites[order[i]].layer_order = i;
+}
+
+void stage_layer_remove(AppState &state, int sprite_idx)
+{
+    if (sprite_idx < 0 || sprite_idx >= (int)state.sprites.size())
+        return;
+    std::vector<int> &order = state.sprite_layers.order;
+    int from = stage_layer_rank(state, sprite_idx);
+    order.erase(order.begin() + from);
+    for (int i = from; i < (int)order.size(); i++)
+        state.sprites[order[i]].layer_order = i;
+    // Indices past the removed sprite move down once it is erased
+    for (int &idx : order)
+        if (idx > sprite_idx)
+            idx--;
+    state.sprite_layers.ranked = order.size();
+}
+
+void stage_layers_clear(AppState &state)
+{
+    state.sprite_layers.order.clear();
+    state.sprite_layers.ranked = 0;
+}
 
 void stage_layout(StageRects &rects)
 {
@@ -23,233 +106,398 @@ void stage_layout(StageRects &rects)
     rects.stage_area.h = stage_h - margin * 2;
 }
 
-void stage_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const StageRects &rects, const Textures &tex)
+// ---> OFFSCREEN STAGE <---
+// The stage is rendered once per repaint into g_stage_target in stage units
+// (2x when the on-screen stage is HiDPI) and every consumer shows that image.
+static SDL_Texture *g_stage_target = nullptr;
+static int g_stage_target_scale = 0;
+static bool g_stage_target_failed = false;
+
+void stage_layout_player(StageRects &rects)
 {
-    set_color(r, COL_STAGE_BG);
-    SDL_RenderFillRect(r, &rects.panel);
+    rects.panel = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    // Largest 4:3 area that fits, centred; the rest is letterboxed
+    int w = WINDOW_WIDTH;
+    int h = WINDOW_WIDTH * STAGE_HEIGHT / STAGE_WIDTH;
+    if (h > WINDOW_HEIGHT)
+    {
+        h = WINDOW_HEIGHT;
+        w = WINDOW_HEIGHT * STAGE_WIDTH / STAGE_HEIGHT;
+    }
+    rects.stage_area = {(WINDOW_WIDTH - w) / 2, (WINDOW_HEIGHT - h) / 2, w, h};
+}
 
-    // ---> DRAW ACTIVE BACKDROP BEHIND EVERYTHING <---
-    if (state.selected_backdrop >= 0 && state.selected_backdrop < (int)state.backdrops.size())
+// ---> POSE INTERPOLATION <---
+// Poses from before the latest simulation step; drawing blends from them to the
+// current pose so motion stays smooth when the display outruns the simulation.
+struct SpritePose
+{
+    int x, y, direction;
+};
+static std::vector<SpritePose> g_prev_poses;
+static float g_pose_alpha = 1.0f;
+static const int SNAP_DISTANCE = 100; // bigger jumps (go to, glide ends) are not smeared
+
+void stage_save_poses(const AppState &state)
+{
+    g_prev_poses.resize(state.sprites.size());
+    for (size_t i = 0; i < state.sprites.size(); i++)
+        g_prev_poses[i] = {state.sprites[i].x, state.sprites[i].y, state.sprites[i].direction};
+}
+
+void stage_set_pose_alpha(float alpha) { g_pose_alpha = std::max(0.0f, std::min(alpha, 1.0f)); }
+
+// Pose to draw sprite idx at: x, y in Scratch units and the render angle in degrees
+static void draw_pose(const AppState &state, int idx, float &x, float &y, double &angle)
+{
+    const Sprite &spr = state.sprites[idx];
+    x = (float)spr.x;
+    y = (float)spr.y;
+    angle = spr.direction - 90.0;
+    if (g_pose_alpha >= 1.0f || g_prev_poses.size() != state.sprites.size())
+        return;
+    const SpritePose &p = g_prev_poses[idx];
+    if (std::abs(spr.x - p.x) > SNAP_DISTANCE || std::abs(spr.y - p.y) > SNAP_DISTANCE)
+        return;
+    x = p.x + (spr.x - p.x) * g_pose_alpha;
+    y = p.y + (spr.y - p.y) * g_pose_alpha;
+    double turn = std::remainder((double)spr.direction - p.direction, 360.0); // shortest way round
+    angle = p.direction + turn * g_pose_alpha - 90.0;
+}
+
+// Sprite bounds in stage pixels with the sprite centred at (x, y) Scratch units
+static SDL_Rect sprite_rect_at(const Sprite &spr, float x, float y)
+{
+    int tex_w = 100, tex_h = 100;
+    if (spr.texture)
+        SDL_QueryTexture(spr.texture, NULL, NULL, &tex_w, &tex_h);
+    int base_w = tex_w;
+    int base_h = tex_h;
+    int MAX_DEFAULT = 120;
+    if (base_w > MAX_DEFAULT || base_h > MAX_DEFAULT)
     {
-        SDL_Texture *bg_tex = state.backdrops[state.selected_backdrop].texture;
-        if (bg_tex)
+        if (base_w > base_h)
         {
-            SDL_RenderCopy(r, bg_tex, NULL, &rects.stage_area);
+            base_h = (base_h * MAX_DEFAULT) / base_w;
+            base_w = MAX_DEFAULT;
         }
         else
         {
-            SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-            SDL_RenderFillRect(r, &rects.stage_area);
+            base_w = (base_w * MAX_DEFAULT) / base_h;
+            base_h = MAX_DEFAULT;
         }
     }
-    else
+    int w = (base_w * spr.size) / 100;
+    int h = (base_h * spr.size) / 100;
+    int cx = STAGE_WIDTH / 2 + (int)std::lround(x);
+    int cy = STAGE_HEIGHT / 2 - (int)std::lround(y);
+    return {cx - w / 2, cy - h / 2, w, h};
+}
+
+SDL_Rect stage_sprite_rect(const Sprite &spr) { return sprite_rect_at(spr, (float)spr.x, (float)spr.y); }
+
+void stage_window_to_stage(const StageRects &rects, int wx, int wy, float &sx, float &sy)
+{
+    sx = (wx - rects.stage_area.x) * (float)STAGE_WIDTH / rects.stage_area.w - STAGE_WIDTH / 2.0f;
+    sy = STAGE_HEIGHT / 2.0f - (wy - rects.stage_area.y) * (float)STAGE_HEIGHT / rects.stage_area.h;
+}
+
+static bool ensure_stage_target(SDL_Renderer *r, int scale)
+{
+    if (g_stage_target && g_stage_target_scale == scale)
+        return true;
+    if (g_stage_target_failed)
+        return false;
+    if (g_stage_target)
+        SDL_DestroyTexture(g_stage_target);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    g_stage_target = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, STAGE_WIDTH * scale, STAGE_HEIGHT * scale);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    if (!g_stage_target)
     {
-        SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-        SDL_RenderFillRect(r, &rects.stage_area);
+        SDL_Log("Stage target failed, showing backdrop and pen only: %s", SDL_GetError());
+        g_stage_target_failed = true;
+        return false;
     }
+    SDL_SetTextureBlendMode(g_stage_target, SDL_BLENDMODE_NONE);
+    g_stage_target_scale = scale;
+    return true;
+}
 
-    // ---> ADD THIS EXACTLY HERE <---
-    // Render Pen Layer (Strokes and Stamps) on top of the backdrop, but under the sprites
-    if (g_pen_layer) {
-        // FIXED: Changed rects.stage to rects.stage_area
-        SDL_RenderCopy(r, g_pen_layer, NULL, &rects.stage_area); 
+// Backdrop and pen: the part of the stage that colour sensing looks at
+static void draw_stage_base(SDL_Renderer *r, const AppState &state, const SDL_Rect &area, int px_w, int px_h)
+{
+    SDL_Texture *bg_tex = nullptr;
+    if (state.selected_backdrop >= 0 && state.selected_backdrop < (int)state.backdrops.size())
+    {
+        const Backdrop &bd = state.backdrops[state.selected_backdrop];
+        bg_tex = bd.texture;
+        if (bg_tex && bg_tex == bd.composed_texture)
+            bg_tex = renderer_pick_level(bd, px_w, px_h);
     }
+    // White under the backdrop, as the sensing snapshot always had
+    rq_set_color(r, 255, 255, 255, 255);
+    rq_fill_rect(r, &area);
+    if (bg_tex)
+        rq_copy(r, bg_tex, NULL, &area);
 
-    set_color(r, COL_STAGE_BORDER);
-    SDL_RenderDrawRect(r, &rects.stage_area);
-    SDL_RenderSetClipRect(r, const_cast<SDL_Rect *>(&rects.stage_area));
+    // Pen layer (strokes and stamps) on top of the backdrop, but under the sprites
+    if (g_pen_layer)
+        rq_copy(r, g_pen_layer, NULL, &area);
+}
+
+SDL_Texture *stage_render(SDL_Renderer *r, TTF_Font *font, const AppState &state, const Textures &tex, int scale)
+{
+    TRACE_ZONE("stage_render");
+    if (!r || !ensure_stage_target(r, scale))
+        return nullptr;
 
-    // ---> DRAW ALL SPRITES (SORTED BY LAYER ORDER) <---
-    std::vector<const Sprite *> sorted_sprites;
-    for (const auto &s : state.sprites)
-        sorted_sprites.push_back(&s);
-    std::stable_sort(sorted_sprites.begin(), sorted_sprites.end(), [](const Sprite *a, const Sprite *b)
-                     { return a->layer_order < b->layer_order; });
+    SDL_Texture *prev_target = SDL_GetRenderTarget(r);
+    float prev_sx = 1.0f, prev_sy = 1.0f;
+    SDL_RenderGetScale(r, &prev_sx, &prev_sy);
+    SDL_Rect prev_clip;
+    bool prev_clipped = SDL_RenderIsClipEnabled(r);
+    SDL_RenderGetClipRect(r, &prev_clip);
+
+    const SDL_Rect area = {0, 0, STAGE_WIDTH, STAGE_HEIGHT};
+    rq_set_target(r, g_stage_target);
+    SDL_RenderSetScale(r, (float)scale, (float)scale);
+    SDL_RenderSetClipRect(r, NULL);
+    draw_stage_base(r, state, area, STAGE_WIDTH * scale, STAGE_HEIGHT * scale);
 
-    for (const Sprite *spr_ptr : sorted_sprites)
+    // ---> DRAW ALL SPRITES (IN LAYER ORDER) <---
+    // Bubbles are laid out with the sprites but drawn after all of them, in batches
+    struct Bubble
     {
-        const Sprite &spr = *spr_ptr;
+        const Sprite *spr;
+        SDL_Rect dest;
+        SDL_Rect box;
+    };
+    std::vector<Bubble> bubbles;
+
+    for (int idx : stage_layers(state))
+    {
+        const Sprite &spr = state.sprites[idx];
         if (spr.visible)
         {
-            int cx = rects.stage_area.x + rects.stage_area.w / 2 + spr.x;
-            int cy = rects.stage_area.y + rects.stage_area.h / 2 - spr.y;
-            int tex_w = 100, tex_h = 100;
-            if (spr.texture)
-                SDL_QueryTexture(spr.texture, NULL, NULL, &tex_w, &tex_h);
-            int base_w = tex_w;
-            int base_h = tex_h;
-            int MAX_DEFAULT = 120;
-            if (base_w > MAX_DEFAULT || base_h > MAX_DEFAULT)
-            {
-                if (base_w > base_h)
-                {
-                    base_h = (base_h * MAX_DEFAULT) / base_w;
-                    base_w = MAX_DEFAULT;
-                }
-                else
-                {
-                    base_w = (base_w * MAX_DEFAULT) / base_h;
-                    base_h = MAX_DEFAULT;
-                }
-            }
-            int w = (base_w * spr.size) / 100;
-            int h = (base_h * spr.size) / 100;
-            SDL_Rect dest = {cx - w / 2, cy - h / 2, w, h};
+            float pose_x, pose_y;
+            double angle;
+            draw_pose(state, idx, pose_x, pose_y, angle);
+            SDL_Rect dest = sprite_rect_at(spr, pose_x, pose_y);
 
             if (spr.texture)
             {
-                double angle = spr.direction - 90.0;
-                SDL_RenderCopyEx(r, spr.texture, NULL, &dest, angle, NULL, SDL_FLIP_NONE);
+                // Sizing above uses the full composition; the atlas samples a mip near the drawn size
+                const GraphicItem *costume = nullptr;
+                if (spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size() &&
+                    spr.costumes[spr.selected_costume].composed_texture == spr.texture)
+                    costume = &spr.costumes[spr.selected_costume];
+                sprite_atlas_draw(r, spr.texture, costume, dest, angle);
             }
             else
             {
-                SDL_SetRenderDrawColor(r, 255, 165, 0, 255);
-                SDL_RenderFillRect(r, &dest);
+                sprite_atlas_flush(r);
+                rq_set_color(r, 255, 165, 0, 255);
+                rq_fill_rect(r, &dest);
             }
 
             if (!spr.say_text.empty())
             {
                 bool should_draw = true;
-                if (spr.say_end_time > 0 && SDL_GetTicks() > spr.say_end_time)
+                if (spr.say_end_time > 0 && interpreter_time() > spr.say_end_time)
                     should_draw = false;
                 if (should_draw)
                 {
                     int tw = 0, th = 0;
-                    TTF_SizeUTF8(font, spr.say_text.c_str(), &tw, &th);
+                    text_size(font, spr.say_text.c_str(), &tw, &th);
                     int bub_w = tw + 24;
                     int bub_h = th + 20;
                     int bub_x = dest.x + dest.w - 10;
                     int bub_y = dest.y - bub_h;
-                    if (bub_x + bub_w > rects.stage_area.x + rects.stage_area.w)
+                    if (bub_x + bub_w > area.x + area.w)
                         bub_x = dest.x - bub_w + 10;
-                    if (bub_y < rects.stage_area.y)
+                    if (bub_y < area.y)
                         bub_y = dest.y + dest.h;
-
-                    if (spr.is_thinking && tex.cloud)
-                    {
-                        SDL_Rect cloud_r = {bub_x - 10, bub_y - 10, bub_w + 20, bub_h + 30};
-                        SDL_RenderCopy(r, tex.cloud, NULL, &cloud_r);
-                    }
-                    else
-                    {
-                        SDL_Rect bub_r = {bub_x, bub_y, bub_w, bub_h};
-                        SDL_SetRenderDrawColor(r, 160, 160, 160, 255);
-                        renderer_fill_rounded_rect(r, &bub_r, 12, 160, 160, 160);
-                        SDL_Rect inner_r = {bub_x + 2, bub_y + 2, bub_w - 4, bub_h - 4};
-                        renderer_fill_rounded_rect(r, &inner_r, 10, 255, 255, 255);
-                        if (spr.is_thinking)
-                        {
-                            renderer_fill_circle(r, bub_x - 5, bub_y + bub_h + 5, 4, 255, 255, 255);
-                            renderer_fill_circle(r, bub_x - 15, bub_y + bub_h + 15, 2, 255, 255, 255);
-                        }
-                        else
-                        {
-                            SDL_SetRenderDrawColor(r, 255, 255, 255, 255);
-                            SDL_RenderDrawLine(r, bub_x + 10, bub_y + bub_h - 2, dest.x + dest.w / 2, dest.y + dest.h / 4);
-                            SDL_RenderDrawLine(r, bub_x + 20, bub_y + bub_h - 2, dest.x + dest.w / 2, dest.y + dest.h / 4);
-                        }
-                    }
-                    SDL_Color tc = {0, 0, 0, 255};
-                    SDL_Surface *s = TTF_RenderUTF8_Blended(font, spr.say_text.c_str(), tc);
-                    if (s)
-                    {
-                        SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-                        SDL_Rect td = {bub_x + 12, bub_y + 10, s->w, s->h};
-                        SDL_RenderCopy(r, t, NULL, &td);
-                        SDL_DestroyTexture(t);
-                        SDL_FreeSurface(s);
-                    }
+                    bubbles.push_back({&spr, dest, {bub_x, bub_y, bub_w, bub_h}});
                 }
             }
         }
     }
 
+    // ---> DRAW SPEECH BUBBLES: CLOUDS, THEN SHAPES, THEN TEXT <---
+    for (const Bubble &b : bubbles)
+    {
+        if (b.spr->is_thinking && tex.cloud)
+        {
+            SDL_Rect cloud_r = {b.box.x - 10, b.box.y - 10, b.box.w + 20, b.box.h + 30};
+            sprite_atlas_draw(r, tex.cloud, nullptr, cloud_r, 0.0);
+        }
+    }
+    sprite_atlas_flush(r);
+
+    geometry_begin_batch();
+    for (const Bubble &b : bubbles)
+    {
+        if (b.spr->is_thinking && tex.cloud)
+            continue;
+        const SDL_Rect &bub = b.box;
+        renderer_fill_rounded_rect(r, &bub, 12, 160, 160, 160);
+        SDL_Rect inner_r = {bub.x + 2, bub.y + 2, bub.w - 4, bub.h - 4};
+        renderer_fill_rounded_rect(r, &inner_r, 10, 255, 255, 255);
+        if (b.spr->is_thinking)
+        {
+            renderer_fill_circle(r, bub.x - 5, bub.y + bub.h + 5, 4, 255, 255, 255);
+            renderer_fill_circle(r, bub.x - 15, bub.y + bub.h + 15, 2, 255, 255, 255);
+        }
+        else
+        {
+            // Tail from the bubble's lower edge to the sprite's upper body
+            SDL_FPoint tip = {(float)(b.dest.x + b.dest.w / 2), (float)(b.dest.y + b.dest.h / 4)};
+            geometry_fill_triangle(r, {(float)(bub.x + 10), (float)(bub.y + bub.h - 2)},
+                                   {(float)(bub.x + 20), (float)(bub.y + bub.h - 2)}, tip, {255, 255, 255, 255});
+        }
+    }
+    geometry_end_batch(r);
+
+    text_begin_batch();
+    SDL_Color bubble_tc = {0, 0, 0, 255};
+    for (const Bubble &b : bubbles)
+        text_draw(r, font, b.spr->say_text.c_str(), b.box.x + 12, b.box.y + 10, bubble_tc);
+    text_end_batch();
+
     // ---> DRAW ASK & WAIT BOX <---
     if (state.ask_active)
     {
         int ask_h = 60;
-        SDL_Rect ask_bg = {rects.stage_area.x, rects.stage_area.y + rects.stage_area.h - ask_h, rects.stage_area.w, ask_h};
-        SDL_SetRenderDrawColor(r, 230, 240, 255, 255);
-        SDL_RenderFillRect(r, &ask_bg);
-        SDL_SetRenderDrawColor(r, 0, 160, 255, 255);
-        SDL_RenderDrawRect(r, &ask_bg);
+        SDL_Rect ask_bg = {area.x, area.y + area.h - ask_h, area.w, ask_h};
+        rq_set_color(r, 230, 240, 255, 255);
+        rq_fill_rect(r, &ask_bg);
+        rq_set_color(r, 0, 160, 255, 255);
+        rq_draw_rect(r, &ask_bg);
         SDL_Color tc = {40, 40, 40, 255};
-        SDL_Surface *ms = TTF_RenderUTF8_Blended(font, state.ask_msg.c_str(), tc);
-        if (ms)
-        {
-            SDL_Texture *mt = SDL_CreateTextureFromSurface(r, ms);
-            SDL_Rect md = {ask_bg.x + 10, ask_bg.y + 10, ms->w, ms->h};
-            SDL_RenderCopy(r, mt, NULL, &md);
-            SDL_DestroyTexture(mt);
-            SDL_FreeSurface(ms);
-        }
+        text_draw(r, font, state.ask_msg.c_str(), ask_bg.x + 10, ask_bg.y + 10, tc);
         SDL_Rect inp_r = {ask_bg.x + 10, ask_bg.y + 30, ask_bg.w - 20, 24};
         renderer_fill_rounded_rect(r, &inp_r, 4, 255, 255, 255);
-        SDL_SetRenderDrawColor(r, 200, 200, 200, 255);
-        SDL_RenderDrawRect(r, &inp_r);
-        SDL_Surface *rs = TTF_RenderUTF8_Blended(font, state.ask_reply.c_str(), tc);
-        if (rs)
-        {
-            SDL_Texture *rt = SDL_CreateTextureFromSurface(r, rs);
-            SDL_Rect rd = {inp_r.x + 6, inp_r.y + 4, rs->w, rs->h};
-            SDL_RenderCopy(r, rt, NULL, &rd);
-            SDL_DestroyTexture(rt);
-            SDL_FreeSurface(rs);
-        }
+        rq_set_color(r, 200, 200, 200, 255);
+        rq_draw_rect(r, &inp_r);
+        text_draw(r, font, state.ask_reply.c_str(), inp_r.x + 6, inp_r.y + 4, tc);
         if ((SDL_GetTicks() / 500) % 2 == 0)
         {
             int tw = 0;
-            TTF_SizeUTF8(font, state.ask_reply.c_str(), &tw, NULL);
-            SDL_SetRenderDrawColor(r, 0, 0, 0, 255);
-            SDL_RenderDrawLine(r, inp_r.x + 6 + tw, inp_r.y + 4, inp_r.x + 6 + tw, inp_r.y + 20);
+            text_size(font, state.ask_reply.c_str(), &tw, NULL);
+            rq_set_color(r, 0, 0, 0, 255);
+            rq_draw_line(r, inp_r.x + 6 + tw, inp_r.y + 4, inp_r.x + 6 + tw, inp_r.y + 20);
         }
     }
 
     // ---> DRAW VARIABLES ON TOP <---
-    int var_y = rects.stage_area.y + 10;
+    int var_y = area.y + 10;
     for (const std::string &vname : state.variables)
     {
         if (state.variable_visible.count(vname) && state.variable_visible.at(vname))
         {
             std::string s_val = state.variable_values.count(vname) ? state.variable_values.at(vname) : "0";
             int tw1 = 0, th1 = 0;
-            TTF_SizeUTF8(font, vname.c_str(), &tw1, &th1);
+            text_size(font, vname.c_str(), &tw1, &th1);
             int tw2 = 0, th2 = 0;
-            TTF_SizeUTF8(font, s_val.c_str(), &tw2, &th2);
+            text_size(font, s_val.c_str(), &tw2, &th2);
             int box_w = tw1 + tw2 + 24;
-            SDL_Rect mon = {rects.stage_area.x + 10, var_y, box_w, 24};
+            SDL_Rect mon = {area.x + 10, var_y, box_w, 24};
 
             renderer_fill_rounded_rect(r, &mon, 4, 210, 210, 210);
-            SDL_SetRenderDrawColor(r, 180, 180, 180, 255);
-            SDL_RenderDrawRect(r, &mon);
+            rq_set_color(r, 180, 180, 180, 255);
+            rq_draw_rect(r, &mon);
 
             SDL_Color tcl = {40, 40, 40, 255};
-            SDL_Surface *s1 = TTF_RenderUTF8_Blended(font, vname.c_str(), tcl);
-            if (s1)
-            {
-                SDL_Texture *t1 = SDL_CreateTextureFromSurface(r, s1);
-                SDL_Rect d1 = {mon.x + 6, mon.y + (24 - s1->h) / 2, s1->w, s1->h};
-                SDL_RenderCopy(r, t1, NULL, &d1);
-                SDL_DestroyTexture(t1);
-                SDL_FreeSurface(s1);
-            }
+            text_draw(r, font, vname.c_str(), mon.x + 6, mon.y + (24 - th1) / 2, tcl);
 
             SDL_Rect val_bg = {mon.x + tw1 + 12, mon.y + 3, tw2 + 8, 18};
             renderer_fill_rounded_rect(r, &val_bg, 4, 255, 140, 26);
             SDL_Color tcv = {255, 255, 255, 255};
-            SDL_Surface *s2 = TTF_RenderUTF8_Blended(font, s_val.c_str(), tcv);
-            if (s2)
-            {
-                SDL_Texture *t2 = SDL_CreateTextureFromSurface(r, s2);
-                SDL_Rect d2 = {val_bg.x + 4, val_bg.y + (18 - s2->h) / 2, s2->w, s2->h};
-                SDL_RenderCopy(r, t2, NULL, &d2);
-                SDL_DestroyTexture(t2);
-                SDL_FreeSurface(s2);
-            }
+            text_draw(r, font, s_val.c_str(), val_bg.x + 4, val_bg.y + (18 - th2) / 2, tcv);
             var_y += 30;
         }
     }
-    SDL_RenderSetClipRect(r, NULL);
+
+    rq_set_target(r, prev_target);
+    SDL_RenderSetScale(r, prev_sx, prev_sy);
+    SDL_RenderSetClipRect(r, prev_clipped ? &prev_clip : NULL);
+    return g_stage_target;
+}
+
+void stage_update_textures(SDL_Renderer *r, TTF_Font *font, AppState &state)
+{
+    TRACE_ZONE("composition");
+    for (auto &spr : state.sprites)
+    {
+        if (!spr.costumes.empty() && spr.selected_costume >= 0 && spr.selected_costume < (int)spr.costumes.size())
+        {
+            update_composed_texture(spr.costumes[spr.selected_costume], r, font);
+            spr.texture = spr.costumes[spr.selected_costume].composed_texture;
+        }
+    }
+    if (!state.backdrops.empty() && state.selected_backdrop >= 0 && state.selected_backdrop < (int)state.backdrops.size())
+    {
+        update_composed_texture(state.backdrops[state.selected_backdrop], r, font);
+        state.backdrops[state.selected_backdrop].texture = state.backdrops[state.selected_backdrop].composed_texture;
+    }
+}
+
+SDL_Texture *stage_texture() { return g_stage_target; }
+
+void stage_shutdown()
+{
+    if (g_stage_target)
+        SDL_DestroyTexture(g_stage_target);
+    g_stage_target = nullptr;
+    g_stage_target_scale = 0;
+    g_stage_target_failed = false;
+}
+
+// 2x target when the stage covers clearly more output pixels than stage units
+static int target_scale_for(SDL_Renderer *r, const SDL_Rect &area)
+{
+    float sx = 1.0f, sy = 1.0f;
+    SDL_RenderGetScale(r, &sx, &sy);
+    return (area.w * sx > STAGE_WIDTH * 1.25f) ? 2 : 1;
+}
+
+void stage_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const StageRects &rects, const Textures &tex)
+{
+    TRACE_ZONE("stage_draw");
+    // Everything that changes the stage marks its panel dirty, so a repaint clipped
+    // to somewhere else would only redraw the same image and then clip it all away
+    SDL_Rect clip;
+    if (g_stage_target && SDL_RenderIsClipEnabled(r))
+    {
+        SDL_RenderGetClipRect(r, &clip);
+        if (!SDL_HasIntersection(&clip, &rects.panel))
+            return;
+    }
+    set_color(r, COL_STAGE_BG);
+    rq_fill_rect(r, &rects.panel);
+
+    SDL_Texture *stage_tex = stage_render(r, font, state, tex, target_scale_for(r, rects.stage_area));
+    if (stage_tex)
+        rq_copy(r, stage_tex, NULL, &rects.stage_area);
+    else
+        draw_stage_base(r, state, rects.stage_area, rects.stage_area.w, rects.stage_area.h);
+
+    set_color(r, COL_STAGE_BORDER);
+    rq_draw_rect(r, &rects.stage_area);
+}
+
+void stage_draw_player(SDL_Renderer *r, TTF_Font *font, const AppState &state, const StageRects &rects, const Textures &tex)
+{
+    TRACE_ZONE("stage_draw");
+    rq_set_color(r, 0, 0, 0, 255);
+    rq_fill_rect(r, &rects.panel);
+
+    SDL_Texture *stage_tex = stage_render(r, font, state, tex, target_scale_for(r, rects.stage_area));
+    if (stage_tex)
+        rq_copy(r, stage_tex, NULL, &rects.stage_area);
+    else
+        draw_stage_base(r, state, rects.stage_area, rects.stage_area.w, rects.stage_area.h);
 }
 
 bool stage_handle_event(const SDL_Event &e, AppState &state, const StageRects &rects, const Textures &tex)
@@ -260,12 +508,11 @@ bool stage_handle_event(const SDL_Event &e, AppState &state, const StageRects &r
         if (point_in_rect(mx, my, rects.stage_area))
         {
             // ---> HIT TEST BACKWARDS (BASED ON LAYER ORDER) <---
-            std::vector<int> sorted_indices;
-            for (int i = 0; i < (int)state.sprites.size(); i++)
-                sorted_indices.push_back(i);
-            std::stable_sort(sorted_indices.begin(), sorted_indices.end(), [&](int a, int b)
-                             { return state.sprites[a].layer_order < state.sprites[b].layer_order; });
-
+            float sx, sy;
+            stage_window_to_stage(rects, mx, my, sx, sy);
+            int px = (int)std::floor(STAGE_WIDTH / 2.0f + sx);
+            int py = (int)std::floor(STAGE_HEIGHT / 2.0f - sy);
+            const std::vector<int> &sorted_indices = stage_layers(state);
             for (int i = (int)sorted_indices.size() - 1; i >= 0; i--)
             {
                 int idx = sorted_indices[i];
@@ -273,40 +520,14 @@ bool stage_handle_event(const SDL_Event &e, AppState &state, const StageRects &r
                 if (!spr.visible)
                     continue;
 
-                int cx = rects.stage_area.x + rects.stage_area.w / 2 + spr.x;
-                int cy = rects.stage_area.y + rects.stage_area.h / 2 - spr.y;
-                int tex_w = 100, tex_h = 100;
-                if (spr.texture)
-                    SDL_QueryTexture(spr.texture, NULL, NULL, &tex_w, &tex_h);
-
-                int base_w = tex_w;
-                int base_h = tex_h;
-                int MAX_DEFAULT = 120;
-                if (base_w > MAX_DEFAULT || base_h > MAX_DEFAULT)
-                {
-                    if (base_w > base_h)
-                    {
-                        base_h = (base_h * MAX_DEFAULT) / base_w;
-                        base_w = MAX_DEFAULT;
-                    }
-                    else
-                    {
-                        base_w = (base_w * MAX_DEFAULT) / base_h;
-                        base_h = MAX_DEFAULT;
-                    }
-                }
-                int w = (base_w * spr.size) / 100;
-                int h = (base_h * spr.size) / 100;
-                SDL_Rect sprite_rect = {cx - w / 2, cy - h / 2, w, h};
-
-                if (point_in_rect(mx, my, sprite_rect))
+                if (point_in_rect(px, py, stage_sprite_rect(spr)))
                 {
                     state.selected_sprite = idx; // Set correct array index!
                     if (spr.draggable)
                     {
                         state.stage_drag_active = true;
-                        state.stage_drag_off_x = mx - cx;
-                        state.stage_drag_off_y = my - cy;
+                        state.stage_drag_off_x = (int)std::lround(sx) - spr.x;
+                        state.stage_drag_off_y = (int)std::lround(sy) - spr.y;
                     }
                     interpreter_trigger_sprite_click(state);
                     return true;
@@ -318,10 +539,10 @@ bool stage_handle_event(const SDL_Event &e, AppState &state, const StageRects &r
     {
         if (state.stage_drag_active && state.selected_sprite >= 0 && state.selected_sprite < (int)state.sprites.size())
         {
-            int cx = e.motion.x - state.stage_drag_off_x;
-            int cy = e.motion.y - state.stage_drag_off_y;
-            state.sprites[state.selected_sprite].x = cx - (rects.stage_area.x + rects.stage_area.w / 2);
-            state.sprites[state.selected_sprite].y = (rects.stage_area.y + rects.stage_area.h / 2) - cy;
+            float sx, sy;
+            stage_window_to_stage(rects, e.motion.x, e.motion.y, sx, sy);
+            state.sprites[state.selected_sprite].x = (int)std::lround(sx) - state.stage_drag_off_x;
+            state.sprites[state.selected_sprite].y = (int)std::lround(sy) - state.stage_drag_off_y;
             return true;
         }
     }
@@ -12,9 +12,43 @@ struct StageRects {
 };
 
 void stage_layout(StageRects &rects);
+/* Player mode: the whole window, with the stage as large as fits at 4:3 */
+void stage_layout_player(StageRects &rects);
+/* Recomposes the selected costumes and backdrop where they changed */
+void stage_update_textures(SDL_Renderer *r, TTF_Font *font, AppState &state);
+/* Renders the stage into its offscreen target (STAGE_WIDTH x STAGE_HEIGHT times scale) and returns it */
+SDL_Texture *stage_render(SDL_Renderer *r, TTF_Font *font, const AppState &state, const Textures &tex, int scale);
+/* The image from the last stage_render, or NULL */
+SDL_Texture *stage_texture();
+void stage_shutdown();
+/* Renders the stage and shows it in rects.stage_area */
 void stage_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state,
                 const StageRects &rects, const Textures &tex);
+/* Renders the stage letterboxed on black, for player mode */
+void stage_draw_player(SDL_Renderer *r, TTF_Font *font, const AppState &state,
+                       const StageRects &rects, const Textures &tex);
 bool stage_handle_event(const SDL_Event &e, AppState &state,
                         const StageRects &rects, const Textures &tex);
 
+/* Sprite bounds in stage pixels, (0,0) being the top-left of the stage */
+SDL_Rect stage_sprite_rect(const Sprite &spr);
+/* Window point to Scratch coordinates (origin at the centre, y up) */
+void stage_window_to_stage(const StageRects &rects, int wx, int wy, float &sx, float &sy);
+
+/* Remembers every sprite's pose; call right before each simulation step */
+void stage_save_poses(const AppState &state);
+/* Where drawing sits between the saved and current poses: 0 = saved, 1 = current */
+void stage_set_pose_alpha(float alpha);
+
+/* Sprite indices back to front */
+const std::vector<int> &stage_layers(const AppState &state);
+/* Layer rank of a sprite, 0 being the back */
+int stage_layer_rank(AppState &state, int sprite_idx);
+/* Moves a sprite to rank (clamped), shifting only the sprites it passes */
+void stage_layer_move(AppState &state, int sprite_idx, int rank);
+/* Takes a sprite out of the order; call right before erasing it from state.sprites */
+void stage_layer_remove(AppState &state, int sprite_idx);
+/* Empties the order; call when state.sprites is cleared */
+void stage_layers_clear(AppState &state);
+
 #endif
\ No newline at end of file
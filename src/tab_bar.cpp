@@ -2,6 +2,8 @@
 #include "config.h"
 #include "renderer.h"
 #include "interpreter.h"
+#include "text.h"
+#include "render_queue.h"
 #include <cstring>
 
 static bool point_in_rect(int px, int py, const SDL_Rect &r) { return px >= r.x && px < r.x + r.w && py >= r.y && py < r.y + r.h; }
@@ -10,7 +12,7 @@ static bool point_in_circle(int px, int py, int cx, int cy, int rad)
     int dx = px - cx, dy = py - cy;
     return (dx * dx + dy * dy) <= (rad * rad);
 }
-static void set_color(SDL_Renderer *r, Color c) { SDL_SetRenderDrawColor(r, c.r, c.g, c.b, 255); }
+static void set_color(SDL_Renderer *r, Color c) { rq_set_color(r, c.r, c.g, c.b, 255); }
 
 static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt, int x, int y, Color c)
 {
@@ -20,14 +22,7 @@ static void draw_text(SDL_Renderer *r, TTF_Font *f, const char *txt, int x, int
     sc.b = (Uint8)c.b;
     sc.a = 255;
 
-    SDL_Surface *s = TTF_RenderUTF8_Blended(f, txt, sc);
-    if (!s)
-        return;
-    SDL_Texture *t = SDL_CreateTextureFromSurface(r, s);
-    SDL_Rect dst = {x, y, s->w, s->h};
-    SDL_RenderCopy(r, t, NULL, &dst);
-    SDL_DestroyTexture(t);
-    SDL_FreeSurface(s);
+    text_draw(r, f, txt, x, y, sc);
 }
 
 void tab_bar_layout(TabBarRects &rects)
@@ -54,14 +49,15 @@ void tab_bar_layout(TabBarRects &rects)
     int cy = y + TAB_BAR_HEIGHT / 2;
     rects.start_btn = {btn_area_x, cy - START_BTN_RADIUS, START_BTN_RADIUS * 2, START_BTN_RADIUS * 2};
     rects.stop_btn = {btn_area_x + START_BTN_RADIUS * 2 + 10, cy - STOP_BTN_RADIUS, STOP_BTN_RADIUS * 2, STOP_BTN_RADIUS * 2};
+    rects.player_btn = {btn_area_x - 40, cy - 12, 24, 24};
 }
 
 void tab_bar_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const TabBarRects &rects, const Textures &tex)
 {
     set_color(r, COL_TAB_BAR_BG);
-    SDL_RenderFillRect(r, &rects.bar);
+    rq_fill_rect(r, &rects.bar);
     set_color(r, COL_SEPARATOR);
-    SDL_RenderDrawLine(r, rects.bar.x, rects.bar.y + rects.bar.h - 1, rects.bar.x + rects.bar.w, rects.bar.y + rects.bar.h - 1);
+    rq_draw_line(r, rects.bar.x, rects.bar.y + rects.bar.h - 1, rects.bar.x + rects.bar.w, rects.bar.y + rects.bar.h - 1);
 
     const char *labels[3] = {"Code", state.editing_target_is_stage ? "Backdrops" : "Costumes", "Sounds"};
 
@@ -76,10 +72,10 @@ void tab_bar_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const
         if (active)
         {
             set_color(r, COL_TAB_ACTIVE_BG);
-            SDL_RenderFillRect(r, &rects.tabs[i]);
-            SDL_SetRenderDrawColor(r, 95, 149, 247, 255);
+            rq_fill_rect(r, &rects.tabs[i]);
+            rq_set_color(r, 95, 149, 247, 255);
             SDL_Rect ul = {rects.tabs[i].x, rects.tabs[i].y + rects.tabs[i].h - 3, rects.tabs[i].w, 3};
-            SDL_RenderFillRect(r, &ul);
+            rq_fill_rect(r, &ul);
         }
 
         // ---> FIXED: Always use the brush icon (like real Scratch) to prevent loading breaks <---
@@ -122,7 +118,21 @@ void tab_bar_draw(SDL_Renderer *r, TTF_Font *font, const AppState &state, const
         set_color(r, COL_WHITE);
         int half = STOP_BTN_RADIUS / 2;
         SDL_Rect sq = {cx - half, cy - half, half * 2, half * 2};
-        SDL_RenderFillRect(r, &sq);
+        rq_fill_rect(r, &sq);
+    }
+
+    // Player mode toggle: four corner brackets
+    const SDL_Rect &pb = rects.player_btn;
+    set_color(r, COL_TAB_INACTIVE_TEXT);
+    int arm = 7;
+    for (int i = 0; i < 4; ++i)
+    {
+        int x = (i & 1) ? pb.x + pb.w - 1 : pb.x;
+        int y = (i & 2) ? pb.y + pb.h - 1 : pb.y;
+        int dx = (i & 1) ? -arm : arm;
+        int dy = (i & 2) ? -arm : arm;
+        rq_draw_line(r, x, y, x + dx, y);
+        rq_draw_line(r, x, y, x, y + dy);
     }
 }
 
@@ -160,6 +170,11 @@ bool tab_bar_handle_event(const SDL_Event &e, AppState &state, const TabBarRects
             interpreter_stop_all(state);
             return true;
         }
+        if (point_in_rect(mx, my, rects.player_btn))
+        {
+            state.player_mode = true;
+            return true;
+        }
         if (point_in_rect(mx, my, rects.bar))
             return true;
     }
@@ -12,6 +12,7 @@ struct TabBarRects {
     SDL_Rect tab_icons[3];
     SDL_Rect start_btn;
     SDL_Rect stop_btn;
+    SDL_Rect player_btn;
 };
 
 void tab_bar_layout(TabBarRects &rects);
@@ -0,0 +1,297 @@
+#include "text.h"
+#include "render_queue.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+static const int ATLAS_SIZE = 1024;
+static const size_t LAYOUT_CACHE_MAX = 4096;
+
+struct Glyph
+{
+    SDL_Rect src; // in the atlas; w == 0 for blank glyphs
+};
+
+struct TextLayout
+{
+    std::vector<Uint32> cps;
+    std::vector<int> xs; // pen x of each glyph
+    int w, h;
+};
+
+struct FontAtlas
+{
+    SDL_Renderer *renderer;
+    SDL_Texture *texture;
+    int shelf_x, shelf_y, shelf_h;
+    std::unordered_map<Uint32, Glyph> glyphs;
+    std::unordered_map<std::string, TextLayout> layouts;
+};
+
+static std::unordered_map<TTF_Font *, FontAtlas *> g_atlases;
+static std::vector<SDL_Vertex> g_verts;
+static std::vector<int> g_indices;
+// While batching, quads of every string are kept and drawn per atlas texture
+static bool g_batching = false;
+static SDL_Renderer *g_batch_renderer = nullptr;
+static SDL_Texture *g_batch_texture = nullptr;
+
+static void flush_batch()
+{
+    if (g_batch_renderer && g_batch_texture && !g_indices.empty())
+        rq_geometry(g_batch_renderer, g_batch_texture, g_verts.data(), (int)g_verts.size(), g_indices.data(), (int)g_indices.size());
+    g_verts.clear();
+    g_indices.clear();
+}
+
+static FontAtlas *atlas_for(TTF_Font *font)
+{
+    auto it = g_atlases.find(font);
+    if (it != g_atlases.end())
+        return it->second;
+    FontAtlas *a = new FontAtlas();
+    a->renderer = nullptr;
+    a->texture = nullptr;
+    a->shelf_x = a->shelf_y = a->shelf_h = 0;
+    g_atlases[font] = a;
+    return a;
+}
+
+// Decodes one UTF-8 sequence; malformed bytes come back as U+FFFD
+static Uint32 next_codepoint(const unsigned char *&s)
+{
+    Uint32 c = *s++;
+    int extra = 0;
+    if (c >= 0xF0)
+        c &= 0x07, extra = 3;
+    else if (c >= 0xE0)
+        c &= 0x0F, extra = 2;
+    else if (c >= 0xC0)
+        c &= 0x1F, extra = 1;
+    else if (c >= 0x80)
+        return 0xFFFD;
+    while (extra-- > 0)
+    {
+        if ((*s & 0xC0) != 0x80)
+            return 0xFFFD;
+        c = (c << 6) | (*s++ & 0x3F);
+    }
+    return c;
+}
+
+static const TextLayout &layout_for(FontAtlas *a, TTF_Font *font, const char *txt)
+{
+    auto it = a->layouts.find(txt);
+    if (it != a->layouts.end())
+        return it->second;
+    if (a->layouts.size() >= LAYOUT_CACHE_MAX)
+        a->layouts.clear();
+
+    TextLayout l;
+    int pen = 0;
+    Uint32 prev = 0;
+    const unsigned char *s = (const unsigned char *)txt;
+    while (*s)
+    {
+        Uint32 cp = next_codepoint(s);
+        if (prev)
+            pen += TTF_GetFontKerningSizeGlyphs32(font, prev, cp);
+        int advance = 0;
+        if (TTF_GlyphMetrics32(font, cp, nullptr, nullptr, nullptr, nullptr, &advance) != 0)
+            advance = 0;
+        l.cps.push_back(cp);
+        l.xs.push_back(pen);
+        pen += advance;
+        prev = cp;
+    }
+    // Report the same box TTF would have rendered
+    l.w = pen;
+    l.h = TTF_FontHeight(font);
+    TTF_SizeUTF8(font, txt, &l.w, &l.h);
+    return a->layouts.emplace(txt, std::move(l)).first->second;
+}
+
+static bool atlas_ensure_texture(FontAtlas *a, SDL_Renderer *r)
+{
+    if (a->texture && a->renderer == r)
+        return true;
+    if (a->texture)
+        SDL_DestroyTexture(a->texture);
+    a->glyphs.clear();
+    a->shelf_x = a->shelf_y = a->shelf_h = 0;
+    a->renderer = r;
+    a->texture = SDL_CreateTexture(r, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, ATLAS_SIZE, ATLAS_SIZE);
+    if (!a->texture)
+    {
+        SDL_Log("Text atlas creation failed: %s", SDL_GetError());
+        return false;
+    }
+    SDL_SetTextureBlendMode(a->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+static const Glyph &atlas_glyph(FontAtlas *a, TTF_Font *font, Uint32 cp)
+{
+    auto it = a->glyphs.find(cp);
+    if (it != a->glyphs.end())
+        return it->second;
+
+    Glyph g = {{0, 0, 0, 0}};
+    SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface *raw = TTF_RenderGlyph32_Blended(font, cp, white);
+    SDL_Surface *surf = raw ? SDL_ConvertSurfaceFormat(raw, SDL_PIXELFORMAT_ARGB8888, 0) : nullptr;
+    if (raw)
+        SDL_FreeSurface(raw);
+    if (surf && surf->w > 0 && surf->h > 0 && surf->w < ATLAS_SIZE && surf->h < ATLAS_SIZE)
+    {
+        if (a->shelf_x + surf->w > ATLAS_SIZE)
+        {
+            a->shelf_x = 0;
+            a->shelf_y += a->shelf_h + 1;
+            a->shelf_h = 0;
+        }
+        if (a->shelf_y + surf->h > ATLAS_SIZE)
+        {
+            // Full: start over, glyphs get re-rasterized as they are drawn.
+            // Quads already queued still point at the old glyphs, so they go out first,
+            // including those of the string being drawn right now.
+            if (g_batching)
+                flush_batch();
+            else if (!g_verts.empty())
+            {
+                rq_geometry(a->renderer, a->texture, g_verts.data(), (int)g_verts.size(), g_indices.data(), (int)g_indices.size());
+                g_verts.clear();
+                g_indices.clear();
+            }
+            render_queue_flush(a->renderer);
+            a->glyphs.clear();
+            a->shelf_x = a->shelf_y = a->shelf_h = 0;
+        }
+        g.src = {a->shelf_x, a->shelf_y, surf->w, surf->h};
+        SDL_UpdateTexture(a->texture, &g.src, surf->pixels, surf->pitch);
+        a->shelf_x += surf->w + 1;
+        if (surf->h > a->shelf_h)
+            a->shelf_h = surf->h;
+    }
+    if (surf)
+        SDL_FreeSurface(surf);
+    return a->glyphs.emplace(cp, g).first->second;
+}
+
+static int text_draw_impl(SDL_Renderer *r, TTF_Font *font, const char *txt, int x, int y, int max_w, SDL_Color c)
+{
+    if (!r || !font || !txt || !txt[0])
+        return 0;
+    FontAtlas *a = atlas_for(font);
+    if (!atlas_ensure_texture(a, r))
+        return 0;
+    const TextLayout &l = layout_for(a, font, txt);
+
+    if (g_batching && (g_batch_texture != a->texture || g_batch_renderer != r))
+        flush_batch();
+    if (g_batching)
+    {
+        g_batch_renderer = r;
+        g_batch_texture = a->texture;
+    }
+    else
+    {
+        g_verts.clear();
+        g_indices.clear();
+    }
+    const float inv = 1.0f / ATLAS_SIZE;
+    for (size_t i = 0; i < l.cps.size(); i++)
+    {
+        const Glyph &g = atlas_glyph(a, font, l.cps[i]);
+        if (g.src.w == 0)
+            continue;
+        int gx = l.xs[i], gw = g.src.w;
+        if (max_w >= 0)
+        {
+            if (gx >= max_w)
+                break;
+            if (gx + gw > max_w)
+                gw = max_w - gx;
+        }
+
+        float x0 = (float)(x + gx), y0 = (float)y;
+        float x1 = x0 + gw, y1 = y0 + g.src.h;
+        float u0 = g.src.x * inv, v0 = g.src.y * inv;
+        float u1 = (g.src.x + gw) * inv, v1 = (g.src.y + g.src.h) * inv;
+        int base = (int)g_verts.size();
+        g_verts.push_back({{x0, y0}, c, {u0, v0}});
+        g_verts.push_back({{x1, y0}, c, {u1, v0}});
+        g_verts.push_back({{x1, y1}, c, {u1, v1}});
+        g_verts.push_back({{x0, y1}, c, {u0, v1}});
+        const int quad[6] = {0, 1, 2, 0, 2, 3};
+        for (int k : quad)
+            g_indices.push_back(base + k);
+    }
+    if (!g_batching && !g_verts.empty())
+        rq_geometry(r, a->texture, g_verts.data(), (int)g_verts.size(), g_indices.data(), (int)g_indices.size());
+    return (max_w >= 0 && l.w > max_w) ? max_w : l.w;
+}
+
+int text_draw(SDL_Renderer *r, TTF_Font *font, const char *txt, int x, int y, SDL_Color c)
+{
+    return text_draw_impl(r, font, txt, x, y, -1, c);
+}
+
+int text_draw_clipped(SDL_Renderer *r, TTF_Font *font, const char *txt, int x, int y, int max_w, SDL_Color c)
+{
+    return text_draw_impl(r, font, txt, x, y, max_w < 0 ? 0 : max_w, c);
+}
+
+void text_size(TTF_Font *font, const char *txt, int *w, int *h)
+{
+    int lw = 0, lh = 0;
+    if (font && txt && txt[0])
+    {
+        const TextLayout &l = layout_for(atlas_for(font), font, txt);
+        lw = l.w;
+        lh = l.h;
+    }
+    else if (font)
+        lh = TTF_FontHeight(font);
+    if (w)
+        *w = lw;
+    if (h)
+        *h = lh;
+}
+
+void text_begin_batch()
+{
+    g_batching = true;
+    g_batch_renderer = nullptr;
+    g_batch_texture = nullptr;
+    g_verts.clear();
+    g_indices.clear();
+}
+
+void text_end_batch()
+{
+    flush_batch();
+    g_batching = false;
+    g_batch_renderer = nullptr;
+    g_batch_texture = nullptr;
+}
+
+size_t text_atlas_bytes()
+{
+    size_t bytes = 0;
+    for (const auto &kv : g_atlases)
+        if (kv.second->texture)
+            bytes += (size_t)ATLAS_SIZE * ATLAS_SIZE * 4;
+    return bytes;
+}
+
+void text_shutdown()
+{
+    for (auto &kv : g_atlases)
+    {
+        if (kv.second->texture)
+            SDL_DestroyTexture(kv.second->texture);
+        delete kv.second;
+    }
+    g_atlases.clear();
+}
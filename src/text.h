@@ -0,0 +1,29 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+
+// ---> CACHED TEXT <---
+// Each TTF_Font gets one glyph atlas texture. A string is laid out once
+// (codepoints + pen positions) and cached; drawing it is then a single
+// SDL_RenderGeometry call of textured quads tinted by the vertex colour.
+
+/* Draws txt with its top-left at (x, y); returns the width drawn */
+int text_draw(SDL_Renderer *r, TTF_Font *font, const char *txt, int x, int y, SDL_Color c);
+/* Same, but glyphs past x + max_w are cut off */
+int text_draw_clipped(SDL_Renderer *r, TTF_Font *font, const char *txt, int x, int y, int max_w, SDL_Color c);
+/* Cached layout size (w or h may be NULL) */
+void text_size(TTF_Font *font, const char *txt, int *w, int *h);
+
+/* Between these, strings are collected and drawn with one call per font */
+void text_begin_batch();
+void text_end_batch();
+
+/* Bytes held by the glyph atlases */
+size_t text_atlas_bytes();
+
+/* Frees every atlas; call before the fonts are closed */
+void text_shutdown();
+
+#endif
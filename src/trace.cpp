@@ -0,0 +1,167 @@
+#include "trace.h"
+
+#ifdef TRACE_ENABLED
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+static const Uint32 RING_SIZE = 16384; // zones kept per thread; older ones are overwritten
+
+struct TraceEvent
+{
+    const char *name;
+    char detail[24];
+    Uint64 start, end;
+};
+
+/* seq is the zone's number + 1 once the event is complete, 0 while it is being written */
+struct TraceSlot
+{
+    std::atomic<Uint32> seq;
+    TraceEvent ev;
+};
+
+struct TraceRing
+{
+    SDL_threadID tid;
+    const char *name;
+    std::atomic<Uint32> head; // zones ever written; only the owning thread stores to it
+    TraceRing *next;
+    TraceSlot slots[RING_SIZE];
+};
+
+static std::atomic<TraceRing *> g_rings(nullptr); // push-only list, read by trace_export
+static thread_local TraceRing *t_ring = nullptr;
+
+static TraceRing *thread_ring()
+{
+    if (t_ring)
+        return t_ring;
+    TraceRing *ring = new TraceRing();
+    ring->tid = SDL_ThreadID();
+    ring->name = nullptr;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->next = g_rings.load(std::memory_order_relaxed);
+    while (!g_rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    t_ring = ring;
+    return ring;
+}
+
+TraceZone::TraceZone(const char *zone_name, const char *zone_detail)
+    : name(zone_name), start(SDL_GetPerformanceCounter()), open(true)
+{
+    detail[0] = '\0';
+    if (zone_detail)
+    {
+        std::strncpy(detail, zone_detail, sizeof(detail) - 1);
+        detail[sizeof(detail) - 1] = '\0';
+    }
+}
+
+void TraceZone::end()
+{
+    if (!open)
+        return;
+    open = false;
+    TraceRing *ring = thread_ring();
+    Uint32 h = ring->head.load(std::memory_order_relaxed);
+    TraceSlot &slot = ring->slots[h % RING_SIZE];
+    // A reader that sees 0, or sees the number change under it, drops the slot
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.ev.name = name;
+    std::memcpy(slot.ev.detail, detail, sizeof(detail));
+    slot.ev.start = start;
+    slot.ev.end = SDL_GetPerformanceCounter();
+    slot.seq.store(h + 1, std::memory_order_release);
+    ring->head.store(h + 1, std::memory_order_release);
+}
+
+void trace_thread_name(const char *name)
+{
+    thread_ring()->name = name;
+}
+
+// ---> EXPORT <---
+static void write_json_string(FILE *f, const char *s)
+{
+    std::fputc('"', f);
+    for (; *s; s++)
+    {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+            std::fprintf(f, "\\%c", c);
+        else if (c < 0x20)
+            std::fprintf(f, "\\u%04x", c);
+        else
+            std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+bool trace_export(const char *path)
+{
+    FILE *f = std::fopen(path, "w");
+    if (!f)
+    {
+        SDL_Log("Trace: cannot open %s", path);
+        return false;
+    }
+    const double us_per_tick = 1e6 / (double)SDL_GetPerformanceFrequency();
+    std::fprintf(f, "{\"traceEvents\":[\n");
+    bool first = true;
+    int written = 0;
+    std::vector<TraceEvent> copy;
+    for (TraceRing *ring = g_rings.load(std::memory_order_acquire); ring; ring = ring->next)
+    {
+        // Keep a slot only if it held the expected zone, complete, before and after the copy
+        Uint32 head = ring->head.load(std::memory_order_acquire);
+        Uint32 count = std::min(head, RING_SIZE);
+        copy.clear();
+        for (Uint32 n = head - count; n != head; n++)
+        {
+            const TraceSlot &slot = ring->slots[n % RING_SIZE];
+            if (slot.seq.load(std::memory_order_acquire) != n + 1)
+                continue;
+            TraceEvent ev = slot.ev;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == n + 1)
+                copy.push_back(ev);
+        }
+
+        std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":",
+                     first ? "" : ",\n", (unsigned long)ring->tid);
+        char fallback[32];
+        std::snprintf(fallback, sizeof(fallback), "thread %lu", (unsigned long)ring->tid);
+        write_json_string(f, ring->name ? ring->name : fallback);
+        std::fprintf(f, "}}");
+        first = false;
+
+        for (const TraceEvent &ev : copy)
+        {
+            std::fprintf(f, ",\n{\"name\":");
+            write_json_string(f, ev.name);
+            std::fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f", (unsigned long)ring->tid,
+                         ev.start * us_per_tick, (ev.end - ev.start) * us_per_tick);
+            if (ev.detail[0])
+            {
+                std::fprintf(f, ",\"args\":{\"detail\":");
+                write_json_string(f, ev.detail);
+                std::fprintf(f, "}");
+            }
+            std::fprintf(f, "}");
+            written++;
+        }
+    }
+    std::fprintf(f, "\n]}\n");
+    bool ok = std::fclose(f) == 0;
+    SDL_Log("Trace: %d zones written to %s", written, path);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// ---> FRAME TRACE ZONES <---
+// Built with `make TRACE=1` (TRACE_ENABLED), TRACE_ZONE("name") times the rest of
+// the enclosing scope. The zone goes into a fixed ring of the calling thread: one
+// writer per ring and no locks. trace_export writes every ring as Chrome trace-event
+// JSON, which chrome://tracing and Perfetto can open. Without TRACE_ENABLED the
+// macros expand to nothing and trace.cpp compiles to an empty unit.
+
+#ifdef TRACE_ENABLED
+
+#include "SDL.h"
+
+struct TraceZone
+{
+    const char *name;
+    char detail[24]; // copied, so the zone may outlive whatever it names
+    Uint64 start;
+    bool open;
+
+    explicit TraceZone(const char *zone_name, const char *zone_detail = nullptr);
+    ~TraceZone() { end(); }
+    void end();
+};
+
+/* Names the calling thread in exported traces; name must outlive the program */
+void trace_thread_name(const char *name);
+/* Writes every thread's recent zones to path; false if the file could not be written */
+bool trace_export(const char *path);
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_JOIN(trace_zone_, __LINE__)(name)
+#define TRACE_ZONE_DETAIL(name, detail) TraceZone TRACE_JOIN(trace_zone_, __LINE__)(name, detail)
+/* For phases that do not match a scope: the zone ends at TRACE_ZONE_END or with the scope */
+#define TRACE_ZONE_BEGIN(var, name) TraceZone var(name)
+#define TRACE_ZONE_END(var) var.end()
+#define TRACE_THREAD_NAME(name) trace_thread_name(name)
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_ZONE_DETAIL(name, detail) ((void)0)
+#define TRACE_ZONE_BEGIN(var, name) ((void)0)
+#define TRACE_ZONE_END(var) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
+
+#endif
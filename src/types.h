@@ -291,18 +291,26 @@ struct GraphicShape
     std::string text;
 };
 
+struct PaintLayer;
+
 struct GraphicItem
 {
     std::string name;
     std::string source_path;
     SDL_Texture *original_texture;
     SDL_Texture *texture;
-    SDL_Texture *paint_layer;
+    PaintLayer *paint_layer; // sparse tiles, see paint_layer.h
     std::vector<GraphicShape> shapes;
     SDL_Texture *composed_texture;
+    std::vector<SDL_Texture *> mips; // composed_texture at 1/2, 1/4, 1/8, 1/16; ~1/3 of its memory again
     bool flip_h;
     bool flip_v;
-    GraphicItem(std::string n, SDL_Texture *t, std::string sp = "") : name(n), source_path(sp), original_texture(t), texture(t), paint_layer(nullptr), composed_texture(nullptr), flip_h(false), flip_v(false) {}
+    // Bumped on every edit; composition only reruns when it differs from composed_version
+    unsigned int version;
+    unsigned int composed_version;
+    // Unique per composition run (never reused), so caches can key on it
+    unsigned int composed_serial;
+    GraphicItem(std::string n, SDL_Texture *t, std::string sp = "") : name(n), source_path(sp), original_texture(t), texture(t), paint_layer(nullptr), composed_texture(nullptr), flip_h(false), flip_v(false), version(1), composed_version(0), composed_serial(0) {}
 };
 
 typedef GraphicItem Costume;
@@ -318,6 +326,25 @@ struct SoundData
     SoundData(std::string n, Mix_Chunk *c, std::string sp = "") : name(n), source_path(sp), chunk(c), volume(100), prev_volume(100) {}
 };
 
+// Uniform grid over the workspace rects of one sprite's blocks, plus an
+// id -> slot map for O(1) lookups. Owned and kept current by workspace.cpp.
+struct BlockIndex
+{
+    mutable std::unordered_map<int, int> slot;          // block id -> index in Sprite::blocks
+    std::unordered_map<int, SDL_Rect> rects;            // block id -> rect as last indexed
+    std::unordered_map<Sint64, std::vector<int>> cells; // grid cell -> block ids
+    Uint64 context = 0;                                 // dropdown names the rects were measured with
+    bool valid = false;
+};
+
+// Sprite indices in draw order, back to front. The first `ranked` sprites have
+// layer_order equal to their rank here. Owned and kept current by stage.cpp.
+struct SpriteLayers
+{
+    mutable std::vector<int> order;
+    mutable size_t ranked = 0;
+};
+
 struct Sprite
 {
     std::string name;
@@ -347,16 +374,25 @@ struct Sprite
 
     std::vector<BlockInstance> blocks;
     std::vector<int> top_level_blocks;
+    BlockIndex block_index;
+    unsigned int blocks_version; // new value on every edit of blocks; see workspace_blocks_changed
 
-    Sprite(std::string n, SDL_Texture *tex, std::string sp = "") : name(n), x(0), y(0), direction(90), visible(true), size(100), say_text(""), is_thinking(false), say_end_time(0), volume(100), draggable(true), layer_order(get_next_layer()), texture(tex), selected_sound(0), selected_costume(0), pen_down(false), pen_size(1), pen_color({15, 189, 140, 255}), pen_color_val(45), pen_saturation(92), pen_brightness(74)
+    Sprite(std::string n, SDL_Texture *tex, std::string sp = "") : name(n), x(0), y(0), direction(90), visible(true), size(100), say_text(""), is_thinking(false), say_end_time(0), volume(100), draggable(true), layer_order(get_next_layer()), texture(tex), selected_sound(0), selected_costume(0), pen_down(false), pen_size(1), pen_color({15, 189, 140, 255}), pen_color_val(45), pen_saturation(92), pen_brightness(74), blocks_version(next_blocks_version())
     {
         costumes.push_back(Costume(n, tex, sp));
     }
+    // Always above every current layer_order (those are ranks once the stage has synced)
     static int get_next_layer()
     {
         static int l = 0;
         return l++;
     }
+    // Unique across sprites, so equal versions mean the same blocks
+    static unsigned int next_blocks_version()
+    {
+        static unsigned int v = 0;
+        return ++v;
+    }
 };
 
 struct AppState
@@ -367,7 +403,9 @@ struct AppState
     Tab current_tab;
     bool start_hover, stop_hover, running;
     AppMode mode;
+    bool player_mode; // stage only, filling the window; editor UI is neither drawn nor handled
     std::vector<Sprite> sprites;
+    SpriteLayers sprite_layers;
     int selected_sprite;
     bool add_sprite_hover;
     std::vector<Backdrop> backdrops;
@@ -388,7 +426,7 @@ struct AppState
     bool msg_modal_active;
 
     bool stage_drag_active;
-    int stage_drag_off_x, stage_drag_off_y;
+    int stage_drag_off_x, stage_drag_off_y; // grab point relative to the sprite, Scratch units
     bool ask_active;
     std::string ask_msg;
     std::string ask_reply;
@@ -409,6 +447,7 @@ struct AppState
     SDL_Color active_color;
     int active_shape_index;
     bool trigger_costume_import;
+    int fill_tolerance; // per-channel colour distance for the bitmap fill, 0..255
     bool new_confirm_active;
 
     // --- Block execution highlight ---
@@ -416,8 +455,12 @@ struct AppState
     int exec_highlight_type; // 0 = Black (Normal), 1 = Yellow (Warning), 2 = Red (Error)
     Uint32 exec_highlight_timer;
 
-    AppState() : file_menu_open(false), file_menu_hover(-1), sprite_menu_open(false), backdrop_menu_open(false), current_tab(TAB_CODE), start_hover(false), stop_hover(false), running(false), mode(MODE_EDITOR), selected_sprite(0), add_sprite_hover(false), selected_backdrop(0), selected_tab(TAB_CODE), selected_category(0), project_name("Untitled"), drag(), next_block_id(1), active_input(INPUT_NONE), input_buffer(""), block_input(), variables({"my variable"}), variable_values({{"my variable", "0"}}), variable_visible({{"my variable", true}}), var_modal_active(false), messages({"message1"}), msg_modal_active(false), stage_drag_active(false), stage_drag_off_x(0), stage_drag_off_y(0), ask_active(false), ask_msg(""), ask_reply(""), global_answer(""), pen_extension_enabled(false), editing_target_is_stage(false), active_tool(TOOL_POINTER), active_color({0, 0, 0, 255}), active_shape_index(-1), trigger_costume_import(false),
-        func_modal_active(false), func_modal_step(0), func_modal_name(""), func_modal_params(), func_modal_param_type(0), func_modal_param_name(""), new_confirm_active(false) , exec_highlight_id(-1), exec_highlight_type(0), exec_highlight_timer(0) {}
+    // --- Code workspace camera: screen = (world - cam) * zoom ---
+    float ws_zoom;
+    float ws_cam_x, ws_cam_y;
+
+    AppState() : file_menu_open(false), file_menu_hover(-1), sprite_menu_open(false), backdrop_menu_open(false), current_tab(TAB_CODE), start_hover(false), stop_hover(false), running(false), mode(MODE_EDITOR), player_mode(false), selected_sprite(0), add_sprite_hover(false), selected_backdrop(0), selected_tab(TAB_CODE), selected_category(0), project_name("Untitled"), drag(), next_block_id(1), active_input(INPUT_NONE), input_buffer(""), block_input(), variables({"my variable"}), variable_values({{"my variable", "0"}}), variable_visible({{"my variable", true}}), var_modal_active(false), messages({"message1"}), msg_modal_active(false), stage_drag_active(false), stage_drag_off_x(0), stage_drag_off_y(0), ask_active(false), ask_msg(""), ask_reply(""), global_answer(""), pen_extension_enabled(false), editing_target_is_stage(false), active_tool(TOOL_POINTER), active_color({0, 0, 0, 255}), active_shape_index(-1), trigger_costume_import(false), fill_tolerance(32),
+        func_modal_active(false), func_modal_step(0), func_modal_name(""), func_modal_params(), func_modal_param_type(0), func_modal_param_name(""), new_confirm_active(false) , exec_highlight_id(-1), exec_highlight_type(0), exec_highlight_timer(0), ws_zoom(1.0f), ws_cam_x(0), ws_cam_y(0) {}
 };
 
 inline std::string copy_asset_to_project(std::string proj_name, std::string original_path)
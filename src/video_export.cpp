@@ -0,0 +1,309 @@
+#include "video_export.h"
+#include "SDL_image.h"
+#include "audio.h"
+#include "config.h"
+#include "interpreter.h"
+#include "renderer.h"
+#include "stage.h"
+#include "trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+struct ExportFrame
+{
+    int index;
+    int w, h;
+    std::vector<Uint8> rgba; // RGBA32 rows, read back from the stage target
+    std::vector<Uint8> yuv;  // I420, filled by a worker in YUV mode
+};
+
+static SDL_mutex *g_lock = nullptr;
+static SDL_cond *g_wake = nullptr; // jobs queued or quitting
+static SDL_cond *g_done = nullptr; // a frame finished
+static std::deque<ExportFrame *> g_jobs;
+static std::map<int, ExportFrame *> g_converted; // YUV frames waiting to be written in order
+static int g_in_flight = 0;                      // read back but not yet written
+static bool g_failed = false;
+static bool g_quit = false;
+static ExportOptions g_opt;
+
+// BT.601 limited range, chroma averaged over each 2x2 block
+static void rgba_to_i420(const ExportFrame &f, std::vector<Uint8> &out)
+{
+    int w = f.w, h = f.h, cw = w / 2, ch = h / 2;
+    out.resize(w * h + cw * ch * 2);
+    Uint8 *yp = out.data();
+    Uint8 *up = yp + w * h;
+    Uint8 *vp = up + cw * ch;
+    const Uint8 *src = f.rgba.data();
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+        {
+            const Uint8 *p = src + (y * w + x) * 4;
+            yp[y * w + x] = (Uint8)(16 + ((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8));
+        }
+    for (int y = 0; y < ch; y++)
+        for (int x = 0; x < cw; x++)
+        {
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; k++)
+            {
+                const Uint8 *p = src + ((y * 2 + k / 2) * w + x * 2 + k % 2) * 4;
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            r /= 4;
+            g /= 4;
+            b /= 4;
+            up[y * cw + x] = (Uint8)(128 + ((-38 * r - 74 * g + 112 * b + 128) >> 8));
+            vp[y * cw + x] = (Uint8)(128 + ((112 * r - 94 * g - 18 * b + 128) >> 8));
+        }
+}
+
+static bool write_png(const ExportFrame &f)
+{
+    SDL_Surface *surf = SDL_CreateRGBSurfaceWithFormatFrom((void *)f.rgba.data(), f.w, f.h, 32, f.w * 4, SDL_PIXELFORMAT_RGBA32);
+    if (!surf)
+    {
+        SDL_Log("Export: frame %d surface failed: %s", f.index, SDL_GetError());
+        return false;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "/frame_%05d.png", f.index);
+    std::string path = g_opt.out_dir + name;
+    int rc = IMG_SavePNG(surf, path.c_str());
+    SDL_FreeSurface(surf);
+    if (rc != 0)
+    {
+        SDL_Log("IMG_SavePNG failed for '%s': %s", path.c_str(), IMG_GetError());
+        return false;
+    }
+    return true;
+}
+
+// ---> WORKERS <---
+// PNG frames are independent files and are written by the worker itself;
+// YUV frames are converted here and appended to the stream by the main thread in order.
+static int export_worker(void *)
+{
+    TRACE_THREAD_NAME("video_export");
+    SDL_LockMutex(g_lock);
+    while (true)
+    {
+        if (g_jobs.empty())
+        {
+            if (g_quit)
+                break;
+            SDL_CondWait(g_wake, g_lock);
+            continue;
+        }
+        ExportFrame *f = g_jobs.front();
+        g_jobs.pop_front();
+        SDL_UnlockMutex(g_lock);
+
+        TRACE_ZONE_BEGIN(encode_zone, "encode frame");
+        bool ok = true;
+        if (g_opt.format == EXPORT_PNG)
+            ok = write_png(*f);
+        else
+        {
+            rgba_to_i420(*f, f->yuv);
+            f->rgba.clear();
+            f->rgba.shrink_to_fit();
+        }
+        TRACE_ZONE_END(encode_zone);
+
+        SDL_LockMutex(g_lock);
+        if (!ok)
+            g_failed = true;
+        if (g_opt.format == EXPORT_PNG)
+        {
+            delete f;
+            g_in_flight--;
+        }
+        else
+            g_converted[f->index] = f;
+        SDL_CondBroadcast(g_done);
+    }
+    SDL_UnlockMutex(g_lock);
+    return 0;
+}
+
+// Appends every converted frame that is next in order; call with g_lock held
+static void write_ready_yuv(FILE *out, int &next_index)
+{
+    auto it = g_converted.find(next_index);
+    while (it != g_converted.end())
+    {
+        ExportFrame *f = it->second;
+        g_converted.erase(it);
+        SDL_UnlockMutex(g_lock);
+        bool ok = std::fwrite(f->yuv.data(), 1, f->yuv.size(), out) == f->yuv.size();
+        delete f;
+        SDL_LockMutex(g_lock);
+        if (!ok)
+        {
+            SDL_Log("Export: writing frame %d to the YUV stream failed", next_index);
+            g_failed = true;
+        }
+        g_in_flight--;
+        it = g_converted.find(++next_index);
+    }
+}
+
+bool video_export_run(SDL_Renderer *r, TTF_Font *font, AppState &state, const Textures &tex, const ExportOptions &opt)
+{
+    if (!r || opt.out_dir.empty() || opt.fps <= 0 || opt.sim_hz <= 0 || opt.seconds <= 0)
+        return false;
+    g_opt = opt;
+    g_opt.scale = std::max(1, std::min(opt.scale, 2));
+
+    std::error_code ec;
+    std::filesystem::create_directories(g_opt.out_dir, ec);
+    FILE *yuv_out = nullptr;
+    if (g_opt.format == EXPORT_YUV)
+    {
+        std::string path = g_opt.out_dir + "/stage.yuv";
+        yuv_out = std::fopen(path.c_str(), "wb");
+        if (!yuv_out)
+        {
+            SDL_Log("Export: cannot open %s", path.c_str());
+            return false;
+        }
+    }
+
+    g_lock = SDL_CreateMutex();
+    g_wake = SDL_CreateCond();
+    g_done = SDL_CreateCond();
+    g_failed = false;
+    g_quit = false;
+    g_in_flight = 0;
+    int worker_count = opt.workers > 0 ? opt.workers : std::max(1, SDL_GetCPUCount() - 1);
+    worker_count = std::min(worker_count, 16);
+    std::vector<SDL_Thread *> workers;
+    if (g_lock && g_wake && g_done)
+        for (int i = 0; i < worker_count; i++)
+            if (SDL_Thread *t = SDL_CreateThread(export_worker, "export", nullptr))
+                workers.push_back(t);
+    if (workers.empty())
+    {
+        SDL_Log("Export: could not start workers: %s", SDL_GetError());
+        if (yuv_out)
+            std::fclose(yuv_out);
+        if (g_done)
+            SDL_DestroyCond(g_done);
+        if (g_wake)
+            SDL_DestroyCond(g_wake);
+        if (g_lock)
+            SDL_DestroyMutex(g_lock);
+        g_done = g_wake = nullptr;
+        g_lock = nullptr;
+        return false;
+    }
+    // Enough frames in flight to keep every worker busy without unbounded memory
+    const int max_in_flight = (int)workers.size() * 2;
+
+    StageRects rects;
+    stage_layout_player(rects);
+    audio_set_silent(true); // sounds would play at export speed; waits on them use the sim clock
+    stage_set_pose_alpha(1.0f);
+    SDL_SetRenderTarget(r, NULL);
+    interpreter_trigger_flag(state);
+
+    const double step_ms = 1000.0 / opt.sim_hz;
+    const double frame_ms = 1000.0 / opt.fps;
+    const int total = (int)(opt.seconds * opt.fps + 0.5);
+    const int w = STAGE_WIDTH * g_opt.scale, h = STAGE_HEIGHT * g_opt.scale;
+    int next_yuv = 0;
+    int steps = 0;
+    Uint32 started = SDL_GetTicks();
+    for (int i = 0; i < total && !g_failed; i++)
+    {
+        SDL_PumpEvents();
+        // Frame i shows the sim at (i + 1) frames in: every step due by then, maybe none
+        const double frame_end = (i + 1) * frame_ms;
+        while ((steps + 1) * step_ms <= frame_end + 1e-6)
+        {
+            interpreter_capture_input(rects);
+            interpreter_tick(state, step_ms);
+            steps++;
+        }
+        renderer_flush_pen_layer();
+        stage_update_textures(r, font, state);
+        SDL_Texture *stage_tex = stage_render(r, font, state, tex, g_opt.scale);
+        if (!stage_tex)
+        {
+            g_failed = true;
+            break;
+        }
+
+        ExportFrame *f = new ExportFrame();
+        f->index = i;
+        f->w = w;
+        f->h = h;
+        f->rgba.resize((size_t)w * h * 4);
+        SDL_SetRenderTarget(r, stage_tex);
+        int rc = SDL_RenderReadPixels(r, NULL, SDL_PIXELFORMAT_RGBA32, f->rgba.data(), w * 4);
+        SDL_SetRenderTarget(r, NULL);
+        if (rc != 0)
+        {
+            SDL_Log("Export: reading frame %d failed: %s", i, SDL_GetError());
+            delete f;
+            g_failed = true;
+            break;
+        }
+
+        SDL_LockMutex(g_lock);
+        while (g_in_flight >= max_in_flight && !g_failed)
+        {
+            if (yuv_out)
+                write_ready_yuv(yuv_out, next_yuv);
+            if (g_in_flight >= max_in_flight)
+                SDL_CondWait(g_done, g_lock);
+        }
+        g_jobs.push_back(f);
+        g_in_flight++;
+        SDL_CondSignal(g_wake);
+        SDL_UnlockMutex(g_lock);
+    }
+
+    // Drain: every queued frame gets written (or dropped after a failure) before the workers stop
+    SDL_LockMutex(g_lock);
+    while (g_in_flight > 0)
+    {
+        if (yuv_out)
+            write_ready_yuv(yuv_out, next_yuv);
+        if (g_in_flight > 0)
+            SDL_CondWait(g_done, g_lock);
+    }
+    g_quit = true;
+    SDL_CondBroadcast(g_wake);
+    SDL_UnlockMutex(g_lock);
+    for (SDL_Thread *t : workers)
+        SDL_WaitThread(t, nullptr);
+
+    bool ok = !g_failed;
+    if (yuv_out && std::fclose(yuv_out) != 0)
+        ok = false;
+    SDL_DestroyCond(g_done);
+    SDL_DestroyCond(g_wake);
+    SDL_DestroyMutex(g_lock);
+    g_done = g_wake = nullptr;
+    g_lock = nullptr;
+    interpreter_stop_all(state);
+    audio_set_silent(false);
+
+    double secs = (SDL_GetTicks() - started) / 1000.0;
+    SDL_Log("Export: %d frames (%.1f s of stage) in %.1f s using %d workers -> %s", total, opt.seconds, secs,
+            (int)workers.size(), g_opt.out_dir.c_str());
+    if (opt.fps != opt.sim_hz)
+        SDL_Log("Export: %d simulation steps at %d Hz for %d frames at %d fps", steps, opt.sim_hz, total, opt.fps);
+    if (ok && g_opt.format == EXPORT_YUV)
+        SDL_Log("Export: encode with ffmpeg -f rawvideo -pix_fmt yuv420p -s %dx%d -r %d -i stage.yuv out.mp4", w, h, opt.fps);
+    return ok;
+}
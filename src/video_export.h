@@ -0,0 +1,39 @@
+#ifndef VIDEO_EXPORT_H
+#define VIDEO_EXPORT_H
+
+#include "SDL.h"
+#include "SDL_ttf.h"
+#include "config.h"
+#include "types.h"
+#include "textures.h"
+#include <string>
+
+// ---> OFFSCREEN EXPORT <---
+// Runs the loaded project on the simulation clock with no real-time pacing: the
+// sim advances in fixed SIM_HZ steps and the stage is rendered offscreen every
+// 1/fps seconds of sim time, so fps only sets the frame rate of the video and
+// never the speed of the scripts. Frames are read back on the
+// render thread; worker threads convert and encode them into a PNG sequence
+// (frame_00000.png, ...) or one raw I420 stream (stage.yuv) for an encoder.
+
+enum ExportFormat
+{
+    EXPORT_PNG,
+    EXPORT_YUV
+};
+
+struct ExportOptions
+{
+    std::string out_dir;
+    double seconds = 10.0;
+    int fps = 30;
+    int sim_hz = SIM_HZ_DEFAULT; // simulation steps per second, as in the editor
+    int scale = 1;  // 1 = 480x360, 2 = 960x720
+    int workers = 0; // 0 = one per spare CPU core
+    ExportFormat format = EXPORT_PNG;
+};
+
+/* Presses the green flag and exports opt.seconds of stage frames; false on any write error */
+bool video_export_run(SDL_Renderer *r, TTF_Font *font, AppState &state, const Textures &tex, const ExportOptions &opt);
+
+#endif
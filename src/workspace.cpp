@@ -1,24 +1,64 @@
 #include "workspace.h"
 #include "block_ui.h"
+#include "blocks.h"
+#include "geometry.h"
 #include "renderer.h"
+#include "text.h"
+#include "render_queue.h"
+#include "trace.h"
 
 #include <SDL_ttf.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <string>
 #include <iostream>
+#include <unordered_map>
 #include <unordered_set>
 
 static int workspace_text_w(TTF_Font *f, const char *txt)
 {
     int w = 0;
     if (f && txt)
-        TTF_SizeUTF8(f, txt, &w, NULL);
+        text_size(f, txt, &w, NULL);
     return w;
 }
 
 static bool point_in_rect(int px, int py, const SDL_Rect &r) { return px >= r.x && px < r.x + r.w && py >= r.y && py < r.y + r.h; }
 
+// ---> CAMERA <---
+// Blocks keep their positions in workspace coordinates; the code area shows
+// them through a pan/zoom camera: screen = (world - cam) * zoom.
+static const float ZOOM_MIN = 0.25f;
+static const float ZOOM_MAX = 2.0f;
+static const float ZOOM_STEP = 1.25f;
+static const float LOD_ZOOM = 0.5f; // below this, chains are drawn as flat silhouettes
+static const int WHEEL_PAN = 40;
+
+static int g_mouse_x = 0, g_mouse_y = 0; // last pointer position, logical window coords
+static bool g_panning = false;
+static int g_pan_x = 0, g_pan_y = 0;
+
+/* Whole-unit camera origin; drawing and hit testing both go through it */
+static int cam_origin(float c) { return (int)std::floor(c); }
+
+void workspace_screen_to_world(const AppState &state, int sx, int sy, int &wx, int &wy)
+{
+    wx = (int)std::floor(sx / state.ws_zoom) + cam_origin(state.ws_cam_x);
+    wy = (int)std::floor(sy / state.ws_zoom) + cam_origin(state.ws_cam_y);
+}
+
+/* Zooms by factor, keeping the workspace point under (sx, sy) where it is */
+static void workspace_zoom_at(AppState &state, int sx, int sy, float factor)
+{
+    float zoom = std::max(ZOOM_MIN, std::min(ZOOM_MAX, state.ws_zoom * factor));
+    float wx = sx / state.ws_zoom + state.ws_cam_x;
+    float wy = sy / state.ws_zoom + state.ws_cam_y;
+    state.ws_zoom = zoom;
+    state.ws_cam_x = wx - sx / zoom;
+    state.ws_cam_y = wy - sy / zoom;
+}
+
 static const CustomFunctionDef *workspace_find_custom_def(const AppState &state, const std::string &name)
 {
     for (const auto &fn : state.custom_functions)
@@ -29,25 +69,251 @@ static const CustomFunctionDef *workspace_find_custom_def(const AppState &state,
 
 static SDL_Rect block_rect(const AppState &state, const BlockInstance &b);
 
+static int block_slot(const Sprite &spr, int id)
+{
+    if (id < 0)
+        return -1;
+    auto &slot = spr.block_index.slot;
+    auto it = slot.find(id);
+    if (it != slot.end() && it->second < (int)spr.blocks.size() && spr.blocks[it->second].id == id)
+        return it->second;
+    // Blocks are appended: the newest one, or the palette ghost pushed for a single
+    // draw and popped again, is found without touching the map
+    if (!spr.blocks.empty() && spr.blocks.back().id == id)
+        return (int)spr.blocks.size() - 1;
+    // The map still covers every block, so the id is simply not there
+    if (it == slot.end() && slot.size() == spr.blocks.size())
+        return -1;
+    // Blocks were added, erased or reordered since the map was built
+    slot.clear();
+    for (int i = 0; i < (int)spr.blocks.size(); i++)
+        slot[spr.blocks[i].id] = i;
+    it = slot.find(id);
+    return it != slot.end() ? it->second : -1;
+}
+
 BlockInstance *workspace_find(AppState &state, int id)
 {
     if (state.selected_sprite < 0 || state.selected_sprite >= (int)state.sprites.size())
         return nullptr;
-    for (auto &b : state.sprites[state.selected_sprite].blocks)
-        if (b.id == id)
-            return &b;
-    return nullptr;
+    Sprite &spr = state.sprites[state.selected_sprite];
+    int i = block_slot(spr, id);
+    return i >= 0 ? &spr.blocks[i] : nullptr;
 }
 const BlockInstance *workspace_find_const(const AppState &state, int id)
 {
     if (state.selected_sprite < 0 || state.selected_sprite >= (int)state.sprites.size())
         return nullptr;
-    for (const auto &b : state.sprites[state.selected_sprite].blocks)
-        if (b.id == id)
-            return &b;
-    return nullptr;
+    const Sprite &spr = state.sprites[state.selected_sprite];
+    int i = block_slot(spr, id);
+    return i >= 0 ? &spr.blocks[i] : nullptr;
+}
+
+// ---> SPATIAL INDEX <---
+// Block rects of the selected sprite bucketed into a uniform grid, so picking,
+// snap search and culling only look at blocks near the point or rect of interest.
+// workspace_layout_chain re-indexes the chain it lays out, and anything that edits
+// blocks without a relayout re-indexes the blocks it touched. Names shown in
+// dropdowns (variables, messages, costumes, custom block definitions) also set
+// block widths; workspace_draw clears `valid` when they change, forcing a rebuild.
+static const int INDEX_CELL = 64;
+
+static int index_cell(int v) { return v >= 0 ? v / INDEX_CELL : -((-v + INDEX_CELL - 1) / INDEX_CELL); }
+static Sint64 index_key(int cx, int cy) { return ((Sint64)cx << 32) ^ (Uint32)cy; }
+
+static void index_remove(BlockIndex &ix, int id)
+{
+    auto it = ix.rects.find(id);
+    if (it == ix.rects.end())
+        return;
+    const SDL_Rect &r = it->second;
+    for (int cy = index_cell(r.y); cy <= index_cell(r.y + r.h - 1); cy++)
+        for (int cx = index_cell(r.x); cx <= index_cell(r.x + r.w - 1); cx++)
+        {
+            auto cell = ix.cells.find(index_key(cx, cy));
+            if (cell == ix.cells.end())
+                continue;
+            auto &ids = cell->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+            if (ids.empty())
+                ix.cells.erase(cell);
+        }
+    ix.rects.erase(it);
+}
+
+static void index_insert(BlockIndex &ix, int id, const SDL_Rect &r)
+{
+    if (r.w <= 0 || r.h <= 0)
+        return;
+    ix.rects[id] = r;
+    for (int cy = index_cell(r.y); cy <= index_cell(r.y + r.h - 1); cy++)
+        for (int cx = index_cell(r.x); cx <= index_cell(r.x + r.w - 1); cx++)
+            ix.cells[index_key(cx, cy)].push_back(id);
+}
+
+static void index_block(BlockIndex &ix, const AppState &state, const BlockInstance &b)
+{
+    SDL_Rect r = block_rect(state, b);
+    auto it = ix.rects.find(b.id);
+    if (it != ix.rects.end() && SDL_RectEquals(&it->second, &r))
+        return;
+    index_remove(ix, b.id);
+    index_insert(ix, b.id, r);
+}
+
+void workspace_blocks_changed(AppState &state)
+{
+    if (state.selected_sprite >= 0 && state.selected_sprite < (int)state.sprites.size())
+        state.sprites[state.selected_sprite].blocks_version = Sprite::next_blocks_version();
+}
+
+static void index_chain(BlockIndex &ix, const AppState &state, int root_id)
+{
+    int cur = root_id;
+    while (cur != -1)
+    {
+        const BlockInstance *b = workspace_find_const(state, cur);
+        if (!b)
+            break;
+        index_block(ix, state, *b);
+        const int subs[] = {b->condition_id, b->child_id, b->child2_id, b->arg0_id, b->arg1_id, b->arg2_id};
+        for (int id : subs)
+            if (id != -1)
+                index_chain(ix, state, id);
+        cur = b->next_id;
+    }
+}
+
+static void index_subtree(AppState &state, int root_id)
+{
+    if (state.selected_sprite < 0 || state.selected_sprite >= (int)state.sprites.size())
+        return;
+    workspace_blocks_changed(state); // once per edit; everything that re-indexes has just edited blocks
+    BlockIndex &ix = state.sprites[state.selected_sprite].block_index;
+    if (!ix.valid)
+        return; // rebuilt in full on the next query anyway
+    index_chain(ix, state, root_id);
+}
+
+/* Appends the ids of indexed blocks whose rect intersects q (sorted, no duplicates) */
+static void index_query(const AppState &state, const SDL_Rect &q, std::vector<int> &out)
+{
+    if (state.selected_sprite < 0 || state.selected_sprite >= (int)state.sprites.size() || q.w <= 0 || q.h <= 0)
+        return;
+    const Sprite &spr = state.sprites[state.selected_sprite];
+    BlockIndex &ix = ((Sprite &)spr).block_index;
+    if (!ix.valid)
+    {
+        ix.rects.clear();
+        ix.cells.clear();
+        for (const auto &b : spr.blocks)
+            index_insert(ix, b.id, block_rect(state, b));
+        ix.valid = true;
+    }
+    for (int cy = index_cell(q.y); cy <= index_cell(q.y + q.h - 1); cy++)
+        for (int cx = index_cell(q.x); cx <= index_cell(q.x + q.w - 1); cx++)
+        {
+            auto cell = ix.cells.find(index_key(cx, cy));
+            if (cell == ix.cells.end())
+                continue;
+            for (int id : cell->second)
+                if (SDL_HasIntersection(&ix.rects[id], &q))
+                    out.push_back(id);
+        }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// ---> WALK ORDER <---
+// Picking and snapping used to walk every chain and keep the first (or last)
+// match. With the index only the candidates are visited, so these helpers
+// recover which of two blocks in the same script such a walk reaches first.
+enum BlockLink
+{
+    LINK_NEXT = 0,
+    LINK_CHILD,
+    LINK_CHILD2,
+    LINK_COND,
+    LINK_ARG0,
+    LINK_ARG1,
+    LINK_ARG2
+};
+
+// Hit testing visits condition, child, child2 and args before the block itself
+static const int PICK_RANK[] = {6, 1, 2, 0, 3, 4, 5};
+// Snap search visits the block, then child, child2, condition and args
+static const int SNAP_RANK[] = {6, 0, 1, 2, 3, 4, 5};
+
+static int link_of(const BlockInstance &p, int id)
+{
+    if (p.child_id == id)
+        return LINK_CHILD;
+    if (p.child2_id == id)
+        return LINK_CHILD2;
+    if (p.condition_id == id)
+        return LINK_COND;
+    if (p.arg0_id == id)
+        return LINK_ARG0;
+    if (p.arg1_id == id)
+        return LINK_ARG1;
+    if (p.arg2_id == id)
+        return LINK_ARG2;
+    return LINK_NEXT;
+}
+
+static void block_path(const AppState &state, int id, std::vector<int> &path)
+{
+    path.clear();
+    size_t guard = state.sprites[state.selected_sprite].blocks.size() + 1;
+    while (id != -1 && path.size() < guard)
+    {
+        path.push_back(id);
+        const BlockInstance *b = workspace_find_const(state, id);
+        if (!b)
+            break;
+        id = b->parent_id;
+    }
+    std::reverse(path.begin(), path.end());
+}
+
+/* True when a walk of their shared script reaches block a before block b */
+static bool walk_precedes(const AppState &state, int a, int b, const int *rank, bool self_first)
+{
+    static std::vector<int> pa, pb;
+    block_path(state, a, pa);
+    block_path(state, b, pb);
+    size_t i = 0;
+    while (i < pa.size() && i < pb.size() && pa[i] == pb[i])
+        i++;
+    if (i == pa.size() && i == pb.size())
+        return false;
+    if (i == pa.size() || i == pb.size())
+    {
+        // One is an ancestor of the other: it comes first unless its sub-blocks are visited before it
+        bool a_is_ancestor = (i == pa.size());
+        const BlockInstance *anc = workspace_find_const(state, a_is_ancestor ? a : b);
+        int link = anc ? link_of(*anc, a_is_ancestor ? pb[i] : pa[i]) : LINK_NEXT;
+        bool ancestor_first = (link == LINK_NEXT) || self_first;
+        return a_is_ancestor ? ancestor_first : !ancestor_first;
+    }
+    if (i == 0)
+        return false;
+    const BlockInstance *p = workspace_find_const(state, pa[i - 1]);
+    if (!p)
+        return false;
+    return rank[link_of(*p, pa[i])] < rank[link_of(*p, pb[i])];
+}
+
+/* Position of each script root in top_level_blocks */
+static void top_level_order(const AppState &state, std::unordered_map<int, int> &order)
+{
+    order.clear();
+    const auto &tl = state.sprites[state.selected_sprite].top_level_blocks;
+    for (int i = 0; i < (int)tl.size(); i++)
+        order[tl[i]] = i;
 }
 
+
 static int last_in_chain(const AppState &state, int root_id)
 {
     int cur = root_id;
@@ -619,6 +885,7 @@ int workspace_add_top_level(AppState &state, const BlockInstance &b0)
     b.id = state.next_block_id++;
     state.sprites[state.selected_sprite].blocks.push_back(b);
     state.sprites[state.selected_sprite].top_level_blocks.push_back(b.id);
+    workspace_blocks_changed(state);
     return b.id;
 }
 int workspace_root_id(const AppState &state, int id)
@@ -639,7 +906,7 @@ int workspace_root_id(const AppState &state, int id)
     return cur;
 }
 
-void workspace_layout_chain(AppState &state, int root_id)
+static void layout_chain(AppState &state, int root_id)
 {
     BlockInstance *root = workspace_find(state, root_id);
     if (!root)
@@ -670,7 +937,7 @@ void workspace_layout_chain(AppState &state, int root_id)
                 }
                 cond->x = x + c_off;
                 cond->y = y + 8;
-                workspace_layout_chain(state, cond->id);
+                layout_chain(state, cond->id);
             }
         }
         if (b->child_id != -1)
@@ -680,7 +947,7 @@ void workspace_layout_chain(AppState &state, int root_id)
             {
                 child->x = x + 16;
                 child->y = y + 40 - m.overlap;
-                workspace_layout_chain(state, child->id);
+                layout_chain(state, child->id);
             }
         }
         if (b->child2_id != -1)
@@ -690,7 +957,7 @@ void workspace_layout_chain(AppState &state, int root_id)
             {
                 child2->x = x + 16;
                 child2->y = y + 40 + std::max(24, chain_height(state, b->child_id)) + 32 - m.overlap;
-                workspace_layout_chain(state, child2->id);
+                layout_chain(state, child2->id);
             }
         }
         y += (block_height(state, *b) - m.overlap);
@@ -698,6 +965,12 @@ void workspace_layout_chain(AppState &state, int root_id)
     }
 }
 
+void workspace_layout_chain(AppState &state, int root_id)
+{
+    layout_chain(state, root_id);
+    index_subtree(state, root_id);
+}
+
 static void remove_from_top_level(AppState &state, int root_id)
 {
     if (state.selected_sprite < 0 || state.selected_sprite >= (int)state.sprites.size())
@@ -710,6 +983,7 @@ static int detach_subchain(AppState &state, int id)
     BlockInstance *b = workspace_find(state, id);
     if (!b)
         return -1;
+    workspace_blocks_changed(state);
     int parent = b->parent_id;
     if (parent == -1)
         remove_from_top_level(state, id);
@@ -809,6 +1083,10 @@ static void delete_chain(AppState &state, int root_id)
     }
 
     auto &blks = state.sprites[state.selected_sprite].blocks;
+    workspace_blocks_changed(state);
+    for (int id : ids)
+        index_remove(state.sprites[state.selected_sprite].block_index, id);
+    state.sprites[state.selected_sprite].block_index.slot.clear(); // slots shift
     blks.erase(std::remove_if(blks.begin(), blks.end(), [&](const BlockInstance &b)
                               { return std::find(ids.begin(), ids.end(), b.id) != ids.end(); }),
                blks.end());
@@ -892,172 +1170,189 @@ static void compute_snap(AppState &state, TTF_Font *font)
         }
     }
 
-    auto check_block_snaps = [&](auto &self, int root_id) -> void
+    // True when the dragged reporter lands in one of b's input slots
+    auto check_block_snaps = [&](int cur, const BlockInstance *b) -> bool
     {
-        int cur = root_id;
-        while (cur != -1)
+        if (dragging_reporter)
         {
-            if (dragged_ids.count(cur))
-                return;
-            const BlockInstance *b = workspace_find_const(state, cur);
-            if (!b)
-                break;
-            if (dragging_reporter)
+            int field = -1;
+            int px = state.drag.mouse_x;
+            int py = state.drag.mouse_y;
+            if (b->kind == BK_MOTION)
             {
-                int field = -1;
-                int px = state.drag.mouse_x;
-                int py = state.drag.mouse_y;
-                if (b->kind == BK_MOTION)
-                {
-                    int d0 = 40, d1 = 48;
-                    if (b->subtype == MB_GO_TO_XY)
-                    {
-                        d0 = 48;
-                        d1 = 48;
-                    }
-                    field = motion_block_hittest_field(font, (MotionBlockType)b->subtype, b->x, b->y, b->a, b->b, (GoToTarget)b->opt, px, py, reporter_extra(state, b->arg0_id, d0), reporter_extra(state, b->arg1_id, d1));
-                }
-                else if (b->kind == BK_LOOKS)
-                    field = looks_block_hittest_field(font, state, (LooksBlockType)b->subtype, b->x, b->y, b->text, b->a, b->b, b->opt, px, py);
-                else if (b->kind == BK_SOUND)
-                    field = sound_block_hittest_field(font, state, (SoundBlockType)b->subtype, b->x, b->y, b->a, b->opt, px, py);
-                else if (b->kind == BK_EVENTS)
-                    field = events_block_hittest_field(font, state, (EventsBlockType)b->subtype, b->x, b->y, b->opt, px, py);
-                else if (b->kind == BK_PEN)
-                    field = pen_block_hittest_field(font, (PenBlockType)b->subtype, b->x, b->y, b->opt, px, py);
-                else if (b->kind == BK_CONTROL)
-                    field = control_block_hittest_field(font, (ControlBlockType)b->subtype, b->x, b->y, chain_height(state, b->child_id), chain_height(state, b->child2_id), b->a, px, py);
-                else if (b->kind == BK_SENSING)
+                int d0 = 40, d1 = 48;
+                if (b->subtype == MB_GO_TO_XY)
                 {
-                    if (b->subtype == SENSB_TOUCHING || b->subtype == SENSB_KEY_PRESSED || b->subtype == SENSB_MOUSE_DOWN || b->subtype == SENSB_TOUCHING_COLOR || b->subtype == SENSB_COLOR_IS_TOUCHING_COLOR)
-                        field = sensing_boolean_block_hittest_field(font, (SensingBlockType)b->subtype, b->x, b->y, b->opt, b->a, b->b, b->c, b->d, b->e, b->f, px, py);
-                    else if (b->subtype == SENSB_ANSWER || b->subtype == SENSB_DISTANCE_TO || b->subtype == SENSB_MOUSE_X || b->subtype == SENSB_MOUSE_Y)
-                        field = sensing_reporter_block_hittest_field(font, (SensingBlockType)b->subtype, b->x, b->y, px, py);
-                    else
-                        field = sensing_stack_block_hittest_field(font, (SensingBlockType)b->subtype, b->x, b->y, b->text, b->opt, px, py);
+                    d0 = 48;
+                    d1 = 48;
                 }
-                else if (b->kind == BK_OPERATORS)
+                field = motion_block_hittest_field(font, (MotionBlockType)b->subtype, b->x, b->y, b->a, b->b, (GoToTarget)b->opt, px, py, reporter_extra(state, b->arg0_id, d0), reporter_extra(state, b->arg1_id, d1));
+            }
+            else if (b->kind == BK_LOOKS)
+                field = looks_block_hittest_field(font, state, (LooksBlockType)b->subtype, b->x, b->y, b->text, b->a, b->b, b->opt, px, py);
+            else if (b->kind == BK_SOUND)
+                field = sound_block_hittest_field(font, state, (SoundBlockType)b->subtype, b->x, b->y, b->a, b->opt, px, py);
+            else if (b->kind == BK_EVENTS)
+                field = events_block_hittest_field(font, state, (EventsBlockType)b->subtype, b->x, b->y, b->opt, px, py);
+            else if (b->kind == BK_PEN)
+                field = pen_block_hittest_field(font, (PenBlockType)b->subtype, b->x, b->y, b->opt, px, py);
+            else if (b->kind == BK_CONTROL)
+                field = control_block_hittest_field(font, (ControlBlockType)b->subtype, b->x, b->y, chain_height(state, b->child_id), chain_height(state, b->child2_id), b->a, px, py);
+            else if (b->kind == BK_SENSING)
+            {
+                if (b->subtype == SENSB_TOUCHING || b->subtype == SENSB_KEY_PRESSED || b->subtype == SENSB_MOUSE_DOWN || b->subtype == SENSB_TOUCHING_COLOR || b->subtype == SENSB_COLOR_IS_TOUCHING_COLOR)
+                    field = sensing_boolean_block_hittest_field(font, (SensingBlockType)b->subtype, b->x, b->y, b->opt, b->a, b->b, b->c, b->d, b->e, b->f, px, py);
+                else if (b->subtype == SENSB_ANSWER || b->subtype == SENSB_DISTANCE_TO || b->subtype == SENSB_MOUSE_X || b->subtype == SENSB_MOUSE_Y)
+                    field = sensing_reporter_block_hittest_field(font, (SensingBlockType)b->subtype, b->x, b->y, px, py);
+                else
+                    field = sensing_stack_block_hittest_field(font, (SensingBlockType)b->subtype, b->x, b->y, b->text, b->opt, px, py);
+            }
+            else if (b->kind == BK_OPERATORS)
+            {
+                int cw0, cw1;
+                get_operator_capsule_widths(state, *b, cw0, cw1);
+                int total_w = block_rect(state, *b).w;
+                field = operators_block_hittest_dynamic(font, (OperatorsBlockType)b->subtype, b->x, b->y, total_w, cw0, cw1, px, py);
+            }
+            else if (b->kind == BK_VARIABLES)
+                field = variables_block_hittest_field(font, state, (VariablesBlockType)b->subtype, b->x, b->y, b->text, b->opt, px, py);
+            else if (b->kind == BK_MY_BLOCKS && b->subtype == MYB_CALL)
+            {
+                int ew0 = 0, ew1 = 0, ew2 = 0;
+                const CustomFunctionDef *def = workspace_find_custom_def(state, b->text);
+                if (def)
                 {
-                    int cw0, cw1;
-                    get_operator_capsule_widths(state, *b, cw0, cw1);
-                    int total_w = block_rect(state, *b).w;
-                    field = operators_block_hittest_dynamic(font, (OperatorsBlockType)b->subtype, b->x, b->y, total_w, cw0, cw1, px, py);
+                    auto gw = [&](int pi)
+                    { return std::max(60, (font ? workspace_text_w(font, def->params[pi].name.c_str()) : (int)def->params[pi].name.size() * 8) + 20); };
+                    if (def->params.size() > 0)
+                        ew0 = reporter_extra(state, b->arg0_id, gw(0));
+                    if (def->params.size() > 1)
+                        ew1 = reporter_extra(state, b->arg1_id, gw(1));
+                    if (def->params.size() > 2)
+                        ew2 = reporter_extra(state, b->arg2_id, gw(2));
                 }
-                else if (b->kind == BK_VARIABLES)
-                    field = variables_block_hittest_field(font, state, (VariablesBlockType)b->subtype, b->x, b->y, b->text, b->opt, px, py);
+                field = myblocks_call_block_hittest_field(font, state, b->text, b->x, b->y, px, py, ew0, ew1, ew2);
+            }
+
+            if (field >= 0 && field <= 2)
+            {
+                bool is_hex_slot = false;
+                if (b->kind == BK_OPERATORS && (b->subtype == OP_AND || b->subtype == OP_OR || b->subtype == OP_NOT))
+                    is_hex_slot = true;
                 else if (b->kind == BK_MY_BLOCKS && b->subtype == MYB_CALL)
                 {
-                    int ew0 = 0, ew1 = 0, ew2 = 0;
                     const CustomFunctionDef *def = workspace_find_custom_def(state, b->text);
-                    if (def)
-                    {
-                        auto gw = [&](int pi)
-                        { return std::max(60, (font ? workspace_text_w(font, def->params[pi].name.c_str()) : (int)def->params[pi].name.size() * 8) + 20); };
-                        if (def->params.size() > 0)
-                            ew0 = reporter_extra(state, b->arg0_id, gw(0));
-                        if (def->params.size() > 1)
-                            ew1 = reporter_extra(state, b->arg1_id, gw(1));
-                        if (def->params.size() > 2)
-                            ew2 = reporter_extra(state, b->arg2_id, gw(2));
-                    }
-                    field = myblocks_call_block_hittest_field(font, state, b->text, b->x, b->y, px, py, ew0, ew1, ew2);
+                    if (def && field < (int)def->params.size() && def->params[field].type == CPARAM_BOOLEAN)
+                        is_hex_slot = true;
                 }
-
-                if (field >= 0 && field <= 2)
+                if (dragging_bool == is_hex_slot)
                 {
-                    bool is_hex_slot = false;
-                    if (b->kind == BK_OPERATORS && (b->subtype == OP_AND || b->subtype == OP_OR || b->subtype == OP_NOT))
-                        is_hex_slot = true;
-                    else if (b->kind == BK_MY_BLOCKS && b->subtype == MYB_CALL)
-                    {
-                        const CustomFunctionDef *def = workspace_find_custom_def(state, b->text);
-                        if (def && field < (int)def->params.size() && def->params[field].type == CPARAM_BOOLEAN)
-                            is_hex_slot = true;
-                    }
-                    if (dragging_bool == is_hex_slot)
-                    {
-                        best_dist = 0;
-                        best_id = cur;
-                        best_dx = 0;
-                        best_dy = 0;
-                        best_type = (field == 0) ? SNAP_INPUT_1 : (field == 1 ? SNAP_INPUT_2 : SNAP_INPUT_3);
-                        return;
-                    }
+                    best_dist = 0;
+                    best_id = cur;
+                    best_dx = 0;
+                    best_dy = 0;
+                    best_type = (field == 0) ? SNAP_INPUT_1 : (field == 1 ? SNAP_INPUT_2 : SNAP_INPUT_3);
+                    return true;
                 }
             }
-            SDL_Rect br = block_rect(state, *b);
-            auto try_snap = [&](int tx, int ty, SnapType st, bool is_hex_slot)
+        }
+        SDL_Rect br = block_rect(state, *b);
+        auto try_snap = [&](int tx, int ty, SnapType st, bool is_hex_slot)
+        {
+            if (dragging_bool != is_hex_slot)
+                return;
+            int dx = tx - dr.x, dy = ty - dr.y;
+            if (std::abs(dx) <= SNAP_DIST && std::abs(dy) <= SNAP_DIST)
             {
-                if (dragging_bool != is_hex_slot)
-                    return;
-                int dx = tx - dr.x, dy = ty - dr.y;
-                if (std::abs(dx) <= SNAP_DIST && std::abs(dy) <= SNAP_DIST)
+                int dist = std::abs(dx) + std::abs(dy);
+                if (dist < best_dist)
                 {
-                    int dist = std::abs(dx) + std::abs(dy);
-                    if (dist < best_dist)
-                    {
-                        best_dist = dist;
-                        best_id = cur;
-                        best_dx = dx;
-                        best_dy = dy;
-                        best_type = st;
-                    }
+                    best_dist = dist;
+                    best_id = cur;
+                    best_dx = dx;
+                    best_dy = dy;
+                    best_type = st;
                 }
-            };
-            if (!dragging_reporter || dragging_bool)
+            }
+        };
+        if (!dragging_reporter || dragging_bool)
+        {
+            bool dragging_event_hat = false;
+            if (state.drag.from_palette)
+                dragging_event_hat = (state.drag.palette_kind == BK_EVENTS && state.drag.palette_subtype != EB_BROADCAST);
+            else
             {
-                bool dragging_event_hat = false;
-                if (state.drag.from_palette)
-                    dragging_event_hat = (state.drag.palette_kind == BK_EVENTS && state.drag.palette_subtype != EB_BROADCAST);
-                else
-                {
-                    const BlockInstance *drb = workspace_find_const(state, state.drag.dragged_block_id);
-                    if (drb)
-                        dragging_event_hat = (drb->kind == BK_EVENTS && drb->subtype != EB_BROADCAST);
-                }
-                bool target_is_hat = (b->kind == BK_EVENTS && b->subtype != EB_BROADCAST);
-
-                if (!dragging_event_hat)
-                    try_snap(br.x, br.y + br.h - motion_block_metrics().overlap, SNAP_AFTER, false);
-                if (!target_is_hat && !dragging_event_hat)
-                    try_snap(br.x, br.y - (dr.h - motion_block_metrics().overlap), SNAP_BEFORE, false);
+                const BlockInstance *drb = workspace_find_const(state, state.drag.dragged_block_id);
+                if (drb)
+                    dragging_event_hat = (drb->kind == BK_EVENTS && drb->subtype != EB_BROADCAST);
             }
-            if (b->kind == BK_CONTROL)
+            bool target_is_hat = (b->kind == BK_EVENTS && b->subtype != EB_BROADCAST);
+
+            if (!dragging_event_hat)
+                try_snap(br.x, br.y + br.h - motion_block_metrics().overlap, SNAP_AFTER, false);
+            if (!target_is_hat && !dragging_event_hat)
+                try_snap(br.x, br.y - (dr.h - motion_block_metrics().overlap), SNAP_BEFORE, false);
+        }
+        if (b->kind == BK_CONTROL)
+        {
+            ControlBlockType ct = (ControlBlockType)b->subtype;
+            if (ct == CB_IF || ct == CB_IF_ELSE || ct == CB_WAIT_UNTIL || ct == CB_REPEAT_UNTIL)
             {
-                ControlBlockType ct = (ControlBlockType)b->subtype;
-                if (ct == CB_IF || ct == CB_IF_ELSE || ct == CB_WAIT_UNTIL || ct == CB_REPEAT_UNTIL)
-                {
-                    int c_off = 35;
-                    if (ct == CB_WAIT_UNTIL)
-                        c_off = 90;
-                    else if (ct == CB_REPEAT_UNTIL)
-                        c_off = 100;
-                    try_snap(br.x + c_off, br.y + 8, SNAP_CONDITION, true);
-                }
-                if (ct == CB_REPEAT || ct == CB_FOREVER || ct == CB_IF || ct == CB_IF_ELSE || ct == CB_REPEAT_UNTIL)
-                    try_snap(br.x + 16, br.y + 40 - motion_block_metrics().overlap, SNAP_INSIDE_1, false);
-                if (ct == CB_IF_ELSE)
-                    try_snap(br.x + 16, br.y + 40 + std::max(24, chain_height(state, b->child_id)) + 32 - motion_block_metrics().overlap, SNAP_INSIDE_2, false);
+                int c_off = 35;
+                if (ct == CB_WAIT_UNTIL)
+                    c_off = 90;
+                else if (ct == CB_REPEAT_UNTIL)
+                    c_off = 100;
+                try_snap(br.x + c_off, br.y + 8, SNAP_CONDITION, true);
             }
-            if (b->child_id != -1)
-                self(self, b->child_id);
-            if (b->child2_id != -1)
-                self(self, b->child2_id);
-            if (b->condition_id != -1)
-                self(self, b->condition_id);
-            if (b->arg0_id != -1)
-                self(self, b->arg0_id);
-            if (b->arg1_id != -1)
-                self(self, b->arg1_id);
-            if (b->arg2_id != -1)
-                self(self, b->arg2_id);
-            cur = b->next_id;
+            if (ct == CB_REPEAT || ct == CB_FOREVER || ct == CB_IF || ct == CB_IF_ELSE || ct == CB_REPEAT_UNTIL)
+                try_snap(br.x + 16, br.y + 40 - motion_block_metrics().overlap, SNAP_INSIDE_1, false);
+            if (ct == CB_IF_ELSE)
+                try_snap(br.x + 16, br.y + 40 + std::max(24, chain_height(state, b->child_id)) + 32 - motion_block_metrics().overlap, SNAP_INSIDE_2, false);
         }
+        return false;
     };
-    if (state.selected_sprite >= 0 && state.selected_sprite < (int)state.sprites.size())
-    {
-        for (int root_id : state.sprites[state.selected_sprite].top_level_blocks)
-            check_block_snaps(check_block_snaps, root_id);
+
+    // Only blocks near the drop point (or under the mouse, for reporters) can snap.
+    // They are visited in the order a walk of the scripts would reach them; a
+    // reporter landing in a block's slot ends that script's walk, as before.
+    std::vector<int> cand;
+    SDL_Rect q = {dr.x - SNAP_DIST, dr.y - SNAP_DIST, SNAP_DIST * 2 + 1, SNAP_DIST * 2 + 1 + std::max(0, dr.h)};
+    index_query(state, q, cand);
+    if (dragging_reporter)
+        index_query(state, {state.drag.mouse_x, state.drag.mouse_y, 1, 1}, cand);
+    if (!cand.empty())
+    {
+        std::unordered_map<int, int> order;
+        top_level_order(state, order);
+        std::vector<std::pair<int, int>> visits; // (script order, block id)
+        for (int id : cand)
+        {
+            if (dragged_ids.count(id))
+                continue;
+            auto it = order.find(workspace_root_id(state, id));
+            if (it != order.end())
+                visits.push_back({it->second, id});
+        }
+        std::sort(visits.begin(), visits.end(), [&](const std::pair<int, int> &x, const std::pair<int, int> &y)
+                  {
+                      if (x.first != y.first)
+                          return x.first < y.first;
+                      return walk_precedes(state, x.second, y.second, SNAP_RANK, true); });
+        std::vector<int> slot_hits, path;
+        for (const auto &v : visits)
+        {
+            block_path(state, v.second, path);
+            bool cut_off = false;
+            for (int id : path)
+                if (std::find(slot_hits.begin(), slot_hits.end(), id) != slot_hits.end())
+                    cut_off = true;
+            const BlockInstance *b = workspace_find_const(state, v.second);
+            if (cut_off || !b)
+                continue;
+            if (check_block_snaps(v.second, b))
+                slot_hits.push_back(v.second);
+        }
     }
     if (best_id != -1)
     {
@@ -1247,10 +1542,11 @@ static void draw_chain(SDL_Renderer *r, TTF_Font *font, const Textures &tex, con
                     int cx = cap.x - 2;
                     int cy = cap.y + (cap.h - cbr.h) / 2;
                     BlockInstance *mutable_child = workspace_find((AppState &)state, arg_id);
-                    if (mutable_child)
+                    if (mutable_child && (mutable_child->x != cx || mutable_child->y != cy))
                     {
                         mutable_child->x = cx;
                         mutable_child->y = cy;
+                        index_subtree((AppState &)state, arg_id);
                     }
                     draw_chain(r, font, tex, state, bg, arg_id, ghost, cx - child->x + off_x, cy - child->y + off_y);
                 }
@@ -1262,33 +1558,374 @@ static void draw_chain(SDL_Renderer *r, TTF_Font *font, const Textures &tex, con
         // ---> NEW: Draw execution highlight border! <---
         if (b->id == state.exec_highlight_id && SDL_GetTicks() <= state.exec_highlight_timer) {
             SDL_Rect hbr = block_rect(state, *b);
-            if (state.exec_highlight_type == 0) SDL_SetRenderDrawColor(r, 0, 0, 0, 255); // Black (Executing)
-            else if (state.exec_highlight_type == 1) SDL_SetRenderDrawColor(r, 220, 180, 0, 255); // Yellow (Warning)
-            else if (state.exec_highlight_type == 2) SDL_SetRenderDrawColor(r, 220, 20, 20, 255); // Red (Error)
+            if (state.exec_highlight_type == 0) rq_set_color(r, 0, 0, 0, 255); // Black (Executing)
+            else if (state.exec_highlight_type == 1) rq_set_color(r, 220, 180, 0, 255); // Yellow (Warning)
+            else if (state.exec_highlight_type == 2) rq_set_color(r, 220, 20, 20, 255); // Red (Error)
 
             // Draw a 3-pixel thick border
             for (int i = 0; i < 3; i++) {
                 SDL_Rect tr = {hbr.x - i + off_x, hbr.y - i + off_y, hbr.w + i * 2, hbr.h + i * 2};
-                SDL_RenderDrawRect(r, &tr);
+                rq_draw_rect(r, &tr);
+            }
+        }
+        cur = b->next_id;
+    }
+}
+
+// ---> CHAIN TEXTURE CACHE <---
+// Each top-level chain is rendered once into a texture and blitted from then on.
+// A texture is reused as is while the sprite's blocks_version and the context
+// (dropdown names, zoom) are the ones it was checked against; that is O(1) per chain.
+// After either changes, the chain is hashed once (its blocks' fields, links and
+// positions) and only re-rendered when the hash differs, so an edit re-renders
+// the chains it touched and merely re-checks the others.
+// Textures are sized at scale x zoom, so the cache is capped by total bytes and
+// the least recently drawn chains give theirs up first.
+struct ChainCache
+{
+    SDL_Texture *texture = nullptr;
+    SDL_Rect bounds = {0, 0, 0, 0}; // workspace coords the texture covers
+    Uint64 key = 0;                 // content hash the texture was rendered from
+    unsigned int version = 0;       // blocks_version the key was last checked at
+    Uint64 context = 0;             // context + scale the key was last checked with
+    size_t bytes = 0;               // texture size, counted in g_chain_bytes
+    Uint32 frame = 0;               // last frame the chain still existed
+    Uint32 drawn = 0;               // last frame the texture was blitted
+};
+
+static const int CHAIN_CACHE_MARGIN = 4;  // room for the exec highlight border and hat caps
+static const int CHAIN_CACHE_MAX = 4096; // taller chains are drawn live
+static const size_t CHAIN_CACHE_BUDGET = (size_t)64 * 1024 * 1024;
+static std::unordered_map<int, ChainCache> g_chain_cache;
+static size_t g_chain_bytes = 0;
+static Uint32 g_chain_frame = 0;
+
+static void chain_cache_drop(SDL_Renderer *r, ChainCache &cc)
+{
+    if (cc.texture)
+        rq_destroy_texture(r, cc.texture);
+    cc.texture = nullptr;
+    g_chain_bytes -= cc.bytes;
+    cc.bytes = 0;
+}
+
+/* Frees the least recently drawn textures until the cache fits its budget */
+static void chain_cache_trim(SDL_Renderer *r)
+{
+    while (g_chain_bytes > CHAIN_CACHE_BUDGET)
+    {
+        ChainCache *oldest = nullptr;
+        for (auto &kv : g_chain_cache)
+            if (kv.second.texture && kv.second.drawn != g_chain_frame && (!oldest || kv.second.drawn < oldest->drawn))
+                oldest = &kv.second;
+        if (!oldest)
+            break; // everything left is on screen this frame
+        chain_cache_drop(r, *oldest);
+    }
+}
+
+static void hash_mix(Uint64 &h, Uint64 v)
+{
+    h ^= v;
+    h *= 1099511628211ULL;
+}
+
+static void hash_str(Uint64 &h, const std::string &s)
+{
+    for (unsigned char c : s)
+        hash_mix(h, c);
+    hash_mix(h, s.size());
+}
+
+static void chain_hash_walk(const AppState &state, int root_id, Uint64 &h, SDL_Rect &bounds, bool &have)
+{
+    int cur = root_id;
+    while (cur != -1)
+    {
+        const BlockInstance *b = workspace_find_const(state, cur);
+        if (!b)
+            break;
+        const int fields[] = {b->id, b->kind, b->subtype, b->x, b->y, b->a, b->b, b->c, b->opt,
+                              b->next_id, b->child_id, b->child2_id, b->condition_id, b->arg0_id, b->arg1_id, b->arg2_id};
+        for (int v : fields)
+            hash_mix(h, (Uint32)v);
+        hash_str(h, b->text);
+        hash_str(h, b->text2);
+        hash_mix(h, (b->color1.r << 16) | (b->color1.g << 8) | b->color1.b);
+        hash_mix(h, (b->color2.r << 16) | (b->color2.g << 8) | b->color2.b);
+
+        SDL_Rect br = block_rect(state, *b);
+        if (!have)
+            bounds = br;
+        else
+            SDL_UnionRect(&bounds, &br, &bounds);
+        have = true;
+
+        const int subs[] = {b->condition_id, b->child_id, b->child2_id, b->arg0_id, b->arg1_id, b->arg2_id};
+        for (int id : subs)
+            if (id != -1)
+                chain_hash_walk(state, id, h, bounds, have);
+        cur = b->next_id;
+    }
+}
+
+// Names other blocks show in their dropdowns; shared by every chain of the sprite
+static Uint64 chain_context_hash(const AppState &state, TTF_Font *font, Color bg)
+{
+    Uint64 h = 14695981039346656037ULL;
+    hash_mix(h, (Uint64)(uintptr_t)font);
+    hash_mix(h, (bg.r << 16) | (bg.g << 8) | bg.b);
+    for (const auto &v : state.variables)
+        hash_str(h, v);
+    for (const auto &m : state.messages)
+        hash_str(h, m);
+    for (const auto &fn : state.custom_functions)
+    {
+        hash_str(h, fn.name);
+        for (const auto &p : fn.params)
+        {
+            hash_str(h, p.name);
+            hash_mix(h, p.type);
+        }
+    }
+    for (const auto &bd : state.backdrops)
+        hash_str(h, bd.name);
+    for (const auto &sp : state.sprites)
+        hash_str(h, sp.name);
+    const Sprite &cur = state.sprites[state.selected_sprite];
+    for (const auto &c : cur.costumes)
+        hash_str(h, c.name);
+    for (const auto &s : cur.sounds)
+        hash_str(h, s.name);
+    return h;
+}
+
+static bool chain_cache_render(SDL_Renderer *r, TTF_Font *font, const Textures &tex, const AppState &state, Color bg, int root_id, ChainCache &cc, const SDL_Rect &bounds)
+{
+    // Render at the output scale so cached chains stay as sharp as live ones
+    float sx = 1.0f, sy = 1.0f;
+    rq_get_scale(r, &sx, &sy);
+    int tw = (int)(bounds.w * sx + 0.999f);
+    int th = (int)(bounds.h * sy + 0.999f);
+    if (tw <= 0 || th <= 0 || tw > CHAIN_CACHE_MAX || th > CHAIN_CACHE_MAX)
+        return false;
+
+    int old_w = 0, old_h = 0;
+    if (cc.texture)
+        SDL_QueryTexture(cc.texture, NULL, NULL, &old_w, &old_h);
+    if (!cc.texture || old_w != tw || old_h != th)
+    {
+        chain_cache_drop(r, cc);
+        cc.texture = SDL_CreateTexture(r, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, tw, th);
+        if (!cc.texture)
+        {
+            SDL_Log("Chain cache texture failed: %s", SDL_GetError());
+            return false;
+        }
+        cc.bytes = (size_t)tw * th * 4;
+        g_chain_bytes += cc.bytes;
+        // Drawn with BLEND onto transparent black, the texture ends up premultiplied
+        SDL_SetTextureBlendMode(cc.texture, SDL_ComposeCustomBlendMode(
+                                                SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+                                                SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD));
+    }
+
+    // Coming back to a texture target (the redraw back buffer) resets scale and clip
+    SDL_Texture *prev_target = rq_get_target(r);
+    SDL_Rect prev_clip;
+    bool prev_clipped = rq_get_clip(r, &prev_clip);
+    rq_set_target(r, cc.texture);
+    rq_set_scale(r, sx, sy);
+    rq_set_blend(r, SDL_BLENDMODE_NONE);
+    rq_set_color(r, 0, 0, 0, 0);
+    rq_clear(r);
+    draw_chain(r, font, tex, state, bg, root_id, false, -bounds.x, -bounds.y);
+    rq_set_target(r, prev_target);
+    rq_set_scale(r, sx, sy);
+    rq_set_clip(r, prev_clipped ? &prev_clip : NULL);
+    cc.bounds = bounds;
+    return true;
+}
+
+static void draw_chain_cached(SDL_Renderer *r, TTF_Font *font, const Textures &tex, const AppState &state, Color bg, int root_id, Uint64 context, int live_a, int live_b, int off_x, int off_y)
+{
+    // Chains being typed into or flashing an exec highlight change every frame
+    if (root_id == live_a || root_id == live_b || !SDL_RenderTargetSupported(r))
+    {
+        draw_chain(r, font, tex, state, bg, root_id, false, off_x, off_y);
+        return;
+    }
+
+    // Textures are rasterized at the current scale, so a zoom step re-renders them
+    float sx = 1.0f, sy = 1.0f;
+    rq_get_scale(r, &sx, &sy);
+    Uint64 scaled_context = context;
+    hash_mix(scaled_context, (Uint64)(sx * 1000.0f) << 32 | (Uint32)(sy * 1000.0f));
+    const Sprite &spr = state.sprites[state.selected_sprite];
+
+    ChainCache &cc = g_chain_cache[root_id];
+    cc.frame = g_chain_frame;
+    if (!cc.texture || cc.version != spr.blocks_version || cc.context != scaled_context)
+    {
+        Uint64 key = scaled_context;
+        SDL_Rect bounds = {0, 0, 0, 0};
+        bool have = false;
+        chain_hash_walk(state, root_id, key, bounds, have);
+        if (!have)
+            return;
+        bounds.x -= CHAIN_CACHE_MARGIN;
+        bounds.y -= CHAIN_CACHE_MARGIN;
+        bounds.w += CHAIN_CACHE_MARGIN * 2;
+        bounds.h += CHAIN_CACHE_MARGIN * 2;
+        if (!cc.texture || cc.key != key)
+        {
+            if (!chain_cache_render(r, font, tex, state, bg, root_id, cc, bounds))
+            {
+                draw_chain(r, font, tex, state, bg, root_id, false, off_x, off_y);
+                return;
             }
+            cc.key = key;
         }
+        // Read after rendering: laying out reporters may have bumped it
+        cc.version = spr.blocks_version;
+        cc.context = scaled_context;
+    }
+    cc.drawn = g_chain_frame;
+    SDL_Rect dst = {cc.bounds.x + off_x, cc.bounds.y + off_y, cc.bounds.w, cc.bounds.h};
+    rq_copy(r, cc.texture, NULL, &dst);
+}
+
+// Far zoomed out: every block is a flat rounded rect in its category colour
+static void draw_chain_silhouette(SDL_Renderer *r, const AppState &state, int root_id, int off_x, int off_y)
+{
+    int cur = root_id;
+    while (cur != -1)
+    {
+        const BlockInstance *b = workspace_find_const(state, cur);
+        if (!b)
+            break;
+        int cat = b->kind == BK_PEN ? 9 : (b->kind == BK_MY_BLOCKS ? 8 : (int)b->kind);
+        Color c = blocks_category_color(cat);
+        SDL_Rect br = block_rect(state, *b);
+        br.x += off_x;
+        br.y += off_y;
+        geometry_fill_rounded_rect(r, br, 4, {(Uint8)c.r, (Uint8)c.g, (Uint8)c.b, 255});
+
+        const int subs[] = {b->condition_id, b->child_id, b->child2_id, b->arg0_id, b->arg1_id, b->arg2_id};
+        for (int id : subs)
+            if (id != -1)
+                draw_chain_silhouette(r, state, id, off_x, off_y);
         cur = b->next_id;
     }
 }
 
+size_t workspace_cache_bytes()
+{
+    return g_chain_bytes;
+}
+
+void workspace_free_cache()
+{
+    for (auto &kv : g_chain_cache)
+        if (kv.second.texture)
+            SDL_DestroyTexture(kv.second.texture);
+    g_chain_cache.clear();
+    g_chain_bytes = 0;
+}
+
 void workspace_draw(SDL_Renderer *r, TTF_Font *font, const Textures &tex, const AppState &state, const SDL_Rect &workspace_rect, Color bg)
 {
-    (void)workspace_rect;
+    TRACE_ZONE("workspace_draw");
+    // Everything below is drawn in workspace coordinates through the camera
+    const float zoom = state.ws_zoom;
+    const int cam_x = cam_origin(state.ws_cam_x), cam_y = cam_origin(state.ws_cam_y);
+    float scale_x = 1.0f, scale_y = 1.0f;
+    rq_get_scale(r, &scale_x, &scale_y);
+    SDL_Rect outer_clip;
+    bool outer_clipped = rq_get_clip(r, &outer_clip);
+    auto zoomed = [zoom](const SDL_Rect &a) -> SDL_Rect
+    {
+        int x0 = (int)std::floor(a.x / zoom), y0 = (int)std::floor(a.y / zoom);
+        int x1 = (int)std::ceil((a.x + a.w) / zoom), y1 = (int)std::ceil((a.y + a.h) / zoom);
+        return {x0, y0, x1 - x0, y1 - y0};
+    };
+    SDL_Rect panel = workspace_rect;
+    if (outer_clipped && !SDL_IntersectRect(&workspace_rect, &outer_clip, &panel))
+        panel = {workspace_rect.x, workspace_rect.y, 0, 0};
+    rq_set_scale(r, scale_x * zoom, scale_y * zoom);
+    SDL_Rect clip = zoomed(panel);
+    rq_set_clip(r, &clip);
+
     if (state.selected_sprite >= 0 && state.selected_sprite < (int)state.sprites.size())
     {
+        int live_input = -1, live_highlight = -1;
+        if (state.active_input == INPUT_BLOCK_FIELD)
+            live_input = workspace_root_id(state, state.block_input.block_id);
+        if (state.exec_highlight_id != -1 && SDL_GetTicks() <= state.exec_highlight_timer)
+            live_highlight = workspace_root_id(state, state.exec_highlight_id);
+
+        // Renamed or redefined names change block widths without any block being edited
+        Uint64 context = chain_context_hash(state, font, bg);
+        BlockIndex &ix = ((AppState &)state).sprites[state.selected_sprite].block_index;
+        if (ix.context != context)
+        {
+            ix.valid = false;
+            ix.context = context;
+        }
+
+        // Scripts with no block inside the panel are skipped (hat caps poke out above their rect)
+        std::vector<int> visible;
+        SDL_Rect view = {clip.x + cam_x - 16, clip.y + cam_y - 16, clip.w + 32, clip.h + 32};
+        index_query(state, view, visible);
+        std::unordered_set<int> visible_roots;
+        for (int id : visible)
+            visible_roots.insert(workspace_root_id(state, id));
+
+        g_chain_frame++;
+        bool silhouettes = zoom < LOD_ZOOM;
         for (int root_id : state.sprites[state.selected_sprite].top_level_blocks)
-            draw_chain(r, font, tex, state, bg, root_id, false, 0, 0);
+        {
+            if (silhouettes)
+            {
+                // No cached textures down here; they are rasterized per zoom level anyway
+                if (visible_roots.count(root_id))
+                    draw_chain_silhouette(r, state, root_id, -cam_x, -cam_y);
+                continue;
+            }
+            if (!visible_roots.count(root_id))
+            {
+                // Keep its texture for when it scrolls back into view
+                auto it = g_chain_cache.find(root_id);
+                if (it != g_chain_cache.end())
+                    it->second.frame = g_chain_frame;
+                continue;
+            }
+            draw_chain_cached(r, font, tex, state, bg, root_id, context, live_input, live_highlight, -cam_x, -cam_y);
+        }
+
+        // Drop textures of chains that were deleted, merged or belong to another sprite
+        for (auto it = g_chain_cache.begin(); it != g_chain_cache.end();)
+        {
+            if (it->second.frame != g_chain_frame)
+            {
+                chain_cache_drop(r, it->second);
+                it = g_chain_cache.erase(it);
+            }
+            else
+                ++it;
+        }
+        chain_cache_trim(r);
     }
+    // The dragged ghost may hang over the palette, so it is not clipped to the panel
+    // and, when recorded, goes on the overlay layer above the palette drawn after it
+    SDL_Rect ghost_clip = zoomed(outer_clip);
+    rq_set_clip(r, outer_clipped ? &ghost_clip : NULL);
+    rq_set_layer(RQ_LAYER_OVERLAY);
     if (state.drag.active)
     {
         if (state.drag.snap_valid)
         {
-            SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_BLEND);
+            rq_set_blend(r, SDL_BLENDMODE_BLEND);
             if (state.drag.snap_type == SNAP_INPUT_1 || state.drag.snap_type == SNAP_INPUT_2 || state.drag.snap_type == SNAP_INPUT_3)
             {
                 BlockInstance *target = workspace_find((AppState &)state, state.drag.snap_target_id);
@@ -1296,13 +1933,15 @@ void workspace_draw(SDL_Renderer *r, TTF_Font *font, const Textures &tex, const
                 {
                     int arg_idx = (state.drag.snap_type == SNAP_INPUT_1) ? 0 : (state.drag.snap_type == SNAP_INPUT_2 ? 1 : 2);
                     SDL_Rect cap = get_capsule_rect(font, state, *target, arg_idx);
-                    SDL_SetRenderDrawColor(r, 255, 255, 255, 150);
+                    cap.x -= cam_x;
+                    cap.y -= cam_y;
+                    rq_set_color(r, 255, 255, 255, 150);
                     renderer_fill_rounded_rect(r, &cap, cap.h / 2, 255, 255, 255);
                 }
             }
             else
             {
-                SDL_SetRenderDrawColor(r, 0, 0, 0, 60);
+                rq_set_color(r, 0, 0, 0, 60);
                 SDL_Rect sr = {state.drag.snap_x, state.drag.snap_y, 200, 40};
                 if (state.drag.from_palette)
                     sr.w = 160;
@@ -1312,11 +1951,11 @@ void workspace_draw(SDL_Renderer *r, TTF_Font *font, const Textures &tex, const
                     if (drb)
                         sr = block_rect(state, *drb);
                 }
-                sr.x += 2;
-                sr.y += 2;
-                SDL_RenderFillRect(r, &sr);
+                sr.x += 2 - cam_x;
+                sr.y += 2 - cam_y;
+                rq_fill_rect(r, &sr);
             }
-            SDL_SetRenderDrawBlendMode(r, SDL_BLENDMODE_NONE);
+            rq_set_blend(r, SDL_BLENDMODE_NONE);
         }
         int dx = state.drag.snap_valid && (state.drag.snap_type != SNAP_INPUT_1 && state.drag.snap_type != SNAP_INPUT_2 && state.drag.snap_type != SNAP_INPUT_3) ? (state.drag.snap_x - state.drag.ghost_x) : 0;
         int dy = state.drag.snap_valid && (state.drag.snap_type != SNAP_INPUT_1 && state.drag.snap_type != SNAP_INPUT_2 && state.drag.snap_type != SNAP_INPUT_3) ? (state.drag.snap_y - state.drag.ghost_y) : 0;
@@ -1356,7 +1995,7 @@ void workspace_draw(SDL_Renderer *r, TTF_Font *font, const Textures &tex, const
 
             if (state.selected_sprite >= 0)
                 ((AppState &)state).sprites[state.selected_sprite].blocks.push_back(def);
-            draw_chain(r, font, tex, state, bg, 9999, true, dx, dy);
+            draw_chain(r, font, tex, state, bg, 9999, true, dx - cam_x, dy - cam_y);
             if (state.selected_sprite >= 0)
                 ((AppState &)state).sprites[state.selected_sprite].blocks.pop_back();
         }
@@ -1367,10 +2006,13 @@ void workspace_draw(SDL_Renderer *r, TTF_Font *font, const Textures &tex, const
             {
                 int real_dx = state.drag.ghost_x - drb->x + dx;
                 int real_dy = state.drag.ghost_y - drb->y + dy;
-                draw_chain(r, font, tex, state, bg, state.drag.dragged_block_id, true, real_dx, real_dy);
+                draw_chain(r, font, tex, state, bg, state.drag.dragged_block_id, true, real_dx - cam_x, real_dy - cam_y);
             }
         }
     }
+    rq_set_layer(RQ_LAYER_BASE);
+    rq_set_scale(r, scale_x, scale_y);
+    rq_set_clip(r, outer_clipped ? &outer_clip : NULL);
 }
 
 static void start_drag_from_workspace(AppState &state, int clicked_id, int mx, int my, TTF_Font *font)
@@ -1583,6 +2225,7 @@ void workspace_commit_active_input(AppState &state)
     if (b->kind == BK_MY_BLOCKS && b->subtype == MYB_CALL)
     {
         myblocks_set_param_val(*b, state.block_input.field_index, state.input_buffer);
+        index_subtree(state, workspace_root_id(state, b->id));
         return;
     }
 
@@ -1603,11 +2246,114 @@ void workspace_commit_active_input(AppState &state)
         else if (state.block_input.field_index == 2)
             b->c = val;
     }
+    // Field widths feed block_rect
+    index_subtree(state, workspace_root_id(state, b->id));
 }
 
-bool workspace_handle_event(const SDL_Event &e, AppState &state, const SDL_Rect &workspace_rect, const SDL_Rect &palette_rect, TTF_Font *font)
+/* Topmost block under the point: later scripts win, and inside a script the
+   innermost block (condition, C-mouth or reporter) wins over its parent */
+static int workspace_pick(const AppState &state, int px, int py)
+{
+    std::vector<int> cand;
+    index_query(state, {px, py, 1, 1}, cand);
+    if (cand.empty())
+        return -1;
+    std::unordered_map<int, int> order;
+    top_level_order(state, order);
+    int best = -1, best_order = -1;
+    for (int id : cand)
+    {
+        const BlockInstance *b = workspace_find_const(state, id);
+        if (!b || !point_in_rect(px, py, block_rect(state, *b)))
+            continue;
+        auto it = order.find(workspace_root_id(state, id));
+        if (it == order.end())
+            continue;
+        if (best == -1 || it->second > best_order || (it->second == best_order && walk_precedes(state, id, best, PICK_RANK, false)))
+        {
+            best = id;
+            best_order = it->second;
+        }
+    }
+    return best;
+}
+
+bool workspace_handle_event(const SDL_Event &screen_e, AppState &state, const SDL_Rect &workspace_rect, const SDL_Rect &palette_rect, TTF_Font *font)
 {
     (void)palette_rect;
+    // Pointer events are mapped into workspace coordinates; the panel test uses screen_e
+    SDL_Event e = screen_e;
+    if (e.type == SDL_MOUSEMOTION)
+    {
+        g_mouse_x = e.motion.x;
+        g_mouse_y = e.motion.y;
+        workspace_screen_to_world(state, e.motion.x, e.motion.y, e.motion.x, e.motion.y);
+    }
+    else if (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEBUTTONUP)
+        workspace_screen_to_world(state, e.button.x, e.button.y, e.button.x, e.button.y);
+
+    if (e.type == SDL_MOUSEWHEEL && !state.drag.active && point_in_rect(g_mouse_x, g_mouse_y, workspace_rect))
+    {
+        int wx = e.wheel.x, wy = e.wheel.y;
+        if (e.wheel.direction == SDL_MOUSEWHEEL_FLIPPED)
+        {
+            wx = -wx;
+            wy = -wy;
+        }
+        SDL_Keymod mod = SDL_GetModState();
+        if (mod & KMOD_CTRL)
+        {
+            if (wy != 0)
+                workspace_zoom_at(state, g_mouse_x, g_mouse_y, wy > 0 ? ZOOM_STEP : 1.0f / ZOOM_STEP);
+            return true;
+        }
+        if (mod & KMOD_SHIFT)
+        {
+            wx -= wy;
+            wy = 0;
+        }
+        state.ws_cam_x += wx * WHEEL_PAN / state.ws_zoom;
+        state.ws_cam_y -= wy * WHEEL_PAN / state.ws_zoom;
+        return true;
+    }
+    if (e.type == SDL_KEYDOWN && (e.key.keysym.mod & KMOD_CTRL) && !state.drag.active)
+    {
+        SDL_Keycode k = e.key.keysym.sym;
+        int cx = workspace_rect.x + workspace_rect.w / 2, cy = workspace_rect.y + workspace_rect.h / 2;
+        if (k == SDLK_EQUALS || k == SDLK_PLUS || k == SDLK_KP_PLUS)
+        {
+            workspace_zoom_at(state, cx, cy, ZOOM_STEP);
+            return true;
+        }
+        if (k == SDLK_MINUS || k == SDLK_KP_MINUS)
+        {
+            workspace_zoom_at(state, cx, cy, 1.0f / ZOOM_STEP);
+            return true;
+        }
+        if (k == SDLK_0 || k == SDLK_KP_0)
+        {
+            state.ws_zoom = 1.0f;
+            state.ws_cam_x = state.ws_cam_y = 0;
+            return true;
+        }
+    }
+    if (g_panning)
+    {
+        if (e.type == SDL_MOUSEMOTION)
+        {
+            state.ws_cam_x -= (screen_e.motion.x - g_pan_x) / state.ws_zoom;
+            state.ws_cam_y -= (screen_e.motion.y - g_pan_y) / state.ws_zoom;
+            g_pan_x = screen_e.motion.x;
+            g_pan_y = screen_e.motion.y;
+            return true;
+        }
+        if (e.type == SDL_MOUSEBUTTONUP && e.button.button == SDL_BUTTON_LEFT)
+        {
+            g_panning = false;
+            return true;
+        }
+    }
+
     if (e.type == SDL_KEYDOWN && state.drag.active)
     {
         if (e.key.keysym.sym == SDLK_DELETE || e.key.keysym.sym == SDLK_BACKSPACE)
@@ -1686,64 +2432,12 @@ bool workspace_handle_event(const SDL_Event &e, AppState &state, const SDL_Rect
     }
     if (e.type != SDL_MOUSEBUTTONDOWN || e.button.button != SDL_BUTTON_LEFT)
         return false;
-    if (!point_in_rect(e.button.x, e.button.y, workspace_rect))
+    if (!point_in_rect(screen_e.button.x, screen_e.button.y, workspace_rect))
         return false;
     if (state.selected_sprite < 0 || state.selected_sprite >= (int)state.sprites.size())
         return false;
 
-    auto find_hit = [&](auto &self, int root_id) -> int
-    {
-        int cur = root_id;
-        while (cur != -1)
-        {
-            const BlockInstance *b = workspace_find_const(state, cur);
-            if (!b)
-                break;
-            if (b->condition_id != -1)
-            {
-                int h = self(self, b->condition_id);
-                if (h != -1)
-                    return h;
-            }
-            if (b->child_id != -1)
-            {
-                int h = self(self, b->child_id);
-                if (h != -1)
-                    return h;
-            }
-            if (b->child2_id != -1)
-            {
-                int h = self(self, b->child2_id);
-                if (h != -1)
-                    return h;
-            }
-            if (b->arg0_id != -1)
-            {
-                int h = self(self, b->arg0_id);
-                if (h != -1)
-                    return h;
-            }
-            if (b->arg1_id != -1)
-            {
-                int h = self(self, b->arg1_id);
-                if (h != -1)
-                    return h;
-            }
-            if (b->arg2_id != -1)
-            {
-                int h = self(self, b->arg2_id);
-                if (h != -1)
-                    return h;
-            }
-            if (point_in_rect(e.button.x, e.button.y, block_rect(state, *b)))
-                return cur;
-            cur = b->next_id;
-        }
-        return -1;
-    };
-    int hit_id = -1;
-    for (int i = (int)state.sprites[state.selected_sprite].top_level_blocks.size() - 1; i >= 0 && hit_id == -1; --i)
-        hit_id = find_hit(find_hit, state.sprites[state.selected_sprite].top_level_blocks[i]);
+    int hit_id = workspace_pick(state, e.button.x, e.button.y);
 
     if (hit_id != -1)
     {
@@ -1955,7 +2649,12 @@ bool workspace_handle_event(const SDL_Event &e, AppState &state, const SDL_Rect
         compute_snap(state, font);
         return true;
     }
-    return false;
+
+    // Dragging empty canvas pans the camera
+    g_panning = true;
+    g_pan_x = screen_e.button.x;
+    g_pan_y = screen_e.button.y;
+    return true;
 }
 bool workspace_save_txt(const AppState & /*state*/, const char * /*path*/) { return false; }
 bool workspace_load_txt(AppState & /*state*/, const char * /*path*/) { return false; }
\ No newline at end of file
@@ -11,12 +11,20 @@ BlockInstance* workspace_find(AppState& state, int id);
 const BlockInstance* workspace_find_const(const AppState& state, int id);
 
 void workspace_draw(SDL_Renderer* r, TTF_Font* font, const Textures& tex, const AppState& state, const SDL_Rect& workspace_rect, Color bg);
+/* Frees the cached chain textures; call before the renderer is destroyed */
+void workspace_free_cache();
+/* Bytes held by the cached chain textures */
+size_t workspace_cache_bytes();
+/* Maps a logical window point through the code-area camera (pan + zoom) */
+void workspace_screen_to_world(const AppState& state, int sx, int sy, int& wx, int& wy);
 bool workspace_handle_event(const SDL_Event& e, AppState& state, const SDL_Rect& workspace_rect, const SDL_Rect& palette_rect, TTF_Font* font);
 
 int chain_height(const AppState& state, int root_id);
 void workspace_layout_chain(AppState& state, int root_id);
 
 int workspace_add_top_level(AppState& state, const BlockInstance& b);
+/* Call after editing the selected sprite's blocks outside workspace.cpp (fields, links, colours) */
+void workspace_blocks_changed(AppState& state);
 int workspace_root_id(const AppState& state, int id);
 
 void workspace_commit_active_input(AppState& state);